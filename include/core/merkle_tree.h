@@ -0,0 +1,54 @@
+#pragma once
+
+#include "storage_engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace replication {
+
+// Hash tree over a storage engine's contents, for anti-entropy. Keys are
+// spread over kLeafCount ranges by a hash that is stable across processes.
+// A leaf hashes to the wrapping sum of its entries' hashes, so it does not
+// depend on iteration order and the whole tree is built in one unordered
+// pass. Each inner node hashes its kFanout children in order.
+//
+// Two stores hold the same data in a range exactly when (barring hash
+// collisions) the range's hashes match, so comparing top-down from the root
+// finds the differing leaves in kDepth round trips.
+class MerkleTree {
+public:
+    // Selects the keys a tree covers, e.g. one partition's
+    using KeyFilter = std::function<bool(const std::string& key)>;
+
+    static constexpr size_t kFanout = 16;
+    static constexpr size_t kDepth = 3;  // levels below the root
+    static constexpr size_t kLeafCount = kFanout * kFanout * kFanout;
+
+    MerkleTree();
+
+    // With keep_keys, also records each leaf's keys so ranges can be served
+    // (or reconciled) without another scan. Keys the filter rejects are left
+    // out, as if the store did not hold them.
+    void build(const StorageEngine& storage, bool keep_keys = false, const KeyFilter& filter = nullptr);
+
+    static size_t leaf_for(const std::string& key);
+    static uint64_t entry_hash(const std::string& key, const std::string& value);
+    // Nodes on a level; level 0 is the root, level kDepth holds the leaves
+    static size_t level_width(size_t level);
+
+    uint64_t node_hash(size_t level, size_t index) const { return levels_[level][index]; }
+    uint64_t root_hash() const { return levels_[0][0]; }
+    // Empty unless built with keep_keys
+    const std::vector<std::string>& leaf_keys(size_t leaf) const;
+    size_t get_key_count() const { return key_count_; }
+
+private:
+    std::vector<std::vector<uint64_t>> levels_;
+    std::vector<std::vector<std::string>> leaf_keys_;
+    size_t key_count_;
+};
+
+} // namespace replication
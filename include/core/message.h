@@ -1,6 +1,8 @@
 #pragma once
 
+#include "payload.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <chrono>
 #include <cstdint>
@@ -25,13 +27,82 @@ enum class MessageType {
     MODE_SWITCH,
     CACHE_UPDATE,
     BATCH_REQUEST,
-    BATCH_RESPONSE
+    BATCH_RESPONSE,
+    QUORUM_READ_INDEX,
+    QUORUM_READ_INDEX_ACK,
+    CHAIN_FORWARD,
+    CHAIN_ACK,
+    CHAIN_VERSION_QUERY,
+    CHAIN_VERSION_RESPONSE,
+    SYNC_TREE_REQUEST,
+    SYNC_TREE_RESPONSE,
+    SYNC_RANGE_REQUEST,
+    SYNC_RANGE_DATA,
+    SYNC_COMPLETE
 };
 
+// Number of MessageType values; keep in sync with the last enumerator
+constexpr size_t kMessageTypeCount = static_cast<size_t>(MessageType::SYNC_COMPLETE) + 1;
+
 enum class ReplicationMode {
     CHAIN_ONLY,
     QUORUM_ONLY,
-    HYBRID
+    HYBRID_AUTO
+};
+
+constexpr size_t kReplicationModeCount = static_cast<size_t>(ReplicationMode::HYBRID_AUTO) + 1;
+
+// Binary wire format (little-endian):
+//   header: magic(1) version(1) type(1) flags(1) body_length(4)
+//   body:   varint sender_id, receiver_id, timestamp, sequence_number
+//           varint ballot, log_index (version >= 2)
+//           varint partition_id (version >= 3)
+//           varint-length-prefixed key, value, correlation_id, metadata
+//           varint target count followed by packed uint32_t target_nodes
+namespace wire {
+constexpr uint8_t kMagic = 0xC7;
+constexpr uint8_t kVersion = 3;
+constexpr uint8_t kMinSupportedVersion = 1;
+constexpr size_t kHeaderSize = 8;
+constexpr uint8_t kFlagSuccess = 0x01;
+
+// True if the buffer starts with a binary frame header (as opposed to the
+// pipe-delimited text format)
+bool is_binary_frame(const char* data, size_t size);
+
+// Total frame length (header + body) or 0 if the header is incomplete/invalid
+size_t frame_size(const char* data, size_t size);
+} // namespace wire
+
+struct Message;
+
+// Non-owning decoded view over a binary frame. Valid only while the
+// underlying buffer is alive.
+struct MessageView {
+    MessageType type;
+    uint32_t sender_id;
+    uint32_t receiver_id;
+    bool success;
+    uint64_t timestamp;
+    uint32_t sequence_number;
+    uint64_t ballot;
+    uint64_t log_index;
+    uint32_t partition_id;
+    std::string_view key;
+    std::string_view value;
+    std::string_view correlation_id;
+    std::string_view metadata;
+    std::string_view target_nodes_raw; // packed uint32_t array
+    
+    MessageView() : type(MessageType::READ_REQUEST), sender_id(0), receiver_id(0),
+                    success(false), timestamp(0), sequence_number(0), ballot(0), log_index(0),
+                    partition_id(0) {}
+    
+    size_t target_node_count() const { return target_nodes_raw.size() / sizeof(uint32_t); }
+    uint32_t target_node(size_t index) const;
+    Message to_message() const;
+    
+    static bool parse(const char* data, size_t size, MessageView& view);
 };
 
 struct Message {
@@ -39,19 +110,33 @@ struct Message {
     uint32_t sender_id;
     uint32_t receiver_id;
     std::string key;
-    std::string value;
+    Payload value;       // copies share the bytes
     bool success;
     uint64_t timestamp;
     uint32_t sequence_number;
     std::string correlation_id;
     std::vector<uint32_t> target_nodes;
     std::string metadata;
+    uint64_t ballot;     // Paxos ballot of the sender
+    uint64_t log_index;  // position in the replication log
+    uint32_t partition_id; // replication group the message belongs to; see PartitionMap
     
     Message() : type(MessageType::READ_REQUEST), sender_id(0), receiver_id(0), 
-                success(false), timestamp(0), sequence_number(0) {}
+                success(false), timestamp(0), sequence_number(0), ballot(0), log_index(0),
+                partition_id(0) {}
     
+    // Binary encoding (default wire format)
     std::string serialize() const;
+    void serialize_to(std::string& out) const; // appends to out
+    size_t encoded_size() const;
+    
+    // Accepts both binary frames and the text format
     static Message deserialize(const std::string& data);
+    static Message deserialize(const char* data, size_t size);
+    
+    // Pipe-delimited text format, kept for debugging
+    std::string serialize_text() const;
+    static Message deserialize_text(const std::string& data);
 };
 
 struct RequestMetrics {
@@ -60,11 +145,13 @@ struct RequestMetrics {
     uint32_t retry_count;
     bool from_cache;
     std::string protocol_used;
-    uint32_t latency_ms;
+    uint64_t latency_ns; // monotonic, from utils/clock.h
     bool success;
     
     RequestMetrics() : start_time(0), end_time(0), retry_count(0), 
-                      from_cache(false), latency_ms(0), success(false) {}
+                      from_cache(false), latency_ns(0), success(false) {}
+    
+    double get_latency_ms() const { return latency_ns / 1e6; }
 };
 
 } // namespace replication
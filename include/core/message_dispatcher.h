@@ -0,0 +1,126 @@
+#pragma once
+
+#include "message.h"
+#include "../utils/bounded_queue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace replication {
+
+struct DispatcherConfig {
+    size_t worker_threads;      // keyed lanes; 0 uses one per hardware thread
+    size_t replication_threads; // replication lanes; 0 matches the keyed lanes
+    size_t lane_capacity;       // messages each ring holds before producers wait
+    size_t spins_before_sleep;  // empty polls before an idle lane parks
+
+    DispatcherConfig() : worker_threads(4), replication_threads(0), lane_capacity(4096),
+                         spins_before_sleep(64) {}
+};
+
+struct DispatcherStats {
+    uint64_t dispatched;
+    uint64_t control_handled;
+    uint64_t keyed_handled;
+    uint64_t replication_handled;
+    uint64_t shared_handled; // unordered messages, run by whichever worker was idle
+    uint64_t full_waits;     // dispatches that found their ring full and waited
+
+    DispatcherStats() : dispatched(0), control_handled(0), keyed_handled(0), replication_handled(0),
+                        shared_handled(0), full_waits(0) {}
+};
+
+enum class DispatchLane {
+    CONTROL,     // one ordered lane with its own thread
+    KEYED,       // the worker owning hash(key), so one key's messages stay in order
+    REPLICATION, // like KEYED, on lanes of their own; keyless batches by sender
+    SHARED       // any idle worker
+};
+
+// Runs inbound messages on a control thread and two sets of keyed lanes,
+// each fed by a lock-free ring. Producers (the network listener,
+// Node::handle_message callers) pick the lane and push; nothing is taken
+// under a shared lock.
+//
+// CONTROL carries failure and membership traffic, Paxos phase 1 and
+// commits, and every reply that completes a waiting operation (acks,
+// promises, version answers, sync replies). A learned commit may wait on
+// the WAL to apply its writes, but nothing here waits on another node, so
+// a lane parked elsewhere never starves the ack it is waiting for.
+// REPLICATION carries the data a replica must log before it answers:
+// chain forwards and batches, and Paxos accepts. These block on the WAL,
+// so they are spread over several lanes. Chain data is spread by
+// (partition, sender): a forward and a batch from one predecessor run in
+// the order it sent them. Paxos accepts are spread by key, since a
+// follower holds commits that overtake their accepts. These lanes are
+// apart from the KEYED ones: a client write parks its worker until it has
+// replicated, possibly through a forward that would be queued behind it.
+// KEYED carries client requests, hedged reads and per-key queries;
+// SHARED carries the rest, such as anti-entropy requests, and is drained
+// by keyed workers whenever their own ring is empty.
+class MessageDispatcher {
+public:
+    using Handler = std::function<void(const Message&)>;
+
+    explicit MessageDispatcher(Handler handler, const DispatcherConfig& config = DispatcherConfig());
+    ~MessageDispatcher(); // stops, dropping whatever was not yet handled
+
+    MessageDispatcher(const MessageDispatcher&) = delete;
+    MessageDispatcher& operator=(const MessageDispatcher&) = delete;
+
+    bool start();
+    // Workers finish what is queued before they exit
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    // Any thread. Messages dispatched before start() wait in their ring.
+    // Waits while the target ring is full; false if it is full and the
+    // dispatcher is not running.
+    bool dispatch(Message message);
+
+    static DispatchLane lane_for(const Message& message);
+    size_t get_worker_count() const { return workers_.size(); }
+    size_t get_replication_lane_count() const { return replication_.size(); }
+    DispatcherStats get_stats() const;
+
+private:
+    struct Lane {
+        BoundedQueue<Message> ring;
+        std::thread thread;
+        std::atomic<bool> sleeping;
+        std::mutex wake_mutex;
+        std::condition_variable wake_cv;
+        std::atomic<uint64_t> handled;
+        std::atomic<uint64_t> shared_handled;
+
+        explicit Lane(size_t capacity) : ring(capacity), sleeping(false), handled(0), shared_handled(0) {}
+    };
+
+    Handler handler_;
+    DispatcherConfig config_;
+    std::atomic<bool> running_;
+
+    Lane control_;
+    std::vector<std::unique_ptr<Lane>> workers_;
+    std::vector<std::unique_ptr<Lane>> replication_;
+    BoundedQueue<Message> shared_;
+    std::atomic<size_t> next_wake_;
+
+    std::atomic<uint64_t> dispatched_;
+    std::atomic<uint64_t> full_waits_;
+
+    Lane& keyed_lane(const Message& message);
+    Lane& replication_lane(const Message& message);
+    bool push(BoundedQueue<Message>& ring, Message& message);
+    void wake(Lane& lane);
+    void wake_idle_worker();
+    void lane_loop(Lane& lane, bool takes_shared);
+    void run(const Message& message);
+};
+
+} // namespace replication
@@ -1,16 +1,22 @@
 #pragma once
 
+#include "message_dispatcher.h"
+#include "payload.h"
+#include "storage_engine.h"
+#include "write_ahead_log.h"
+#include "../utils/failure_detector.h"
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <mutex>
 #include <atomic>
 #include <memory>
 #include <thread>
-#include <queue>
 #include <condition_variable>
 #include <chrono>
 #include <cstdint>
+#include <utility>
 
 namespace replication {
 
@@ -18,21 +24,54 @@ class NetworkManager;
 class ChainReplication;
 class QuorumReplication;
 class HybridProtocol;
+class PartitionedReplication;
 
 class Node {
 public:
-    Node(uint32_t node_id, const std::vector<uint32_t>& cluster_nodes);
+    Node(uint32_t node_id, const std::vector<uint32_t>& cluster_nodes,
+         std::unique_ptr<StorageEngine> storage = nullptr);
     ~Node();
     
     // Lifecycle
     bool start();
     void stop();
     bool is_running() const { return running_; }
+    // False while catching up after a recovery; such a node takes writes
+    // but must not answer reads
+    bool is_serving() const { return serving_.load(); }
     
     // Data operations
     bool read(const std::string& key, std::string& value);
+    ValueRef read_ref(const std::string& key); // no copy; nullptr if missing
+    // Shares the stored buffer; value is left alone if the key is missing
+    bool read(const std::string& key, Payload& value);
     bool write(const std::string& key, const std::string& value);
+    // Stores value itself, so the caller's copies keep sharing it
+    bool write_ref(const std::string& key, ValueRef value);
     bool delete_key(const std::string& key);
+    // Apply a group of puts with a single durability wait
+    bool write_batch(const std::vector<std::pair<std::string, std::string>>& entries);
+    StorageEngine& get_storage() { return *storage_; }
+    
+    // Durability: restores the latest snapshot in config.directory, replays
+    // the WAL past it, and from then on logs every write and delete. Call
+    // once, before start() and before any write.
+    bool enable_durability(const DurabilityConfig& config);
+    bool is_durable() const { return wal_ != nullptr; }
+    // Rotates the WAL and writes a snapshot at the rotation point; older
+    // snapshots and covered WAL segments are deleted
+    bool take_snapshot();
+    const WriteAheadLog* get_wal() const { return wal_.get(); }
+    uint64_t get_recovery_time_us() const { return recovery_time_us_; }
+    
+    // Anti-entropy catch-up. Between begin and end the node is not serving,
+    // and keys written through write()/delete_key() are remembered, so
+    // apply_catch_up() skips them instead of overwriting a live write with
+    // older range data. Returns how many entries were applied.
+    void begin_catch_up();
+    void end_catch_up();
+    size_t apply_catch_up(const std::vector<std::pair<std::string, std::string>>& puts,
+                          const std::vector<std::string>& erases);
     
     // Cluster management
     uint32_t get_node_id() const { return node_id_; }
@@ -40,53 +79,104 @@ public:
     const std::vector<uint32_t>& get_cluster_nodes() const { return cluster_nodes_; }
     bool is_leader() const { return node_id_ == leader_id_; }
     
-    // Message handling
+    // Message handling. Inbound messages run on the dispatcher's threads,
+    // in order per key; see MessageDispatcher for the lanes.
     void handle_message(const std::string& message_data);
-    void send_message(uint32_t target_node, const std::string& message_data);
+    void handle_message(Message message);
+    void send_message(uint32_t target_node, const Message& message);
+    // Replaces the dispatcher; call before start()
+    void configure_dispatcher(const DispatcherConfig& config);
+    DispatcherStats get_dispatch_stats() const { return dispatcher_->get_stats(); }
     
     // Failure handling
     void handle_node_failure(uint32_t failed_node);
     void handle_node_recovery(uint32_t recovered_node);
+    // Fed by the network's failure detector once started. A FAILED peer is
+    // dropped from the chain and quorum, and one heard from again rejoins
+    // once caught up (at once if this node was the one cut off); when
+    // suspected and failed peers leave this node without a majority, the
+    // protocols are told of a network partition.
+    void handle_peer_liveness(uint32_t peer, PeerLiveness liveness);
+    bool is_partitioned() const { return partitioned_.load(); }
     
     // Performance metrics
-    uint64_t get_operation_count() const { return operation_count_; }
-    uint64_t get_success_count() const { return success_count_; }
+    uint64_t get_operation_count() const;
+    uint64_t get_success_count() const;
     double get_success_rate() const;
     
     // Protocol access
     std::shared_ptr<ChainReplication> get_chain_protocol() { return chain_protocol_; }
     std::shared_ptr<QuorumReplication> get_quorum_protocol() { return quorum_protocol_; }
     std::shared_ptr<HybridProtocol> get_hybrid_protocol() { return hybrid_protocol_; }
+    std::shared_ptr<NetworkManager> get_network_manager() { return network_manager_; }
+    // Inbound messages go to the partition groups instead of the single
+    // hybrid protocol; call before start(). Held weakly, as the groups hold
+    // the node.
+    void attach_partitions(const std::shared_ptr<PartitionedReplication>& partitions) { partitions_ = partitions; }
 
 private:
     uint32_t node_id_;
     uint32_t leader_id_;
     std::vector<uint32_t> cluster_nodes_;
     std::atomic<bool> running_;
+    std::atomic<bool> serving_;
     
     // Data storage
-    std::unordered_map<std::string, std::string> data_store_;
-    mutable std::mutex data_mutex_;
+    std::unique_ptr<StorageEngine> storage_;
+    
+    // Anti-entropy catch-up; lock order is catch_up_mutex_ before the WAL
+    std::atomic<bool> catching_up_;
+    std::mutex catch_up_mutex_;
+    std::unordered_set<std::string> catch_up_written_;
+    
+    // Durability
+    std::unique_ptr<WriteAheadLog> wal_;
+    DurabilityConfig durability_;
+    uint64_t recovery_time_us_;
+    std::mutex snapshot_mutex_;  // one snapshot at a time
+    std::condition_variable snapshot_cv_;
+    std::thread snapshot_thread_;
+    bool snapshot_stopping_;
+    std::atomic<uint64_t> writes_since_snapshot_;
     
     // Message handling
-    std::queue<std::string> message_queue_;
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
-    std::thread message_thread_;
+    std::unique_ptr<MessageDispatcher> dispatcher_;
     
-    // Performance metrics
-    std::atomic<uint64_t> operation_count_;
-    std::atomic<uint64_t> success_count_;
+    // Performance metrics, one slot per thread (round robin past
+    // kCounterSlots) so concurrent readers never share a counter
+    static constexpr size_t kCounterSlots = 32;
+    struct alignas(64) OperationCounters {
+        std::atomic<uint64_t> operations;
+        std::atomic<uint64_t> successes;
+        
+        OperationCounters() : operations(0), successes(0) {}
+    };
+    std::unique_ptr<OperationCounters[]> op_counters_;
+    void count_operations(uint64_t operations, uint64_t successes);
     
     // Protocol components
     std::shared_ptr<NetworkManager> network_manager_;
     std::shared_ptr<ChainReplication> chain_protocol_;
     std::shared_ptr<QuorumReplication> quorum_protocol_;
     std::shared_ptr<HybridProtocol> hybrid_protocol_;
+    std::weak_ptr<PartitionedReplication> partitions_;
+    
+    // Peer liveness as last reported; heartbeat thread only
+    std::unordered_map<uint32_t, PeerLiveness> peer_liveness_;
+    std::atomic<bool> partitioned_;
+    // Set when this node lost its majority, until no peer is FAILED again:
+    // peers heard from meanwhile kept serving and need no catch-up
+    bool lost_majority_;
     
     // Internal methods
-    void message_processing_loop();
-    void process_incoming_message(const std::string& message_data);
+    void snapshot_loop();
+    void note_logged_writes(uint64_t count);
+    // Logs (when durable) and applies a put or delete; returns its LSN, or 0
+    // without a WAL
+    // value is null for deletes
+    uint64_t apply_local(WalRecordType type, const std::string& key, const ValueRef& value, bool* erased);
+    uint64_t log_and_apply(WalRecordType type, const std::string& key, const ValueRef& value, bool* erased);
+    void process_incoming_message(const Message& message);
 };
 
 } // namespace replication
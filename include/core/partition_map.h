@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace replication {
+
+struct PartitionConfig {
+    uint32_t partition_count;
+    size_t replication_factor; // capped at the cluster size
+
+    PartitionConfig() : partition_count(16), replication_factor(3) {}
+};
+
+// Splits the keyspace into a fixed number of partitions and places each on
+// replication_factor nodes. A key belongs to the partition whose range of a
+// 64-bit hash it falls in, so partitions are even in expectation and a key
+// maps the same on every node and build.
+//
+// Replicas are chosen by rendezvous hashing: each partition ranks every node
+// by a hash of the pair and takes the top replication_factor, best first.
+// That first replica is the partition's chain head and preferred quorum
+// leader, and the last is its chain tail, so heads, tails and leaders spread
+// evenly over the nodes. Adding or removing a node only moves the partitions
+// it enters or leaves.
+//
+// Immutable once built, so it may be shared between threads.
+class PartitionMap {
+public:
+    PartitionMap(const std::vector<uint32_t>& nodes, const PartitionConfig& config = PartitionConfig());
+
+    uint32_t partition_for(const std::string& key) const;
+    uint32_t get_partition_count() const { return static_cast<uint32_t>(replicas_.size()); }
+    const std::vector<uint32_t>& get_nodes() const { return nodes_; }
+
+    // Chain order of the partition: head (and leader) first, tail last
+    const std::vector<uint32_t>& replicas(uint32_t partition) const { return replicas_[partition]; }
+    uint32_t leader(uint32_t partition) const;
+    bool replicates(uint32_t node, uint32_t partition) const;
+    // Partitions the node replicates, and those it leads, in id order
+    std::vector<uint32_t> partitions_of(uint32_t node) const;
+    std::vector<uint32_t> partitions_led_by(uint32_t node) const;
+
+    // FNV-1a with a splitmix64 finish: unlike std::hash, the same on every
+    // node and build, and well spread in the high bits the ranges use
+    static uint64_t key_hash(const std::string& key);
+
+private:
+    std::vector<uint32_t> nodes_;
+    std::vector<std::vector<uint32_t>> replicas_;
+};
+
+} // namespace replication
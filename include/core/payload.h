@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace replication {
+
+// Immutable, reference-counted value bytes of a Message. Copying a Payload
+// shares its buffer, so a write that sits in a batch, the pending-write map
+// and CRAQ's version map at once still owns one allocation. ref() hands the
+// same buffer to StorageEngine::put_ref().
+//
+// A shared buffer is never written; mutable_str() first makes a private
+// copy unless this Payload is its only owner.
+class Payload {
+public:
+    using Ref = std::shared_ptr<const std::string>;
+
+    Payload() : writable_(false) {}
+    Payload(std::string value) : writable_(!value.empty()) {
+        if (writable_) {
+            buffer_ = std::make_shared<std::string>(std::move(value));
+        }
+    }
+    Payload(const char* value) : Payload(std::string(value)) {}
+    // Shares a buffer owned elsewhere, e.g. a stored value
+    explicit Payload(Ref ref) : buffer_(std::move(ref)), writable_(false) {}
+
+    const std::string& str() const { return buffer_ ? *buffer_ : empty_string(); }
+    operator const std::string&() const { return str(); }
+    std::string_view view() const { return str(); }
+    const char* data() const { return str().data(); }
+    size_t size() const { return buffer_ ? buffer_->size() : 0; }
+    bool empty() const { return size() == 0; }
+    std::string substr(size_t pos, size_t count = std::string::npos) const { return str().substr(pos, count); }
+
+    // Never null, so it can always be stored
+    Ref ref() const { return buffer_ ? buffer_ : std::make_shared<const std::string>(); }
+    // Owners other than this Payload, e.g. copies or stored refs
+    long share_count() const { return buffer_ ? buffer_.use_count() : 0; }
+
+    std::string& mutable_str() {
+        if (!writable_ || buffer_.use_count() != 1) {
+            buffer_ = std::make_shared<std::string>(str());
+            writable_ = true;
+        }
+        // Sound: a writable buffer was created as a non-const std::string
+        return const_cast<std::string&>(*buffer_);
+    }
+    void assign(const char* data, size_t size) { *this = Payload(std::string(data, size)); }
+    void clear() {
+        buffer_.reset();
+        writable_ = false;
+    }
+    // Moves the bytes out when nobody else shares them, copies otherwise
+    std::string release() {
+        std::string value = writable_ && buffer_.use_count() == 1 ? std::move(mutable_str()) : str();
+        clear();
+        return value;
+    }
+
+    friend bool operator==(const Payload& a, const Payload& b) { return a.buffer_ == b.buffer_ || a.view() == b.view(); }
+    friend bool operator==(const Payload& a, const std::string& b) { return a.view() == b; }
+    friend bool operator==(const std::string& a, const Payload& b) { return b == a; }
+    friend bool operator==(const Payload& a, const char* b) { return a.view() == b; }
+    friend bool operator!=(const Payload& a, const Payload& b) { return !(a == b); }
+    friend bool operator!=(const Payload& a, const std::string& b) { return !(a == b); }
+    friend bool operator!=(const std::string& a, const Payload& b) { return !(b == a); }
+    friend bool operator!=(const Payload& a, const char* b) { return !(a == b); }
+    friend std::ostream& operator<<(std::ostream& out, const Payload& payload) { return out << payload.str(); }
+
+private:
+    std::shared_ptr<const std::string> buffer_; // null when empty
+    bool writable_; // buffer_ was created here, so it may be written once unshared
+
+    static const std::string& empty_string() {
+        static const std::string empty;
+        return empty;
+    }
+};
+
+} // namespace replication
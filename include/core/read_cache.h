@@ -0,0 +1,123 @@
+#pragma once
+
+#include "storage_engine.h"
+#include "../utils/frequency_sketch.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace replication {
+
+struct ReadCacheConfig {
+    size_t shard_count;
+    size_t max_entries;
+    size_t max_bytes;
+    uint64_t ttl_us;
+    bool admission_enabled;
+
+    ReadCacheConfig() : shard_count(16), max_entries(1000), max_bytes(64 * 1024 * 1024),
+                        ttl_us(30000000), admission_enabled(true) {} // 30 seconds
+};
+
+// Sharded read-through cache. Each shard evicts with CLOCK (O(1) amortized)
+// and is bounded by entry count and by key+value bytes. With admission
+// enabled, a TinyLFU sketch only lets a new key displace the CLOCK victim
+// when it has been requested more often, so one-off scans do not flush hot
+// keys. Hits only take a shared lock on their shard.
+//
+// Entries may carry a version (0 = unversioned). invalidate() drops entries
+// older than the given version and remembers it, so a fill from a read that
+// started before the invalidation is refused instead of reinstating a stale
+// value.
+class ReadCache {
+public:
+    explicit ReadCache(const ReadCacheConfig& config = ReadCacheConfig());
+    ~ReadCache() = default;
+    
+    ReadCache(const ReadCache&) = delete;
+    ReadCache& operator=(const ReadCache&) = delete;
+
+    bool get(const std::string& key, std::string& value);
+    ValueRef get_ref(const std::string& key);
+    // Returns false if the entry was not admitted or is older than a
+    // previous invalidation of the key
+    bool put(const std::string& key, const std::string& value, uint64_t version = 0);
+    bool put_ref(const std::string& key, ValueRef value, uint64_t version = 0);
+    bool erase(const std::string& key);
+    // Returns true if a cached entry was dropped
+    bool invalidate(const std::string& key, uint64_t version);
+    void clear();
+
+    void set_ttl(uint64_t ttl_us) { ttl_us_.store(ttl_us, std::memory_order_relaxed); }
+    uint64_t get_ttl() const { return ttl_us_.load(std::memory_order_relaxed); }
+
+    size_t size() const;
+    size_t bytes() const;
+    size_t get_shard_count() const { return shard_count_; }
+    uint64_t get_hits() const;
+    uint64_t get_misses() const;
+    uint64_t get_evictions() const;
+    uint64_t get_rejections() const;
+    uint64_t get_invalidations() const;
+
+private:
+    struct Entry {
+        std::string key;
+        ValueRef value;
+        uint64_t hash;
+        uint64_t version;
+        uint64_t expiry_us;
+        size_t bytes;
+        bool occupied;
+        std::atomic<bool> referenced; // CLOCK bit, set by readers under the shared lock
+
+        Entry() : hash(0), version(0), expiry_us(0), bytes(0), occupied(false), referenced(false) {}
+    };
+
+    // Highest invalidated version per hash slot; collisions only make fills
+    // more conservative
+    static constexpr size_t kTombstoneSlots = 256;
+
+    // Padded to a cache line so neighbouring shard locks don't false-share
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, size_t> index;
+        std::unique_ptr<Entry[]> slots;
+        std::vector<size_t> free_slots;
+        size_t capacity;
+        size_t hand;
+        size_t bytes;
+        std::unique_ptr<FrequencySketch> sketch;
+        std::atomic<bool> aging_due;
+        std::array<uint64_t, kTombstoneSlots> tombstones{};
+        
+        // Per-shard so readers of different shards never share a counter
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+        std::atomic<uint64_t> evictions;
+        std::atomic<uint64_t> rejections;
+        std::atomic<uint64_t> invalidations;
+
+        Shard() : capacity(0), hand(0), bytes(0), aging_due(false),
+                  hits(0), misses(0), evictions(0), rejections(0), invalidations(0) {}
+    };
+
+    size_t shard_count_;
+    size_t max_bytes_per_shard_;
+    bool admission_enabled_;
+    std::atomic<uint64_t> ttl_us_;
+    std::unique_ptr<Shard[]> shards_;
+
+    Shard& shard_for(uint64_t hash) const;
+    uint64_t& tombstone_for(Shard& shard, uint64_t hash) const;
+    size_t select_victim(Shard& shard, uint64_t now);
+    void remove_slot(Shard& shard, size_t slot, std::vector<ValueRef>& released);
+    uint64_t sum_counter(std::atomic<uint64_t> Shard::*counter) const;
+};
+
+} // namespace replication
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "storage_engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace replication {
+
+// Read-only view of a snapshot file mapped into memory. Layout, in host
+// byte order:
+//   header: char magic[8] = "HCQSNAP1", u32 format version,
+//           u32 CRC-32 of the entry area, u64 LSN, u64 entry count,
+//           u64 entry-area bytes
+//   entries: u32 key length, u32 value length, key bytes, value bytes
+// Nothing is parsed up front beyond the header and checksum, so opening
+// costs one pass over the mapping rather than a read and copy.
+class MappedSnapshot {
+public:
+    MappedSnapshot();
+    ~MappedSnapshot();
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    // Maps the file and verifies its header and checksum
+    bool open(const std::string& path);
+    void close();
+
+    uint64_t get_lsn() const { return lsn_; }
+    uint64_t get_entry_count() const { return entry_count_; }
+    size_t get_mapped_bytes() const { return size_; }
+
+    // Walks entries in file order. The pointers stay valid until close().
+    void for_each(const std::function<void(const char* key, size_t key_size,
+                                           const char* value, size_t value_size)>& visitor) const;
+
+private:
+    const char* data_;
+    size_t size_;
+    uint64_t lsn_;
+    uint64_t entry_count_;
+};
+
+// Snapshots of one node's store, kept as <directory>/snapshot-<lsn>.snap.
+// A snapshot is written to a temporary file, synced and then renamed into
+// place, so a crash mid-write never leaves a partial snapshot under a real
+// name.
+//
+// Writes may land while a snapshot is taken; the image then mixes values
+// from just after its LSN. That is safe because recovery replays every WAL
+// record past the LSN, and puts and deletes carry whole values.
+class SnapshotStore {
+public:
+    explicit SnapshotStore(const std::string& directory);
+
+    bool write(const StorageEngine& storage, uint64_t lsn);
+    // Opens the newest snapshot that verifies; false if there is none
+    bool open_latest(MappedSnapshot& snapshot) const;
+    void remove_older_than(uint64_t lsn);
+    std::vector<uint64_t> list() const; // LSNs, oldest first
+
+private:
+    std::string directory_;
+
+    std::string path_for(uint64_t lsn) const;
+};
+
+} // namespace replication
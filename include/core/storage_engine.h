@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <cstdint>
+
+namespace replication {
+
+// Immutable, ref-counted stored value. Readers can hold on to it without
+// copying the string or blocking writers.
+using ValueRef = std::shared_ptr<const std::string>;
+
+class StorageEngine {
+public:
+    virtual ~StorageEngine() = default;
+    
+    virtual bool get(const std::string& key, std::string& value) const = 0;
+    virtual ValueRef get_ref(const std::string& key) const = 0;
+    virtual void put(const std::string& key, const std::string& value) = 0;
+    virtual void put_ref(const std::string& key, ValueRef value) = 0;
+    virtual bool erase(const std::string& key) = 0;
+    virtual size_t size() const = 0;
+    
+    // Visits every entry; concurrent writes may or may not be observed.
+    // The visitor must not modify the engine.
+    virtual void for_each(const std::function<void(const std::string&, const ValueRef&)>& visitor) const = 0;
+};
+
+// N-way sharded hash map with a reader/writer lock per shard
+class ShardedStorageEngine : public StorageEngine {
+public:
+    explicit ShardedStorageEngine(size_t shard_count = 64);
+    ~ShardedStorageEngine() override = default;
+    
+    bool get(const std::string& key, std::string& value) const override;
+    ValueRef get_ref(const std::string& key) const override;
+    void put(const std::string& key, const std::string& value) override;
+    void put_ref(const std::string& key, ValueRef value) override;
+    bool erase(const std::string& key) override;
+    size_t size() const override;
+    void for_each(const std::function<void(const std::string&, const ValueRef&)>& visitor) const override;
+    
+    size_t get_shard_count() const { return shard_count_; }
+
+private:
+    // Padded to a cache line so neighbouring shard locks don't false-share
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, ValueRef> data;
+    };
+    
+    size_t shard_count_;
+    std::unique_ptr<Shard[]> shards_;
+    
+    Shard& shard_for(const std::string& key) const;
+};
+
+} // namespace replication
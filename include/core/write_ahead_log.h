@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace replication {
+
+// PER_OP already shares syncs among writers that overlap one; PER_BATCH
+// also holds each sync back to gather writers that have not arrived yet,
+// which only pays off when a sync costs more than the delay
+enum class WalSyncPolicy {
+    PER_OP,     // each write waits for its own record to be synced
+    PER_BATCH,  // as PER_OP, but a sync waits briefly to gather more writers
+    INTERVAL    // writes return at once; a background thread syncs on a timer
+};
+
+struct DurabilityConfig {
+    std::string directory;
+    WalSyncPolicy sync_policy;
+    uint64_t group_commit_delay_us;  // PER_BATCH: how long a sync gathers writers
+    size_t group_commit_bytes;       // PER_BATCH: sync early once this much is buffered
+    uint64_t sync_interval_us;       // INTERVAL: bound on the window of lost writes
+    uint64_t snapshot_interval_ops;  // writes between snapshots; 0 disables them
+
+    DurabilityConfig() : sync_policy(WalSyncPolicy::PER_OP), group_commit_delay_us(200),
+                         group_commit_bytes(1024 * 1024), sync_interval_us(10000),
+                         snapshot_interval_ops(100000) {}
+};
+
+enum class WalRecordType : uint8_t {
+    PUT = 1,
+    DELETE = 2
+};
+
+struct WalRecord {
+    uint64_t lsn;
+    WalRecordType type;
+    std::string key;
+    std::string value;
+};
+
+// Append-only log of puts and deletes, split into segment files named after
+// their first LSN (wal-<lsn>.log). Each record is framed as
+//   u32 body length, u32 CRC-32 of the body,
+//   body: u64 lsn, u8 type, u32 key length, u32 value length, key, value
+// in host byte order. Replay stops at the first record that is short or
+// fails its checksum, which is where a crash tore the tail.
+//
+// Group commit: appends only copy into a shared buffer. Whoever needs a sync
+// first becomes the leader, writes out everything buffered so far and issues
+// one fdatasync for all of it; writers arriving meanwhile wait for the next
+// leader, so N concurrent writers cost one sync rather than N.
+class WriteAheadLog {
+public:
+    explicit WriteAheadLog(const DurabilityConfig& config);
+    ~WriteAheadLog(); // syncs whatever is still buffered
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Replays every record with an LSN above after_lsn in LSN order, truncates
+    // a torn tail, then opens a fresh segment for appends
+    bool open(uint64_t after_lsn, const std::function<void(const WalRecord&)>& replay);
+
+    // Logs the record and runs apply() under the append lock, so the order of
+    // applied writes always matches the log. The record is not durable until
+    // wait_durable() returns for its LSN.
+    template <typename Apply>
+    uint64_t append(WalRecordType type, const std::string& key, const std::string& value, Apply&& apply) {
+        std::lock_guard<std::mutex> lock(append_mutex_);
+        uint64_t lsn = next_lsn_++;
+        encode_record(lsn, type, key, value);
+        apply();
+        buffered_bytes_.store(buffer_.size(), std::memory_order_relaxed);
+        return lsn;
+    }
+
+    // Blocks as the sync policy demands; false once the log has failed
+    bool wait_durable(uint64_t lsn);
+    // Syncs everything appended so far, whatever the policy
+    bool sync();
+
+    // Closes the current segment and starts a new one. Returns the last LSN
+    // of the closed segments; every record up to it has been applied, so it
+    // is a valid snapshot point.
+    uint64_t rotate();
+    // Deletes closed segments holding no record above lsn
+    void remove_segments_through(uint64_t lsn);
+
+    uint64_t get_last_lsn() const;
+    uint64_t get_durable_lsn() const;
+    uint64_t get_sync_count() const { return syncs_.load(); }
+    uint64_t get_record_count() const { return records_.load(); }
+    bool is_healthy() const { return !failed_.load(); }
+
+private:
+    DurabilityConfig config_;
+
+    // Guarded by append_mutex_
+    mutable std::mutex append_mutex_;
+    uint64_t next_lsn_;
+    std::string buffer_;
+    std::atomic<size_t> buffered_bytes_;
+
+    // Guarded by sync_mutex_
+    mutable std::mutex sync_mutex_;
+    std::condition_variable sync_cv_;
+    bool syncing_;  // a leader holds the segment
+    uint64_t durable_lsn_;
+    
+    // Leader only
+    int fd_;  // current segment
+    std::vector<uint64_t> segments_;  // first LSN of each segment, oldest first
+    std::string spare_buffer_;  // swapped with buffer_ on every flush
+
+    std::thread interval_thread_;
+    bool stopping_;
+    std::atomic<bool> failed_;
+    std::atomic<uint64_t> syncs_;
+    std::atomic<uint64_t> records_;
+
+    void encode_record(uint64_t lsn, WalRecordType type, const std::string& key, const std::string& value);
+    bool replay_segment(const std::string& path, uint64_t after_lsn, uint64_t& last_lsn,
+                        const std::function<void(const WalRecord&)>& replay);
+    bool open_segment(uint64_t first_lsn);
+    std::string segment_path(uint64_t first_lsn) const;
+
+    bool sync_through(uint64_t lsn, bool gather);
+    void become_leader(std::unique_lock<std::mutex>& lock);
+    void step_down(std::unique_lock<std::mutex>& lock);
+    // Leader only: writes and syncs the buffer; returns the last LSN it covered
+    bool flush(uint64_t& flushed_lsn, bool rotate_segment);
+    void interval_sync_loop();
+};
+
+} // namespace replication
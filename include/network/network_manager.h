@@ -1,12 +1,21 @@
 #pragma once
 
 #include "../core/message.h"
+#include "../utils/buffer_pool.h"
+#include "../utils/compression.h"
+#include "../utils/failure_detector.h"
+#include "../utils/mpsc_queue.h"
+#include "../utils/peer_telemetry.h"
 #include <unordered_map>
 #include <string>
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <deque>
+#include <vector>
 
 namespace replication {
 
@@ -15,10 +24,88 @@ struct NodeEndpoint {
     uint16_t port;
     bool is_active;
     uint64_t last_heartbeat;
+    PeerLiveness liveness; // as last judged by the heartbeat thread
     
-    NodeEndpoint() : port(0), is_active(false), last_heartbeat(0) {}
+    NodeEndpoint() : port(0), is_active(false), last_heartbeat(0), liveness(PeerLiveness::UNKNOWN) {}
     NodeEndpoint(const std::string& host, uint16_t p) 
-        : hostname(host), port(p), is_active(true), last_heartbeat(0) {}
+        : hostname(host), port(p), is_active(true), last_heartbeat(0), liveness(PeerLiveness::UNKNOWN) {}
+};
+
+// One persistent outbound TCP stream to a peer. Frames are queued here by
+// senders and drained by the sender thread with writev().
+struct PeerConnection {
+    int fd;
+    uint32_t peer_id;
+    bool connected;
+    bool flush_scheduled;
+    std::deque<std::string> outbound_frames;
+    size_t head_offset;   // bytes of the front frame already written
+    size_t queued_bytes;
+    std::mutex mutex;
+    
+    PeerConnection() : fd(-1), peer_id(0), connected(false), flush_scheduled(false),
+                       head_offset(0), queued_bytes(0) {}
+};
+
+// Per-peer send coalescing statistics
+struct PeerBatchStats {
+    uint64_t batches_flushed;
+    uint64_t messages_flushed;
+    uint64_t bytes_flushed;
+    uint64_t total_flush_latency_us; // oldest enqueue -> flush
+    uint64_t max_flush_latency_us;
+    
+    PeerBatchStats() : batches_flushed(0), messages_flushed(0), bytes_flushed(0),
+                       total_flush_latency_us(0), max_flush_latency_us(0) {}
+    
+    double average_batch_size() const {
+        return batches_flushed > 0 ? static_cast<double>(messages_flushed) / batches_flushed : 0.0;
+    }
+    double average_flush_latency_us() const {
+        return batches_flushed > 0 ? static_cast<double>(total_flush_latency_us) / batches_flushed : 0.0;
+    }
+};
+
+// Frames waiting to be coalesced into one BATCH_REQUEST for a peer.
+// Producers push lock-free; whoever holds flush_mutex drains.
+struct PeerBatchQueue {
+    MpscQueue<std::string> frames;
+    std::atomic<size_t> pending_count;
+    std::atomic<size_t> pending_bytes;
+    std::atomic<uint64_t> oldest_enqueue_us; // 0 when empty
+    std::mutex flush_mutex;
+    PeerBatchStats stats; // guarded by flush_mutex
+    
+    PeerBatchQueue() : pending_count(0), pending_bytes(0), oldest_enqueue_us(0) {}
+};
+
+// Per-peer frame compression statistics. Send-side counters cover frames
+// at or above the threshold; the receive side counts what the peer sent us.
+struct PeerCompressionStats {
+    uint32_t peer_codecs;           // decoders the peer offered, 0 until its offer arrives
+    CompressionCodec codec;         // what frames to the peer are compressed with
+    uint64_t frames_compressed;
+    uint64_t frames_incompressible; // sent raw because compressing did not shrink them
+    uint64_t raw_bytes;             // input of compressed frames
+    uint64_t compressed_bytes;
+    uint64_t compress_ns;           // includes incompressible attempts
+    uint64_t frames_decompressed;
+    uint64_t decompress_ns;
+    
+    PeerCompressionStats() : peer_codecs(0), codec(CompressionCodec::NONE), frames_compressed(0),
+                             frames_incompressible(0), raw_bytes(0), compressed_bytes(0),
+                             compress_ns(0), frames_decompressed(0), decompress_ns(0) {}
+    
+    double compression_ratio() const {
+        return compressed_bytes > 0 ? static_cast<double>(raw_bytes) / compressed_bytes : 1.0;
+    }
+    double average_compress_us() const {
+        uint64_t attempts = frames_compressed + frames_incompressible;
+        return attempts > 0 ? compress_ns / 1000.0 / attempts : 0.0;
+    }
+    double average_decompress_us() const {
+        return frames_decompressed > 0 ? decompress_ns / 1000.0 / frames_decompressed : 0.0;
+    }
 };
 
 class NetworkManager {
@@ -30,6 +117,8 @@ public:
     bool start();
     void stop();
     bool is_running() const { return running_.load(); }
+    // The bound port once started; differs from the constructor's when that was 0
+    uint16_t get_listen_port() const { return listen_port_; }
     
     // Node management
     void add_node(uint32_t node_id, const std::string& hostname, uint16_t port);
@@ -43,10 +132,19 @@ public:
     void set_message_handler(std::function<void(const Message&)> handler);
     
     // Performance optimizations
+    // Compresses frames (whole coalesced batches when batching is on) of at
+    // least the threshold, to peers that offered a matching decoder
     void enable_compression(bool enable) { compression_enabled_ = enable; }
+    void set_compression_threshold(size_t bytes) { compression_min_bytes_ = bytes; }
+    // Preferred codec; peers that lack it get the built-in LZ
+    void set_compression_codec(CompressionCodec codec) { compression_codec_ = codec; }
     void enable_message_batching(bool enable) { message_batching_enabled_ = enable; }
-    void set_batch_timeout(uint64_t timeout_ms) { batch_timeout_ = timeout_ms; }
-    void set_connection_pool_size(size_t size) { connection_pool_size_ = size; }
+    void set_batch_timeout(uint64_t timeout_ms) { batch_flush_deadline_us_ = timeout_ms * 1000; }
+    void set_batch_flush_deadline_us(uint64_t deadline_us) { batch_flush_deadline_us_ = deadline_us; }
+    void set_batch_max_messages(size_t count) { batch_max_messages_ = count > 0 ? count : 1; }
+    void set_batch_max_bytes(size_t bytes) { batch_max_bytes_ = bytes; }
+    void set_connection_pool_size(size_t size) { connection_pool_size_ = size > 0 ? size : 1; }
+    void set_max_queued_bytes(size_t bytes) { max_queued_bytes_ = bytes; }
     
     // Reliability features
     void enable_reliable_delivery(bool enable) { reliable_delivery_enabled_ = enable; }
@@ -54,20 +152,50 @@ public:
     void set_timeout(uint64_t timeout_ms) { message_timeout_ = timeout_ms; }
     
     // Network monitoring
+    // Mean of the peer's recent round trips, in milliseconds
     double get_network_latency(uint32_t target_node) const;
+    // Shared with the protocols, which time their own request/reply pairs
+    std::shared_ptr<PeerTelemetry> get_peer_telemetry() const { return peer_telemetry_; }
     double get_packet_loss_rate(uint32_t target_node) const;
     size_t get_message_queue_size() const;
+    size_t get_queued_bytes(uint32_t target_node) const;
+    PeerBatchStats get_peer_batch_stats(uint32_t target_node) const;
+    std::unordered_map<uint32_t, PeerBatchStats> get_all_batch_stats() const;
+    PeerCompressionStats get_peer_compression_stats(uint32_t peer) const;
+    std::unordered_map<uint32_t, PeerCompressionStats> get_all_compression_stats() const;
+    // Bytes moved on peer sockets, counted at each writev()/read()
+    uint64_t get_bytes_sent() const { return bytes_sent_.load(std::memory_order_relaxed); }
+    uint64_t get_bytes_received() const { return bytes_received_.load(std::memory_order_relaxed); }
+    uint64_t get_bytes_transferred() const { return get_bytes_sent() + get_bytes_received(); }
     
-    // Heartbeat management
+    // Heartbeat management. Every inbound frame counts as a heartbeat for
+    // the phi-accrual detector; the heartbeat thread probes only links that
+    // sent nothing for interval_ms, and reports each peer's liveness changes
+    // to the handler from that thread. A FAILED peer is unreachable until
+    // it is heard from again.
     void start_heartbeat(uint64_t interval_ms);
     void stop_heartbeat();
     void handle_heartbeat(uint32_t sender_node);
+    // Call before start_heartbeat(); its interval supersedes probe_interval_ms
+    void set_failure_detector_config(const FailureDetectorConfig& config) { failure_detector_.configure(config); }
+    void set_liveness_handler(std::function<void(uint32_t node_id, PeerLiveness liveness)> handler);
+    PeerLiveness get_peer_liveness(uint32_t node_id) const;
+    PhiAccrualDetector::Estimate get_liveness_estimate(uint32_t node_id) const {
+        return failure_detector_.estimate(node_id);
+    }
+    uint64_t get_heartbeat_probes_sent() const { return heartbeat_probes_sent_.load(); }
 
 private:
     uint32_t node_id_;
     uint16_t listen_port_;
     std::atomic<bool> running_;
     
+    // Transport descriptors
+    int listen_fd_;
+    int listener_epoll_fd_;
+    int sender_epoll_fd_;
+    int sender_wakeup_fd_;
+    
     // Node registry
     std::unordered_map<uint32_t, NodeEndpoint> known_nodes_;
     mutable std::mutex nodes_mutex_;
@@ -79,32 +207,51 @@ private:
     
     // Performance features
     bool compression_enabled_;
+    size_t compression_min_bytes_;
+    CompressionCodec compression_codec_;
     bool message_batching_enabled_;
     bool reliable_delivery_enabled_;
-    uint64_t batch_timeout_;
+    uint64_t batch_flush_deadline_us_;
+    size_t batch_max_messages_;
+    size_t batch_max_bytes_;
     size_t connection_pool_size_;
+    size_t max_queued_bytes_;
     int max_retry_attempts_;
     uint64_t message_timeout_;
     
     // Message batching
-    std::unordered_map<uint32_t, std::vector<Message>> pending_batches_;
-    mutable std::mutex batch_mutex_;
+    std::unordered_map<uint32_t, std::unique_ptr<PeerBatchQueue>> peer_batches_;
+    mutable std::shared_mutex batch_queues_mutex_; // guards the map, not the queues
     std::thread batch_processor_thread_;
     
     // Heartbeat system
     std::thread heartbeat_thread_;
     std::atomic<bool> heartbeat_running_;
     uint64_t heartbeat_interval_;
+    PhiAccrualDetector failure_detector_;
+    std::function<void(uint32_t, PeerLiveness)> liveness_handler_;
+    std::atomic<uint64_t> heartbeat_probes_sent_;
     
     // Connection management
-    std::unordered_map<uint32_t, int> connection_pool_;
+    std::unordered_map<uint32_t, std::vector<std::shared_ptr<PeerConnection>>> connection_pool_;
     mutable std::mutex connection_mutex_;
+    std::vector<std::shared_ptr<PeerConnection>> dirty_connections_;
+    std::mutex dirty_mutex_;
+    std::unordered_map<int, std::string> inbound_buffers_; // listener thread only
+    // Outbound frames are serialized into recycled buffers and handed back
+    // once written
+    BufferPool frame_pool_;
     
     // Performance tracking
     mutable std::mutex stats_mutex_;
-    std::unordered_map<uint32_t, std::vector<uint64_t>> latency_history_;
     std::unordered_map<uint32_t, size_t> message_counts_;
     std::unordered_map<uint32_t, size_t> failed_sends_;
+    std::shared_ptr<PeerTelemetry> peer_telemetry_;
+    // Keyed by peer; written by senders and the listener thread
+    std::unordered_map<uint32_t, PeerCompressionStats> compression_stats_;
+    mutable std::mutex compression_mutex_;
+    std::atomic<uint64_t> bytes_sent_;
+    std::atomic<uint64_t> bytes_received_;
     
     // Internal methods
     void listener_loop();
@@ -113,19 +260,33 @@ private:
     void heartbeat_loop();
     
     // Network operations
+    bool open_listen_socket();
     bool establish_connection(uint32_t target_node);
     void close_connection(uint32_t target_node);
-    bool send_raw_message(uint32_t target_node, const std::vector<uint8_t>& data);
-    bool receive_raw_message(std::vector<uint8_t>& data);
+    std::shared_ptr<PeerConnection> get_connection(uint32_t target_node, size_t stream_hint);
+    bool send_raw_message(uint32_t target_node, std::string frame, size_t stream_hint = 0);
+    // Queues frame on a stream already connected; never connects itself
+    bool enqueue_frame(uint32_t target_node, const std::shared_ptr<PeerConnection>& connection,
+                       std::string frame);
+    bool receive_raw_message(int fd);
+    void accept_connections();
+    void schedule_flush(const std::shared_ptr<PeerConnection>& connection);
+    void flush_connection(const std::shared_ptr<PeerConnection>& connection);
+    void reset_connection(PeerConnection& connection);
+    void wake_sender();
     
     // Message processing
-    void process_incoming_message(const std::vector<uint8_t>& raw_data);
+    void process_incoming_message(const char* data, size_t size);
+    PeerBatchQueue& get_batch_queue(uint32_t target_node);
     void process_message_batch(uint32_t target_node);
+    bool flush_batch_queue(uint32_t target_node, PeerBatchQueue& queue, bool wait_for_lock);
     bool retry_failed_message(uint32_t target_node, const Message& message);
     
     // Optimization helpers
-    std::vector<uint8_t> compress_data(const std::vector<uint8_t>& data);
-    std::vector<uint8_t> decompress_data(const std::vector<uint8_t>& compressed_data);
+    // Replaces frame with a compressed envelope when that is worth it
+    void compress_frame(uint32_t target_node, std::string& frame);
+    void process_compressed_frame(const MessageView& view);
+    void record_codec_offer(uint32_t peer, uint32_t codecs);
     void update_network_stats(uint32_t target_node, uint64_t latency, bool success);
 };
 
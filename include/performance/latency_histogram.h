@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace replication {
+
+// Log-linear (HDR-style) latency histogram over integer values
+// (nanoseconds in PerformanceMonitor). Each power-of-two range is split
+// into 64 linear sub-buckets, so any recorded value is reported with at
+// most ~1.6% relative error. Values above 2^40 (~18 minutes in ns) are
+// clamped into the last bucket.
+//
+// record() must only be called by a single owning thread; readers on any
+// thread may take snapshots concurrently and see a slightly stale view.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 6;
+    static constexpr uint64_t kSubBucketCount = 1ULL << kSubBucketBits;
+    static constexpr unsigned kMaxValueBits = 40;
+    static constexpr uint64_t kMaxValue = (1ULL << kMaxValueBits) - 1;
+    static constexpr size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+
+    // Point-in-time copy used for merging shards and computing percentiles
+    struct Snapshot {
+        std::array<uint64_t, kBucketCount> counts{};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t min = UINT64_MAX;
+        uint64_t max = 0;
+
+        void merge(const Snapshot& other) {
+            for (size_t i = 0; i < kBucketCount; ++i) {
+                counts[i] += other.counts[i];
+            }
+            count += other.count;
+            sum += other.sum;
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+        }
+
+        double mean() const {
+            return count > 0 ? static_cast<double>(sum) / count : 0.0;
+        }
+
+        // Returns the upper bound of the bucket holding the given quantile
+        // (0.0 - 1.0), clamped to the observed min/max.
+        uint64_t percentile(double quantile) const {
+            if (count == 0) {
+                return 0;
+            }
+            quantile = std::min(std::max(quantile, 0.0), 1.0);
+            uint64_t rank = static_cast<uint64_t>(quantile * (count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBucketCount; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return std::min(std::max(bucket_upper_bound(i), min), max);
+                }
+            }
+            return max;
+        }
+    };
+
+    LatencyHistogram() {
+        reset();
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // Single-writer increments: plain load/store avoids locked RMW cycles
+    void record(uint64_t value) {
+        value = std::min(value, kMaxValue);
+        bump(counts_[bucket_index(value)], 1);
+        bump(count_, 1);
+        bump(sum_, value);
+        if (value < min_.load(std::memory_order_relaxed)) {
+            min_.store(value, std::memory_order_relaxed);
+        }
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void add_to(Snapshot& snapshot) const {
+        uint64_t count = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t bucket = counts_[i].load(std::memory_order_relaxed);
+            snapshot.counts[i] += bucket;
+            count += bucket;
+        }
+        // Derive the count from the buckets so percentile ranks stay consistent
+        snapshot.count += count;
+        snapshot.sum += sum_.load(std::memory_order_relaxed);
+        snapshot.min = std::min(snapshot.min, min_.load(std::memory_order_relaxed));
+        snapshot.max = std::max(snapshot.max, max_.load(std::memory_order_relaxed));
+    }
+
+    uint64_t count() const {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& bucket : counts_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(UINT64_MAX, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < kSubBucketCount) {
+            return static_cast<size_t>(value);
+        }
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned exponent = msb - kSubBucketBits + 1;
+        return exponent * kSubBucketCount + ((value >> (exponent - 1)) - kSubBucketCount);
+    }
+
+    static uint64_t bucket_upper_bound(size_t index) {
+        if (index < kSubBucketCount) {
+            return index;
+        }
+        uint64_t exponent = index / kSubBucketCount;
+        uint64_t sub_bucket = index % kSubBucketCount + kSubBucketCount;
+        return ((sub_bucket + 1) << (exponent - 1)) - 1;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> counts_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+} // namespace replication
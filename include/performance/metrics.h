@@ -1,11 +1,15 @@
 #pragma once
 
 #include "../core/message.h"
+#include "latency_histogram.h"
 #include <vector>
 #include <atomic>
 #include <mutex>
 #include <chrono>
-#include <unordered_map>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <thread>
 
 namespace replication {
 
@@ -24,6 +28,7 @@ struct PerformanceStats {
                         cpu_utilization(0.0), memory_usage_mb(0.0), network_utilization(0.0) {}
 };
 
+// Times are monotonic nanoseconds (utils/clock.h)
 struct OperationMetrics {
     uint64_t start_time;
     uint64_t end_time;
@@ -34,20 +39,66 @@ struct OperationMetrics {
     uint32_t hops;
     ReplicationMode mode_used;
     
-    uint64_t get_latency_ms() const {
-        return (end_time - start_time) / 1000; // Convert microseconds to milliseconds
+    uint64_t get_latency_ns() const {
+        return end_time - start_time;
     }
+    
+    double get_latency_ms() const {
+        return get_latency_ns() / 1e6;
+    }
+};
+
+// Tail latency summary in nanoseconds, computed from merged histograms
+struct LatencySummary {
+    uint64_t count;
+    double mean_ns;
+    uint64_t p50_ns;
+    uint64_t p95_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+    
+    LatencySummary() : count(0), mean_ns(0.0), p50_ns(0), p95_ns(0), p99_ns(0),
+                       p999_ns(0), max_ns(0) {}
+};
+
+// Point-in-time view published by the resource sampler. Readers such as
+// the scrape endpoint load it atomically and never touch the per-thread
+// shards, so scraping cannot stall the operation path.
+struct MetricsSnapshot {
+    uint64_t taken_at_ns;  // monotonic
+    uint64_t uptime_ns;    // since construction or the last reset
+    PerformanceStats overall;
+    LatencySummary mode_latency[kReplicationModeCount];
+    uint64_t mode_failures[kReplicationModeCount];
+    uint64_t network_bytes; // cumulative, both directions
+    
+    // Process-wide perf-events counters; zero when unavailable. Each mode's
+    // share is apportioned by its share of operation time per interval.
+    bool hardware_counters;
+    uint64_t cpu_cycles;
+    uint64_t cache_misses;
+    uint64_t mode_cycles[kReplicationModeCount];
+    uint64_t mode_cache_misses[kReplicationModeCount];
+    
+    MetricsSnapshot() : taken_at_ns(0), uptime_ns(0), mode_failures(), network_bytes(0),
+                        hardware_counters(false), cpu_cycles(0), cache_misses(0),
+                        mode_cycles(), mode_cache_misses() {}
 };
 
 class PerformanceMonitor {
 public:
     PerformanceMonitor();
-    ~PerformanceMonitor() = default;
+    ~PerformanceMonitor();
     
     // Operation tracking
     void start_operation(uint64_t operation_id, MessageType type, const std::string& key);
     void end_operation(uint64_t operation_id, bool success, ReplicationMode mode, uint32_t hops = 1);
     
+    // Records an already-timed operation without going through the active table
+    void record_operation(MessageType type, ReplicationMode mode, uint64_t latency_ns,
+                          bool success, uint32_t hops = 1);
+    
     // Real-time metrics
     PerformanceStats get_current_stats() const;
     PerformanceStats get_historical_stats(uint64_t duration_ms) const;
@@ -58,17 +109,38 @@ public:
     double get_percentile_latency(double percentile) const;
     double get_success_rate() const;
     
+    // Latency distributions by replication mode and/or operation type
+    LatencySummary get_latency_summary(ReplicationMode mode, MessageType type) const;
+    LatencySummary get_mode_latency_summary(ReplicationMode mode) const;
+    LatencySummary get_type_latency_summary(MessageType type) const;
+    LatencySummary get_overall_latency_summary() const;
+    
     // Mode-specific metrics
     PerformanceStats get_chain_stats() const;
     PerformanceStats get_quorum_stats() const;
     PerformanceStats get_hybrid_stats() const;
     
-    // System resource monitoring
+    // System resource monitoring. CPU is a percentage of all cores and
+    // memory the resident set in MB, both from /proc/self; network is a
+    // percentage of the configured capacity, from the byte source.
     void update_system_stats();
     double get_cpu_utilization() const { return cpu_utilization_.load(); }
     double get_memory_usage() const { return memory_usage_.load(); }
     double get_network_utilization() const { return network_utilization_.load(); }
     
+    // Runs update_system_stats() every interval_ms on a background thread
+    void start_sampler(uint64_t interval_ms);
+    void stop_sampler();
+    // Latest published snapshot; null until the first update_system_stats()
+    std::shared_ptr<const MetricsSnapshot> get_metrics_snapshot() const;
+    // Cumulative bytes moved on replication sockets (NetworkManager::get_bytes_transferred)
+    void set_network_byte_source(std::function<uint64_t()> source);
+    void set_network_capacity(double bytes_per_sec);
+    // Opens cycle and cache-miss counters for this process. Counting is
+    // inherited only by threads started afterwards, so enable it before
+    // the node starts. Returns false where perf events are unavailable.
+    bool enable_hardware_counters(bool enable);
+    
     // Performance optimization insights
     std::vector<std::string> get_performance_recommendations() const;
     bool should_scale_up() const;
@@ -87,29 +159,49 @@ public:
     std::vector<std::string> get_active_alerts() const;
 
 private:
-    // Operation tracking
-    mutable std::mutex operations_mutex_;
-    std::unordered_map<uint64_t, OperationMetrics> active_operations_;
-    std::vector<OperationMetrics> completed_operations_;
+    struct ThreadMetrics;
+    
+    // Slot in the fixed active-operation table, indexed by operation id
+    struct ActiveOperation {
+        std::atomic<uint64_t> tag; // operation_id + 1, 0 when free
+        std::atomic<uint64_t> start_time;
+        std::atomic<uint32_t> operation_type;
+    };
+    
+    static constexpr size_t kActiveOperationSlots = 16384;
+    static constexpr int kAnyFilter = -1;
     
-    // Real-time counters
-    std::atomic<uint64_t> total_operations_;
-    std::atomic<uint64_t> successful_operations_;
-    std::atomic<uint64_t> failed_operations_;
-    std::atomic<double> cumulative_latency_;
+    // Per-thread shards; each thread only writes its own shard
+    const uint64_t monitor_id_;
+    mutable std::mutex shards_mutex_;
+    std::vector<std::unique_ptr<ThreadMetrics>> shards_;
+    std::unique_ptr<ActiveOperation[]> active_operations_;
     
     // System resources
     std::atomic<double> cpu_utilization_;
     std::atomic<double> memory_usage_;
     std::atomic<double> network_utilization_;
     
-    // Mode-specific tracking
-    std::atomic<uint64_t> chain_operations_;
-    std::atomic<uint64_t> quorum_operations_;
-    std::atomic<uint64_t> hybrid_operations_;
-    std::atomic<double> chain_latency_;
-    std::atomic<double> quorum_latency_;
-    std::atomic<double> hybrid_latency_;
+    // Sampler state; resource readings are deltas against the previous call
+    std::mutex sampler_mutex_;
+    uint64_t last_sample_ns_;
+    uint64_t last_cpu_ticks_;
+    uint64_t last_network_bytes_;
+    std::function<uint64_t()> network_byte_source_;
+    double network_capacity_;
+    int perf_cycles_fd_;
+    int perf_cache_misses_fd_;
+    uint64_t last_cycles_;
+    uint64_t last_cache_misses_;
+    double last_mode_time_ns_[kReplicationModeCount];
+    uint64_t mode_cycles_[kReplicationModeCount];
+    uint64_t mode_cache_misses_[kReplicationModeCount];
+    std::shared_ptr<const MetricsSnapshot> snapshot_; // std::atomic_load/store only
+    
+    std::thread sampler_thread_;
+    std::mutex sampler_thread_mutex_;
+    std::condition_variable sampler_cv_;
+    bool sampler_running_; // guarded by sampler_thread_mutex_
     
     // Configuration
     bool detailed_logging_enabled_;
@@ -117,23 +209,32 @@ private:
     double throughput_threshold_;
     
     // Time tracking
-    uint64_t start_time_;
+    std::atomic<uint64_t> start_time_;
     
     // Helper methods
     uint64_t get_current_timestamp() const;
-    std::vector<uint64_t> get_latency_samples(uint64_t duration_ms) const;
+    ThreadMetrics& local_shard();
+    void record(MessageType type, ReplicationMode mode, uint64_t start_time,
+                uint64_t latency_ns, bool success, uint32_t hops);
+    LatencyHistogram::Snapshot merge_histograms(int mode, int type, uint64_t* failures) const;
+    LatencySummary summarize(int mode, int type) const;
+    PerformanceStats mode_stats(ReplicationMode mode) const;
     double calculate_percentile(const std::vector<uint64_t>& sorted_values, double percentile) const;
-    void cleanup_old_operations();
     
-    // System monitoring
-    double measure_cpu_usage() const;
+    // System monitoring; callers hold sampler_mutex_
+    double measure_cpu_usage(uint64_t elapsed_ns);
     double measure_memory_usage() const;
-    double measure_network_usage() const;
+    double measure_network_usage(uint64_t elapsed_ns, uint64_t total_bytes);
+    void sample_hardware_counters(MetricsSnapshot& snapshot);
+    void close_hardware_counters();
+    void publish_snapshot(uint64_t network_bytes);
+    void sampler_loop(uint64_t interval_ms);
     
     // Analysis helpers
     bool is_performance_degraded() const;
     ReplicationMode analyze_optimal_mode() const;
     double calculate_efficiency_score(ReplicationMode mode) const;
+    double average_hops(ReplicationMode mode) const;
 };
 
 // Global performance monitor instance
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "metrics.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace replication {
+
+// Plain-HTTP scrape endpoint serving GET /metrics in the Prometheus text
+// format. Responses are rendered from PerformanceMonitor's published
+// MetricsSnapshot only, so a scrape costs the operation path nothing; how
+// fresh the numbers are depends on the monitor's sampler interval.
+// Connections are served one at a time on a single thread.
+class MetricsEndpoint {
+public:
+    MetricsEndpoint(const PerformanceMonitor& monitor, uint16_t port);
+    ~MetricsEndpoint();
+
+    MetricsEndpoint(const MetricsEndpoint&) = delete;
+    MetricsEndpoint& operator=(const MetricsEndpoint&) = delete;
+
+    bool start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+    // The bound port once started; differs from the constructor's when that was 0
+    uint16_t get_port() const { return port_; }
+
+    static std::string render(const MetricsSnapshot& snapshot);
+
+private:
+    const PerformanceMonitor& monitor_;
+    uint16_t port_;
+    int listen_fd_;
+    std::atomic<bool> running_;
+    std::thread server_thread_;
+
+    void server_loop();
+    void serve_connection(int fd);
+};
+
+} // namespace replication
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace replication {
+
+enum class KeyDistribution {
+    UNIFORM,
+    ZIPFIAN, // popular keys scattered over the keyspace
+    LATEST,  // popularity follows insertion order, newest first
+    HOTSPOT  // a fixed hot fraction of keys takes a fixed fraction of requests
+};
+
+enum class ValueSizeDistribution {
+    FIXED,
+    UNIFORM,
+    ZIPFIAN // mostly near the minimum, with a long tail
+};
+
+enum class WorkloadOperationKind {
+    READ,
+    UPDATE,
+    INSERT,
+    SCAN,
+    READ_MODIFY_WRITE
+};
+
+// Operation mix and key/value shape of one workload. Proportions need not
+// sum to 1; they are normalized.
+struct WorkloadSpec {
+    std::string name;
+    double read_proportion;
+    double update_proportion;
+    double insert_proportion;
+    double scan_proportion;
+    double read_modify_write_proportion;
+    KeyDistribution key_distribution;
+    double zipfian_constant;
+    double hotspot_data_fraction;
+    double hotspot_operation_fraction;
+    size_t max_scan_length; // scans cover 1..max_scan_length keys, uniformly
+    ValueSizeDistribution value_distribution;
+    size_t min_value_size;
+    size_t max_value_size; // FIXED uses this
+
+    WorkloadSpec() : read_proportion(1.0), update_proportion(0.0), insert_proportion(0.0),
+                     scan_proportion(0.0), read_modify_write_proportion(0.0),
+                     key_distribution(KeyDistribution::ZIPFIAN), zipfian_constant(0.99),
+                     hotspot_data_fraction(0.2), hotspot_operation_fraction(0.8), max_scan_length(100),
+                     value_distribution(ValueSizeDistribution::FIXED), min_value_size(1),
+                     max_value_size(100) {}
+
+    // The core YCSB workloads, 'A' to 'F'; false for any other letter
+    static bool ycsb(char workload, WorkloadSpec& spec);
+};
+
+struct WorkloadOperation {
+    WorkloadOperationKind kind;
+    uint64_t key_index;  // first key for scans; the new key for inserts
+    size_t value_size;   // updates, inserts and read-modify-writes
+    size_t scan_length;
+
+    WorkloadOperation() : kind(WorkloadOperationKind::READ), key_index(0), value_size(0), scan_length(0) {}
+};
+
+// Zipfian ranks over [0, items) by Gray et al.'s method, as YCSB draws
+// them: rank 0 is the most popular. items may change between calls; growth
+// extends the normalizing constant incrementally rather than recomputing it.
+class ZipfianGenerator {
+public:
+    explicit ZipfianGenerator(uint64_t items, double theta = 0.99);
+
+    uint64_t next(std::mt19937_64& rng, uint64_t items);
+    uint64_t next(std::mt19937_64& rng) { return next(rng, items_); }
+
+private:
+    uint64_t items_;
+    double theta_;
+    double alpha_;
+    double zeta2_;
+    double zetan_;
+    double eta_;
+
+    void grow(uint64_t items);
+};
+
+// One thread's operation stream. Generators on different threads share
+// record_count, the number of keys inserted so far, so inserts claim
+// distinct keys and LATEST follows them.
+class WorkloadGenerator {
+public:
+    WorkloadGenerator(const WorkloadSpec& spec, std::atomic<uint64_t>& record_count, uint64_t seed);
+
+    WorkloadOperation next();
+    // Key of a YCSB-style load phase, bypassing the operation mix
+    uint64_t next_insert_key() { return record_count_.fetch_add(1); }
+    size_t next_value_size();
+
+    const WorkloadSpec& spec() const { return spec_; }
+    static std::string key_name(uint64_t index) { return "bench_key_" + std::to_string(index); }
+
+private:
+    WorkloadSpec spec_;
+    std::atomic<uint64_t>& record_count_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> unit_;
+    ZipfianGenerator key_ranks_;
+    ZipfianGenerator value_sizes_;
+    double total_proportion_;
+
+    uint64_t next_key(uint64_t records);
+};
+
+// Exponential gaps between request start times, so arrivals form a
+// Poisson process regardless of how long each request takes
+class PoissonArrivals {
+public:
+    PoissonArrivals(double ops_per_sec, uint64_t seed)
+        : rng_(seed), gaps_(ops_per_sec > 0 ? ops_per_sec / 1e9 : 1.0) {}
+
+    uint64_t next_gap_ns() { return static_cast<uint64_t>(gaps_(rng_)); }
+
+private:
+    std::mt19937_64 rng_;
+    std::exponential_distribution<double> gaps_;
+};
+
+const char* workload_operation_name(WorkloadOperationKind kind);
+const char* key_distribution_name(KeyDistribution distribution);
+// Accepts the names above in lower case; false for anything else
+bool parse_key_distribution(const std::string& name, KeyDistribution& distribution);
+bool parse_value_size_distribution(const std::string& name, ValueSizeDistribution& distribution);
+
+} // namespace replication
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../core/message.h"
+#include "../core/merkle_tree.h"
+#include "../core/node.h"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace replication {
+
+struct AntiEntropyConfig {
+    size_t chunk_bytes;          // target payload of one SYNC_RANGE_DATA frame
+    size_t max_inflight_chunks;  // range requests outstanding at once
+    uint64_t request_timeout_ms;
+    size_t max_passes;
+    // A pass that changes at most this many keys is close enough to stop
+    // repeating passes and fence the node in
+    size_t converged_keys;
+
+    AntiEntropyConfig() : chunk_bytes(64 * 1024), max_inflight_chunks(4), request_timeout_ms(2000),
+                          max_passes(8), converged_keys(64) {}
+};
+
+struct AntiEntropyStats {
+    size_t passes;
+    size_t ranges_compared;     // tree nodes compared, all levels
+    size_t ranges_transferred;  // leaves fetched
+    size_t keys_transferred;
+    size_t bytes_transferred;
+    size_t keys_removed;
+
+    AntiEntropyStats() : passes(0), ranges_compared(0), ranges_transferred(0),
+                         keys_transferred(0), bytes_transferred(0), keys_removed(0) {}
+};
+
+// Merkle-tree catch-up for a recovering replica. The recipient walks the
+// source's tree top-down, one SYNC_TREE_REQUEST per level, and fetches only
+// the leaves whose hashes differ. Leaves are pulled in chunks of about
+// chunk_bytes with at most max_inflight_chunks requests outstanding, so the
+// source never sends faster than the recipient applies.
+//
+// Wire use of Message fields:
+//   SYNC_TREE_REQUEST   log_index = level, value = packed u32 node indices
+//   SYNC_TREE_RESPONSE  value = packed u64 child hashes, kFanout per node
+//   SYNC_RANGE_REQUEST  log_index = leaf, ballot = key offset in the leaf
+//   SYNC_RANGE_DATA     log_index = leaf, ballot = next offset,
+//                       value = packed [u32 klen][u32 vlen][key][value],
+//                       metadata = "sync_last" on the leaf's final chunk
+// Requests and replies are matched by sequence_number.
+//
+// The source answers from a tree it builds when a pass starts (level 0 is
+// requested) and keeps per requester, so offsets stay stable for the pass.
+// Values are read live, so a chunk may be newer than the tree; the next
+// pass settles any difference.
+class AntiEntropy {
+public:
+    AntiEntropy(std::shared_ptr<Node> node, const AntiEntropyConfig& config = AntiEntropyConfig());
+
+    // Recipient: one full compare-and-fetch pass against source. Returns
+    // false if the source stopped answering; keys_changed counts the keys
+    // written or removed locally.
+    bool sync_pass(uint32_t source, size_t& keys_changed);
+
+    // Source side
+    void handle_tree_request(const Message& request);
+    void handle_range_request(const Message& request);
+    void end_session(uint32_t requester);
+
+    // Recipient side
+    void handle_tree_response(const Message& response);
+    void handle_range_data(const Message& response);
+
+    // Limits both sides of a sync to one partition's keys, and tags requests
+    // with its id; call before the first pass or request
+    void set_scope(uint32_t partition_id, MerkleTree::KeyFilter filter);
+
+    // Call before the first pass or request
+    void set_config(const AntiEntropyConfig& config);
+    const AntiEntropyConfig& get_config() const { return config_; }
+    AntiEntropyStats get_stats() const;
+
+private:
+    std::shared_ptr<Node> node_;
+    AntiEntropyConfig config_;
+    uint32_t partition_id_;
+    MerkleTree::KeyFilter filter_; // empty: every key
+
+    // Source: the tree each requester is syncing against
+    std::unordered_map<uint32_t, std::shared_ptr<MerkleTree>> sessions_;
+    std::mutex sessions_mutex_;
+
+    // Recipient: requests waiting for their reply
+    std::unordered_map<uint32_t, std::shared_ptr<std::promise<Message>>> pending_;
+    std::mutex pending_mutex_;
+    std::atomic<uint32_t> next_request_id_;
+
+    mutable std::mutex stats_mutex_;
+    AntiEntropyStats stats_;
+
+    std::shared_ptr<MerkleTree> session_for(uint32_t requester, bool rebuild);
+    // Stamps request with a fresh id (in sequence_number) and sends it
+    std::future<Message> send_request(uint32_t source, Message& request);
+    bool await_reply(uint32_t request_id, std::future<Message>& reply, Message& response);
+    void abandon(uint32_t request_id);
+    void resolve(const Message& response);
+    bool find_differing_leaves(uint32_t source, const MerkleTree& local, std::vector<uint32_t>& leaves);
+    bool fetch_leaves(uint32_t source, const MerkleTree& local, const std::vector<uint32_t>& leaves,
+                      size_t& keys_changed);
+};
+
+} // namespace replication
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace replication {
+
+// Pairwise round trips in milliseconds. Each replica measures only its own
+// row, so the matrix is assembled from rows reported at different times. A
+// missing direction falls back to the reverse one, and a pair nobody has
+// measured costs the mean of the known pairs, so it neither attracts nor
+// repels a placement.
+class LatencyMatrix {
+public:
+    LatencyMatrix() : total_ms_(0.0) {}
+
+    void set(uint32_t from, uint32_t to, double rtt_ms);
+    bool has(uint32_t from, uint32_t to) const;
+    double get(uint32_t from, uint32_t to) const;
+    size_t size() const { return rtt_ms_.size(); }
+    void clear();
+
+private:
+    std::map<std::pair<uint32_t, uint32_t>, double> rtt_ms_;
+    double total_ms_;
+};
+
+struct ChainPlacementPolicy {
+    // Failure domain (rack or zone) of each node. Nodes not listed are never
+    // held to a domain constraint.
+    std::unordered_map<uint32_t, uint32_t> failure_domains;
+    // Keep head and tail in different domains when the chain spans more than
+    // one, so losing a domain never takes both ends at once
+    bool separate_head_and_tail;
+
+    // Round trip from each node to the clients issuing writes and to the
+    // readers; the head's and tail's are added to the path, scaled by the
+    // weights. Nodes not listed cost nothing.
+    std::unordered_map<uint32_t, double> client_rtt_ms;
+    std::unordered_map<uint32_t, double> reader_rtt_ms;
+    double client_weight;
+    double reader_weight;
+
+    // A periodic reorder must save at least the larger of these per write;
+    // membership changes take any strict improvement
+    double min_improvement_ms;
+    double min_improvement_ratio;
+
+    ChainPlacementPolicy() : separate_head_and_tail(true), client_weight(1.0), reader_weight(1.0),
+                             min_improvement_ms(0.5), min_improvement_ratio(0.1) {}
+};
+
+struct ChainPlan {
+    std::vector<uint32_t> order;
+    double cost_ms;
+    double current_cost_ms;
+    bool changed; // order differs from the current one and saves enough
+
+    ChainPlan() : cost_ms(0.0), current_cost_ms(0.0), changed(false) {}
+};
+
+// Orders a chain's members to minimize the latency every write pays: the
+// sum of round trips along the chain, plus the head's distance to clients
+// and the tail's to readers. Membership is never changed.
+class ChainPlanner {
+public:
+    // Chains up to this long are solved exactly (dynamic programming over
+    // subsets); longer ones get nearest-neighbour orders from every head,
+    // refined by 2-opt
+    static constexpr size_t kMaxExactNodes = 10;
+
+    // Cost of an order; infinite if it breaks the failure-domain constraint
+    static double cost(const std::vector<uint32_t>& order, const LatencyMatrix& rtt,
+                       const ChainPlacementPolicy& policy);
+
+    static ChainPlan plan(const std::vector<uint32_t>& current, const LatencyMatrix& rtt,
+                          const ChainPlacementPolicy& policy, bool require_improvement);
+};
+
+} // namespace replication
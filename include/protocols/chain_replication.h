@@ -2,19 +2,73 @@
 
 #include "../core/message.h"
 #include "../core/node.h"
+#include "../utils/peer_telemetry.h"
+#include "chain_planner.h"
 #include <vector>
 #include <memory>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <thread>
 
 namespace replication {
 
+// CRAQ bookkeeping for one key. Storage always holds the newest version;
+// clean_value keeps the committed one while newer versions are in flight.
+// Values share their buffers with storage and the in-flight messages.
+struct CraqKeyState {
+    uint64_t clean_version;
+    bool clean_exists;
+    Payload clean_value;
+    std::map<uint64_t, Payload> dirty_versions;
+    
+    CraqKeyState() : clean_version(0), clean_exists(false) {}
+    
+    bool is_dirty() const { return !dirty_versions.empty(); }
+};
+
+// A write forwarded downstream and not yet covered by the tail's ack
+struct PendingChainWrite {
+    Message message;
+    std::shared_ptr<std::promise<bool>> completion;  // set on the head only
+    std::shared_ptr<uint64_t> version;               // head: filled in when versioned
+    uint64_t start_time;
+    
+    PendingChainWrite() : start_time(0) {}
+};
+
 class ChainReplication {
 public:
     ChainReplication(std::shared_ptr<Node> node, const std::vector<uint32_t>& chain_order);
-    ~ChainReplication() = default;
+    ~ChainReplication();
     
     // Chain replication operations
     bool process_read(const Message& request, Message& response);
+    // At the head, answers once the tail has committed the write, or fails
+    // after the write timeout; response.log_index is the write's version.
+    // Other replicas forward the write to the head.
     bool process_write(const Message& request, Message& response);
+    // Answers from this replica's committed state without querying the tail;
+    // returns false if the key is dirty here or this node is not in the chain
+    bool serve_local_read(const Message& request, Message& response);
+    
+    // Pipelined write at the head; the future resolves when the tail commits
+    std::future<bool> submit_write(const Message& request);
+    
+    // Called at the head for every write the tail has committed, before its
+    // caller is answered. Runs with the chain lock held, so it must not call
+    // back into this object.
+    using CommitListener = std::function<void(const std::string& key, uint64_t version)>;
+    void set_commit_listener(CommitListener listener);
+    
+    // Sends the writes down the chain as one batch frame, together with any
+    // writes already waiting in the open batch. Like process_write(), each
+    // write succeeds once the tail has committed it.
+    bool process_batch_write(const std::vector<Message>& requests, std::vector<Message>& responses);
     
     // Chain management
     void update_chain_order(const std::vector<uint32_t>& new_chain);
@@ -22,44 +76,157 @@ public:
     bool is_tail() const;
     uint32_t get_successor() const;
     uint32_t get_predecessor() const;
+    std::vector<uint32_t> get_chain_order() const;
+    
+    // Chain message handlers
+    void handle_chain_forward(const Message& message);
+    void handle_chain_ack(const Message& message);
+    void handle_chain_batch(const Message& message);
+    void handle_version_query(const Message& message);
+    void handle_version_response(const Message& message);
     
     // Fault tolerance
     void handle_node_failure(uint32_t failed_node);
     void handle_node_recovery(uint32_t recovered_node);
     
+    // Latency-aware ordering. Members report their RTT rows to the head,
+    // which replans every reorder interval and on membership changes. To
+    // switch, the head keeps admitting writes but holds their forwarding
+    // until the writes in flight are acked, then sends the new order as a
+    // CHAIN_UPDATE. Chain messages carry the sender's epoch in ballot; one
+    // from a newer epoch waits until its CHAIN_UPDATE arrives.
+    //
+    // Wire use of CHAIN_UPDATE:
+    //   order    ballot = chain epoch, log_index = head's last version,
+    //            target_nodes = new order
+    //   report   metadata = "rtt_row", target_nodes = peers,
+    //            value = packed u32 mean RTT in microseconds per peer
+    void enable_reordering(bool enable);
+    void set_reorder_interval(uint64_t interval_ms);
+    void set_placement_policy(const ChainPlacementPolicy& policy);
+    // At the head, plans and switches now; true if the order changed.
+    // Without require_improvement any strict saving is taken, as after a
+    // membership change, and an unchanged order is restated to the members.
+    bool reorder_chain(bool require_improvement = true);
+    void handle_chain_update(const Message& message);
+    uint64_t get_chain_epoch() const;
+    size_t get_reorders_applied() const { return reorders_applied_.load(); }
+    
     // Performance optimizations
     void enable_batching(bool enable) { batching_enabled_ = enable; }
     void set_batch_size(size_t size) { batch_size_ = size; }
-    void enable_pipelining(bool enable) { pipelining_enabled_ = enable; }
+    void set_batch_max_delay_us(uint64_t delay_us);
+    size_t get_batches_flushed() const { return batches_flushed_.load(); }
+    void enable_pipelining(bool enable);
+    void set_pipeline_window(size_t max_inflight_writes);
+    void set_write_timeout(uint64_t timeout_ms) { write_timeout_ms_ = timeout_ms; }
+    size_t get_inflight_writes() const;
+    // Flushes the open batch and waits until the tail has acked everything
+    bool drain_writes(uint64_t timeout_ms);
+    uint64_t get_acked_version() const;
+    void set_version_query_timeout(uint64_t timeout_ms) { version_query_timeout_ms_ = timeout_ms; }
+    // Version query round trips to the tail are recorded here
+    void set_peer_telemetry(std::shared_ptr<PeerTelemetry> telemetry) { peer_telemetry_ = std::move(telemetry); }
+    // Tags every chain message this replica sends; call before traffic
+    void set_partition(uint32_t partition_id) { partition_id_ = partition_id; }
     
     // Metrics
     double get_chain_utilization() const;
     size_t get_chain_length() const { return chain_order_.size(); }
+    bool is_key_dirty(const std::string& key) const;
+    size_t get_clean_read_count() const { return clean_reads_.load(); }
+    size_t get_dirty_read_count() const { return dirty_reads_.load(); }
 
 private:
     std::shared_ptr<Node> node_;
     std::vector<uint32_t> chain_order_;
     uint32_t my_position_;
+    uint32_t partition_id_;
     
     // Performance optimizations
     bool batching_enabled_;
     size_t batch_size_;
     bool pipelining_enabled_;
-    std::vector<Message> write_batch_;
+    std::vector<PendingChainWrite> write_batch_;
+    uint64_t batch_max_delay_us_;
+    std::condition_variable batch_cv_;
+    std::thread batch_flush_thread_;
+    bool stopping_;
+    std::atomic<size_t> batches_flushed_;
     
     // Internal state
-    std::unordered_map<uint64_t, Message> pending_writes_;
+    std::map<uint64_t, PendingChainWrite> pending_writes_;  // ordered by version
+    CommitListener commit_listener_;
     mutable std::mutex chain_mutex_;
+    std::condition_variable window_cv_;
+    uint64_t next_version_;
+    size_t max_inflight_writes_;
+    uint64_t write_timeout_ms_;
+    
+    // Cumulative ack state: every version <= acked_version_ is committed
+    uint64_t acked_version_;
+    uint64_t commit_watermark_;              // tail: highest contiguous version
+    std::map<uint64_t, Message> early_commits_;  // tail: versions past a gap
+    
+    // CRAQ versions; lock order is chain_mutex_ before versions_mutex_
+    std::unordered_map<std::string, CraqKeyState> key_versions_;
+    mutable std::mutex versions_mutex_;
+    
+    // Outstanding version queries to the tail
+    std::unordered_map<uint32_t, std::shared_ptr<std::promise<uint64_t>>> version_queries_;
+    std::mutex queries_mutex_;
+    std::atomic<uint32_t> next_query_id_;
+    uint64_t version_query_timeout_ms_;
+    std::shared_ptr<PeerTelemetry> peer_telemetry_;
+    
+    std::atomic<size_t> clean_reads_;
+    std::atomic<size_t> dirty_reads_;
+    
+    // Reordering; the policy, matrix and epoch are guarded by chain_mutex_
+    ChainPlacementPolicy placement_policy_;
+    LatencyMatrix latency_matrix_;
+    uint64_t chain_epoch_;
+    bool reordering_enabled_;
+    bool membership_changed_;
+    bool switching_;                         // head: forwarding held for a reorder
+    std::vector<Message> deferred_messages_; // chain messages from a newer epoch
+    uint64_t reorder_interval_ms_;
+    std::condition_variable planner_cv_;
+    std::thread planner_thread_;
+    std::atomic<size_t> reorders_applied_;
     
     // Helper methods
     void find_my_position();
-    bool forward_write(const Message& message);
+    // Sends message on and keeps it as the pending write, without a copy
+    bool forward_write(Message message);
     bool send_ack(const Message& original_request);
-    void process_write_batch();
+    uint64_t start_write(std::unique_lock<std::mutex>& lock, const Message& request,
+                         std::shared_ptr<std::promise<bool>> completion);
+    bool commit_at_tail(const Message& message, Message& last_committed);
+    void acknowledge_through(uint64_t version, std::vector<std::shared_ptr<std::promise<bool>>>& completed);
+    size_t pipeline_window() const { return pipelining_enabled_ ? max_inflight_writes_ : 1; }
+    void process_write_batch(std::unique_lock<std::mutex>& lock);
+    void batch_flush_loop();
+    
+    // CRAQ helpers
+    void apply_version(const std::string& key, const Payload& value, uint64_t version, bool committed);
+    void mark_clean(const std::string& key, uint64_t version);
+    bool read_clean(const std::string& key, std::string& value, bool& found);
+    bool read_committed(const std::string& key, uint64_t version, std::string& value, bool& found);
+    bool query_tail_version(uint32_t tail_node, const std::string& key, uint64_t& version);
     bool validate_chain_integrity();
     
+    // Reordering helpers; callers hold chain_mutex_
+    bool replan(std::unique_lock<std::mutex>& lock, bool membership_changed);
+    void announce_chain_order(const std::vector<uint32_t>& new_order);
+    void apply_chain_order(const std::vector<uint32_t>& new_order);
+    bool defer_if_newer_epoch(const Message& message);
+    void schedule_replan();
+    void record_local_latencies();
+    Message make_latency_report();
+    void planner_loop();
+    
     // Optimization methods
-    void optimize_chain_ordering();
     bool should_use_fast_path(const Message& request);
 };
 
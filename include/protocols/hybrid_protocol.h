@@ -2,10 +2,21 @@
 
 #include "../core/message.h"
 #include "../core/node.h"
+#include "../core/read_cache.h"
+#include "anti_entropy.h"
 #include "chain_replication.h"
 #include "quorum_replication.h"
+#include "../performance/metrics.h"
+#include "../utils/hot_key_tracker.h"
 #include <memory>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 
 namespace replication {
 
@@ -19,7 +30,7 @@ enum class WorkloadPattern {
 
 struct AdaptiveMetrics {
     double read_write_ratio;
-    double average_latency;
+    double average_latency; // milliseconds, fractional
     double throughput;
     double network_partition_probability;
     size_t active_nodes;
@@ -35,33 +46,142 @@ public:
     HybridProtocol(std::shared_ptr<Node> node, 
                    const std::vector<uint32_t>& chain_order,
                    const std::vector<uint32_t>& quorum_nodes);
-    ~HybridProtocol() = default;
+    ~HybridProtocol();
     
     // Main protocol interface
     bool process_read(const Message& request, Message& response);
     bool process_write(const Message& request, Message& response);
     
+    // Entry point for inbound messages: routes protocol traffic to the
+    // chain, quorum and anti-entropy handlers, and answers READ_REQUEST and
+    // WRITE_REQUEST from remote clients with a response to the sender.
+    // Safe to call from several dispatcher threads at once.
+    void handle_message(const Message& message);
+    
+    // Batched operations. Keys are grouped by the protocol that owns them and
+    // each group goes out as one batch: one consensus instance for quorum
+    // writes, one chain frame for chain writes, one leadership check for
+    // quorum reads. responses line up with the input; returns true if every
+    // operation succeeded.
+    bool multi_get(const std::vector<std::string>& keys, std::vector<Message>& responses);
+    bool multi_put(const std::vector<std::pair<std::string, std::string>>& entries,
+                   std::vector<Message>& responses);
+    
     // Adaptive mode switching
     void enable_adaptive_switching(bool enable) { adaptive_switching_enabled_ = enable; }
     void update_workload_metrics(const AdaptiveMetrics& metrics);
     ReplicationMode select_optimal_mode(const Message& request);
     
+    // A new mode must win `confirmations` evaluations in a row, the current
+    // one must have been active for min_dwell_ms, and the latency it saves
+    // over the horizon must exceed the measured cost of switching
+    void set_switch_hysteresis(uint64_t min_dwell_ms, size_t confirmations);
+    void set_switch_horizon(double horizon_seconds) { switch_horizon_s_ = horizon_seconds; }
+    
+    // Drains in-flight writes, fences a new MODE_SWITCH epoch to the other
+    // replicas, then activates the mode. Bypasses hysteresis.
+    bool switch_mode(ReplicationMode target);
+    void handle_mode_switch(const Message& message);
+    ReplicationMode get_current_mode() const { return current_mode_.load(); }
+    uint64_t get_mode_epoch() const { return mode_epoch_.load(); }
+    size_t get_mode_switch_count() const;
+    
     // Protocol management
     void update_chain_configuration(const std::vector<uint32_t>& new_chain);
     void update_quorum_configuration(const std::vector<uint32_t>& new_quorum);
+    // Makes this protocol one partition's replication group: every message
+    // it and its sub-protocols send carries partition_id, and anti-entropy
+    // covers only the keys owns_key accepts. Call before serving traffic.
+    void set_partition(uint32_t partition_id, MerkleTree::KeyFilter owns_key);
+    uint32_t get_partition() const { return partition_id_; }
+    // Quorum writes elsewhere are refused, naming this node, while it is up
+    void set_quorum_leader(uint32_t node_id) { quorum_protocol_->set_preferred_leader(node_id); }
+    // Latency-aware chain ordering, driven by the chain's head
+    void enable_chain_reordering(bool enable) { chain_protocol_->enable_reordering(enable); }
+    void set_chain_reorder_interval(uint64_t interval_ms) { chain_protocol_->set_reorder_interval(interval_ms); }
+    void set_chain_placement_policy(const ChainPlacementPolicy& policy) { chain_protocol_->set_placement_policy(policy); }
     
     // Performance optimizations
     void enable_intelligent_routing(bool enable) { intelligent_routing_enabled_ = enable; }
+    // Keys with at least min_ops decayed operations are routed on their own
+    // mix: read-mostly ones to chain (CRAQ), write-contended ones to quorum
+    void set_hot_key_thresholds(uint32_t min_ops, double read_mostly_ratio, double write_contended_ratio);
+    void set_key_heat_half_life(uint64_t half_life_us) { key_heat_->set_half_life_us(half_life_us); }
+    HotKeyTracker::Heat get_key_heat(const std::string& key) const { return key_heat_->heat(key); }
+    // This replica's classification of the key from its local heat;
+    // HYBRID_AUTO when the key is not hot enough to be routed on its own
+    ReplicationMode get_key_route(const std::string& key) const;
+    // Protocol (CHAIN_ONLY or QUORUM_ONLY) every read and write of key goes
+    // through. Only fenced state decides it: the key's pin, else the active
+    // mode, else the write preference, so all replicas route a key alike.
+    ReplicationMode get_pinned_route(const std::string& key) const;
+    // Drains in-flight writes and pins key to mode on every replica with a
+    // MODE_SWITCH fence that carries the key. A hot key whose classification
+    // differs from its route is pinned this way automatically.
+    bool pin_key_route(const std::string& key, ReplicationMode mode);
+    // Protocol the calling thread's latest process_read/process_write went
+    // through; HYBRID_AUTO for a read answered by the cache or refused
+    static ReplicationMode get_last_mode_used();
     void enable_load_balancing(bool enable) { load_balancing_enabled_ = enable; }
     void enable_caching(bool enable) { caching_enabled_ = enable; }
+    // Replaces the read cache; call before serving traffic
+    void configure_cache(const ReadCacheConfig& config);
+    void set_cache_ttl(uint64_t ttl_ms) { read_cache_->set_ttl(ttl_ms * 1000); }
+    const ReadCache& get_read_cache() const { return *read_cache_; }
+    
+    // Cache coherence: committed writes are announced to every other replica
+    // as versioned CACHE_UPDATE invalidations, batched up to the max delay
+    void enable_cache_coherence(bool enable) { cache_coherence_enabled_ = enable; }
+    void set_cache_update_batch(size_t max_keys, uint64_t max_delay_us);
+    void handle_cache_update(const Message& message);
+    void flush_cache_updates();
+    uint64_t get_cache_version() const { return cache_version_.load(std::memory_order_acquire); }
+    size_t get_cache_updates_sent() const { return cache_updates_sent_.load(); }
     
     // Fault tolerance enhancements
     void handle_network_partition();
     void handle_node_failure(uint32_t failed_node);
+    // A recovered peer is held out of the chain and quorum, and does not
+    // count as active, until it reports SYNC_COMPLETE. It is told so, and
+    // starts rejoin_cluster() against this node on its own.
     void handle_node_recovery(uint32_t recovered_node);
+    // Restores a peer at once, for when this node was the one cut off and
+    // the peer kept serving the majority
+    void readmit_node(uint32_t node_id);
+    
+    // Anti-entropy catch-up, run on the recovering node. The node stops
+    // serving reads, repeats Merkle passes against source until one changes
+    // at most converged_keys keys, asks its peers to promote it (to the
+    // chain tail and a quorum voter), then runs a last pass to cover writes
+    // that landed before the promotion and starts serving again. Returns
+    // false, leaving the node out of service, if the source stops answering;
+    // it may simply be called again.
+    bool rejoin_cluster(uint32_t source);
+    void configure_anti_entropy(const AntiEntropyConfig& config);
+    // Routes the SYNC_* messages
+    void handle_anti_entropy_message(const Message& message);
+    void handle_sync_complete(const Message& message);
+    std::vector<uint32_t> get_catching_up_nodes() const;
+    AntiEntropyStats get_anti_entropy_stats() const { return anti_entropy_->get_stats(); }
     
     // Advanced features
-    void enable_speculative_execution(bool enable) { speculative_execution_enabled_ = enable; }
+    // Hedged reads: a read still running past the p95 latency of its mode
+    // gets a duplicate sent to the lowest-latency other replica, and the
+    // first successful answer wins. The primary runs on a read worker so the
+    // caller can take either answer.
+    void enable_speculative_execution(bool enable);
+    // At most max_inflight duplicates are outstanding at once; no read is
+    // hedged sooner than min_delay_us
+    void set_hedge_policy(size_t max_inflight, uint64_t min_delay_us);
+    void handle_hedged_read(const Message& request);
+    void handle_hedged_read_response(const Message& response);
+    size_t get_hedged_read_count() const { return hedged_reads_sent_.load(); }
+    size_t get_hedge_win_count() const { return hedge_wins_.load(); }
+    size_t get_hedges_inflight() const { return hedges_inflight_.load(); }
+    
+    // Per-peer RTT and outstanding requests behind replica selection; shared
+    // with the network manager and both sub-protocols
+    std::shared_ptr<PeerTelemetry> get_peer_telemetry() const { return peer_telemetry_; }
     void enable_request_batching(bool enable) { request_batching_enabled_ = enable; }
     void set_switching_threshold(double threshold) { switching_threshold_ = threshold; }
     
@@ -69,21 +189,23 @@ public:
     double get_hybrid_efficiency() const;
     double get_mode_switching_overhead() const;
     AdaptiveMetrics get_current_metrics() const;
+    LatencySummary get_mode_latency(ReplicationMode mode) const;
     
     // Configuration
-    void set_read_preference(ReplicationMode mode) { read_preference_ = mode; }
+    // Route of keys that are not pinned while no mode switch has happened;
+    // reads of a key follow its writes
     void set_write_preference(ReplicationMode mode) { write_preference_ = mode; }
 
 private:
     std::shared_ptr<Node> node_;
     std::unique_ptr<ChainReplication> chain_protocol_;
     std::unique_ptr<QuorumReplication> quorum_protocol_;
+    uint32_t partition_id_;
     
     // Adaptive switching
     bool adaptive_switching_enabled_;
     AdaptiveMetrics current_metrics_;
-    ReplicationMode current_mode_;
-    ReplicationMode read_preference_;
+    std::atomic<ReplicationMode> current_mode_;
     ReplicationMode write_preference_;
     double switching_threshold_;
     
@@ -94,36 +216,147 @@ private:
     bool speculative_execution_enabled_;
     bool request_batching_enabled_;
     
+    // Per-key routing
+    std::unique_ptr<HotKeyTracker> key_heat_;
+    uint32_t hot_key_min_ops_;
+    double read_mostly_ratio_;
+    double write_contended_ratio_;
+    
+    // Pinned key routes. Each key orders its fences by (epoch, sender) like
+    // mode switches, and a pin is held for the switch dwell time.
+    struct KeyPin {
+        ReplicationMode mode;
+        uint64_t epoch;
+        uint32_t owner;
+        uint64_t pinned_us;
+    };
+    std::unordered_map<std::string, KeyPin> key_routes_;
+    mutable std::mutex key_routes_mutex_;
+    
     // Caching layer
-    std::unordered_map<std::string, std::pair<std::string, uint64_t>> cache_;
-    std::mutex cache_mutex_;
-    uint64_t cache_ttl_;
+    std::unique_ptr<ReadCache> read_cache_;
+    
+    // Cache coherence. cache_version_ is a logical clock advanced past every
+    // commit index and every version received, so reads tagged with it order
+    // against invalidations on this node.
+    bool cache_coherence_enabled_;
+    std::atomic<uint64_t> cache_version_;
+    std::vector<uint32_t> coherence_peers_;
+    std::vector<Message> pending_invalidations_;
+    size_t cache_update_batch_size_;
+    uint64_t cache_update_max_delay_us_;
+    uint64_t oldest_invalidation_us_;
+    bool coherence_stopping_;
+    std::mutex coherence_mutex_;
+    std::condition_variable coherence_cv_;
+    std::thread coherence_flush_thread_;
+    std::atomic<size_t> cache_updates_sent_;
     
-    // Request batching
-    std::vector<Message> pending_reads_;
-    std::vector<Message> pending_writes_;
-    std::mutex batch_mutex_;
+    // Hedged reads, keyed by the id carried in sequence_number
+    struct HedgedRead {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t outstanding;     // attempts still without an answer
+        bool primary_answered;
+        bool done;              // an attempt found the key, or every attempt failed
+        bool hedge_won;
+        uint32_t hedge_id;      // 0 until a duplicate is sent
+        Message response;
+        
+        HedgedRead() : outstanding(1), primary_answered(false), done(false), hedge_won(false), hedge_id(0) {}
+    };
+    std::unordered_map<uint32_t, std::shared_ptr<HedgedRead>> hedged_reads_;
+    std::mutex hedge_mutex_;
+    std::atomic<uint32_t> next_hedge_id_;
+    size_t max_inflight_hedges_;
+    uint64_t min_hedge_delay_us_;
+    std::atomic<uint64_t> hedge_delay_us_[2]; // p95 per mode: chain, quorum
+    std::atomic<uint64_t> hedge_delay_refresh_us_;
+    std::atomic<size_t> hedges_inflight_;
+    std::atomic<size_t> hedged_reads_sent_;
+    std::atomic<size_t> hedge_wins_;
+    
+    // Read workers run the primary attempt of a hedged read
+    std::vector<std::thread> read_workers_;
+    std::deque<std::function<void()>> read_tasks_;
+    bool read_workers_stopping_;
+    std::mutex read_task_mutex_;
+    std::condition_variable read_task_cv_;
     
     // Performance tracking
     mutable std::mutex metrics_mutex_;
     std::vector<double> mode_switching_times_;
+    
+    // Mode switch pipeline. Writes hold switch_gate_ shared; a switch takes
+    // it exclusively to drain them. switch_mutex_ serializes switches.
+    std::shared_mutex switch_gate_;
+    std::mutex switch_mutex_;
+    std::atomic<uint64_t> mode_epoch_;
+    std::atomic<uint32_t> mode_epoch_owner_;  // node that fenced mode_epoch_
+    ReplicationMode candidate_mode_;
+    size_t candidate_votes_;
+    size_t switch_confirmations_;
+    uint64_t min_mode_dwell_us_;
+    uint64_t last_switch_us_;
+    double switch_horizon_s_;
+    double switch_cost_ns_; // smoothed measured duration of a switch
     std::atomic<size_t> chain_operations_;
     std::atomic<size_t> quorum_operations_;
-    std::atomic<size_t> cache_hits_;
-    std::atomic<size_t> cache_misses_;
+    std::shared_ptr<PeerTelemetry> peer_telemetry_;
+    
+    // Recovery: peers still catching up, and the promotion ack rejoin_cluster()
+    // waits for from its source. Rejoins peers ask for run on
+    // rejoin_thread_, trying each asking peer as source until one succeeds.
+    std::unique_ptr<AntiEntropy> anti_entropy_;
+    std::vector<uint32_t> catching_up_nodes_;
+    std::shared_ptr<std::promise<bool>> promotion_ack_;
+    uint32_t promotion_source_;
+    std::thread rejoin_thread_;
+    std::deque<uint32_t> rejoin_sources_;
+    bool rejoining_;
+    mutable std::mutex recovery_mutex_;
+    
+    // Observed latency distributions of the sub-protocols, by mode and type
+    std::unique_ptr<PerformanceMonitor> latency_monitor_;
     
     // Decision algorithms
-    ReplicationMode decide_protocol_for_read(const Message& request);
-    ReplicationMode decide_protocol_for_write(const Message& request);
+    // Pins a hot key whose classification differs from its route; the
+    // caller must not hold switch_gate_
+    void repin_hot_key(const std::string& key);
     bool should_switch_mode(ReplicationMode target_mode);
+    bool switch_pays_off(ReplicationMode from, ReplicationMode to) const;
+    // epoch 0 fences the next epoch as this node; otherwise adopts the
+    // epoch fenced by epoch_owner
+    bool execute_mode_switch(ReplicationMode target, uint64_t epoch, uint32_t epoch_owner, bool announce);
+    bool fence_supersedes(uint64_t epoch, uint32_t owner) const;
+    // As execute_mode_switch(), for one key's route
+    bool execute_key_pin(const std::string& key, ReplicationMode mode, uint64_t epoch, uint32_t epoch_owner,
+                         bool announce);
+    LatencySummary latency_for_mode(ReplicationMode mode) const;
+    std::vector<uint32_t> replica_peers();
+    void promote_node(uint32_t caught_up_node);
+    void start_rejoin(uint32_t source);
+    bool request_promotion(uint32_t source);
     
     // Optimization methods
     bool try_cache_read(const std::string& key, std::string& value);
-    void update_cache(const std::string& key, const std::string& value);
-    void process_batched_requests();
+    void update_cache(const std::string& key, const std::string& value, uint64_t version);
+    uint64_t advance_cache_version(uint64_t observed);
+    void publish_invalidation(const std::string& key, uint64_t commit_index);
+    void send_invalidations(std::unique_lock<std::mutex>& lock);
+    void coherence_flush_loop();
+    void refresh_coherence_peers();
+    
+    // Runs a READ_REQUEST or WRITE_REQUEST from another node and replies
+    void serve_remote_request(const Message& request);
     
     // Speculative execution
-    void start_speculative_read(const Message& request);
+    bool hedged_read(const Message& request, Message& response, ReplicationMode mode);
+    bool send_hedge(const Message& request, ReplicationMode mode, const std::shared_ptr<HedgedRead>& read);
+    void finish_hedge_attempt(HedgedRead& read, Message& answer, bool found, bool from_hedge);
+    uint64_t hedge_delay_us(ReplicationMode mode);
+    uint32_t select_hedge_replica(ReplicationMode mode);
+    void read_worker_loop();
     void start_speculative_write(const Message& request);
     
     // Load balancing
@@ -131,7 +364,9 @@ private:
     std::vector<uint32_t> select_optimal_nodes_for_write();
     
     // Metrics collection
-    void update_performance_metrics(const Message& request, uint64_t latency, bool success);
+    void update_performance_metrics(const Message& request, ReplicationMode mode,
+                                    uint64_t latency_ns, bool success);
+    void refresh_read_write_ratio();
     WorkloadPattern analyze_workload_pattern();
     double calculate_network_health();
 };
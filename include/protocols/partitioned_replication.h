@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../core/message.h"
+#include "../core/node.h"
+#include "../core/partition_map.h"
+#include "hybrid_protocol.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace replication {
+
+// Runs one independent replication group (a HybridProtocol with its own
+// chain, quorum, leader, cache and mode) for every partition this node
+// replicates, so writes to different partitions go through different chain
+// heads and Paxos leaders spread over the cluster.
+//
+// The groups share the node's storage, dispatcher and NetworkManager: two
+// nodes keep one connection and one heartbeat between them however many
+// groups they share, and messages of different groups bound for the same
+// peer are coalesced into the same batch frames. Every protocol message
+// carries its group's partition_id; READ_REQUEST and WRITE_REQUEST from
+// clients are routed by key instead, so clients need not know the map.
+class PartitionedReplication {
+public:
+    PartitionedReplication(std::shared_ptr<Node> node, const PartitionConfig& config = PartitionConfig());
+    ~PartitionedReplication() = default;
+
+    // Client operations, routed to the key's group. A key whose partition
+    // this node does not replicate is refused, with the partition's replicas
+    // (leader first) in response.target_nodes. Writes belong at the leader,
+    // which heads the chain and runs the partition's Paxos: other replicas
+    // forward chain writes to it and refuse quorum writes, naming it in
+    // response.target_nodes, until it fails.
+    bool process_read(const Message& request, Message& response);
+    bool process_write(const Message& request, Message& response);
+    // Split by partition into one batch per group; responses line up with
+    // the input; returns true if every operation succeeded
+    bool multi_get(const std::vector<std::string>& keys, std::vector<Message>& responses);
+    bool multi_put(const std::vector<std::pair<std::string, std::string>>& entries,
+                   std::vector<Message>& responses);
+
+    // Entry point for inbound messages; see Node::attach_partitions
+    void handle_message(const Message& message);
+
+    // Forwarded to the groups the node belongs to
+    void handle_node_failure(uint32_t failed_node);
+    void handle_node_recovery(uint32_t recovered_node);
+    void readmit_node(uint32_t node_id);
+
+    const PartitionMap& get_partition_map() const { return *map_; }
+    // nullptr for a partition this node does not replicate
+    std::shared_ptr<HybridProtocol> get_group(uint32_t partition) const;
+    const std::vector<uint32_t>& get_local_partitions() const { return local_partitions_; }
+    size_t get_group_count() const { return local_partitions_.size(); }
+    // Applies a setting to every local group, e.g. a mode preference
+    void for_each_group(const std::function<void(uint32_t partition, HybridProtocol& group)>& apply);
+
+private:
+    std::shared_ptr<Node> node_;
+    std::shared_ptr<const PartitionMap> map_;
+    std::vector<std::shared_ptr<HybridProtocol>> groups_; // by partition id; null if not local
+    std::vector<uint32_t> local_partitions_;
+
+    HybridProtocol* group_for_key(const std::string& key, uint32_t& partition) const;
+    void refuse(const Message& request, uint32_t partition, MessageType type, Message& response) const;
+};
+
+} // namespace replication
@@ -2,29 +2,74 @@
 
 #include "../core/message.h"
 #include "../core/node.h"
+#include "../utils/peer_telemetry.h"
 #include <vector>
 #include <memory>
 #include <unordered_set>
 #include <unordered_map>
+#include <map>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <future>
 #include <atomic>
 
 namespace replication {
 
+// How reads are served. Every mode but LOCAL is linearizable.
+enum class QuorumReadMode {
+    LEASE,          // leaseholder serves locally, falls back to ReadIndex
+    READ_INDEX,     // leader confirms its ballot with one batched heartbeat round
+    PREPARE_ROUND,  // full prepare round per read
+    LOCAL           // fast path: any replica answers from its committed state,
+                    // which may trail the leader; misses fall back to ReadIndex
+};
+
 enum class QuorumPhase {
     PREPARE,
     ACCEPT,
     COMMIT
 };
 
+// A value an acceptor accepted for one slot. Acceptors apply it only once
+// the leader reports the slot committed, and report it in promises so a
+// new leader can finish what its predecessor started.
+struct AcceptedValue {
+    uint64_t ballot;
+    std::string key;
+    std::string value;
+    bool batch;
+    
+    AcceptedValue() : ballot(0), batch(false) {}
+};
+
+// Phase-1 round, used for leader election and quorum reads
 struct QuorumState {
     uint64_t proposal_number;
+    uint64_t ballot;          // 0 for read rounds
     QuorumPhase phase;
     std::string key;
     std::string value;
     std::unordered_set<uint32_t> promised_nodes;
     std::unordered_set<uint32_t> accepted_nodes;
     uint64_t start_time;
+    uint64_t highest_accepted_index;  // largest log index reported by promisers
+    std::map<uint64_t, AcceptedValue> accepted_values;  // highest-ballot value per slot
+    bool rejected;
+    bool completed;
+    std::shared_ptr<std::promise<bool>> completion;  // fulfilled on majority or rejection
+    
+    QuorumState() : proposal_number(0), ballot(0), phase(QuorumPhase::PREPARE),
+                    start_time(0), highest_accepted_index(0), rejected(false),
+                    completed(false), completion(std::make_shared<std::promise<bool>>()) {}
+    
+    void complete(bool success) {
+        if (!completed) {
+            completed = true;
+            completion->set_value(success);
+        }
+    }
     
     bool has_majority(size_t total_nodes) const {
         size_t required = (total_nodes / 2) + 1;
@@ -37,6 +82,72 @@ struct QuorumState {
     }
 };
 
+// Leadership confirmation shared by every read waiting when it was sent
+struct ReadIndexRound {
+    uint64_t id;
+    uint64_t ballot;
+    uint64_t read_index;
+    uint64_t start_time;
+    std::unordered_set<uint32_t> acks;
+    bool completed;
+    std::shared_ptr<std::promise<bool>> completion;
+    std::shared_future<bool> done;
+    
+    ReadIndexRound() : id(0), ballot(0), read_index(0), start_time(0), completed(false),
+                       completion(std::make_shared<std::promise<bool>>()),
+                       done(completion->get_future().share()) {}
+    
+    void complete(bool success) {
+        if (!completed) {
+            completed = true;
+            completion->set_value(success);
+        }
+    }
+};
+
+// One slot of the Multi-Paxos log, owned by the leader until it commits
+struct LogSlot {
+    uint64_t index;
+    uint64_t ballot;
+    std::string key;
+    std::string value;
+    std::unordered_set<uint32_t> accepted_nodes;
+    bool chosen;
+    bool batch;  // value holds serialized key/value frames, key is empty
+    uint64_t start_time;
+    std::shared_ptr<std::promise<bool>> completion;
+    
+    LogSlot() : index(0), ballot(0), chosen(false), batch(false), start_time(0) {}
+    
+    bool has_accept_majority(size_t total_nodes) const {
+        size_t required = (total_nodes / 2) + 1;
+        return accepted_nodes.size() >= required;
+    }
+};
+
+// Uncommitted suffix of the log; slots are contiguous starting at first_index()
+class PaxosLog {
+public:
+    PaxosLog() : first_index_(1) {}
+    
+    uint64_t first_index() const { return first_index_; }
+    uint64_t next_index() const { return first_index_ + slots_.size(); }
+    size_t inflight() const { return slots_.size(); }
+    bool empty() const { return slots_.empty(); }
+    
+    LogSlot& append(uint64_t ballot, const std::string& key, const std::string& value);
+    LogSlot* find(uint64_t index);
+    LogSlot& front() { return slots_.front(); }
+    void pop_front();
+    
+    // Drops every uncommitted slot and restarts numbering at next_index
+    std::deque<LogSlot> truncate(uint64_t next_index);
+
+private:
+    uint64_t first_index_;
+    std::deque<LogSlot> slots_;
+};
+
 class QuorumReplication {
 public:
     QuorumReplication(std::shared_ptr<Node> node, const std::vector<uint32_t>& quorum_nodes);
@@ -45,10 +156,21 @@ public:
     // Core operations
     bool process_read(const Message& request, Message& response);
     bool process_write(const Message& request, Message& response);
+    // Answers from local state when that needs no round: a single-node
+    // quorum, a valid lease, or a fast-path hit in LOCAL mode. Returns
+    // false otherwise.
+    bool serve_local_read(const Message& request, Message& response);
+    
+    // Batched operations: a batch of writes commits as one log slot, and a
+    // batch of reads shares one lease check or ReadIndex round. responses
+    // line up with requests; returns true if every operation succeeded.
+    bool process_batch_write(const std::vector<Message>& requests, std::vector<Message>& responses);
+    bool process_batch_read(const std::vector<Message>& requests, std::vector<Message>& responses);
     
     // Configuration management
     void update_quorum_nodes(const std::vector<uint32_t>& new_nodes);
     size_t get_quorum_size() const;
+    std::vector<uint32_t> get_quorum_nodes() const;
     bool is_in_quorum(uint32_t node_id) const;
     
     // Paxos message handlers
@@ -56,6 +178,9 @@ public:
     void handle_promise(const Message& message);
     void handle_accept(const Message& message);
     void handle_accepted(const Message& message);
+    void handle_commit(const Message& message);
+    void handle_read_index(const Message& message);
+    void handle_read_index_ack(const Message& message);
     
     // Fault tolerance
     void handle_node_failure(uint32_t failed_node);
@@ -66,16 +191,47 @@ public:
     void enable_read_optimization(bool enable) { read_optimization_enabled_ = enable; }
     void enable_adaptive_quorum(bool enable) { adaptive_quorum_enabled_ = enable; }
     void set_timeout(uint64_t timeout_ms) { operation_timeout_ = timeout_ms; }
+    void set_pipeline_window(size_t max_inflight_accepts);
+    size_t get_pipeline_window() const { return max_inflight_accepts_; }
+    void set_read_mode(QuorumReadMode mode) { read_mode_ = mode; }
+    QuorumReadMode get_read_mode() const { return read_mode_; }
+    void set_lease_duration(uint64_t lease_ms) { lease_duration_us_ = lease_ms * 1000; }
+    void set_max_clock_drift(uint64_t drift_ms) { max_clock_drift_us_ = drift_ms * 1000; }
     void adjust_quorum_size_based_on_load();
+    // Round trips of PREPARE, ACCEPT and READ_INDEX messages are recorded
+    // here and rank peers for thrifty quorum subsets
+    void set_peer_telemetry(std::shared_ptr<PeerTelemetry> telemetry) { peer_telemetry_ = std::move(telemetry); }
+    const PeerTelemetry& get_peer_telemetry() const { return *peer_telemetry_; }
+    // Tags every Paxos message this replica sends; call before traffic
+    void set_partition(uint32_t partition_id) { partition_id_ = partition_id; }
+    // While the preferred leader is in the quorum, other replicas refuse
+    // writes with it in response.target_nodes and never run phase 1; they
+    // compete for leadership only once it has failed. 0 for no preference.
+    void set_preferred_leader(uint32_t node_id);
+    uint32_t get_preferred_leader() const;
     
     // Performance metrics
     double get_consensus_success_rate() const;
     double get_average_consensus_time() const;
+    
+    // Multi-Paxos state
+    bool is_leader() const;
+    uint64_t get_current_ballot() const;
+    uint64_t get_commit_index() const;
+    bool has_valid_lease() const;
+    // The node holding the read lease as far as this replica knows: itself
+    // while its own lease is valid, else the leader it granted one to.
+    // 0 when no lease is known to be live.
+    uint32_t get_leaseholder() const;
+    size_t get_lease_read_count() const { return lease_reads_.load(); }
+    size_t get_read_index_read_count() const { return read_index_reads_.load(); }
+    size_t get_read_index_round_count() const { return read_index_rounds_sent_.load(); }
 
 private:
     std::shared_ptr<Node> node_;
     std::vector<uint32_t> quorum_nodes_;
     size_t quorum_size_;
+    uint32_t partition_id_;
     
     std::atomic<uint64_t> next_proposal_number_;
     
@@ -84,21 +240,89 @@ private:
     bool adaptive_quorum_enabled_;
     uint64_t operation_timeout_;
     
-    std::unordered_map<uint64_t, QuorumState> active_proposals_;
-    std::mutex consensus_mutex_;
+    // Phase-1 rounds (leader election and quorum reads), keyed by proposal number
+    std::unordered_map<uint64_t, QuorumState> prepare_rounds_;
+    mutable std::mutex consensus_mutex_;
+    std::condition_variable phase1_cv_;
+    std::condition_variable window_cv_;
+    
+    // Proposer state: once phase 1 succeeds the leader skips PREPARE
+    // for later slots until a higher ballot is observed
+    PaxosLog log_;
+    uint64_t current_ballot_;
+    uint64_t highest_seen_ballot_;
+    bool phase1_complete_;
+    bool phase1_in_progress_;
+    uint64_t commit_index_;
+    // Last slot re-proposed when leadership was won; reads wait for it to
+    // commit, since earlier leaders may have chosen values up to there
+    uint64_t recovery_index_;
+    size_t max_inflight_accepts_;
+    
+    // Acceptor state. accepted_values_ holds every slot past commit_index_
+    // plus a window of committed ones, so a lagging leader can recover them.
+    uint64_t promised_ballot_;
+    uint64_t accepted_index_;
+    std::map<uint64_t, AcceptedValue> accepted_values_;
+    // Commits reported by leaders and not yet applied: last index -> ballot
+    // that committed it. Accepts travel apart from commits, so a follower
+    // may learn a commit before the value it covers.
+    std::map<uint64_t, uint64_t> commit_ballots_;
+    
+    // Leases: the leader's lease ends max_clock_drift_us_ before any
+    // follower's grant can, so no other node wins phase 1 while it serves
+    QuorumReadMode read_mode_;
+    uint64_t lease_duration_us_;
+    uint64_t max_clock_drift_us_;
+    uint64_t lease_expiry_us_;
+    uint64_t lease_grant_ballot_;
+    uint64_t lease_grant_expiry_us_;
+    
+    // Replica the placement prefers as leader; 0 when any may lead
+    uint32_t preferred_leader_;
+    
+    // ReadIndex batching: reads join the open round until it is sent
+    std::unordered_map<uint64_t, ReadIndexRound> read_index_rounds_;
+    uint64_t open_read_round_;
+    uint64_t inflight_read_round_;
+    std::atomic<size_t> lease_reads_;
+    std::atomic<size_t> read_index_reads_;
+    std::atomic<size_t> read_index_rounds_sent_;
     
     // Performance tracking
+    std::shared_ptr<PeerTelemetry> peer_telemetry_;
     std::atomic<size_t> successful_consensus_;
     std::atomic<size_t> failed_consensus_;
     std::vector<uint64_t> consensus_times_;
     
     // Internal methods
     uint64_t generate_proposal_number();
-    bool initiate_consensus(const std::string& key, const std::string& value);
+    uint64_t generate_ballot();
+    bool initiate_consensus(const std::string& key, const std::string& value, bool batch = false);
+    bool ensure_leadership(std::unique_lock<std::mutex>& lock,
+                           std::chrono::steady_clock::time_point deadline);
+    void commit_chosen_slots();
+    // Follower side of commits: applies accepted values in log order
+    void apply_learned_commits();
+    void trim_accepted_values();
+    std::string pack_accepted_values(uint64_t after_index) const;
+    bool merge_accepted_values(const Message& promise, QuorumState& round);
+    void apply_write(const std::string& key, const std::string& value, bool batch);
+    void step_down(uint64_t observed_ballot);
+    void extend_lease(uint64_t round_start_us);
+    bool can_serve_reads() const;
+    bool defers_to_leader() const;
+    bool refuse_for_leader(const Message& request, Message& response);
+    bool serve_linearizable_read(const std::string& key, std::string& value, bool& found,
+                                 std::chrono::steady_clock::time_point deadline);
+    bool confirm_read_index(std::chrono::steady_clock::time_point deadline);
     void cleanup_expired_proposals();
     
-    bool send_prepare_messages(uint64_t proposal_number, const std::string& key);
-    bool send_accept_messages(uint64_t proposal_number, const std::string& key, const std::string& value);
+    bool send_prepare_messages(uint64_t proposal_number, uint64_t ballot, const std::string& key,
+                               uint64_t commit_index = 0);
+    bool send_accept_messages(uint64_t ballot, uint64_t log_index, const std::string& key,
+                              const std::string& value, bool batch);
+    void send_commit_messages(uint64_t ballot, uint64_t commit_index);
     
     size_t calculate_optimal_quorum_size();
     bool can_use_fast_path(const Message& request);
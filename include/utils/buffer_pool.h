@@ -0,0 +1,50 @@
+#pragma once
+
+#include "bounded_queue.h"
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace replication {
+
+// Recycles std::string buffers, so frames serialized at a steady rate reuse
+// capacity instead of allocating per message. Free buffers sit in a
+// lock-free ring; a buffer released into a full pool, or grown past
+// max_capacity, is simply freed.
+class BufferPool {
+public:
+    explicit BufferPool(size_t max_buffers = 1024, size_t max_capacity = 256 * 1024)
+        : free_(max_buffers), max_capacity_(max_capacity), reused_(0) {}
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Empty, but keeps whatever capacity it was released with
+    std::string acquire() {
+        std::string buffer;
+        if (free_.try_pop(buffer)) {
+            reused_.fetch_add(1, std::memory_order_relaxed);
+            buffer.clear();
+        }
+        return buffer;
+    }
+
+    void release(std::string buffer) {
+        // Short-string buffers own no heap memory worth keeping
+        static const size_t inline_capacity = std::string().capacity();
+        if (buffer.capacity() <= inline_capacity || buffer.capacity() > max_capacity_) {
+            return;
+        }
+        free_.try_push(std::move(buffer));
+    }
+
+    size_t get_reuse_count() const { return reused_.load(std::memory_order_relaxed); }
+
+private:
+    BoundedQueue<std::string> free_;
+    size_t max_capacity_;
+    std::atomic<size_t> reused_;
+};
+
+} // namespace replication
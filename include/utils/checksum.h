@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace replication {
+
+// CRC-32 (IEEE polynomial, reflected), table-driven. Used to spot torn or
+// corrupt records in on-disk files, not as a cryptographic digest. Pass the
+// previous result as `crc` to checksum data in pieces.
+inline uint32_t crc32(const void* data, size_t length, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? (0xEDB88320U ^ (value >> 1)) : (value >> 1);
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+} // namespace replication
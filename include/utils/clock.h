@@ -0,0 +1,20 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace replication {
+
+// Monotonic timestamps for latency accounting and deadlines. steady_clock
+// is vDSO-backed (TSC on x86) so a read costs ~20ns and never jumps with
+// wall-clock adjustments. Values are only meaningful as differences.
+inline uint64_t monotonic_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t monotonic_now_us() {
+    return monotonic_now_ns() / 1000;
+}
+
+} // namespace replication
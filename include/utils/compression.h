@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace replication {
+
+// Wire ids; a peer's codec offer is a bit mask of (1 << id)
+enum class CompressionCodec : uint8_t {
+    NONE = 0,
+    LZ = 1,   // built in: byte-oriented LZ77, cheap on CPU
+    ZLIB = 2  // only with REPLICATION_WITH_ZLIB; smaller output, more CPU
+};
+
+// One block compression algorithm. Implementations are stateless, so one
+// instance serves every thread.
+class FrameCodec {
+public:
+    virtual ~FrameCodec() = default;
+
+    virtual CompressionCodec id() const = 0;
+    virtual const char* name() const = 0;
+    // Appends the compressed form of data to out; false, leaving out as it
+    // was, if the codec failed
+    virtual bool compress(const char* data, size_t size, std::string& out) const = 0;
+    // Appends exactly raw_size bytes to out; false if data is corrupt or
+    // does not expand to raw_size
+    virtual bool decompress(const char* data, size_t size, size_t raw_size, std::string& out) const = 0;
+};
+
+// nullptr for NONE and for codecs this build does not include
+const FrameCodec* find_codec(CompressionCodec id);
+// Bit mask of the codecs find_codec() can return
+uint32_t supported_codecs();
+const char* codec_name(CompressionCodec id);
+
+} // namespace replication
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace replication {
+namespace durable_file {
+
+// Persists file data (not necessarily metadata such as mtime). macOS only
+// reaches the platter with F_FULLFSYNC.
+inline bool sync_data(int fd) {
+#ifdef __APPLE__
+    return fcntl(fd, F_FULLFSYNC) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+// Makes a create, rename or unlink inside the directory durable
+inline bool sync_directory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+inline bool ensure_directory(const std::string& directory) {
+    if (::mkdir(directory.c_str(), 0755) == 0) {
+        return true;
+    }
+    struct stat info;
+    return errno == EEXIST && ::stat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+inline bool write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// <directory>/<prefix><number, zero-padded so names sort numerically><suffix>
+inline std::string numbered_path(const std::string& directory, const char* prefix, uint64_t number,
+                                 const char* suffix) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%020" PRIu64 "%s", prefix, number, suffix);
+    return directory + "/" + name;
+}
+
+// Numbers of every <prefix><number><suffix> file in the directory, ascending
+inline std::vector<uint64_t> list_numbered(const std::string& directory, const char* prefix, const char* suffix) {
+    std::vector<uint64_t> numbers;
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) {
+        return numbers;
+    }
+    size_t prefix_length = std::strlen(prefix);
+    size_t suffix_length = std::strlen(suffix);
+    while (struct dirent* entry = ::readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= prefix_length + suffix_length ||
+            name.compare(0, prefix_length, prefix) != 0 ||
+            name.compare(name.size() - suffix_length, suffix_length, suffix) != 0) {
+            continue;
+        }
+        std::string digits = name.substr(prefix_length, name.size() - prefix_length - suffix_length);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        numbers.push_back(std::strtoull(digits.c_str(), nullptr, 10));
+    }
+    ::closedir(dir);
+    std::sort(numbers.begin(), numbers.end());
+    return numbers;
+}
+
+} // namespace durable_file
+} // namespace replication
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "clock.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace replication {
+
+enum class PeerLiveness {
+    UNKNOWN, // not watched or heard from yet
+    ALIVE,
+    SUSPECT, // phi past suspect_phi
+    FAILED   // phi past fail_phi
+};
+
+struct FailureDetectorConfig {
+    uint64_t probe_interval_ms;    // an idle link gets a HEARTBEAT once nothing was sent for this long
+    double suspect_phi;
+    double fail_phi;
+    uint64_t min_std_deviation_ms; // floor on the spread, so a steady link does not turn hair-trigger
+    uint64_t acceptable_pause_ms;  // added to the expected gap, for GC or scheduling stalls
+
+    FailureDetectorConfig() : probe_interval_ms(1000), suspect_phi(5.0), fail_phi(8.0),
+                              min_std_deviation_ms(100), acceptable_pause_ms(0) {}
+};
+
+// Phi-accrual failure detector (Hayashibara et al.). Each peer keeps a ring
+// of the last kWindow gaps between frames from it; phi is -log10 of the
+// chance that a gap at least as long as the current silence occurs, under a
+// normal fit to that ring. phi 1 is a 10% chance of a false suspicion,
+// phi 8 one in 10^8.
+//
+// Any frame counts as a heartbeat, so a busy link needs no probes. Gaps
+// shorter than the probe interval are recorded as the probe interval, and
+// at most once per interval: a burst of traffic would otherwise teach the
+// detector to expect microsecond gaps and suspect the first idle one. Gaps
+// over kMaxGapIntervals probe intervals are outages rather than jitter and
+// are not recorded, so a peer that comes back is judged by its old rhythm.
+//
+// on_arrival() and on_send() are the hot paths: a shared lock and an atomic
+// store, plus the ring's mutex once per interval. estimate() walks the ring,
+// which is cheap at the rate the heartbeat thread asks.
+class PhiAccrualDetector {
+public:
+    static constexpr size_t kWindow = 128;
+    static constexpr uint64_t kMaxGapIntervals = 10;
+
+    struct Estimate {
+        PeerLiveness liveness;
+        double phi;
+        double mean_gap_ms;
+        double std_deviation_ms;
+        uint64_t silence_ms; // since the last frame from the peer
+        size_t samples;
+
+        Estimate() : liveness(PeerLiveness::UNKNOWN), phi(0.0), mean_gap_ms(0.0), std_deviation_ms(0.0),
+                     silence_ms(0), samples(0) {}
+    };
+
+    explicit PhiAccrualDetector(const FailureDetectorConfig& config = FailureDetectorConfig()) {
+        configure(config);
+    }
+
+    PhiAccrualDetector(const PhiAccrualDetector&) = delete;
+    PhiAccrualDetector& operator=(const PhiAccrualDetector&) = delete;
+
+    // Thresholds are read unsynchronized; change them before traffic flows
+    void configure(const FailureDetectorConfig& config) {
+        config_ = config;
+        probe_interval_us_.store(std::max<uint64_t>(config.probe_interval_ms, 1) * 1000);
+    }
+    const FailureDetectorConfig& get_config() const { return config_; }
+    // Safe at any time; supersedes config.probe_interval_ms
+    void set_probe_interval(uint64_t interval_ms) {
+        probe_interval_us_.store(std::max<uint64_t>(interval_ms, 1) * 1000);
+    }
+    uint64_t get_probe_interval_us() const { return probe_interval_us_.load(std::memory_order_relaxed); }
+
+    void on_arrival(uint32_t peer, uint64_t now_us = monotonic_now_us()) {
+        Peer& state = peer_state(peer);
+        uint64_t previous = state.last_arrival_us.exchange(now_us, std::memory_order_relaxed);
+        if (previous == 0) {
+            state.last_sample_us.store(now_us, std::memory_order_relaxed);
+            return; // the first frame only starts the clock
+        }
+        uint64_t interval = get_probe_interval_us();
+        uint64_t sampled = state.last_sample_us.load(std::memory_order_relaxed);
+        if (now_us < sampled + interval ||
+            !state.last_sample_us.compare_exchange_strong(sampled, now_us, std::memory_order_relaxed)) {
+            return;
+        }
+        uint64_t gap = now_us > previous ? now_us - previous : 0;
+        if (gap > interval * kMaxGapIntervals) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(state.mutex);
+        add_gap(state, std::max(gap, interval));
+    }
+
+    // Starts the clock for a peer not heard from yet, as if it had just
+    // spoken, so one that never does is still suspected in time
+    void watch(uint32_t peer, uint64_t now_us = monotonic_now_us()) {
+        Peer& state = peer_state(peer);
+        uint64_t never = 0;
+        if (state.last_arrival_us.compare_exchange_strong(never, now_us, std::memory_order_relaxed)) {
+            state.last_sample_us.store(now_us, std::memory_order_relaxed);
+        }
+    }
+
+    void on_send(uint32_t peer, uint64_t now_us = monotonic_now_us()) {
+        peer_state(peer).last_send_us.store(now_us, std::memory_order_relaxed);
+    }
+
+    // How long nothing was sent to the peer; a peer never sent to is idle
+    // since the epoch
+    uint64_t send_idle_us(uint32_t peer, uint64_t now_us = monotonic_now_us()) const {
+        Peer* state = find_peer(peer);
+        uint64_t last = state ? state->last_send_us.load(std::memory_order_relaxed) : 0;
+        return now_us > last ? now_us - last : 0;
+    }
+
+    double phi(uint32_t peer, uint64_t now_us = monotonic_now_us()) const {
+        return estimate(peer, now_us).phi;
+    }
+
+    PeerLiveness liveness(uint32_t peer, uint64_t now_us = monotonic_now_us()) const {
+        return estimate(peer, now_us).liveness;
+    }
+
+    Estimate estimate(uint32_t peer, uint64_t now_us = monotonic_now_us()) const {
+        Estimate result;
+        Peer* state = find_peer(peer);
+        uint64_t last = state ? state->last_arrival_us.load(std::memory_order_relaxed) : 0;
+        if (last == 0) {
+            return result;
+        }
+        uint64_t silence_us = now_us > last ? now_us - last : 0;
+
+        // Until gaps are known, expect one probe interval give or take a quarter
+        double interval = static_cast<double>(get_probe_interval_us());
+        double mean = interval;
+        double std_deviation = interval / 4;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            result.samples = state->count;
+            if (state->count > 0) {
+                double sum = 0.0;
+                for (size_t i = 0; i < state->count; ++i) {
+                    sum += static_cast<double>(state->gaps_us[i]);
+                }
+                mean = sum / static_cast<double>(state->count);
+                double squares = 0.0;
+                for (size_t i = 0; i < state->count; ++i) {
+                    double deviation = static_cast<double>(state->gaps_us[i]) - mean;
+                    squares += deviation * deviation;
+                }
+                std_deviation = std::sqrt(squares / static_cast<double>(state->count));
+            }
+        }
+        std_deviation = std::max(std_deviation, static_cast<double>(config_.min_std_deviation_ms) * 1000);
+
+        result.mean_gap_ms = mean / 1000;
+        result.std_deviation_ms = std_deviation / 1000;
+        result.silence_ms = silence_us / 1000;
+        result.phi = phi_of(static_cast<double>(silence_us),
+                            mean + static_cast<double>(config_.acceptable_pause_ms) * 1000, std_deviation);
+        result.liveness = result.phi >= config_.fail_phi    ? PeerLiveness::FAILED
+                          : result.phi >= config_.suspect_phi ? PeerLiveness::SUSPECT
+                                                              : PeerLiveness::ALIVE;
+        return result;
+    }
+
+    // The logistic approximation of the normal tail that Akka and Cassandra
+    // use; past the mean it is computed in log space so it never reaches
+    // infinity
+    static double phi_of(double elapsed, double mean, double std_deviation) {
+        double y = (elapsed - mean) / std_deviation;
+        double exponent = y * (1.5976 + 0.070566 * y * y);
+        if (elapsed > mean) {
+            return (exponent + std::log1p(std::exp(-exponent))) / std::log(10.0);
+        }
+        double e = std::exp(-exponent);
+        return -std::log10(1.0 - 1.0 / (1.0 + e));
+    }
+
+private:
+    struct Peer {
+        std::atomic<uint64_t> last_arrival_us{0}; // 0 = never
+        std::atomic<uint64_t> last_sample_us{0};
+        std::atomic<uint64_t> last_send_us{0};
+        mutable std::mutex mutex; // guards the ring
+        std::array<uint64_t, kWindow> gaps_us{};
+        size_t count = 0;
+        size_t next = 0;
+    };
+
+    static void add_gap(Peer& state, uint64_t gap_us) {
+        state.gaps_us[state.next] = gap_us;
+        state.next = (state.next + 1) % kWindow;
+        state.count = std::min(state.count + 1, kWindow);
+    }
+
+    Peer* find_peer(uint32_t peer) const {
+        std::shared_lock<std::shared_mutex> lock(peers_mutex_);
+        auto it = peers_.find(peer);
+        return it != peers_.end() ? it->second.get() : nullptr;
+    }
+
+    Peer& peer_state(uint32_t peer) {
+        if (Peer* state = find_peer(peer)) {
+            return *state;
+        }
+        std::unique_lock<std::shared_mutex> lock(peers_mutex_);
+        std::unique_ptr<Peer>& state = peers_[peer];
+        if (!state) {
+            state = std::make_unique<Peer>();
+        }
+        return *state;
+    }
+
+    FailureDetectorConfig config_;
+    std::atomic<uint64_t> probe_interval_us_;
+    // Peers are never removed, so pointers stay valid for the object's life
+    std::unordered_map<uint32_t, std::unique_ptr<Peer>> peers_;
+    mutable std::shared_mutex peers_mutex_;
+};
+
+inline const char* peer_liveness_name(PeerLiveness liveness) {
+    switch (liveness) {
+        case PeerLiveness::ALIVE: return "alive";
+        case PeerLiveness::SUSPECT: return "suspect";
+        case PeerLiveness::FAILED: return "failed";
+        default: return "unknown";
+    }
+}
+
+} // namespace replication
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace replication {
+
+// Count-min sketch with saturating counters. Once increment() reports the
+// sample is full, age() halves every counter so old popularity decays;
+// callers may also age on their own schedule and ignore the signal.
+//
+// increment() and estimate() may race with each other; relaxed load/store
+// updates can lose the odd increment, which is fine for an estimator.
+// age() is expected to be serialized by the caller.
+template <typename Counter, Counter kMax>
+class CountMinSketch {
+public:
+    static constexpr size_t kDepth = 4;
+    static constexpr Counter kMaxCount = kMax;
+
+    explicit CountMinSketch(size_t expected_items)
+        : width_(round_up_pow2(std::max<size_t>(expected_items, 16)))
+        , counters_(new std::atomic<Counter>[kDepth * width_])
+        , sample_size_(10 * width_)
+        , additions_(0) {
+        for (size_t i = 0; i < kDepth * width_; ++i) {
+            counters_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    CountMinSketch(const CountMinSketch&) = delete;
+    CountMinSketch& operator=(const CountMinSketch&) = delete;
+
+    // Returns true when the sketch is due for aging (see age())
+    bool increment(uint64_t hash) {
+        bool added = false;
+        for (size_t row = 0; row < kDepth; ++row) {
+            std::atomic<Counter>& counter = counters_[row * width_ + index_for(hash, row)];
+            Counter value = counter.load(std::memory_order_relaxed);
+            if (value < kMaxCount) {
+                counter.store(static_cast<Counter>(value + 1), std::memory_order_relaxed);
+                added = true;
+            }
+        }
+        if (!added) {
+            return false;
+        }
+        uint64_t additions = additions_.load(std::memory_order_relaxed) + 1;
+        additions_.store(additions, std::memory_order_relaxed);
+        return additions >= sample_size_;
+    }
+
+    Counter estimate(uint64_t hash) const {
+        Counter result = kMaxCount;
+        for (size_t row = 0; row < kDepth; ++row) {
+            result = std::min(result, counters_[row * width_ + index_for(hash, row)].load(std::memory_order_relaxed));
+        }
+        return result;
+    }
+
+    // Halves every counter
+    void age() {
+        for (size_t i = 0; i < kDepth * width_; ++i) {
+            counters_[i].store(static_cast<Counter>(counters_[i].load(std::memory_order_relaxed) >> 1),
+                               std::memory_order_relaxed);
+        }
+        additions_.store(additions_.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    size_t index_for(uint64_t hash, size_t row) const {
+        static constexpr uint64_t kSeeds[kDepth] = {
+            0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL,
+            0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+        };
+        // Full splitmix64 finalizer per row so rows collide independently
+        uint64_t mixed = hash + kSeeds[row];
+        mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+        mixed ^= mixed >> 31;
+        return static_cast<size_t>(mixed) & (width_ - 1);
+    }
+
+    const size_t width_;
+    std::unique_ptr<std::atomic<Counter>[]> counters_;
+    const uint64_t sample_size_;
+    std::atomic<uint64_t> additions_;
+};
+
+// TinyLFU's 4-bit counters, stored one per byte; used for cache admission
+using FrequencySketch = CountMinSketch<uint8_t, 15>;
+
+} // namespace replication
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "frequency_sketch.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace replication {
+
+// Time-decayed read and write counts per key, kept in a pair of count-min
+// sketches so memory stays fixed however large the keyspace is. Every
+// half-life all counts are halved, so a key that cools down stops looking
+// hot within a few half-lives. Estimates only ever over-count (by
+// collisions), which errs towards treating a cold key as warm.
+class HotKeyTracker {
+public:
+    struct Heat {
+        uint32_t reads;
+        uint32_t writes;
+
+        Heat() : reads(0), writes(0) {}
+        uint32_t total() const { return reads + writes; }
+    };
+
+    explicit HotKeyTracker(size_t expected_keys = 4096, uint64_t half_life_us = 1000000)
+        : reads_(expected_keys)
+        , writes_(expected_keys)
+        , half_life_us_(half_life_us)
+        , last_decay_us_(0)
+        , total_reads_(0)
+        , total_writes_(0) {}
+
+    HotKeyTracker(const HotKeyTracker&) = delete;
+    HotKeyTracker& operator=(const HotKeyTracker&) = delete;
+
+    void record_read(const std::string& key, uint64_t now_us) {
+        maybe_decay(now_us);
+        reads_.increment(std::hash<std::string>()(key));
+        total_reads_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_write(const std::string& key, uint64_t now_us) {
+        maybe_decay(now_us);
+        writes_.increment(std::hash<std::string>()(key));
+        total_writes_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Heat heat(const std::string& key) const {
+        uint64_t hash = std::hash<std::string>()(key);
+        Heat result;
+        result.reads = reads_.estimate(hash);
+        result.writes = writes_.estimate(hash);
+        return result;
+    }
+
+    // Decayed reads per write across all keys
+    double read_write_ratio() const {
+        uint64_t writes = total_writes_.load(std::memory_order_relaxed);
+        uint64_t reads = total_reads_.load(std::memory_order_relaxed);
+        if (writes == 0) {
+            return reads > 0 ? static_cast<double>(reads) : 1.0;
+        }
+        return static_cast<double>(reads) / writes;
+    }
+
+    void set_half_life_us(uint64_t half_life_us) { half_life_us_.store(half_life_us, std::memory_order_relaxed); }
+
+private:
+    using Sketch = CountMinSketch<uint32_t, UINT32_MAX>;
+
+    void maybe_decay(uint64_t now_us) {
+        uint64_t last = last_decay_us_.load(std::memory_order_relaxed);
+        if (last == 0) {
+            last_decay_us_.compare_exchange_strong(last, now_us, std::memory_order_relaxed);
+            return;
+        }
+        if (now_us < last + half_life_us_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        // Whoever wins the exchange ages; everyone else keeps counting
+        if (!last_decay_us_.compare_exchange_strong(last, now_us, std::memory_order_relaxed)) {
+            return;
+        }
+        reads_.age();
+        writes_.age();
+        total_reads_.store(total_reads_.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+        total_writes_.store(total_writes_.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+    }
+
+    Sketch reads_;
+    Sketch writes_;
+    std::atomic<uint64_t> half_life_us_;
+    std::atomic<uint64_t> last_decay_us_;
+    std::atomic<uint64_t> total_reads_;
+    std::atomic<uint64_t> total_writes_;
+};
+
+} // namespace replication
@@ -1,9 +1,21 @@
 #pragma once
 
+#include "bounded_queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <string>
 #include <fstream>
 #include <mutex>
 #include <iostream>
+#include <memory>
+#include <thread>
+
+// Messages below this level are compiled out of LOG_* call sites entirely
+// (0=DEBUG ... 4=CRITICAL). Release builds set it to 1 to drop DEBUG.
+#ifndef REPLICATION_MIN_LOG_LEVEL
+#define REPLICATION_MIN_LOG_LEVEL 0
+#endif
 
 namespace replication {
 
@@ -22,7 +34,20 @@ public:
     void setLogLevel(LogLevel level);
     void setLogFile(const std::string& filename);
     
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= currentLevel_.load(std::memory_order_relaxed);
+    }
+    
+    // Hands formatting and I/O to a background writer. Records are queued in
+    // a bounded ring; when it is full, records are dropped and counted.
+    void enableAsync(size_t capacity = 8192);
+    void disableAsync();
+    bool isAsync() const { return async_enabled_.load(std::memory_order_acquire); }
+    void flush();
+    uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    
     void log(LogLevel level, const std::string& message);
+    void log(LogLevel level, std::string&& message);
     void debug(const std::string& message);
     void info(const std::string& message);
     void warning(const std::string& message);
@@ -30,24 +55,53 @@ public:
     void critical(const std::string& message);
 
 private:
+    struct LogRecord {
+        LogLevel level;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+    
     Logger() = default;
-    ~Logger() = default;
+    ~Logger();
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
     
-    LogLevel currentLevel_ = LogLevel::INFO;
+    std::atomic<int> currentLevel_{static_cast<int>(LogLevel::INFO)};
     std::ofstream logFile_;
     std::mutex logMutex_;
     
-    std::string getCurrentTimestamp() const;
+    // Asynchronous sink
+    std::unique_ptr<BoundedQueue<LogRecord>> queue_;
+    std::atomic<bool> async_enabled_{false};
+    std::atomic<bool> writer_stopping_{false};
+    std::atomic<bool> writer_idle_{false};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> written_{0};
+    std::thread writer_thread_;
+    std::mutex writer_mutex_;
+    std::condition_variable writer_cv_;
+    
+    void writerLoop();
+    void write(const LogRecord& record);
+    std::string formatTimestamp(std::chrono::system_clock::time_point time) const;
     std::string logLevelToString(LogLevel level) const;
 };
 
-// Convenience macros
-#define LOG_DEBUG(msg) Logger::getInstance().debug(msg)
-#define LOG_INFO(msg) Logger::getInstance().info(msg)
-#define LOG_WARNING(msg) Logger::getInstance().warning(msg)
-#define LOG_ERROR(msg) Logger::getInstance().error(msg)
-#define LOG_CRITICAL(msg) Logger::getInstance().critical(msg)
+} // namespace replication
+
+// Convenience macros. The message expression is only evaluated when the
+// level survives both the compile-time floor and the runtime level.
+#define REPLICATION_LOG(level, msg) \
+    do { \
+        if (static_cast<int>(level) >= REPLICATION_MIN_LOG_LEVEL && \
+            ::replication::Logger::getInstance().isEnabled(level)) { \
+            ::replication::Logger::getInstance().log(level, msg); \
+        } \
+    } while (0)
 
-} // namespace replication 
\ No newline at end of file
+#define LOG_DEBUG(msg) REPLICATION_LOG(::replication::LogLevel::DEBUG, msg)
+#define LOG_INFO(msg) REPLICATION_LOG(::replication::LogLevel::INFO, msg)
+#define LOG_WARNING(msg) REPLICATION_LOG(::replication::LogLevel::WARNING, msg)
+#define LOG_ERROR(msg) REPLICATION_LOG(::replication::LogLevel::ERROR, msg)
+#define LOG_CRITICAL(msg) REPLICATION_LOG(::replication::LogLevel::CRITICAL, msg)
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace replication {
+
+// Unbounded lock-free multi-producer / single-consumer queue (Vyukov).
+// push() may be called from any thread; pop() must only be called by one
+// consumer at a time (callers serialize consumers externally).
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        T discarded;
+        while (pop(discarded)) {}
+        delete tail_;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    bool pop(T& value) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+
+        value = std::move(next->value);
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+
+    bool empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next;
+        T value;
+
+        Node() : next(nullptr) {}
+        explicit Node(T v) : next(nullptr), value(std::move(v)) {}
+    };
+
+    std::atomic<Node*> head_;
+    Node* tail_; // consumer-owned
+};
+
+} // namespace replication
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "clock.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace replication {
+
+// Per-peer round-trip and load telemetry. Each peer keeps two fixed-size
+// rings: the last kRttSamples round trips, and the send times of requests
+// still awaiting a reply (matched by token), whose live entries are the
+// peer's outstanding-request count. Nothing allocates after a peer's first
+// sample.
+//
+// A peer's load score is its smoothed RTT scaled by one plus its
+// outstanding requests, so a fast peer that is already backed up loses to
+// a slightly slower idle one. Peers never sampled are scored with
+// kDefaultRttUs so they get tried.
+class PeerTelemetry {
+public:
+    static constexpr size_t kRttSamples = 64;
+    static constexpr size_t kPendingSlots = 256;
+    static constexpr uint64_t kDefaultRttUs = 1000;
+
+    struct PeerStats {
+        uint64_t samples;
+        double ewma_rtt_us;
+        double mean_rtt_us;   // over the sample ring
+        uint64_t max_rtt_us;  // over the sample ring
+        size_t outstanding;
+
+        PeerStats() : samples(0), ewma_rtt_us(0.0), mean_rtt_us(0.0), max_rtt_us(0), outstanding(0) {}
+    };
+
+    PeerTelemetry() : selection_seed_(0x9E3779B97F4A7C15ULL) {}
+
+    PeerTelemetry(const PeerTelemetry&) = delete;
+    PeerTelemetry& operator=(const PeerTelemetry&) = delete;
+
+    // Distinguishes request kinds that share a numbering space with one peer
+    static uint64_t token(uint32_t kind, uint64_t id) { return (static_cast<uint64_t>(kind) << 56) ^ id; }
+
+    void on_request_sent(uint32_t peer, uint64_t token) {
+        Peer& state = peer_state(peer);
+        std::lock_guard<std::mutex> lock(state.mutex);
+        PendingRequest& slot = state.pending[slot_for(token)];
+        if (slot.sent_us != 0) {
+            --state.outstanding; // overwritten before a reply; treat as lost
+        }
+        slot.token = token;
+        slot.sent_us = monotonic_now_us();
+        ++state.outstanding;
+    }
+
+    // Returns false if the request was not tracked (or already answered)
+    bool on_reply_received(uint32_t peer, uint64_t token) {
+        Peer* state = find_peer(peer);
+        if (!state) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(state->mutex);
+        PendingRequest& slot = state->pending[slot_for(token)];
+        if (slot.sent_us == 0 || slot.token != token) {
+            return false;
+        }
+        uint64_t now = monotonic_now_us();
+        add_sample(*state, now > slot.sent_us ? now - slot.sent_us : 0);
+        slot.sent_us = 0;
+        --state->outstanding;
+        return true;
+    }
+
+    // RTT measured outside the request/reply matching (e.g. by the transport)
+    void record_rtt(uint32_t peer, uint64_t rtt_us) {
+        Peer& state = peer_state(peer);
+        std::lock_guard<std::mutex> lock(state.mutex);
+        add_sample(state, rtt_us);
+    }
+
+    PeerStats get_stats(uint32_t peer) const {
+        PeerStats stats;
+        Peer* state = find_peer(peer);
+        if (!state) {
+            return stats;
+        }
+        std::lock_guard<std::mutex> lock(state->mutex);
+        stats.samples = state->samples;
+        stats.ewma_rtt_us = state->ewma_rtt_us;
+        stats.outstanding = state->outstanding;
+        size_t filled = static_cast<size_t>(std::min<uint64_t>(state->samples, kRttSamples));
+        uint64_t total = 0;
+        for (size_t i = 0; i < filled; ++i) {
+            total += state->rtt_us[i];
+            stats.max_rtt_us = std::max(stats.max_rtt_us, state->rtt_us[i]);
+        }
+        stats.mean_rtt_us = filled > 0 ? static_cast<double>(total) / filled : 0.0;
+        return stats;
+    }
+
+    double load_score(uint32_t peer) const {
+        Peer* state = find_peer(peer);
+        if (!state) {
+            return static_cast<double>(kDefaultRttUs);
+        }
+        std::lock_guard<std::mutex> lock(state->mutex);
+        double rtt = state->samples > 0 ? state->ewma_rtt_us : static_cast<double>(kDefaultRttUs);
+        return rtt * static_cast<double>(1 + state->outstanding);
+    }
+
+    // Power of two choices: the better-scored of two random candidates.
+    // Returns 0 if there are none.
+    uint32_t pick_two(const std::vector<uint32_t>& candidates) {
+        if (candidates.empty()) {
+            return 0;
+        }
+        if (candidates.size() == 1) {
+            return candidates[0];
+        }
+        uint64_t draw = next_random();
+        size_t first = static_cast<size_t>(draw % candidates.size());
+        size_t second = static_cast<size_t>((draw >> 32) % (candidates.size() - 1));
+        if (second >= first) {
+            ++second;
+        }
+        return load_score(candidates[second]) < load_score(candidates[first]) ? candidates[second]
+                                                                               : candidates[first];
+    }
+
+    // Candidates ordered best first
+    std::vector<uint32_t> rank(const std::vector<uint32_t>& candidates) const {
+        std::vector<std::pair<double, uint32_t>> scored;
+        scored.reserve(candidates.size());
+        for (uint32_t peer : candidates) {
+            scored.emplace_back(load_score(peer), peer);
+        }
+        std::stable_sort(scored.begin(), scored.end(),
+                         [](const std::pair<double, uint32_t>& a, const std::pair<double, uint32_t>& b) {
+                             return a.first < b.first;
+                         });
+        std::vector<uint32_t> ranked;
+        ranked.reserve(scored.size());
+        for (const auto& entry : scored) {
+            ranked.push_back(entry.second);
+        }
+        return ranked;
+    }
+
+private:
+    struct PendingRequest {
+        uint64_t token;
+        uint64_t sent_us; // 0 = free
+
+        PendingRequest() : token(0), sent_us(0) {}
+    };
+
+    struct Peer {
+        mutable std::mutex mutex;
+        std::array<uint64_t, kRttSamples> rtt_us{};
+        std::array<PendingRequest, kPendingSlots> pending;
+        uint64_t samples = 0;
+        double ewma_rtt_us = 0.0;
+        size_t outstanding = 0;
+    };
+
+    static size_t slot_for(uint64_t token) {
+        // Kinds live in the top byte; fold them into the slot index
+        return static_cast<size_t>((token ^ (token >> 56)) % kPendingSlots);
+    }
+
+    static void add_sample(Peer& state, uint64_t rtt_us) {
+        state.rtt_us[state.samples % kRttSamples] = rtt_us;
+        state.ewma_rtt_us = state.samples == 0 ? static_cast<double>(rtt_us)
+                                               : 0.8 * state.ewma_rtt_us + 0.2 * static_cast<double>(rtt_us);
+        ++state.samples;
+    }
+
+    Peer* find_peer(uint32_t peer) const {
+        std::shared_lock<std::shared_mutex> lock(peers_mutex_);
+        auto it = peers_.find(peer);
+        return it != peers_.end() ? it->second.get() : nullptr;
+    }
+
+    Peer& peer_state(uint32_t peer) {
+        if (Peer* state = find_peer(peer)) {
+            return *state;
+        }
+        std::unique_lock<std::shared_mutex> lock(peers_mutex_);
+        std::unique_ptr<Peer>& state = peers_[peer];
+        if (!state) {
+            state = std::make_unique<Peer>();
+        }
+        return *state;
+    }
+
+    uint64_t next_random() {
+        // splitmix64 over a shared counter; only needs to spread choices
+        uint64_t z = selection_seed_.fetch_add(0x9E3779B97F4A7C15ULL, std::memory_order_relaxed);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Peers are never removed, so pointers stay valid for the object's life
+    std::unordered_map<uint32_t, std::unique_ptr<Peer>> peers_;
+    mutable std::shared_mutex peers_mutex_;
+    std::atomic<uint64_t> selection_seed_;
+};
+
+} // namespace replication
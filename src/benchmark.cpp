@@ -1,29 +1,74 @@
 #include "core/node.h"
+#include "core/partition_map.h"
+#include "network/network_manager.h"
 #include "protocols/hybrid_protocol.h"
 #include "protocols/chain_replication.h"
 #include "protocols/quorum_replication.h"
+#include "protocols/partitioned_replication.h"
 #include "performance/metrics.h"
+#include "performance/workload.h"
+#include "utils/clock.h"
+#include "utils/compression.h"
+#include "utils/durable_file.h"
 #include "utils/logger.h"
 #include <iostream>
+#include <algorithm>
 #include <vector>
 #include <thread>
 #include <chrono>
 #include <random>
 #include <fstream>
 #include <iomanip>
+#include <limits>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
 using namespace replication;
 
+// Every heap allocation in the process goes through here, so a benchmark
+// can report allocations per operation from the counter's delta
+static std::atomic<uint64_t> g_allocation_count(0);
+
+void* operator new(size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    std::free(block);
+}
+
 struct BenchmarkConfig {
     int num_nodes = 5;
     int num_threads = 4;
     int operations_per_thread = 1000;
     double read_ratio = 0.7; // 70% reads, 30% writes
     int key_range = 1000;
-    int value_size = 100; // bytes
+    int value_size = 100; // bytes; the largest size for non-fixed distributions
+    int min_value_size = 1;
+    ValueSizeDistribution value_distribution = ValueSizeDistribution::FIXED;
     bool enable_batching = true;
     bool enable_caching = true;
     bool enable_compression = false;
+    int batch_size = 1; // keys per multi_get/multi_put; 1 issues single-key calls
+    int think_time_us = 0; // pause between a closed-loop thread's operations
+    std::string workloads; // YCSB letters to run, e.g. "ABF"; empty skips the suite
+    bool override_key_distribution = false;
+    KeyDistribution key_distribution = KeyDistribution::ZIPFIAN;
+    double target_ops_per_sec = 0; // > 0 runs YCSB phases open-loop with Poisson arrivals
+    bool latency_sweep = false;    // throughput-vs-latency curve per YCSB workload
+    int partitions = 0;            // > 0 benchmarks keyspace partitioning with this many
+    int replication_factor = 3;
+    std::string wal_directory; // empty skips the durability benchmark
     std::string output_file = "benchmark_results.json";
 };
 
@@ -44,6 +89,19 @@ public:
         std::cout << "  Read ratio: " << (config_.read_ratio * 100) << "%" << std::endl;
         std::cout << "  Key range: " << config_.key_range << std::endl;
         std::cout << "  Value size: " << config_.value_size << " bytes" << std::endl;
+        std::cout << "  Batch size: " << config_.batch_size << std::endl;
+        if (!config_.workloads.empty()) {
+            std::cout << "  YCSB workloads: " << config_.workloads;
+            if (config_.target_ops_per_sec > 0) {
+                std::cout << " at " << config_.target_ops_per_sec << " ops/sec offered";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "  Compression: " << (config_.enable_compression ? "on" : "off") << std::endl;
+        if (config_.partitions > 0) {
+            std::cout << "  Partitions: " << config_.partitions << ", replication factor "
+                      << config_.replication_factor << std::endl;
+        }
         std::cout << std::endl;
         
         // Test each protocol separately
@@ -53,6 +111,19 @@ public:
         
         // Run scalability tests
         auto scalability_results = benchmark_scalability();
+        storage_scaling_results_ = benchmark_storage_read_scaling();
+        if (!config_.wal_directory.empty()) {
+            durability_results_ = benchmark_durability();
+        }
+        if (config_.enable_compression) {
+            compression_results_ = benchmark_compression();
+        }
+        if (!config_.workloads.empty()) {
+            ycsb_results_ = benchmark_ycsb();
+        }
+        if (config_.partitions > 0) {
+            partitioning_results_ = benchmark_partitioning();
+        }
         
         // Run latency distribution test
         auto latency_results = benchmark_latency_distribution();
@@ -68,27 +139,92 @@ public:
 private:
     BenchmarkConfig config_;
     
+    struct ScalingPoint {
+        int threads;
+        double reads_per_sec;
+    };
+    std::vector<ScalingPoint> storage_scaling_results_;
+    
+    struct DurabilityPoint {
+        std::string policy;
+        double writes_per_sec;
+        double records_per_sync;
+        double restart_ms;
+        uint64_t restored_keys;
+    };
+    std::vector<DurabilityPoint> durability_results_;
+    
+    struct CompressionPoint {
+        std::string codec;
+        size_t value_bytes;
+        double ratio;
+        double compress_mb_per_sec;
+        double decompress_mb_per_sec;
+    };
+    std::vector<CompressionPoint> compression_results_;
+    
+    struct PartitioningPoint {
+        uint32_t partitions;
+        size_t min_leaders; // partitions led, over the configured nodes
+        size_t max_leaders;
+        double key_skew;    // keys in the fullest partition over the mean
+        double writes_per_sec;
+        double success_rate;
+    };
+    std::vector<PartitioningPoint> partitioning_results_;
+    
+    static constexpr size_t kWorkloadOperationKinds = 5;
+    
+    // One YCSB phase: the load, the measured run, or one sweep point
+    struct PhaseResult {
+        std::string workload;
+        std::string protocol;
+        std::string phase;
+        double target_ops_per_sec; // 0 for closed loop
+        double achieved_ops_per_sec;
+        double duration_sec;
+        uint64_t operations;
+        uint64_t failures;
+        // From the intended start to completion. Open-loop requests that
+        // start late because earlier ones stalled are charged the wait,
+        // which corrects for coordinated omission; closed-loop this is the
+        // service time.
+        LatencyHistogram::Snapshot latency;
+        LatencyHistogram::Snapshot service_time; // actual start to completion
+        std::array<uint64_t, kReplicationModeCount> mode_counts;
+        std::array<uint64_t, kWorkloadOperationKinds> operation_counts;
+        
+        PhaseResult() : target_ops_per_sec(0), achieved_ops_per_sec(0), duration_sec(0),
+                        operations(0), failures(0), mode_counts{}, operation_counts{} {}
+    };
+    std::vector<PhaseResult> ycsb_results_;
+    
     struct BenchmarkResults {
         std::string protocol_name;
         double throughput_ops_per_sec;
         double average_latency_ms;
         double p95_latency_ms;
         double p99_latency_ms;
+        double p50_latency_us;
+        double p999_latency_us;
+        double max_latency_us;
         double success_rate;
         double cpu_utilization;
         double memory_usage_mb;
         double network_utilization;
         int total_operations;
         double test_duration_sec;
+        double allocations_per_op;
         
         // Protocol-specific metrics
         double efficiency_score;
         double mode_switching_overhead;
         
         BenchmarkResults() : throughput_ops_per_sec(0), average_latency_ms(0),
-                           p95_latency_ms(0), p99_latency_ms(0), success_rate(0),
+                           p95_latency_ms(0), p99_latency_ms(0), p50_latency_us(0),
+                           p999_latency_us(0), max_latency_us(0), success_rate(0),
                            cpu_utilization(0), memory_usage_mb(0), network_utilization(0),
-                           total_operations(0), test_duration_sec(0),
+                           total_operations(0), test_duration_sec(0), allocations_per_op(0),
                            efficiency_score(0), mode_switching_overhead(0) {}
     };
     
@@ -105,23 +241,11 @@ private:
         }
         
         auto node = std::make_shared<Node>(1, cluster_nodes);
-        node->start();
-        
-        std::shared_ptr<HybridProtocol> protocol;
-        if (mode == ReplicationMode::HYBRID_AUTO) {
-            protocol = std::make_shared<HybridProtocol>(node, cluster_nodes, cluster_nodes);
-            protocol->enable_intelligent_routing(true);
-            protocol->enable_load_balancing(true);
-            protocol->enable_caching(config_.enable_caching);
-            protocol->enable_request_batching(config_.enable_batching);
-        } else {
-            protocol = std::make_shared<HybridProtocol>(node, cluster_nodes, cluster_nodes);
-            protocol->set_read_preference(mode);
-            protocol->set_write_preference(mode);
-        }
+        std::shared_ptr<HybridProtocol> protocol = start_protocol(node, cluster_nodes, mode);
         
         // Run benchmark
-        auto start_time = std::chrono::high_resolution_clock::now();
+        auto start_time = std::chrono::steady_clock::now();
+        uint64_t allocations_before = g_allocation_count.load(std::memory_order_relaxed);
         
         std::vector<std::thread> workers;
         std::atomic<int> completed_ops(0);
@@ -141,15 +265,19 @@ private:
             worker.join();
         }
         
-        auto end_time = std::chrono::high_resolution_clock::now();
+        auto end_time = std::chrono::steady_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
             end_time - start_time).count();
+        uint64_t allocations = g_allocation_count.load(std::memory_order_relaxed) - allocations_before;
         
         // Collect results
         BenchmarkResults results;
         results.protocol_name = name;
         results.test_duration_sec = duration / 1000.0;
         results.total_operations = completed_ops.load();
+        if (results.total_operations > 0) {
+            results.allocations_per_op = static_cast<double>(allocations) / results.total_operations;
+        }
         
         if (g_performance_monitor) {
             PerformanceStats stats = g_performance_monitor->get_current_stats();
@@ -158,6 +286,11 @@ private:
             results.p95_latency_ms = stats.p95_latency_ms;
             results.p99_latency_ms = stats.p99_latency_ms;
             results.success_rate = stats.success_rate;
+            
+            LatencySummary latency = g_performance_monitor->get_overall_latency_summary();
+            results.p50_latency_us = latency.p50_ns / 1000.0;
+            results.p999_latency_us = latency.p999_ns / 1000.0;
+            results.max_latency_us = latency.max_ns / 1000.0;
             results.cpu_utilization = stats.cpu_utilization;
             results.memory_usage_mb = stats.memory_usage_mb;
             results.network_utilization = stats.network_utilization;
@@ -173,13 +306,33 @@ private:
         std::cout << "  Completed: " << results.total_operations << " operations" << std::endl;
         std::cout << "  Throughput: " << std::fixed << std::setprecision(2) 
                   << results.throughput_ops_per_sec << " ops/sec" << std::endl;
-        std::cout << "  Average latency: " << results.average_latency_ms << "ms" << std::endl;
+        std::cout << "  Average latency: " << results.average_latency_ms * 1000.0 << "us (p50 "
+                  << results.p50_latency_us << "us, p99.9 " << results.p999_latency_us << "us)" << std::endl;
         std::cout << "  Success rate: " << (results.success_rate * 100) << "%" << std::endl;
+        std::cout << "  Allocations: " << results.allocations_per_op << " per op" << std::endl;
         std::cout << std::endl;
         
         return results;
     }
     
+    std::shared_ptr<HybridProtocol> start_protocol(const std::shared_ptr<Node>& node,
+                                                   const std::vector<uint32_t>& cluster_nodes,
+                                                   ReplicationMode mode) {
+        node->get_network_manager()->enable_compression(config_.enable_compression);
+        node->start();
+        
+        auto protocol = std::make_shared<HybridProtocol>(node, cluster_nodes, cluster_nodes);
+        if (mode == ReplicationMode::HYBRID_AUTO) {
+            protocol->enable_intelligent_routing(true);
+            protocol->enable_load_balancing(true);
+            protocol->enable_caching(config_.enable_caching);
+            protocol->enable_request_batching(config_.enable_batching);
+        } else {
+            protocol->set_write_preference(mode);
+        }
+        return protocol;
+    }
+    
     void run_worker_thread(std::shared_ptr<HybridProtocol> protocol, int thread_id,
                           std::atomic<int>& completed_ops, std::atomic<int>& successful_ops) {
         std::random_device rd;
@@ -190,6 +343,11 @@ private:
         // Generate random value of specified size
         std::string value_template(config_.value_size, 'x');
         
+        if (config_.batch_size > 1) {
+            run_batched_worker_thread(protocol, thread_id, gen, value_template, completed_ops, successful_ops);
+            return;
+        }
+        
         for (int i = 0; i < config_.operations_per_thread; ++i) {
             uint64_t op_id = thread_id * config_.operations_per_thread + i;
             Message request;
@@ -202,7 +360,7 @@ private:
                 
                 TRACK_OPERATION(op_id, MessageType::READ_REQUEST, request.key);
                 bool success = protocol->process_read(request, response);
-                END_OPERATION(op_id, success, ReplicationMode::HYBRID_AUTO, 1);
+                END_OPERATION(op_id, success, HybridProtocol::get_last_mode_used(), 1);
                 
                 if (success) successful_ops.fetch_add(1);
             } else {
@@ -213,26 +371,80 @@ private:
                 
                 TRACK_OPERATION(op_id, MessageType::WRITE_REQUEST, request.key);
                 bool success = protocol->process_write(request, response);
-                END_OPERATION(op_id, success, ReplicationMode::HYBRID_AUTO, 1);
+                END_OPERATION(op_id, success, HybridProtocol::get_last_mode_used(), 1);
                 
                 if (success) successful_ops.fetch_add(1);
             }
             
             completed_ops.fetch_add(1);
             
-            // Small delay to simulate realistic load
-            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            if (config_.think_time_us > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(config_.think_time_us));
+            }
+        }
+    }
+    
+    // Same operation mix, issued batch_size keys at a time of one type. Each
+    // key is tracked as its own operation and sees the whole batch latency.
+    void run_batched_worker_thread(std::shared_ptr<HybridProtocol> protocol, int thread_id,
+                                   std::mt19937& gen, const std::string& value_template,
+                                   std::atomic<int>& completed_ops, std::atomic<int>& successful_ops) {
+        std::uniform_int_distribution<> key_dist(1, config_.key_range);
+        std::uniform_real_distribution<> op_dist(0.0, 1.0);
+        std::vector<Message> responses;
+        
+        for (int i = 0; i < config_.operations_per_thread; ) {
+            int count = std::min(config_.batch_size, config_.operations_per_thread - i);
+            uint64_t first_op = thread_id * config_.operations_per_thread + i;
+            
+            if (op_dist(gen) < config_.read_ratio) {
+                std::vector<std::string> keys;
+                for (int k = 0; k < count; ++k) {
+                    keys.push_back("bench_key_" + std::to_string(key_dist(gen)));
+                    TRACK_OPERATION(first_op + k, MessageType::READ_REQUEST, keys.back());
+                }
+                protocol->multi_get(keys, responses);
+            } else {
+                std::vector<std::pair<std::string, std::string>> entries;
+                for (int k = 0; k < count; ++k) {
+                    entries.emplace_back("bench_key_" + std::to_string(key_dist(gen)),
+                                         value_template + "_" + std::to_string(first_op + k));
+                    TRACK_OPERATION(first_op + k, MessageType::WRITE_REQUEST, entries.back().first);
+                }
+                protocol->multi_put(entries, responses);
+            }
+            
+            // A batch's keys split across protocols, so no single path applies
+            for (int k = 0; k < count; ++k) {
+                bool success = responses[k].success;
+                END_OPERATION(first_op + k, success, ReplicationMode::HYBRID_AUTO, 1);
+                if (success) successful_ops.fetch_add(1);
+            }
+            completed_ops.fetch_add(count);
+            i += count;
+            
+            // Same think time per request as the single-key loop
+            if (config_.think_time_us > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(config_.think_time_us));
+            }
         }
     }
     
     void monitor_progress(std::atomic<int>& completed_ops, 
-                         std::chrono::high_resolution_clock::time_point start_time) {
+                         std::chrono::steady_clock::time_point start_time) {
         int total_ops = config_.num_threads * config_.operations_per_thread;
         
+        // Polls finely so a short run is not padded out to the report interval,
+        // which would understate its throughput
+        auto next_report = start_time + std::chrono::seconds(2);
         while (completed_ops.load() < total_ops) {
-            std::this_thread::sleep_for(std::chrono::seconds(2));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            auto current_time = std::chrono::steady_clock::now();
+            if (current_time < next_report) {
+                continue;
+            }
+            next_report += std::chrono::seconds(2);
             
-            auto current_time = std::chrono::high_resolution_clock::now();
             auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
                 current_time - start_time).count();
             
@@ -269,6 +481,146 @@ private:
         return results;
     }
     
+    // Local read throughput against the storage engine alone, swept over
+    // thread counts up to the number of cores (or --threads if larger)
+    std::vector<ScalingPoint> benchmark_storage_read_scaling() {
+        std::cout << "Running storage read scaling benchmark..." << std::endl;
+        
+        std::vector<uint32_t> cluster_nodes = {1};
+        auto node = std::make_shared<Node>(1, cluster_nodes);
+        
+        std::vector<std::string> keys;
+        std::string value(config_.value_size, 'x');
+        for (int i = 1; i <= config_.key_range; ++i) {
+            keys.push_back("bench_key_" + std::to_string(i));
+            node->write(keys.back(), value);
+        }
+        
+        int max_threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), config_.num_threads);
+        std::vector<ScalingPoint> results;
+        
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            std::atomic<bool> stop(false);
+            std::atomic<uint64_t> total_reads(0);
+            std::vector<std::thread> readers;
+            
+            for (int t = 0; t < threads; ++t) {
+                readers.emplace_back([&, t]() {
+                    uint64_t reads = 0;
+                    size_t index = static_cast<size_t>(t) * 7919;
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        if (node->read_ref(keys[index++ % keys.size()])) {
+                            reads++;
+                        }
+                    }
+                    total_reads.fetch_add(reads);
+                });
+            }
+            
+            auto start_time = std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            stop.store(true);
+            for (auto& reader : readers) {
+                reader.join();
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            
+            ScalingPoint point;
+            point.threads = threads;
+            point.reads_per_sec = total_reads.load() / elapsed;
+            results.push_back(point);
+            
+            std::cout << "  " << threads << " threads: " << std::fixed << std::setprecision(0)
+                      << point.reads_per_sec << " reads/sec" << std::endl;
+            
+            if (threads < max_threads && threads * 2 > max_threads) {
+                threads = max_threads / 2; // Always finish on max_threads
+            }
+        }
+        
+        return results;
+    }
+    
+    // Write throughput through the WAL under each sync policy, then the time
+    // a fresh node takes to come back from the snapshot plus WAL tail
+    std::vector<DurabilityPoint> benchmark_durability() {
+        std::cout << "Running durability benchmark in " << config_.wal_directory << "..." << std::endl;
+        if (!durable_file::ensure_directory(config_.wal_directory)) {
+            std::cerr << "  Cannot create " << config_.wal_directory << std::endl;
+            return {};
+        }
+        
+        const std::pair<const char*, WalSyncPolicy> policies[] = {
+            {"per-op", WalSyncPolicy::PER_OP},
+            {"per-batch", WalSyncPolicy::PER_BATCH},
+            {"interval", WalSyncPolicy::INTERVAL}
+        };
+        std::vector<uint32_t> cluster_nodes = {1};
+        std::string value(config_.value_size, 'x');
+        std::vector<DurabilityPoint> results;
+        
+        for (const auto& policy : policies) {
+            DurabilityConfig durability;
+            durability.directory = config_.wal_directory + "/" + policy.first;
+            durability.sync_policy = policy.second;
+            // Snapshotted by hand midway, so the restart replays half the writes
+            durability.snapshot_interval_ops = 0;
+            
+            DurabilityPoint point;
+            point.policy = policy.first;
+            int total_writes = config_.num_threads * config_.operations_per_thread;
+            {
+                Node node(1, cluster_nodes);
+                if (!node.enable_durability(durability)) {
+                    std::cerr << "  Cannot use " << durability.directory << std::endl;
+                    continue;
+                }
+                uint64_t syncs_before = node.get_wal()->get_sync_count();
+                uint64_t records_before = node.get_wal()->get_record_count();
+                
+                std::atomic<int> issued(0);
+                std::vector<std::thread> writers;
+                auto start_time = std::chrono::steady_clock::now();
+                for (int t = 0; t < config_.num_threads; ++t) {
+                    writers.emplace_back([&]() {
+                        int op;
+                        while ((op = issued.fetch_add(1)) < total_writes) {
+                            node.write("bench_key_" + std::to_string(op % config_.key_range), value);
+                            if (op == total_writes / 2) {
+                                node.take_snapshot();
+                            }
+                        }
+                    });
+                }
+                for (auto& writer : writers) {
+                    writer.join();
+                }
+                double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+                
+                uint64_t syncs = node.get_wal()->get_sync_count() - syncs_before;
+                point.writes_per_sec = total_writes / elapsed;
+                point.records_per_sync = syncs > 0 ?
+                    static_cast<double>(node.get_wal()->get_record_count() - records_before) / syncs : 0.0;
+            }
+            
+            Node restarted(1, cluster_nodes);
+            if (!restarted.enable_durability(durability)) {
+                continue;
+            }
+            point.restart_ms = restarted.get_recovery_time_us() / 1000.0;
+            point.restored_keys = restarted.get_storage().size();
+            results.push_back(point);
+            
+            std::cout << "  " << std::left << std::setw(10) << point.policy << std::right << std::fixed
+                      << std::setprecision(0) << point.writes_per_sec << " writes/sec, "
+                      << std::setprecision(1) << point.records_per_sync << " records/sync, restart "
+                      << std::setprecision(2) << point.restart_ms << "ms (" << point.restored_keys << " keys)"
+                      << std::endl;
+        }
+        
+        return results;
+    }
+    
     std::vector<BenchmarkResults> benchmark_latency_distribution() {
         std::cout << "Running latency distribution benchmark..." << std::endl;
         
@@ -298,6 +650,420 @@ private:
         return results;
     }
     
+    // YCSB workloads against each protocol: a load phase inserting
+    // key_range records, then the measured run, closed-loop unless a
+    // target rate is set. The sweep offers open-loop load at fractions of
+    // the closed-loop capacity, to show where each protocol saturates.
+    std::vector<PhaseResult> benchmark_ycsb() {
+        std::vector<PhaseResult> results;
+        const std::pair<const char*, ReplicationMode> protocols[] = {
+            {"chain", ReplicationMode::CHAIN_ONLY},
+            {"quorum", ReplicationMode::QUORUM_ONLY},
+            {"hybrid", ReplicationMode::HYBRID_AUTO}
+        };
+        std::vector<uint32_t> cluster_nodes;
+        for (int i = 1; i <= config_.num_nodes; ++i) {
+            cluster_nodes.push_back(i);
+        }
+        uint64_t run_operations = static_cast<uint64_t>(config_.num_threads) * config_.operations_per_thread;
+        
+        for (char letter : config_.workloads) {
+            WorkloadSpec spec;
+            if (!WorkloadSpec::ycsb(letter, spec)) {
+                std::cerr << "Unknown YCSB workload '" << letter << "'" << std::endl;
+                continue;
+            }
+            if (config_.override_key_distribution) {
+                spec.key_distribution = config_.key_distribution;
+            }
+            spec.value_distribution = config_.value_distribution;
+            spec.max_value_size = std::max(1, config_.value_size);
+            spec.min_value_size = std::min(std::max(1, config_.min_value_size), config_.value_size);
+            std::cout << "Running " << spec.name << " (" << key_distribution_name(spec.key_distribution)
+                      << " keys)..." << std::endl;
+            
+            for (const auto& protocol_entry : protocols) {
+                auto node = std::make_shared<Node>(1, cluster_nodes);
+                std::shared_ptr<HybridProtocol> protocol = start_protocol(node, cluster_nodes, protocol_entry.second);
+                std::atomic<uint64_t> records(0);
+                
+                PhaseResult load = run_phase(*protocol, spec, records, config_.key_range, 0, true);
+                load.workload = spec.name;
+                load.protocol = protocol_entry.first;
+                load.phase = "load";
+                results.push_back(load);
+                print_phase(load);
+                
+                PhaseResult run = run_phase(*protocol, spec, records, run_operations, config_.target_ops_per_sec, false);
+                run.workload = spec.name;
+                run.protocol = protocol_entry.first;
+                run.phase = "run";
+                results.push_back(run);
+                print_phase(run);
+                
+                if (config_.latency_sweep) {
+                    double capacity = run.achieved_ops_per_sec;
+                    if (config_.target_ops_per_sec > 0) {
+                        capacity = run_phase(*protocol, spec, records, run_operations, 0, false).achieved_ops_per_sec;
+                    }
+                    for (double fraction : {0.25, 0.5, 0.75, 0.9, 1.0, 1.1, 1.25}) {
+                        PhaseResult point = run_phase(*protocol, spec, records, run_operations,
+                                                      capacity * fraction, false);
+                        point.workload = spec.name;
+                        point.protocol = protocol_entry.first;
+                        point.phase = "sweep";
+                        results.push_back(point);
+                        print_phase(point);
+                    }
+                }
+                
+                node->stop();
+            }
+        }
+        
+        return results;
+    }
+    
+    PhaseResult run_phase(HybridProtocol& protocol, const WorkloadSpec& spec, std::atomic<uint64_t>& records,
+                          uint64_t operations, double target_ops_per_sec, bool load) {
+        struct PhaseShard {
+            LatencyHistogram latency;
+            LatencyHistogram service_time;
+            std::array<uint64_t, kReplicationModeCount> mode_counts{};
+            std::array<uint64_t, kWorkloadOperationKinds> operation_counts{};
+            uint64_t failures = 0;
+        };
+        
+        g_performance_monitor->reset_metrics();
+        int threads = std::max(1, config_.num_threads);
+        std::vector<std::unique_ptr<PhaseShard>> shards;
+        for (int t = 0; t < threads; ++t) {
+            shards.push_back(std::make_unique<PhaseShard>());
+        }
+        std::string value_template(spec.max_value_size, 'x');
+        static std::atomic<uint64_t> phase_seed(1);
+        uint64_t seed = phase_seed.fetch_add(1) * 0x9E3779B97F4A7C15ULL;
+        
+        uint64_t start_ns = monotonic_now_ns();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            uint64_t thread_operations = operations / threads + (static_cast<uint64_t>(t) < operations % threads ? 1 : 0);
+            workers.emplace_back([&, t, thread_operations]() {
+                PhaseShard& shard = *shards[t];
+                WorkloadGenerator generator(spec, records, seed + t);
+                PoissonArrivals arrivals(target_ops_per_sec / threads, seed ^ (t + 1));
+                uint64_t intended_ns = start_ns;
+                
+                for (uint64_t i = 0; i < thread_operations; ++i) {
+                    if (target_ops_per_sec > 0) {
+                        // Arrivals keep their schedule however far behind the
+                        // thread falls; the backlog shows up as latency
+                        intended_ns += arrivals.next_gap_ns();
+                        wait_until_ns(intended_ns);
+                    }
+                    
+                    WorkloadOperation operation;
+                    if (load) {
+                        operation.kind = WorkloadOperationKind::INSERT;
+                        operation.key_index = generator.next_insert_key();
+                        operation.value_size = generator.next_value_size();
+                    } else {
+                        operation = generator.next();
+                    }
+                    
+                    uint64_t began_ns = monotonic_now_ns();
+                    if (target_ops_per_sec <= 0) {
+                        intended_ns = began_ns;
+                    }
+                    ReplicationMode mode = ReplicationMode::HYBRID_AUTO;
+                    bool success = execute_operation(protocol, operation, value_template, mode);
+                    uint64_t done_ns = monotonic_now_ns();
+                    
+                    shard.latency.record(done_ns - intended_ns);
+                    shard.service_time.record(done_ns - began_ns);
+                    shard.mode_counts[static_cast<size_t>(mode)]++;
+                    shard.operation_counts[static_cast<size_t>(operation.kind)]++;
+                    if (!success) {
+                        shard.failures++;
+                    }
+                    bool is_read = operation.kind == WorkloadOperationKind::READ ||
+                                   operation.kind == WorkloadOperationKind::SCAN;
+                    g_performance_monitor->record_operation(is_read ? MessageType::READ_REQUEST : MessageType::WRITE_REQUEST,
+                                                            mode, done_ns - intended_ns, success);
+                    
+                    if (target_ops_per_sec <= 0 && config_.think_time_us > 0) {
+                        std::this_thread::sleep_for(std::chrono::microseconds(config_.think_time_us));
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        
+        PhaseResult result;
+        result.target_ops_per_sec = target_ops_per_sec;
+        result.duration_sec = (monotonic_now_ns() - start_ns) / 1e9;
+        for (const auto& shard : shards) {
+            shard->latency.add_to(result.latency);
+            shard->service_time.add_to(result.service_time);
+            for (size_t i = 0; i < kReplicationModeCount; ++i) {
+                result.mode_counts[i] += shard->mode_counts[i];
+            }
+            for (size_t i = 0; i < kWorkloadOperationKinds; ++i) {
+                result.operation_counts[i] += shard->operation_counts[i];
+            }
+            result.failures += shard->failures;
+        }
+        result.operations = result.latency.count;
+        result.achieved_ops_per_sec = result.duration_sec > 0 ? result.operations / result.duration_sec : 0.0;
+        return result;
+    }
+    
+    // Sleeps most of the way, then yields: sleep alone overshoots by tens of
+    // microseconds, which would itself skew the arrival process
+    static void wait_until_ns(uint64_t deadline_ns) {
+        constexpr uint64_t kSpinWindowNs = 100000;
+        uint64_t now = monotonic_now_ns();
+        if (deadline_ns > now + kSpinWindowNs) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(deadline_ns - now - kSpinWindowNs));
+        }
+        while (monotonic_now_ns() < deadline_ns) {
+            std::this_thread::yield();
+        }
+    }
+    
+    // Scans read consecutive keys with one multi_get, since the protocols
+    // have no range read; their keys can take different paths, so they are
+    // attributed to HYBRID_AUTO
+    bool execute_operation(HybridProtocol& protocol, const WorkloadOperation& operation,
+                           const std::string& value_template, ReplicationMode& mode) {
+        Message request;
+        Message response;
+        request.key = WorkloadGenerator::key_name(operation.key_index);
+        
+        switch (operation.kind) {
+            case WorkloadOperationKind::READ: {
+                request.type = MessageType::READ_REQUEST;
+                bool success = protocol.process_read(request, response);
+                mode = HybridProtocol::get_last_mode_used();
+                return success;
+            }
+            case WorkloadOperationKind::SCAN: {
+                std::vector<std::string> keys;
+                for (size_t i = 0; i < operation.scan_length; ++i) {
+                    keys.push_back(WorkloadGenerator::key_name(operation.key_index + i));
+                }
+                std::vector<Message> responses;
+                protocol.multi_get(keys, responses);
+                mode = ReplicationMode::HYBRID_AUTO;
+                // Keys past the last record are simply absent
+                return std::any_of(responses.begin(), responses.end(),
+                                   [](const Message& scanned) { return scanned.success; });
+            }
+            case WorkloadOperationKind::READ_MODIFY_WRITE: {
+                request.type = MessageType::READ_REQUEST;
+                bool read = protocol.process_read(request, response);
+                request.type = MessageType::WRITE_REQUEST;
+                request.value = value_template.substr(0, operation.value_size);
+                Message write_response;
+                bool written = protocol.process_write(request, write_response);
+                mode = HybridProtocol::get_last_mode_used();
+                return read && written;
+            }
+            case WorkloadOperationKind::UPDATE:
+            case WorkloadOperationKind::INSERT:
+            default: {
+                request.type = MessageType::WRITE_REQUEST;
+                request.value = value_template.substr(0, operation.value_size);
+                bool success = protocol.process_write(request, response);
+                mode = HybridProtocol::get_last_mode_used();
+                return success;
+            }
+        }
+    }
+    
+    void print_phase(const PhaseResult& result) {
+        std::cout << "  " << std::left << std::setw(7) << result.protocol << std::setw(6) << result.phase
+                  << std::right << std::fixed << std::setprecision(0);
+        if (result.target_ops_per_sec > 0) {
+            std::cout << "offered " << result.target_ops_per_sec << ", ";
+        }
+        std::cout << result.achieved_ops_per_sec << " ops/sec, p50 " << std::setprecision(1)
+                  << result.latency.percentile(0.50) / 1000.0 << "us, p99 "
+                  << result.latency.percentile(0.99) / 1000.0 << "us, p99.9 "
+                  << result.latency.percentile(0.999) / 1000.0 << "us";
+        if (result.target_ops_per_sec > 0) {
+            std::cout << " (service p99 " << result.service_time.percentile(0.99) / 1000.0 << "us)";
+        }
+        if (result.failures > 0) {
+            std::cout << ", " << result.failures << " failed";
+        }
+        std::cout << std::endl;
+    }
+    
+    // JSON documents shaped like replicated values: repeated field names,
+    // varying numbers and short strings
+    static std::string make_json_value(size_t size, std::mt19937& gen) {
+        static const char* const names[] = {"alice", "bob", "carol", "dave", "erin", "frank"};
+        std::uniform_int_distribution<int> number(0, 99999);
+        std::string value = "[";
+        while (value.size() < size) {
+            value += "{\"id\":" + std::to_string(number(gen)) + ",\"owner\":\"" + names[number(gen) % 6] +
+                     "\",\"balance\":" + std::to_string(number(gen)) + "." + std::to_string(number(gen) % 100) +
+                     ",\"active\":" + (number(gen) % 2 ? "true" : "false") + "},";
+        }
+        value.resize(size);
+        return value;
+    }
+    
+    // Bandwidth against CPU for each codec built in, over the value sizes
+    // that replicate across WAN links. Frames under the network threshold
+    // are never compressed, so small values are not measured.
+    std::vector<CompressionPoint> benchmark_compression() {
+        std::cout << "Running compression benchmark..." << std::endl;
+        
+        std::mt19937 gen(42);
+        std::vector<CompressionPoint> results;
+        for (size_t value_bytes : {size_t(4 * 1024), size_t(16 * 1024), size_t(64 * 1024)}) {
+            std::vector<std::string> values;
+            for (int i = 0; i < 64; ++i) {
+                values.push_back(make_json_value(value_bytes, gen));
+            }
+            
+            for (uint32_t id = 1; id < 32; ++id) {
+                const FrameCodec* codec = find_codec(static_cast<CompressionCodec>(id));
+                if (!codec) {
+                    continue;
+                }
+                
+                std::vector<std::string> compressed(values.size());
+                size_t raw_total = 0;
+                size_t compressed_total = 0;
+                auto start_time = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < values.size(); ++i) {
+                    codec->compress(values[i].data(), values[i].size(), compressed[i]);
+                    raw_total += values[i].size();
+                    compressed_total += compressed[i].size();
+                }
+                double compress_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+                
+                std::string restored;
+                start_time = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < values.size(); ++i) {
+                    restored.clear();
+                    if (!codec->decompress(compressed[i].data(), compressed[i].size(), values[i].size(), restored) ||
+                        restored != values[i]) {
+                        std::cerr << "  " << codec->name() << " failed to round-trip a value" << std::endl;
+                    }
+                }
+                double decompress_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+                
+                CompressionPoint point;
+                point.codec = codec->name();
+                point.value_bytes = value_bytes;
+                point.ratio = compressed_total > 0 ? static_cast<double>(raw_total) / compressed_total : 0.0;
+                point.compress_mb_per_sec = compress_sec > 0 ? raw_total / compress_sec / (1024 * 1024) : 0.0;
+                point.decompress_mb_per_sec = decompress_sec > 0 ? raw_total / decompress_sec / (1024 * 1024) : 0.0;
+                results.push_back(point);
+                
+                std::cout << "  " << point.codec << " " << (value_bytes / 1024) << "KB: " << std::fixed
+                          << std::setprecision(2) << point.ratio << "x, " << std::setprecision(0)
+                          << point.compress_mb_per_sec << " MB/s compress, "
+                          << point.decompress_mb_per_sec << " MB/s decompress" << std::endl;
+            }
+        }
+        
+        return results;
+    }
+    
+    // Placement balance of the map across the configured nodes, and write
+    // throughput through one node hosting every group (replication factor
+    // 1, so the groups run locally) against a single group. Separate groups
+    // split the chain and Paxos locks, so concurrent writers stop queueing
+    // behind one leader.
+    std::vector<PartitioningPoint> benchmark_partitioning() {
+        std::cout << "Running partitioning benchmark..." << std::endl;
+        
+        std::vector<uint32_t> cluster_nodes;
+        for (int i = 1; i <= config_.num_nodes; ++i) {
+            cluster_nodes.push_back(i);
+        }
+        std::vector<PartitioningPoint> results;
+        for (uint32_t partitions : {1u, static_cast<uint32_t>(config_.partitions)}) {
+            if (!results.empty() && partitions == results.front().partitions) {
+                break;
+            }
+            PartitionConfig placement_config;
+            placement_config.partition_count = partitions;
+            placement_config.replication_factor = config_.replication_factor;
+            PartitionMap placement(cluster_nodes, placement_config);
+            
+            PartitioningPoint point;
+            point.partitions = partitions;
+            point.min_leaders = std::numeric_limits<size_t>::max();
+            point.max_leaders = 0;
+            for (uint32_t node_id : cluster_nodes) {
+                size_t led = placement.partitions_led_by(node_id).size();
+                point.min_leaders = std::min(point.min_leaders, led);
+                point.max_leaders = std::max(point.max_leaders, led);
+            }
+            std::vector<size_t> keys_per_partition(partitions, 0);
+            for (int i = 1; i <= config_.key_range; ++i) {
+                keys_per_partition[placement.partition_for("bench_key_" + std::to_string(i))]++;
+            }
+            double mean_keys = static_cast<double>(config_.key_range) / partitions;
+            point.key_skew = mean_keys > 0 ?
+                *std::max_element(keys_per_partition.begin(), keys_per_partition.end()) / mean_keys : 0.0;
+            
+            std::vector<uint32_t> local_cluster = {1};
+            auto node = std::make_shared<Node>(1, local_cluster);
+            PartitionConfig local_config;
+            local_config.partition_count = partitions;
+            local_config.replication_factor = 1;
+            auto groups = std::make_shared<PartitionedReplication>(node, local_config);
+            node->attach_partitions(groups);
+            node->start();
+            
+            std::atomic<uint64_t> successes(0);
+            std::vector<std::thread> writers;
+            auto start_time = std::chrono::steady_clock::now();
+            for (int t = 0; t < config_.num_threads; ++t) {
+                writers.emplace_back([&, t]() {
+                    std::mt19937 gen(t + 1);
+                    std::uniform_int_distribution<> key_dist(1, config_.key_range);
+                    std::string value(config_.value_size, 'x');
+                    uint64_t succeeded = 0;
+                    for (int op = 0; op < config_.operations_per_thread; ++op) {
+                        Message request;
+                        request.type = MessageType::WRITE_REQUEST;
+                        request.key = "bench_key_" + std::to_string(key_dist(gen));
+                        request.value = value;
+                        Message response;
+                        succeeded += groups->process_write(request, response);
+                    }
+                    successes.fetch_add(succeeded);
+                });
+            }
+            for (auto& writer : writers) {
+                writer.join();
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            node->stop();
+            
+            uint64_t operations = static_cast<uint64_t>(config_.num_threads) * config_.operations_per_thread;
+            point.writes_per_sec = elapsed > 0 ? operations / elapsed : 0.0;
+            point.success_rate = operations > 0 ? static_cast<double>(successes.load()) / operations : 0.0;
+            results.push_back(point);
+            
+            std::cout << "  " << partitions << " partitions: " << std::fixed << std::setprecision(0)
+                      << point.writes_per_sec << " writes/sec, " << point.min_leaders << "-" << point.max_leaders
+                      << " led per node, key skew " << std::setprecision(2) << point.key_skew << std::endl;
+        }
+        
+        return results;
+    }
+    
     void generate_report(const BenchmarkResults& chain_results,
                         const BenchmarkResults& quorum_results,
                         const BenchmarkResults& hybrid_results,
@@ -338,6 +1104,64 @@ private:
             }
         }
         
+        if (!storage_scaling_results_.empty()) {
+            std::cout << "\n--- Storage Read Scaling ---" << std::endl;
+            double baseline = storage_scaling_results_.front().reads_per_sec;
+            for (const auto& point : storage_scaling_results_) {
+                std::cout << point.threads << " threads: " << std::fixed << std::setprecision(0)
+                          << point.reads_per_sec << " reads/sec ("
+                          << std::setprecision(2) << (baseline > 0 ? point.reads_per_sec / baseline : 0.0)
+                          << "x)" << std::endl;
+            }
+        }
+        
+        if (!durability_results_.empty()) {
+            std::cout << "\n--- Durability (WAL + snapshots) ---" << std::endl;
+            for (const auto& point : durability_results_) {
+                std::cout << point.policy << ": " << std::fixed << std::setprecision(0)
+                          << point.writes_per_sec << " writes/sec, " << std::setprecision(1)
+                          << point.records_per_sync << " records/sync, restart in "
+                          << std::setprecision(2) << point.restart_ms << "ms" << std::endl;
+            }
+        }
+        
+        if (!compression_results_.empty()) {
+            std::cout << "\n--- Frame Compression ---" << std::endl;
+            for (const auto& point : compression_results_) {
+                // CPU spent per MB of wire traffic saved, both directions
+                double saved_fraction = point.ratio > 0 ? 1.0 - 1.0 / point.ratio : 0.0;
+                double cpu_ms_per_mb = point.compress_mb_per_sec > 0 && point.decompress_mb_per_sec > 0
+                    ? 1000.0 / point.compress_mb_per_sec + 1000.0 / point.decompress_mb_per_sec : 0.0;
+                std::cout << point.codec << " " << (point.value_bytes / 1024) << "KB: " << std::fixed
+                          << std::setprecision(2) << point.ratio << "x, "
+                          << std::setprecision(1) << (saved_fraction * 100) << "% bandwidth saved, "
+                          << std::setprecision(2) << cpu_ms_per_mb << "ms CPU per MB" << std::endl;
+            }
+        }
+        
+        if (!partitioning_results_.empty()) {
+            std::cout << "\n--- Keyspace Partitioning ---" << std::endl;
+            double baseline = partitioning_results_.front().writes_per_sec;
+            for (const auto& point : partitioning_results_) {
+                std::cout << point.partitions << " partitions: " << std::fixed << std::setprecision(0)
+                          << point.writes_per_sec << " writes/sec (" << std::setprecision(2)
+                          << (baseline > 0 ? point.writes_per_sec / baseline : 0.0) << "x), "
+                          << point.min_leaders << "-" << point.max_leaders << " partitions led per node of "
+                          << config_.num_nodes << ", fullest partition " << point.key_skew << "x the mean"
+                          << std::endl;
+            }
+        }
+        
+        if (!ycsb_results_.empty()) {
+            std::cout << "\n--- YCSB Workloads ---" << std::endl;
+            for (const auto& result : ycsb_results_) {
+                if (result.phase != "load") {
+                    std::cout << result.workload;
+                    print_phase(result);
+                }
+            }
+        }
+        
         // Generate JSON report
         generate_json_report(chain_results, quorum_results, hybrid_results,
                            scalability_results, latency_results, fault_results);
@@ -348,7 +1172,7 @@ private:
     void print_result_summary(const BenchmarkResults& result) {
         std::cout << std::left << std::setw(20) << result.protocol_name << ": "
                   << std::fixed << std::setprecision(0) << std::setw(8) << result.throughput_ops_per_sec << " ops/sec, "
-                  << std::setprecision(2) << std::setw(6) << result.average_latency_ms << "ms avg, "
+                  << std::setprecision(3) << std::setw(8) << result.average_latency_ms << "ms avg, "
                   << std::setprecision(1) << std::setw(5) << (result.success_rate * 100) << "% success"
                   << std::endl;
     }
@@ -373,7 +1197,12 @@ private:
         file << "    \"operations_per_thread\": " << config_.operations_per_thread << ",\n";
         file << "    \"read_ratio\": " << config_.read_ratio << ",\n";
         file << "    \"key_range\": " << config_.key_range << ",\n";
-        file << "    \"value_size\": " << config_.value_size << "\n";
+        file << "    \"value_size\": " << config_.value_size << ",\n";
+        file << "    \"batch_size\": " << config_.batch_size << ",\n";
+        file << "    \"compression\": " << (config_.enable_compression ? "true" : "false") << ",\n";
+        file << "    \"workloads\": \"" << config_.workloads << "\",\n";
+        file << "    \"target_ops_per_sec\": " << config_.target_ops_per_sec << ",\n";
+        file << "    \"think_time_us\": " << config_.think_time_us << "\n";
         file << "  },\n";
         
         file << "  \"protocol_comparison\": {\n";
@@ -392,6 +1221,78 @@ private:
         }
         file << "  ],\n";
         
+        file << "  \"storage_read_scaling\": [\n";
+        for (size_t i = 0; i < storage_scaling_results_.size(); ++i) {
+            file << "    {\"threads\": " << storage_scaling_results_[i].threads
+                 << ", \"reads_per_sec\": " << storage_scaling_results_[i].reads_per_sec << "}"
+                 << (i + 1 < storage_scaling_results_.size() ? "," : "") << "\n";
+        }
+        file << "  ],\n";
+        
+        file << "  \"durability\": [\n";
+        for (size_t i = 0; i < durability_results_.size(); ++i) {
+            const DurabilityPoint& point = durability_results_[i];
+            file << "    {\"sync_policy\": \"" << point.policy << "\", \"writes_per_sec\": " << point.writes_per_sec
+                 << ", \"records_per_sync\": " << point.records_per_sync
+                 << ", \"restart_ms\": " << point.restart_ms
+                 << ", \"restored_keys\": " << point.restored_keys << "}"
+                 << (i + 1 < durability_results_.size() ? "," : "") << "\n";
+        }
+        file << "  ],\n";
+        
+        file << "  \"compression\": [\n";
+        for (size_t i = 0; i < compression_results_.size(); ++i) {
+            const CompressionPoint& point = compression_results_[i];
+            file << "    {\"codec\": \"" << point.codec << "\", \"value_bytes\": " << point.value_bytes
+                 << ", \"ratio\": " << point.ratio
+                 << ", \"compress_mb_per_sec\": " << point.compress_mb_per_sec
+                 << ", \"decompress_mb_per_sec\": " << point.decompress_mb_per_sec << "}"
+                 << (i + 1 < compression_results_.size() ? "," : "") << "\n";
+        }
+        file << "  ],\n";
+        
+        file << "  \"partitioning\": [\n";
+        for (size_t i = 0; i < partitioning_results_.size(); ++i) {
+            const PartitioningPoint& point = partitioning_results_[i];
+            file << "    {\"partitions\": " << point.partitions
+                 << ", \"replication_factor\": " << config_.replication_factor
+                 << ", \"min_leaders_per_node\": " << point.min_leaders
+                 << ", \"max_leaders_per_node\": " << point.max_leaders
+                 << ", \"key_skew\": " << point.key_skew
+                 << ", \"writes_per_sec\": " << point.writes_per_sec
+                 << ", \"success_rate\": " << point.success_rate << "}"
+                 << (i + 1 < partitioning_results_.size() ? "," : "") << "\n";
+        }
+        file << "  ],\n";
+        
+        file << "  \"ycsb\": [\n";
+        for (size_t i = 0; i < ycsb_results_.size(); ++i) {
+            const PhaseResult& result = ycsb_results_[i];
+            file << "    {\n";
+            file << "      \"workload\": \"" << result.workload << "\",\n";
+            file << "      \"protocol\": \"" << result.protocol << "\",\n";
+            file << "      \"phase\": \"" << result.phase << "\",\n";
+            file << "      \"target_ops_per_sec\": " << result.target_ops_per_sec << ",\n";
+            file << "      \"achieved_ops_per_sec\": " << result.achieved_ops_per_sec << ",\n";
+            file << "      \"duration_sec\": " << result.duration_sec << ",\n";
+            file << "      \"operations\": " << result.operations << ",\n";
+            file << "      \"failures\": " << result.failures << ",\n";
+            file << "      \"operation_mix\": {";
+            for (size_t kind = 0; kind < kWorkloadOperationKinds; ++kind) {
+                file << (kind > 0 ? ", " : "") << "\""
+                     << workload_operation_name(static_cast<WorkloadOperationKind>(kind)) << "\": "
+                     << result.operation_counts[kind];
+            }
+            file << "},\n";
+            file << "      \"paths\": {\"chain\": " << result.mode_counts[static_cast<size_t>(ReplicationMode::CHAIN_ONLY)]
+                 << ", \"quorum\": " << result.mode_counts[static_cast<size_t>(ReplicationMode::QUORUM_ONLY)]
+                 << ", \"hybrid\": " << result.mode_counts[static_cast<size_t>(ReplicationMode::HYBRID_AUTO)] << "},\n";
+            write_json_histogram(file, "latency", result.latency, false);
+            write_json_histogram(file, "service_time", result.service_time, true);
+            file << "    }" << (i + 1 < ycsb_results_.size() ? "," : "") << "\n";
+        }
+        file << "  ],\n";
+        
         file << "  \"timestamp\": \"" << get_timestamp() << "\"\n";
         file << "}\n";
         
@@ -405,12 +1306,40 @@ private:
         file << "      \"average_latency_ms\": " << result.average_latency_ms << ",\n";
         file << "      \"p95_latency_ms\": " << result.p95_latency_ms << ",\n";
         file << "      \"p99_latency_ms\": " << result.p99_latency_ms << ",\n";
+        file << "      \"p50_latency_us\": " << result.p50_latency_us << ",\n";
+        file << "      \"p999_latency_us\": " << result.p999_latency_us << ",\n";
+        file << "      \"max_latency_us\": " << result.max_latency_us << ",\n";
         file << "      \"success_rate\": " << result.success_rate << ",\n";
         file << "      \"total_operations\": " << result.total_operations << ",\n";
-        file << "      \"test_duration_sec\": " << result.test_duration_sec << "\n";
+        file << "      \"test_duration_sec\": " << result.test_duration_sec << ",\n";
+        file << "      \"allocations_per_op\": " << result.allocations_per_op << "\n";
         file << "    }" << (is_last ? "" : ",") << "\n";
     }
     
+    // Percentiles plus the non-empty buckets as [upper bound ns, count] pairs
+    void write_json_histogram(std::ofstream& file, const std::string& name,
+                              const LatencyHistogram::Snapshot& histogram, bool is_last) {
+        file << "      \"" << name << "\": {\n";
+        file << "        \"mean_us\": " << histogram.mean() / 1000.0 << ",\n";
+        file << "        \"p50_us\": " << histogram.percentile(0.50) / 1000.0 << ",\n";
+        file << "        \"p95_us\": " << histogram.percentile(0.95) / 1000.0 << ",\n";
+        file << "        \"p99_us\": " << histogram.percentile(0.99) / 1000.0 << ",\n";
+        file << "        \"p999_us\": " << histogram.percentile(0.999) / 1000.0 << ",\n";
+        file << "        \"max_us\": " << histogram.max / 1000.0 << ",\n";
+        file << "        \"buckets\": [";
+        bool first = true;
+        for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+            if (histogram.counts[i] == 0) {
+                continue;
+            }
+            file << (first ? "" : ", ") << "[" << LatencyHistogram::bucket_upper_bound(i) << ", "
+                 << histogram.counts[i] << "]";
+            first = false;
+        }
+        file << "]\n";
+        file << "      }" << (is_last ? "" : ",") << "\n";
+    }
+    
     std::string get_timestamp() {
         auto now = std::chrono::system_clock::now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
@@ -424,7 +1353,9 @@ int main(int argc, char* argv[]) {
     // Set up logging
     Logger& logger = Logger::getInstance();
     logger.setLogLevel(LogLevel::INFO);
-    // Console output is enabled by default
+    // Console output is enabled by default; a background writer keeps it
+    // off the measured path
+    logger.enableAsync();
     
     BenchmarkConfig config;
     
@@ -439,6 +1370,41 @@ int main(int argc, char* argv[]) {
             config.operations_per_thread = std::stoi(argv[++i]);
         } else if (arg == "--read-ratio" && i + 1 < argc) {
             config.read_ratio = std::stod(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            config.batch_size = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--wal" && i + 1 < argc) {
+            config.wal_directory = argv[++i];
+        } else if (arg == "--workload" && i + 1 < argc) {
+            config.workloads = argv[++i];
+        } else if (arg == "--key-dist" && i + 1 < argc) {
+            if (!parse_key_distribution(argv[++i], config.key_distribution)) {
+                std::cerr << "Unknown key distribution: " << argv[i] << std::endl;
+                return 1;
+            }
+            config.override_key_distribution = true;
+        } else if (arg == "--value-size" && i + 1 < argc) {
+            config.value_size = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--min-value-size" && i + 1 < argc) {
+            config.min_value_size = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--value-dist" && i + 1 < argc) {
+            if (!parse_value_size_distribution(argv[++i], config.value_distribution)) {
+                std::cerr << "Unknown value size distribution: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--records" && i + 1 < argc) {
+            config.key_range = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            config.target_ops_per_sec = std::stod(argv[++i]);
+        } else if (arg == "--sweep") {
+            config.latency_sweep = true;
+        } else if (arg == "--think-us" && i + 1 < argc) {
+            config.think_time_us = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--compression") {
+            config.enable_compression = true;
+        } else if (arg == "--partitions" && i + 1 < argc) {
+            config.partitions = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--replication-factor" && i + 1 < argc) {
+            config.replication_factor = std::max(1, std::stoi(argv[++i]));
         } else if (arg == "--output" && i + 1 < argc) {
             config.output_file = argv[++i];
         } else if (arg == "--help") {
@@ -448,6 +1414,21 @@ int main(int argc, char* argv[]) {
                       << "  --threads N       Number of worker threads (default: 4)\n"
                       << "  --ops N           Operations per thread (default: 1000)\n"
                       << "  --read-ratio R    Read operation ratio 0-1 (default: 0.7)\n"
+                      << "  --batch N         Keys per multi_get/multi_put call (default: 1)\n"
+                      << "  --wal DIR         Benchmark WAL sync policies and restart in empty DIR\n"
+                      << "  --compression     Compress network frames and benchmark each codec\n"
+                      << "  --partitions N    Benchmark N keyspace partitions against one group\n"
+                      << "  --replication-factor N Replicas per partition (default: 3)\n"
+                      << "  --workload LIST   YCSB workloads to run per protocol, letters A-F (e.g. ABF)\n"
+                      << "  --key-dist D      YCSB key distribution: uniform, zipfian, latest, hotspot\n"
+                      << "                    (default: each workload's own)\n"
+                      << "  --records N       Keys loaded before each YCSB run (default: 1000)\n"
+                      << "  --value-size N    Value size, or the largest size (default: 100)\n"
+                      << "  --min-value-size N Smallest value size for uniform/zipfian (default: 1)\n"
+                      << "  --value-dist D    Value sizes: fixed, uniform, zipfian (default: fixed)\n"
+                      << "  --rate R          Run YCSB open-loop at R ops/sec, Poisson arrivals\n"
+                      << "  --sweep           Throughput-vs-latency curve per YCSB workload\n"
+                      << "  --think-us N      Closed-loop pause between operations (default: 0)\n"
                       << "  --output FILE     Output file (default: benchmark_results.json)\n"
                       << "  --help            Show this help\n" << std::endl;
             return 0;
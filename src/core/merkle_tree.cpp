@@ -0,0 +1,91 @@
+#include "core/merkle_tree.h"
+
+namespace replication {
+
+namespace {
+
+// FNV-1a: unlike std::hash, the same on every node and build
+uint64_t fnv1a(const std::string& data, uint64_t hash = 0xCBF29CE484222325ULL) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// splitmix64 finalizer, so sums and folds of hashes stay well spread
+uint64_t mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+const std::vector<std::string> kNoKeys;
+
+} // namespace
+
+static_assert(MerkleTree::kLeafCount == MerkleTree::kFanout * MerkleTree::kFanout * MerkleTree::kFanout,
+              "kLeafCount must be kFanout^kDepth");
+
+MerkleTree::MerkleTree() : key_count_(0) {
+    levels_.resize(kDepth + 1);
+    for (size_t level = 0; level <= kDepth; ++level) {
+        levels_[level].assign(level_width(level), 0);
+    }
+}
+
+size_t MerkleTree::level_width(size_t level) {
+    size_t width = 1;
+    for (size_t i = 0; i < level; ++i) {
+        width *= kFanout;
+    }
+    return width;
+}
+
+size_t MerkleTree::leaf_for(const std::string& key) {
+    return static_cast<size_t>(mix(fnv1a(key)) % kLeafCount);
+}
+
+uint64_t MerkleTree::entry_hash(const std::string& key, const std::string& value) {
+    return mix(fnv1a(key) ^ mix(fnv1a(value) + 0x9E3779B97F4A7C15ULL));
+}
+
+void MerkleTree::build(const StorageEngine& storage, bool keep_keys, const KeyFilter& filter) {
+    std::vector<uint64_t>& leaves = levels_[kDepth];
+    leaves.assign(kLeafCount, 0);
+    leaf_keys_.clear();
+    if (keep_keys) {
+        leaf_keys_.resize(kLeafCount);
+    }
+    key_count_ = 0;
+
+    storage.for_each([&](const std::string& key, const ValueRef& value) {
+        if (!value || (filter && !filter(key))) {
+            return;
+        }
+        size_t leaf = leaf_for(key);
+        leaves[leaf] += entry_hash(key, *value);
+        if (keep_keys) {
+            leaf_keys_[leaf].push_back(key);
+        }
+        ++key_count_;
+    });
+
+    for (size_t level = kDepth; level > 0; --level) {
+        const std::vector<uint64_t>& children = levels_[level];
+        std::vector<uint64_t>& parents = levels_[level - 1];
+        for (size_t parent = 0; parent < parents.size(); ++parent) {
+            uint64_t hash = mix(level);
+            for (size_t child = 0; child < kFanout; ++child) {
+                hash = mix(hash ^ children[parent * kFanout + child]);
+            }
+            parents[parent] = hash;
+        }
+    }
+}
+
+const std::vector<std::string>& MerkleTree::leaf_keys(size_t leaf) const {
+    return leaf < leaf_keys_.size() ? leaf_keys_[leaf] : kNoKeys;
+}
+
+} // namespace replication
@@ -1,10 +1,257 @@
 #include "core/message.h"
 #include <sstream>
 #include <chrono>
+#include <cstring>
+#include <stdexcept>
 
 namespace replication {
 
+namespace {
+
+size_t varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+char* put_varint(char* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<char>(value);
+    return out;
+}
+
+char* put_u32(char* out, uint32_t value) {
+    out[0] = static_cast<char>(value & 0xFF);
+    out[1] = static_cast<char>((value >> 8) & 0xFF);
+    out[2] = static_cast<char>((value >> 16) & 0xFF);
+    out[3] = static_cast<char>((value >> 24) & 0xFF);
+    return out + 4;
+}
+
+uint32_t get_u32(const char* in) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    return static_cast<uint32_t>(p[0]) |
+           (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+char* put_bytes(char* out, const std::string& bytes) {
+    out = put_varint(out, bytes.size());
+    if (!bytes.empty()) {
+        std::memcpy(out, bytes.data(), bytes.size());
+    }
+    return out + bytes.size();
+}
+
+// Bounds-checked reader over a frame body
+class WireReader {
+public:
+    WireReader(const char* data, size_t size) : pos_(data), end_(data + size) {}
+    
+    bool read_varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos_ < end_; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(*pos_++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    bool read_bytes(std::string_view& bytes) {
+        uint64_t length = 0;
+        if (!read_varint(length) || length > static_cast<uint64_t>(end_ - pos_)) {
+            return false;
+        }
+        bytes = std::string_view(pos_, static_cast<size_t>(length));
+        pos_ += length;
+        return true;
+    }
+    
+    bool read_raw(std::string_view& bytes, size_t length) {
+        if (length > static_cast<size_t>(end_ - pos_)) {
+            return false;
+        }
+        bytes = std::string_view(pos_, length);
+        pos_ += length;
+        return true;
+    }
+    
+    bool at_end() const { return pos_ == end_; }
+
+private:
+    const char* pos_;
+    const char* end_;
+};
+
+} // namespace
+
+namespace wire {
+
+bool is_binary_frame(const char* data, size_t size) {
+    return size >= kHeaderSize && static_cast<uint8_t>(data[0]) == kMagic;
+}
+
+size_t frame_size(const char* data, size_t size) {
+    if (!is_binary_frame(data, size)) {
+        return 0;
+    }
+    uint8_t version = static_cast<uint8_t>(data[1]);
+    if (version < kMinSupportedVersion || version > kVersion) {
+        return 0;
+    }
+    return kHeaderSize + get_u32(data + 4);
+}
+
+} // namespace wire
+
+uint32_t MessageView::target_node(size_t index) const {
+    return get_u32(target_nodes_raw.data() + index * sizeof(uint32_t));
+}
+
+Message MessageView::to_message() const {
+    Message msg;
+    msg.type = type;
+    msg.sender_id = sender_id;
+    msg.receiver_id = receiver_id;
+    msg.key.assign(key.data(), key.size());
+    msg.value.assign(value.data(), value.size());
+    msg.success = success;
+    msg.timestamp = timestamp;
+    msg.sequence_number = sequence_number;
+    msg.ballot = ballot;
+    msg.log_index = log_index;
+    msg.partition_id = partition_id;
+    msg.correlation_id.assign(correlation_id.data(), correlation_id.size());
+    msg.metadata.assign(metadata.data(), metadata.size());
+    
+    size_t count = target_node_count();
+    msg.target_nodes.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        msg.target_nodes.push_back(target_node(i));
+    }
+    return msg;
+}
+
+bool MessageView::parse(const char* data, size_t size, MessageView& view) {
+    size_t total = wire::frame_size(data, size);
+    if (total == 0 || total > size) {
+        return false;
+    }
+    
+    view.type = static_cast<MessageType>(static_cast<uint8_t>(data[2]));
+    view.success = (static_cast<uint8_t>(data[3]) & wire::kFlagSuccess) != 0;
+    
+    WireReader reader(data + wire::kHeaderSize, total - wire::kHeaderSize);
+    uint64_t sender = 0, receiver = 0, timestamp = 0, sequence = 0, target_count = 0;
+    if (!reader.read_varint(sender) || !reader.read_varint(receiver) ||
+        !reader.read_varint(timestamp) || !reader.read_varint(sequence)) {
+        return false;
+    }
+    view.ballot = 0;
+    view.log_index = 0;
+    if (static_cast<uint8_t>(data[1]) >= 2 &&
+        (!reader.read_varint(view.ballot) || !reader.read_varint(view.log_index))) {
+        return false;
+    }
+    uint64_t partition = 0;
+    if (static_cast<uint8_t>(data[1]) >= 3 && !reader.read_varint(partition)) {
+        return false;
+    }
+    if (!reader.read_bytes(view.key) || !reader.read_bytes(view.value) ||
+        !reader.read_bytes(view.correlation_id) || !reader.read_bytes(view.metadata)) {
+        return false;
+    }
+    if (!reader.read_varint(target_count) ||
+        target_count > (total - wire::kHeaderSize) / sizeof(uint32_t) ||
+        !reader.read_raw(view.target_nodes_raw, target_count * sizeof(uint32_t))) {
+        return false;
+    }
+    
+    view.sender_id = static_cast<uint32_t>(sender);
+    view.receiver_id = static_cast<uint32_t>(receiver);
+    view.timestamp = timestamp;
+    view.sequence_number = static_cast<uint32_t>(sequence);
+    view.partition_id = static_cast<uint32_t>(partition);
+    return reader.at_end();
+}
+
+size_t Message::encoded_size() const {
+    size_t size = wire::kHeaderSize;
+    size += varint_size(sender_id) + varint_size(receiver_id) +
+            varint_size(timestamp) + varint_size(sequence_number);
+    size += varint_size(ballot) + varint_size(log_index);
+    size += varint_size(partition_id);
+    size += varint_size(key.size()) + key.size();
+    size += varint_size(value.size()) + value.size();
+    size += varint_size(correlation_id.size()) + correlation_id.size();
+    size += varint_size(metadata.size()) + metadata.size();
+    size += varint_size(target_nodes.size()) + target_nodes.size() * sizeof(uint32_t);
+    return size;
+}
+
+void Message::serialize_to(std::string& out) const {
+    size_t size = encoded_size();
+    size_t offset = out.size();
+    out.resize(offset + size);
+    
+    char* p = &out[offset];
+    *p++ = static_cast<char>(wire::kMagic);
+    *p++ = static_cast<char>(wire::kVersion);
+    *p++ = static_cast<char>(static_cast<uint8_t>(type));
+    *p++ = static_cast<char>(success ? wire::kFlagSuccess : 0);
+    p = put_u32(p, static_cast<uint32_t>(size - wire::kHeaderSize));
+    
+    p = put_varint(p, sender_id);
+    p = put_varint(p, receiver_id);
+    p = put_varint(p, timestamp);
+    p = put_varint(p, sequence_number);
+    p = put_varint(p, ballot);
+    p = put_varint(p, log_index);
+    p = put_varint(p, partition_id);
+    p = put_bytes(p, key);
+    p = put_bytes(p, value);
+    p = put_bytes(p, correlation_id);
+    p = put_bytes(p, metadata);
+    
+    p = put_varint(p, target_nodes.size());
+    for (uint32_t node : target_nodes) {
+        p = put_u32(p, node);
+    }
+}
+
 std::string Message::serialize() const {
+    std::string out;
+    serialize_to(out);
+    return out;
+}
+
+Message Message::deserialize(const std::string& data) {
+    return deserialize(data.data(), data.size());
+}
+
+Message Message::deserialize(const char* data, size_t size) {
+    if (!wire::is_binary_frame(data, size)) {
+        return deserialize_text(std::string(data, size));
+    }
+    
+    MessageView view;
+    if (!MessageView::parse(data, size, view)) {
+        throw std::runtime_error("Malformed binary message frame");
+    }
+    return view.to_message();
+}
+
+std::string Message::serialize_text() const {
     std::ostringstream oss;
     oss << static_cast<int>(type) << "|"
         << sender_id << "|"
@@ -27,7 +274,7 @@ std::string Message::serialize() const {
     return oss.str();
 }
 
-Message Message::deserialize(const std::string& data) {
+Message Message::deserialize_text(const std::string& data) {
     Message msg;
     std::istringstream iss(data);
     std::string token;
@@ -0,0 +1,277 @@
+#include "core/message_dispatcher.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <string>
+
+namespace replication {
+
+namespace {
+
+// A parked lane also rechecks its rings this often, as a backstop to the
+// fenced wakeup
+constexpr auto kMaxPark = std::chrono::milliseconds(10);
+
+size_t default_worker_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+} // namespace
+
+MessageDispatcher::MessageDispatcher(Handler handler, const DispatcherConfig& config)
+    : handler_(std::move(handler))
+    , config_(config)
+    , running_(false)
+    , control_(config.lane_capacity)
+    , shared_(config.lane_capacity)
+    , next_wake_(0)
+    , dispatched_(0)
+    , full_waits_(0) {
+    size_t workers = config_.worker_threads > 0 ? config_.worker_threads : default_worker_count();
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Lane>(config_.lane_capacity));
+    }
+    size_t replication = config_.replication_threads > 0 ? config_.replication_threads : workers;
+    for (size_t i = 0; i < replication; ++i) {
+        replication_.push_back(std::make_unique<Lane>(config_.lane_capacity));
+    }
+}
+
+MessageDispatcher::~MessageDispatcher() {
+    stop();
+}
+
+bool MessageDispatcher::start() {
+    if (running_.exchange(true)) {
+        return true;
+    }
+    control_.thread = std::thread(&MessageDispatcher::lane_loop, this, std::ref(control_), false);
+    for (auto& worker : workers_) {
+        worker->thread = std::thread(&MessageDispatcher::lane_loop, this, std::ref(*worker), true);
+    }
+    // Shared work may block (a mode switch drains writes), so these skip it
+    for (auto& lane : replication_) {
+        lane->thread = std::thread(&MessageDispatcher::lane_loop, this, std::ref(*lane), false);
+    }
+    LOG_DEBUG("Message dispatcher started with " + std::to_string(workers_.size()) + " workers and " +
+              std::to_string(replication_.size()) + " replication lanes");
+    return true;
+}
+
+void MessageDispatcher::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    wake(control_);
+    for (auto& worker : workers_) {
+        wake(*worker);
+    }
+    for (auto& lane : replication_) {
+        wake(*lane);
+    }
+    if (control_.thread.joinable()) {
+        control_.thread.join();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    for (auto& lane : replication_) {
+        if (lane->thread.joinable()) {
+            lane->thread.join();
+        }
+    }
+}
+
+DispatchLane MessageDispatcher::lane_for(const Message& message) {
+    switch (message.type) {
+        case MessageType::READ_REQUEST:
+        case MessageType::WRITE_REQUEST:
+        case MessageType::CHAIN_VERSION_QUERY:
+            return message.key.empty() ? DispatchLane::SHARED : DispatchLane::KEYED;
+
+        case MessageType::HEARTBEAT:
+        case MessageType::NODE_FAILURE:
+        case MessageType::NODE_RECOVERY:
+        case MessageType::CHAIN_UPDATE:
+        case MessageType::CHAIN_ACK:
+        case MessageType::CHAIN_VERSION_RESPONSE:
+        case MessageType::QUORUM_PREPARE:
+        case MessageType::QUORUM_PROMISE:
+        case MessageType::QUORUM_ACCEPTED:
+        case MessageType::QUORUM_COMMIT:
+        case MessageType::QUORUM_ABORT:
+        case MessageType::QUORUM_READ_INDEX:
+        case MessageType::QUORUM_READ_INDEX_ACK:
+        case MessageType::READ_RESPONSE:
+        case MessageType::SYNC_TREE_RESPONSE:
+        case MessageType::SYNC_RANGE_DATA:
+        case MessageType::SYNC_COMPLETE:
+            return DispatchLane::CONTROL;
+
+        case MessageType::CHAIN_FORWARD:
+        case MessageType::BATCH_REQUEST: // chain batches; send coalescing is unpacked by the network
+        case MessageType::QUORUM_ACCEPT:
+            return DispatchLane::REPLICATION;
+
+        // MODE_SWITCH drains in-flight writes, whose acks arrive on the
+        // control lane, so it must not run there
+        case MessageType::MODE_SWITCH:
+        default:
+            return DispatchLane::SHARED;
+    }
+}
+
+bool MessageDispatcher::dispatch(Message message) {
+    dispatched_.fetch_add(1, std::memory_order_relaxed);
+    switch (lane_for(message)) {
+        case DispatchLane::CONTROL:
+            if (!push(control_.ring, message)) {
+                return false;
+            }
+            wake(control_);
+            return true;
+        case DispatchLane::KEYED: {
+            Lane& lane = keyed_lane(message);
+            if (!push(lane.ring, message)) {
+                return false;
+            }
+            wake(lane);
+            return true;
+        }
+        case DispatchLane::REPLICATION: {
+            Lane& lane = replication_lane(message);
+            if (!push(lane.ring, message)) {
+                return false;
+            }
+            wake(lane);
+            return true;
+        }
+        case DispatchLane::SHARED:
+        default:
+            if (!push(shared_, message)) {
+                return false;
+            }
+            wake_idle_worker();
+            return true;
+    }
+}
+
+MessageDispatcher::Lane& MessageDispatcher::keyed_lane(const Message& message) {
+    return *workers_[std::hash<std::string>()(message.key) % workers_.size()];
+}
+
+MessageDispatcher::Lane& MessageDispatcher::replication_lane(const Message& message) {
+    if (message.type == MessageType::QUORUM_ACCEPT && !message.key.empty()) {
+        return *replication_[std::hash<std::string>()(message.key) % replication_.size()];
+    }
+    // Chain forwards and batches from one predecessor stay on one lane, in
+    // the order it sent them
+    uint64_t stream = (static_cast<uint64_t>(message.partition_id) << 32) | message.sender_id;
+    return *replication_[std::hash<uint64_t>()(stream) % replication_.size()];
+}
+
+bool MessageDispatcher::push(BoundedQueue<Message>& ring, Message& message) {
+    if (ring.try_push(std::move(message))) {
+        return true;
+    }
+    // try_push leaves the message alone when the ring is full
+    full_waits_.fetch_add(1, std::memory_order_relaxed);
+    while (!ring.try_push(std::move(message))) {
+        if (!running_.load(std::memory_order_acquire)) {
+            LOG_WARNING("Dropping message type " + std::to_string(static_cast<int>(message.type)) +
+                        " from node " + std::to_string(message.sender_id) + ": dispatcher is stopped");
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void MessageDispatcher::wake(Lane& lane) {
+    // Pairs with the fence in lane_loop: either the lane sees the new
+    // message before parking, or this sees it parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lane.sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(lane.wake_mutex);
+        lane.wake_cv.notify_one();
+    }
+}
+
+void MessageDispatcher::wake_idle_worker() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Busy workers reach the shared ring on their own once their ring drains
+    size_t start = next_wake_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        Lane& lane = *workers_[(start + i) % workers_.size()];
+        if (lane.sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(lane.wake_mutex);
+            lane.wake_cv.notify_one();
+            return;
+        }
+    }
+}
+
+void MessageDispatcher::lane_loop(Lane& lane, bool takes_shared) {
+    Message message;
+    size_t idle_polls = 0;
+    while (true) {
+        // Own ring first, so keyed work never waits behind shared work
+        if (lane.ring.try_pop(message)) {
+            run(message);
+            lane.handled.fetch_add(1, std::memory_order_relaxed);
+            idle_polls = 0;
+            continue;
+        }
+        if (takes_shared && shared_.try_pop(message)) {
+            run(message);
+            lane.shared_handled.fetch_add(1, std::memory_order_relaxed);
+            idle_polls = 0;
+            continue;
+        }
+        if (!running_.load(std::memory_order_acquire)) {
+            break; // rings drained
+        }
+        if (++idle_polls < config_.spins_before_sleep) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(lane.wake_mutex);
+        lane.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (lane.ring.empty() && (!takes_shared || shared_.empty()) && running_.load()) {
+            lane.wake_cv.wait_for(lock, kMaxPark);
+        }
+        lane.sleeping.store(false, std::memory_order_relaxed);
+        idle_polls = 0;
+    }
+}
+
+void MessageDispatcher::run(const Message& message) {
+    try {
+        handler_(message);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to process message type " + std::to_string(static_cast<int>(message.type)) +
+                  ": " + std::string(e.what()));
+    }
+}
+
+DispatcherStats MessageDispatcher::get_stats() const {
+    DispatcherStats stats;
+    stats.dispatched = dispatched_.load(std::memory_order_relaxed);
+    stats.control_handled = control_.handled.load(std::memory_order_relaxed);
+    for (const auto& worker : workers_) {
+        stats.keyed_handled += worker->handled.load(std::memory_order_relaxed);
+        stats.shared_handled += worker->shared_handled.load(std::memory_order_relaxed);
+    }
+    for (const auto& lane : replication_) {
+        stats.replication_handled += lane->handled.load(std::memory_order_relaxed);
+    }
+    stats.full_waits = full_waits_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace replication
@@ -3,21 +3,35 @@
 #include "protocols/chain_replication.h"
 #include "protocols/quorum_replication.h"
 #include "protocols/hybrid_protocol.h"
+#include "protocols/partitioned_replication.h"
+#include "core/snapshot.h"
+#include "utils/clock.h"
 #include "utils/logger.h"
 #include <algorithm>
 #include <random>
 
 namespace replication {
 
-Node::Node(uint32_t node_id, const std::vector<uint32_t>& cluster_nodes)
+Node::Node(uint32_t node_id, const std::vector<uint32_t>& cluster_nodes,
+           std::unique_ptr<StorageEngine> storage)
     : node_id_(node_id), leader_id_(0), cluster_nodes_(cluster_nodes), 
-      running_(false), operation_count_(0), success_count_(0) {
+      running_(false), serving_(true), storage_(std::move(storage)), catching_up_(false),
+      recovery_time_us_(0), snapshot_stopping_(false), writes_since_snapshot_(0),
+      op_counters_(new OperationCounters[kCounterSlots]), partitioned_(false),
+      lost_majority_(false) {
+    
+    if (!storage_) {
+        storage_ = std::make_unique<ShardedStorageEngine>();
+    }
     
     // Initialize leader (first node in cluster)
     if (!cluster_nodes.empty()) {
         leader_id_ = cluster_nodes[0];
     }
     
+    dispatcher_ = std::make_unique<MessageDispatcher>(
+        [this](const Message& message) { process_incoming_message(message); });
+    
     // Initialize network manager
     network_manager_ = std::make_shared<NetworkManager>(node_id_);
     
@@ -29,6 +43,16 @@ Node::Node(uint32_t node_id, const std::vector<uint32_t>& cluster_nodes)
 
 Node::~Node() {
     stop();
+    
+    {
+        std::lock_guard<std::mutex> lock(snapshot_mutex_);
+        snapshot_stopping_ = true;
+    }
+    snapshot_cv_.notify_all();
+    if (snapshot_thread_.joinable()) {
+        snapshot_thread_.join();
+    }
+    // wal_ syncs whatever is still buffered as it is destroyed
 }
 
 bool Node::start() {
@@ -38,16 +62,20 @@ bool Node::start() {
     
     running_ = true;
     
+    // Workers first, so nothing the network delivers waits for them
+    dispatcher_->start();
+    network_manager_->set_message_handler([this](const Message& message) { dispatcher_->dispatch(message); });
+    network_manager_->set_liveness_handler(
+        [this](uint32_t peer, PeerLiveness liveness) { handle_peer_liveness(peer, liveness); });
+    
     // Start network manager
     if (!network_manager_->start()) {
+        dispatcher_->stop();
         running_ = false;
         return false;
     }
     
-    // Start message processing thread
-    message_thread_ = std::thread(&Node::message_processing_loop, this);
-    
-    Logger::getInstance().logInfo("Node " + std::to_string(node_id_) + " started successfully");
+    LOG_INFO("Node " + std::to_string(node_id_) + " started successfully");
     return true;
 }
 
@@ -58,62 +86,288 @@ void Node::stop() {
     
     running_ = false;
     
-    // Notify message thread to stop
-    queue_cv_.notify_all();
-    
-    // Wait for message thread to finish
-    if (message_thread_.joinable()) {
-        message_thread_.join();
-    }
+    // Handles what is already queued, then joins the workers
+    dispatcher_->stop();
     
     // Stop network manager
     network_manager_->stop();
     
-    Logger::getInstance().logInfo("Node " + std::to_string(node_id_) + " stopped");
+    LOG_INFO("Node " + std::to_string(node_id_) + " stopped");
 }
 
 bool Node::read(const std::string& key, std::string& value) {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    auto it = data_store_.find(key);
-    if (it != data_store_.end()) {
-        value = it->second;
-        operation_count_++;
-        success_count_++;
-        return true;
+    bool found = storage_->get(key, value);
+    count_operations(1, found ? 1 : 0);
+    return found;
+}
+
+ValueRef Node::read_ref(const std::string& key) {
+    ValueRef value = storage_->get_ref(key);
+    count_operations(1, value ? 1 : 0);
+    return value;
+}
+
+bool Node::read(const std::string& key, Payload& value) {
+    ValueRef stored = read_ref(key);
+    if (!stored) {
+        return false;
     }
-    operation_count_++;
-    return false;
+    value = Payload(std::move(stored));
+    return true;
 }
 
 bool Node::write(const std::string& key, const std::string& value) {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    data_store_[key] = value;
-    operation_count_++;
-    success_count_++;
+    // Allocate outside any lock, as put() does
+    return write_ref(key, std::make_shared<const std::string>(value));
+}
+
+bool Node::write_ref(const std::string& key, ValueRef value) {
+    // Readers may see the value before it is durable, as with any group
+    // commit; the writer is only told once it is
+    uint64_t lsn = apply_local(WalRecordType::PUT, key, value, nullptr);
+    if (wal_ && !wal_->wait_durable(lsn)) {
+        LOG_ERROR("Write of key " + key + " applied but not durable");
+        count_operations(1, 0);
+        return false;
+    }
+    count_operations(1, 1);
+    return true;
+}
+
+bool Node::write_batch(const std::vector<std::pair<std::string, std::string>>& entries) {
+    uint64_t last_lsn = 0;
+    for (const auto& entry : entries) {
+        last_lsn = apply_local(WalRecordType::PUT, entry.first, std::make_shared<const std::string>(entry.second),
+                               nullptr);
+    }
+    if (wal_ && !entries.empty() && !wal_->wait_durable(last_lsn)) {
+        LOG_ERROR("Batch of " + std::to_string(entries.size()) + " writes applied but not durable");
+        count_operations(entries.size(), 0);
+        return false;
+    }
+    count_operations(entries.size(), entries.size());
     return true;
 }
 
 bool Node::delete_key(const std::string& key) {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    auto it = data_store_.find(key);
-    if (it != data_store_.end()) {
-        data_store_.erase(it);
-        operation_count_++;
-        success_count_++;
-        return true;
+    // Logged even when the key is absent; replay makes that a no-op
+    bool erased = false;
+    uint64_t lsn = apply_local(WalRecordType::DELETE, key, nullptr, &erased);
+    if (wal_ && !wal_->wait_durable(lsn)) {
+        LOG_ERROR("Delete of key " + key + " applied but not durable");
+        erased = false;
+    }
+    count_operations(1, erased ? 1 : 0);
+    return erased;
+}
+
+uint64_t Node::apply_local(WalRecordType type, const std::string& key, const ValueRef& value, bool* erased) {
+    if (!catching_up_.load(std::memory_order_acquire)) {
+        return log_and_apply(type, key, value, erased);
+    }
+    // Remembered so anti-entropy never overwrites it with older range data
+    std::lock_guard<std::mutex> lock(catch_up_mutex_);
+    catch_up_written_.insert(key);
+    return log_and_apply(type, key, value, erased);
+}
+
+uint64_t Node::log_and_apply(WalRecordType type, const std::string& key, const ValueRef& value, bool* erased) {
+    auto apply = [&]() {
+        if (type == WalRecordType::PUT) {
+            storage_->put_ref(key, value);
+            return;
+        }
+        bool removed = storage_->erase(key);
+        if (erased) {
+            *erased = removed;
+        }
+    };
+    if (!wal_) {
+        apply();
+        return 0;
+    }
+    static const std::string kNoValue;
+    uint64_t lsn = wal_->append(type, key, value ? *value : kNoValue, apply);
+    note_logged_writes(1);
+    return lsn;
+}
+
+void Node::begin_catch_up() {
+    std::lock_guard<std::mutex> lock(catch_up_mutex_);
+    // A retried catch-up keeps protecting what was written since the first
+    if (!catching_up_.load()) {
+        catch_up_written_.clear();
+    }
+    serving_.store(false);
+    catching_up_.store(true, std::memory_order_release);
+}
+
+void Node::end_catch_up() {
+    std::lock_guard<std::mutex> lock(catch_up_mutex_);
+    catching_up_.store(false, std::memory_order_release);
+    catch_up_written_.clear();
+    serving_.store(true);
+}
+
+size_t Node::apply_catch_up(const std::vector<std::pair<std::string, std::string>>& puts,
+                            const std::vector<std::string>& erases) {
+    size_t applied = 0;
+    uint64_t last_lsn = 0;
+    {
+        std::lock_guard<std::mutex> lock(catch_up_mutex_);
+        for (const auto& entry : puts) {
+            if (catch_up_written_.count(entry.first) == 0) {
+                last_lsn = log_and_apply(WalRecordType::PUT, entry.first,
+                                         std::make_shared<const std::string>(entry.second), nullptr);
+                ++applied;
+            }
+        }
+        for (const std::string& key : erases) {
+            bool erased = false;
+            if (catch_up_written_.count(key) == 0) {
+                last_lsn = log_and_apply(WalRecordType::DELETE, key, nullptr, &erased);
+            }
+            applied += erased ? 1 : 0;
+        }
+    }
+    // One durability wait for the whole chunk
+    if (wal_ && last_lsn != 0 && !wal_->wait_durable(last_lsn)) {
+        LOG_ERROR("Catch-up chunk applied but not durable");
+    }
+    return applied;
+}
+
+bool Node::enable_durability(const DurabilityConfig& config) {
+    if (wal_ || running_) {
+        LOG_ERROR("Durability must be enabled once, before the node starts");
+        return false;
+    }
+    
+    uint64_t start_us = monotonic_now_us();
+    
+    // The snapshot is copied into the store straight out of the mapping
+    SnapshotStore snapshots(config.directory);
+    MappedSnapshot snapshot;
+    uint64_t snapshot_lsn = 0;
+    uint64_t restored = 0;
+    if (snapshots.open_latest(snapshot)) {
+        snapshot_lsn = snapshot.get_lsn();
+        snapshot.for_each([this, &restored](const char* key, size_t key_size, const char* value, size_t value_size) {
+            storage_->put_ref(std::string(key, key_size), std::make_shared<const std::string>(value, value_size));
+            ++restored;
+        });
+        snapshot.close();
+    }
+    
+    auto wal = std::make_unique<WriteAheadLog>(config);
+    uint64_t replayed = 0;
+    bool opened = wal->open(snapshot_lsn, [this, &replayed](const WalRecord& record) {
+        if (record.type == WalRecordType::PUT) {
+            storage_->put(record.key, record.value);
+        } else {
+            storage_->erase(record.key);
+        }
+        ++replayed;
+    });
+    if (!opened) {
+        LOG_ERROR("Node " + std::to_string(node_id_) + " could not open its WAL in " + config.directory);
+        return false;
+    }
+    
+    wal_ = std::move(wal);
+    durability_ = config;
+    recovery_time_us_ = monotonic_now_us() - start_us;
+    if (durability_.snapshot_interval_ops > 0) {
+        snapshot_thread_ = std::thread(&Node::snapshot_loop, this);
+    }
+    
+    LOG_INFO("Node " + std::to_string(node_id_) + " recovered " + std::to_string(restored) +
+             " keys from snapshot at LSN " + std::to_string(snapshot_lsn) + " and replayed " +
+             std::to_string(replayed) + " WAL records in " + std::to_string(recovery_time_us_) + "us");
+    return true;
+}
+
+bool Node::take_snapshot() {
+    if (!wal_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    
+    uint64_t lsn = wal_->rotate();
+    if (!wal_->is_healthy()) {
+        return false;
+    }
+    SnapshotStore snapshots(durability_.directory);
+    std::vector<uint64_t> existing = snapshots.list();
+    if (!existing.empty() && existing.back() == lsn) {
+        return true; // nothing written since the last snapshot
+    }
+    if (!snapshots.write(*storage_, lsn)) {
+        return false;
+    }
+    
+    writes_since_snapshot_.store(0, std::memory_order_relaxed);
+    snapshots.remove_older_than(lsn);
+    wal_->remove_segments_through(lsn);
+    return true;
+}
+
+void Node::note_logged_writes(uint64_t count) {
+    uint64_t interval = durability_.snapshot_interval_ops;
+    uint64_t writes = writes_since_snapshot_.fetch_add(count, std::memory_order_relaxed) + count;
+    if (interval > 0 && writes >= interval && writes - count < interval) {
+        snapshot_cv_.notify_one(); // only the write that crosses the threshold
+    }
+}
+
+void Node::snapshot_loop() {
+    std::unique_lock<std::mutex> lock(snapshot_mutex_);
+    while (!snapshot_stopping_) {
+        // Writers notify without the lock (it is held for a whole snapshot),
+        // so a wakeup can be missed; the timeout bounds the delay
+        snapshot_cv_.wait_for(lock, std::chrono::seconds(1), [this]() {
+            return snapshot_stopping_ ||
+                   writes_since_snapshot_.load(std::memory_order_relaxed) >= durability_.snapshot_interval_ops;
+        });
+        if (snapshot_stopping_) {
+            break;
+        }
+        lock.unlock();
+        if (!take_snapshot()) {
+            LOG_ERROR("Node " + std::to_string(node_id_) + " failed to take a snapshot");
+            writes_since_snapshot_.store(0, std::memory_order_relaxed); // retry after another interval
+        }
+        lock.lock();
     }
-    operation_count_++;
-    return false;
 }
 
 void Node::handle_message(const std::string& message_data) {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    message_queue_.push(message_data);
-    queue_cv_.notify_one();
+    // Decoded on the caller's thread, which the lane choice needs anyway
+    Message message;
+    try {
+        message = Message::deserialize(message_data);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to deserialize message: " + std::string(e.what()));
+        return;
+    }
+    dispatcher_->dispatch(std::move(message));
+}
+
+void Node::handle_message(Message message) {
+    dispatcher_->dispatch(std::move(message));
+}
+
+void Node::configure_dispatcher(const DispatcherConfig& config) {
+    if (running_) {
+        LOG_WARNING("Node " + std::to_string(node_id_) + " cannot replace its dispatcher while running");
+        return;
+    }
+    dispatcher_ = std::make_unique<MessageDispatcher>(
+        [this](const Message& message) { process_incoming_message(message); }, config);
 }
 
-void Node::send_message(uint32_t target_node, const std::string& message_data) {
-    network_manager_->send_message(target_node, message_data);
+void Node::send_message(uint32_t target_node, const Message& message) {
+    network_manager_->send_message(target_node, message);
 }
 
 void Node::handle_node_failure(uint32_t failed_node) {
@@ -128,7 +382,7 @@ void Node::handle_node_failure(uint32_t failed_node) {
         leader_id_ = cluster_nodes_[0];
     }
     
-    Logger::getInstance().logWarning("Node " + std::to_string(failed_node) + " failed, removed from cluster");
+    LOG_WARNING("Node " + std::to_string(failed_node) + " failed, removed from cluster");
 }
 
 void Node::handle_node_recovery(uint32_t recovered_node) {
@@ -138,48 +392,113 @@ void Node::handle_node_recovery(uint32_t recovered_node) {
         std::sort(cluster_nodes_.begin(), cluster_nodes_.end());
     }
     
-    Logger::getInstance().logInfo("Node " + std::to_string(recovered_node) + " recovered, added back to cluster");
+    LOG_INFO("Node " + std::to_string(recovered_node) + " recovered, added back to cluster");
+}
+
+void Node::handle_peer_liveness(uint32_t peer, PeerLiveness liveness) {
+    PeerLiveness previous = peer_liveness_[peer];
+    peer_liveness_[peer] = liveness;
+    std::shared_ptr<PartitionedReplication> partitions = partitions_.lock();
+    
+    // Only a failure reconfigures the chain and quorum; a suspect may just
+    // be slow, and reshaping the chain around it costs more than waiting
+    if (liveness == PeerLiveness::FAILED) {
+        if (partitions) {
+            partitions->handle_node_failure(peer);
+        } else if (hybrid_protocol_) {
+            hybrid_protocol_->handle_node_failure(peer);
+        }
+    } else if (liveness == PeerLiveness::ALIVE && previous == PeerLiveness::FAILED) {
+        // Whichever side lost the majority is the stale one. A peer heard
+        // from again after this node was cut off is re-admitted as is; one
+        // coming back to the majority is held back and told to catch up.
+        if (partitions) {
+            if (lost_majority_) {
+                partitions->readmit_node(peer);
+            } else {
+                partitions->handle_node_recovery(peer);
+            }
+        } else if (hybrid_protocol_) {
+            if (lost_majority_) {
+                hybrid_protocol_->readmit_node(peer);
+            } else {
+                hybrid_protocol_->handle_node_recovery(peer);
+            }
+        }
+    }
+    
+    // Suspects count here: quorum rounds stall on them just the same
+    size_t doubted = 0;
+    size_t failed = 0;
+    for (const auto& entry : peer_liveness_) {
+        if ((entry.second == PeerLiveness::SUSPECT || entry.second == PeerLiveness::FAILED) &&
+            std::find(cluster_nodes_.begin(), cluster_nodes_.end(), entry.first) != cluster_nodes_.end()) {
+            ++doubted;
+            failed += entry.second == PeerLiveness::FAILED;
+        }
+    }
+    size_t cluster_size = std::max<size_t>(cluster_nodes_.size(), 1);
+    bool partitioned = (cluster_size - std::min(doubted, cluster_size)) * 2 <= cluster_size;
+    
+    if (partitioned) {
+        lost_majority_ = true;
+    } else if (failed == 0) {
+        lost_majority_ = false;
+    }
+    
+    if (partitioned && !partitioned_.exchange(true)) {
+        LOG_WARNING("Node " + std::to_string(node_id_) + " doubts " + std::to_string(doubted) + " of " +
+                    std::to_string(cluster_size) + " nodes, treating it as a network partition");
+        if (partitions) {
+            partitions->for_each_group([](uint32_t, HybridProtocol& group) { group.handle_network_partition(); });
+        } else if (hybrid_protocol_) {
+            hybrid_protocol_->handle_network_partition();
+        }
+    } else if (!partitioned && partitioned_.exchange(false)) {
+        LOG_INFO("Node " + std::to_string(node_id_) + " reaches a majority again");
+    }
+}
+
+uint64_t Node::get_operation_count() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < kCounterSlots; ++i) {
+        total += op_counters_[i].operations.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Node::get_success_count() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < kCounterSlots; ++i) {
+        total += op_counters_[i].successes.load(std::memory_order_relaxed);
+    }
+    return total;
 }
 
 double Node::get_success_rate() const {
-    uint64_t ops = operation_count_.load();
+    uint64_t ops = get_operation_count();
     if (ops == 0) return 0.0;
-    return static_cast<double>(success_count_.load()) / ops;
-}
-
-void Node::message_processing_loop() {
-    while (running_) {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        queue_cv_.wait(lock, [this] { return !message_queue_.empty() || !running_; });
-        
-        if (!running_) break;
-        
-        if (!message_queue_.empty()) {
-            std::string message_data = message_queue_.front();
-            message_queue_.pop();
-            lock.unlock();
-            
-            process_incoming_message(message_data);
-        }
+    return static_cast<double>(get_success_count()) / ops;
+}
+
+void Node::count_operations(uint64_t operations, uint64_t successes) {
+    static std::atomic<size_t> next_slot(0);
+    thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % kCounterSlots;
+    OperationCounters& counters = op_counters_[slot];
+    counters.operations.fetch_add(operations, std::memory_order_relaxed);
+    if (successes > 0) {
+        counters.successes.fetch_add(successes, std::memory_order_relaxed);
     }
 }
 
-void Node::process_incoming_message(const std::string& message_data) {
-    try {
-        Message msg = Message::deserialize(message_data);
-        
-        // Route message to appropriate protocol
-        switch (msg.type) {
-            case MessageType::READ_REQUEST:
-            case MessageType::WRITE_REQUEST:
-                // Let hybrid protocol handle routing
-                break;
-            default:
-                // Handle other message types
-                break;
-        }
-    } catch (const std::exception& e) {
-        Logger::getInstance().logError("Failed to process message: " + std::string(e.what()));
+void Node::process_incoming_message(const Message& message) {
+    if (std::shared_ptr<PartitionedReplication> partitions = partitions_.lock()) {
+        partitions->handle_message(message);
+        return;
+    }
+    // Every protocol this node runs hangs off the hybrid protocol
+    if (hybrid_protocol_) {
+        hybrid_protocol_->handle_message(message);
     }
 }
 
@@ -0,0 +1,92 @@
+#include "core/partition_map.h"
+#include <algorithm>
+#include <utility>
+
+namespace replication {
+
+namespace {
+
+uint64_t mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+uint64_t rendezvous_score(uint32_t partition, uint32_t node) {
+    return mix((static_cast<uint64_t>(partition) << 32 | node) ^ 0x9E3779B97F4A7C15ULL);
+}
+
+} // namespace
+
+PartitionMap::PartitionMap(const std::vector<uint32_t>& nodes, const PartitionConfig& config)
+    : nodes_(nodes) {
+    std::sort(nodes_.begin(), nodes_.end());
+    nodes_.erase(std::unique(nodes_.begin(), nodes_.end()), nodes_.end());
+
+    uint32_t partitions = std::max<uint32_t>(config.partition_count, 1);
+    size_t factor = std::min(std::max<size_t>(config.replication_factor, 1), nodes_.size());
+    replicas_.resize(partitions);
+
+    std::vector<std::pair<uint64_t, uint32_t>> ranked(nodes_.size());
+    for (uint32_t partition = 0; partition < partitions; ++partition) {
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            ranked[i] = std::make_pair(rendezvous_score(partition, nodes_[i]), nodes_[i]);
+        }
+        std::partial_sort(ranked.begin(), ranked.begin() + factor, ranked.end(),
+                          [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) {
+                              return a.first > b.first;
+                          });
+        std::vector<uint32_t>& replicas = replicas_[partition];
+        for (size_t i = 0; i < factor; ++i) {
+            replicas.push_back(ranked[i].second);
+        }
+    }
+}
+
+uint64_t PartitionMap::key_hash(const std::string& key) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 0x100000001B3ULL;
+    }
+    return mix(hash);
+}
+
+uint32_t PartitionMap::partition_for(const std::string& key) const {
+    // Partition i owns the i-th of partition_count equal ranges of the top
+    // 32 hash bits
+    uint64_t high = key_hash(key) >> 32;
+    return static_cast<uint32_t>((high * replicas_.size()) >> 32);
+}
+
+uint32_t PartitionMap::leader(uint32_t partition) const {
+    const std::vector<uint32_t>& replicas = replicas_[partition];
+    return replicas.empty() ? 0 : replicas.front();
+}
+
+bool PartitionMap::replicates(uint32_t node, uint32_t partition) const {
+    const std::vector<uint32_t>& replicas = replicas_[partition];
+    return std::find(replicas.begin(), replicas.end(), node) != replicas.end();
+}
+
+std::vector<uint32_t> PartitionMap::partitions_of(uint32_t node) const {
+    std::vector<uint32_t> partitions;
+    for (uint32_t partition = 0; partition < replicas_.size(); ++partition) {
+        if (replicates(node, partition)) {
+            partitions.push_back(partition);
+        }
+    }
+    return partitions;
+}
+
+std::vector<uint32_t> PartitionMap::partitions_led_by(uint32_t node) const {
+    std::vector<uint32_t> partitions;
+    for (uint32_t partition = 0; partition < replicas_.size(); ++partition) {
+        if (leader(partition) == node) {
+            partitions.push_back(partition);
+        }
+    }
+    return partitions;
+}
+
+} // namespace replication
@@ -0,0 +1,314 @@
+#include "core/read_cache.h"
+#include "utils/clock.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace replication {
+
+ReadCache::ReadCache(const ReadCacheConfig& config)
+    : shard_count_(std::max<size_t>(1, std::min(config.shard_count, std::max<size_t>(1, config.max_entries))))
+    , max_bytes_per_shard_(std::max<size_t>(1, config.max_bytes / shard_count_))
+    , admission_enabled_(config.admission_enabled)
+    , ttl_us_(config.ttl_us)
+    , shards_(new Shard[shard_count_]) {
+
+    size_t capacity = std::max<size_t>(1, config.max_entries / shard_count_);
+    for (size_t i = 0; i < shard_count_; ++i) {
+        Shard& shard = shards_[i];
+        shard.capacity = capacity;
+        shard.slots.reset(new Entry[capacity]);
+        shard.free_slots.reserve(capacity);
+        for (size_t slot = capacity; slot > 0; --slot) {
+            shard.free_slots.push_back(slot - 1);
+        }
+        shard.index.reserve(capacity);
+        if (admission_enabled_) {
+            // Oversized relative to the shard so a scan of cold keys does not
+            // inflate estimates through collisions with the hot set
+            shard.sketch = std::make_unique<FrequencySketch>(capacity * 8);
+        }
+    }
+}
+
+ReadCache::Shard& ReadCache::shard_for(uint64_t hash) const {
+    return shards_[hash % shard_count_];
+}
+
+uint64_t& ReadCache::tombstone_for(Shard& shard, uint64_t hash) const {
+    // The low bits already picked the shard
+    return shard.tombstones[(hash / shard_count_) % kTombstoneSlots];
+}
+
+bool ReadCache::get(const std::string& key, std::string& value) {
+    ValueRef ref = get_ref(key);
+    if (!ref) {
+        return false;
+    }
+    value = *ref;
+    return true;
+}
+
+ValueRef ReadCache::get_ref(const std::string& key) {
+    uint64_t hash = std::hash<std::string>()(key);
+    Shard& shard = shard_for(hash);
+    uint64_t now = monotonic_now_us();
+
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+    // Misses count too: a key that keeps missing is a candidate worth admitting
+    if (shard.sketch && shard.sketch->increment(hash)) {
+        shard.aging_due.store(true, std::memory_order_relaxed);
+    }
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Entry& entry = shard.slots[it->second];
+    if (entry.expiry_us <= now) {
+        // Expired entries are reclaimed by the next writer on this shard
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (!entry.referenced.load(std::memory_order_relaxed)) {
+        entry.referenced.store(true, std::memory_order_relaxed);
+    }
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    return entry.value;
+}
+
+bool ReadCache::put(const std::string& key, const std::string& value, uint64_t version) {
+    // Allocate outside the lock to keep the critical section short
+    return put_ref(key, std::make_shared<const std::string>(value), version);
+}
+
+bool ReadCache::put_ref(const std::string& key, ValueRef value, uint64_t version) {
+    uint64_t hash = std::hash<std::string>()(key);
+    Shard& shard = shard_for(hash);
+    uint64_t now = monotonic_now_us();
+    uint64_t expiry = now + ttl_us_.load(std::memory_order_relaxed);
+    size_t entry_bytes = key.size() + (value ? value->size() : 0);
+
+    // Values are released after the lock is dropped
+    std::vector<ValueRef> released;
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+    if (shard.sketch && shard.aging_due.exchange(false, std::memory_order_relaxed)) {
+        shard.sketch->age();
+    }
+
+    // The read behind this fill started before the key was last invalidated
+    if (version != 0 && version < tombstone_for(shard, hash)) {
+        shard.rejections.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        size_t slot = it->second;
+        if (version != 0 && version < shard.slots[slot].version) {
+            return false; // already holds a newer value
+        }
+        if (entry_bytes > max_bytes_per_shard_) {
+            remove_slot(shard, slot, released);
+            shard.rejections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Entry& entry = shard.slots[slot];
+        shard.bytes = shard.bytes - entry.bytes + entry_bytes;
+        released.push_back(std::move(entry.value));
+        entry.value = std::move(value);
+        entry.version = version;
+        entry.bytes = entry_bytes;
+        entry.expiry_us = expiry;
+        entry.referenced.store(true, std::memory_order_relaxed);
+
+        // A grown value may push the shard over its byte budget
+        while (shard.bytes > max_bytes_per_shard_) {
+            size_t victim = select_victim(shard, now);
+            if (victim == slot || victim == shard.capacity) {
+                break;
+            }
+            remove_slot(shard, victim, released);
+            shard.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    if (entry_bytes > max_bytes_per_shard_) {
+        shard.rejections.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Make room: CLOCK picks a victim, TinyLFU decides whether the newcomer
+    // is more valuable than it
+    while (shard.free_slots.empty() || shard.bytes + entry_bytes > max_bytes_per_shard_) {
+        size_t victim = select_victim(shard, now);
+        if (victim == shard.capacity) {
+            break;
+        }
+
+        const Entry& candidate = shard.slots[victim];
+        bool expired = candidate.expiry_us <= now;
+        if (!expired && shard.sketch &&
+            shard.sketch->estimate(hash) <= shard.sketch->estimate(candidate.hash)) {
+            shard.rejections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        remove_slot(shard, victim, released);
+        shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t slot = shard.free_slots.back();
+    shard.free_slots.pop_back();
+
+    Entry& entry = shard.slots[slot];
+    entry.key = key;
+    entry.value = std::move(value);
+    entry.hash = hash;
+    entry.version = version;
+    entry.expiry_us = expiry;
+    entry.bytes = entry_bytes;
+    entry.occupied = true;
+    entry.referenced.store(false, std::memory_order_relaxed);
+
+    shard.index.emplace(key, slot);
+    shard.bytes += entry_bytes;
+    return true;
+}
+
+bool ReadCache::erase(const std::string& key) {
+    uint64_t hash = std::hash<std::string>()(key);
+    Shard& shard = shard_for(hash);
+    std::vector<ValueRef> released;
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    remove_slot(shard, it->second, released);
+    return true;
+}
+
+bool ReadCache::invalidate(const std::string& key, uint64_t version) {
+    uint64_t hash = std::hash<std::string>()(key);
+    Shard& shard = shard_for(hash);
+    std::vector<ValueRef> released;
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    uint64_t& tombstone = tombstone_for(shard, hash);
+    tombstone = std::max(tombstone, version);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end() || shard.slots[it->second].version >= version) {
+        return false;
+    }
+    remove_slot(shard, it->second, released);
+    shard.invalidations.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ReadCache::clear() {
+    for (size_t i = 0; i < shard_count_; ++i) {
+        Shard& shard = shards_[i];
+        std::vector<ValueRef> released;
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        for (size_t slot = 0; slot < shard.capacity; ++slot) {
+            if (shard.slots[slot].occupied) {
+                remove_slot(shard, slot, released);
+            }
+        }
+        shard.hand = 0;
+    }
+}
+
+size_t ReadCache::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_count_; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        total += shards_[i].index.size();
+    }
+    return total;
+}
+
+size_t ReadCache::bytes() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_count_; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        total += shards_[i].bytes;
+    }
+    return total;
+}
+
+uint64_t ReadCache::get_hits() const {
+    return sum_counter(&Shard::hits);
+}
+
+uint64_t ReadCache::get_misses() const {
+    return sum_counter(&Shard::misses);
+}
+
+uint64_t ReadCache::get_evictions() const {
+    return sum_counter(&Shard::evictions);
+}
+
+uint64_t ReadCache::get_rejections() const {
+    return sum_counter(&Shard::rejections);
+}
+
+uint64_t ReadCache::get_invalidations() const {
+    return sum_counter(&Shard::invalidations);
+}
+
+uint64_t ReadCache::sum_counter(std::atomic<uint64_t> Shard::*counter) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < shard_count_; ++i) {
+        total += (shards_[i].*counter).load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t ReadCache::select_victim(Shard& shard, uint64_t now) {
+    // Two sweeps are enough: the first clears every reference bit
+    for (size_t steps = 0; steps < 2 * shard.capacity; ++steps) {
+        size_t slot = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.capacity;
+
+        Entry& entry = shard.slots[slot];
+        if (!entry.occupied) {
+            continue;
+        }
+        if (entry.expiry_us <= now) {
+            return slot;
+        }
+        if (entry.referenced.exchange(false, std::memory_order_relaxed)) {
+            continue;
+        }
+        return slot;
+    }
+    return shard.capacity;
+}
+
+void ReadCache::remove_slot(Shard& shard, size_t slot, std::vector<ValueRef>& released) {
+    Entry& entry = shard.slots[slot];
+    shard.index.erase(entry.key);
+    shard.bytes -= entry.bytes;
+    released.push_back(std::move(entry.value));
+    entry.key.clear();
+    entry.version = 0;
+    entry.bytes = 0;
+    entry.occupied = false;
+    entry.referenced.store(false, std::memory_order_relaxed);
+    shard.free_slots.push_back(slot);
+}
+
+} // namespace replication
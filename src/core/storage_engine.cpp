@@ -0,0 +1,85 @@
+#include "core/storage_engine.h"
+#include <mutex>
+
+namespace replication {
+
+ShardedStorageEngine::ShardedStorageEngine(size_t shard_count)
+    : shard_count_(shard_count > 0 ? shard_count : 1)
+    , shards_(new Shard[shard_count_]) {
+}
+
+ShardedStorageEngine::Shard& ShardedStorageEngine::shard_for(const std::string& key) const {
+    return shards_[std::hash<std::string>()(key) % shard_count_];
+}
+
+bool ShardedStorageEngine::get(const std::string& key, std::string& value) const {
+    ValueRef ref = get_ref(key);
+    if (!ref) {
+        return false;
+    }
+    value = *ref;
+    return true;
+}
+
+ValueRef ShardedStorageEngine::get_ref(const std::string& key) const {
+    Shard& shard = shard_for(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    
+    auto it = shard.data.find(key);
+    if (it != shard.data.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+void ShardedStorageEngine::put(const std::string& key, const std::string& value) {
+    // Allocate outside the lock to keep the critical section short
+    put_ref(key, std::make_shared<const std::string>(value));
+}
+
+void ShardedStorageEngine::put_ref(const std::string& key, ValueRef value) {
+    Shard& shard = shard_for(key);
+    ValueRef previous;
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto& slot = shard.data[key];
+        previous = std::move(slot);
+        slot = std::move(value);
+    }
+    // previous is released here, outside the lock
+}
+
+bool ShardedStorageEngine::erase(const std::string& key) {
+    Shard& shard = shard_for(key);
+    ValueRef previous;
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.data.find(key);
+        if (it == shard.data.end()) {
+            return false;
+        }
+        previous = std::move(it->second);
+        shard.data.erase(it);
+    }
+    return true;
+}
+
+size_t ShardedStorageEngine::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_count_; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        total += shards_[i].data.size();
+    }
+    return total;
+}
+
+void ShardedStorageEngine::for_each(const std::function<void(const std::string&, const ValueRef&)>& visitor) const {
+    for (size_t i = 0; i < shard_count_; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        for (const auto& entry : shards_[i].data) {
+            visitor(entry.first, entry.second);
+        }
+    }
+}
+
+} // namespace replication
@@ -0,0 +1,365 @@
+#include "core/write_ahead_log.h"
+#include "utils/checksum.h"
+#include "utils/durable_file.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace replication {
+
+namespace {
+
+constexpr const char* kSegmentPrefix = "wal-";
+constexpr const char* kSegmentSuffix = ".log";
+
+// u32 body length + u32 checksum
+constexpr size_t kFrameHeaderBytes = 8;
+// u64 lsn + u8 type + u32 key length + u32 value length
+constexpr size_t kBodyHeaderBytes = 17;
+
+template <typename T>
+void append_raw(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T read_raw(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(const DurabilityConfig& config)
+    : config_(config)
+    , next_lsn_(1)
+    , buffered_bytes_(0)
+    , syncing_(false)
+    , durable_lsn_(0)
+    , fd_(-1)
+    , stopping_(false)
+    , failed_(false)
+    , syncs_(0)
+    , records_(0) {
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        stopping_ = true;
+    }
+    sync_cv_.notify_all();
+    if (interval_thread_.joinable()) {
+        interval_thread_.join();
+    }
+
+    if (fd_ >= 0) {
+        sync();
+        ::close(fd_);
+    }
+}
+
+bool WriteAheadLog::open(uint64_t after_lsn, const std::function<void(const WalRecord&)>& replay) {
+    if (!durable_file::ensure_directory(config_.directory)) {
+        LOG_ERROR("Cannot create WAL directory " + config_.directory + ": " + std::strerror(errno));
+        return false;
+    }
+
+    uint64_t last_lsn = after_lsn;
+    std::vector<uint64_t> found = durable_file::list_numbered(config_.directory, kSegmentPrefix, kSegmentSuffix);
+    for (size_t i = 0; i < found.size(); ++i) {
+        segments_.push_back(found[i]);
+        if (replay_segment(segment_path(found[i]), after_lsn, last_lsn, replay)) {
+            continue;
+        }
+        // Segments are synced before the next one is created, so only the
+        // newest can be torn; anything after it would leave a gap in the log
+        for (size_t later = i + 1; later < found.size(); ++later) {
+            LOG_WARNING("Discarding WAL segment past a torn record: " + segment_path(found[later]));
+            ::unlink(segment_path(found[later]).c_str());
+        }
+        break;
+    }
+
+    next_lsn_ = last_lsn + 1;
+    durable_lsn_ = last_lsn;
+    if (!open_segment(next_lsn_)) {
+        return false;
+    }
+
+    if (config_.sync_policy == WalSyncPolicy::INTERVAL) {
+        interval_thread_ = std::thread(&WriteAheadLog::interval_sync_loop, this);
+    }
+    return true;
+}
+
+bool WriteAheadLog::replay_segment(const std::string& path, uint64_t after_lsn, uint64_t& last_lsn,
+                                   const std::function<void(const WalRecord&)>& replay) {
+    int fd = ::open(path.c_str(), O_RDWR);
+    struct stat info;
+    if (fd < 0 || ::fstat(fd, &info) != 0) {
+        LOG_ERROR("Cannot read WAL segment " + path + ": " + std::strerror(errno));
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    std::string contents(static_cast<size_t>(info.st_size), '\0');
+    size_t loaded = 0;
+    while (loaded < contents.size()) {
+        ssize_t got = ::pread(fd, &contents[loaded], contents.size() - loaded, static_cast<off_t>(loaded));
+        if (got <= 0) {
+            break;
+        }
+        loaded += static_cast<size_t>(got);
+    }
+    contents.resize(loaded);
+
+    size_t offset = 0;
+    WalRecord record;
+    while (contents.size() - offset >= kFrameHeaderBytes) {
+        const char* frame = contents.data() + offset;
+        uint32_t body_length = read_raw<uint32_t>(frame);
+        uint32_t checksum = read_raw<uint32_t>(frame + 4);
+        if (body_length < kBodyHeaderBytes || body_length > contents.size() - offset - kFrameHeaderBytes) {
+            break;
+        }
+        const char* body = frame + kFrameHeaderBytes;
+        if (crc32(body, body_length) != checksum) {
+            break;
+        }
+        uint32_t key_length = read_raw<uint32_t>(body + 9);
+        uint32_t value_length = read_raw<uint32_t>(body + 13);
+        if (static_cast<uint64_t>(key_length) + value_length + kBodyHeaderBytes != body_length) {
+            break;
+        }
+
+        record.lsn = read_raw<uint64_t>(body);
+        record.type = static_cast<WalRecordType>(body[8]);
+        if (record.lsn > after_lsn) {
+            if (record.lsn != last_lsn + 1) {
+                LOG_WARNING("WAL gap before LSN " + std::to_string(record.lsn) + " in " + path);
+            }
+            record.key.assign(body + kBodyHeaderBytes, key_length);
+            record.value.assign(body + kBodyHeaderBytes + key_length, value_length);
+            replay(record);
+            last_lsn = record.lsn;
+        } else {
+            last_lsn = std::max(last_lsn, record.lsn);
+        }
+        offset += kFrameHeaderBytes + body_length;
+    }
+
+    bool intact = offset == contents.size();
+    if (!intact) {
+        LOG_WARNING("Truncating torn WAL tail in " + path + " at byte " + std::to_string(offset));
+        if (::ftruncate(fd, static_cast<off_t>(offset)) != 0 || !durable_file::sync_data(fd)) {
+            LOG_ERROR("Cannot truncate WAL segment " + path + ": " + std::strerror(errno));
+        }
+    }
+    ::close(fd);
+    return intact;
+}
+
+bool WriteAheadLog::open_segment(uint64_t first_lsn) {
+    std::string path = segment_path(first_lsn);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Cannot open WAL segment " + path + ": " + std::strerror(errno));
+        failed_.store(true);
+        return false;
+    }
+    durable_file::sync_directory(config_.directory);
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = fd;
+    if (segments_.empty() || segments_.back() != first_lsn) {
+        segments_.push_back(first_lsn);
+    }
+    return true;
+}
+
+std::string WriteAheadLog::segment_path(uint64_t first_lsn) const {
+    return durable_file::numbered_path(config_.directory, kSegmentPrefix, first_lsn, kSegmentSuffix);
+}
+
+void WriteAheadLog::encode_record(uint64_t lsn, WalRecordType type, const std::string& key,
+                                  const std::string& value) {
+    // Caller holds append_mutex_
+    size_t frame_start = buffer_.size();
+    uint32_t body_length = static_cast<uint32_t>(kBodyHeaderBytes + key.size() + value.size());
+    append_raw<uint32_t>(buffer_, body_length);
+    append_raw<uint32_t>(buffer_, 0); // checksum, filled in below
+    append_raw<uint64_t>(buffer_, lsn);
+    buffer_.push_back(static_cast<char>(type));
+    append_raw<uint32_t>(buffer_, static_cast<uint32_t>(key.size()));
+    append_raw<uint32_t>(buffer_, static_cast<uint32_t>(value.size()));
+    buffer_.append(key);
+    buffer_.append(value);
+
+    uint32_t checksum = crc32(buffer_.data() + frame_start + kFrameHeaderBytes, body_length);
+    std::memcpy(&buffer_[frame_start + 4], &checksum, sizeof(checksum));
+    records_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool WriteAheadLog::wait_durable(uint64_t lsn) {
+    if (config_.sync_policy == WalSyncPolicy::INTERVAL) {
+        return !failed_.load(); // the interval thread bounds what a crash can lose
+    }
+    return sync_through(lsn, config_.sync_policy == WalSyncPolicy::PER_BATCH);
+}
+
+bool WriteAheadLog::sync() {
+    return sync_through(get_last_lsn(), false);
+}
+
+bool WriteAheadLog::sync_through(uint64_t lsn, bool gather) {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    while (durable_lsn_ < lsn) {
+        if (failed_.load()) {
+            return false;
+        }
+        if (syncing_) {
+            // The current leader may already cover lsn; if not, one of the
+            // woken waiters leads the next round
+            sync_cv_.wait(lock);
+            continue;
+        }
+
+        syncing_ = true;
+        lock.unlock();
+        if (gather && buffered_bytes_.load(std::memory_order_relaxed) < config_.group_commit_bytes) {
+            std::this_thread::sleep_for(std::chrono::microseconds(config_.group_commit_delay_us));
+        }
+        uint64_t flushed_lsn = 0;
+        bool flushed = flush(flushed_lsn, false);
+        lock.lock();
+        if (flushed) {
+            durable_lsn_ = std::max(durable_lsn_, flushed_lsn);
+        }
+        step_down(lock);
+    }
+    return true;
+}
+
+void WriteAheadLog::become_leader(std::unique_lock<std::mutex>& lock) {
+    sync_cv_.wait(lock, [this]() { return !syncing_; });
+    syncing_ = true;
+}
+
+void WriteAheadLog::step_down(std::unique_lock<std::mutex>& lock) {
+    (void)lock; // held by the caller
+    syncing_ = false;
+    sync_cv_.notify_all();
+}
+
+bool WriteAheadLog::flush(uint64_t& flushed_lsn, bool rotate_segment) {
+    bool new_segment = false;
+    {
+        std::lock_guard<std::mutex> lock(append_mutex_);
+        spare_buffer_.swap(buffer_);
+        buffered_bytes_.store(0, std::memory_order_relaxed);
+        flushed_lsn = next_lsn_ - 1;
+        // An empty segment is reused rather than rotated past
+        new_segment = rotate_segment && segments_.back() <= flushed_lsn;
+    }
+
+    if (failed_.load()) {
+        spare_buffer_.clear();
+        return false;
+    }
+
+    bool ok = true;
+    if (!spare_buffer_.empty()) {
+        ok = durable_file::write_all(fd_, spare_buffer_.data(), spare_buffer_.size()) &&
+             durable_file::sync_data(fd_);
+        syncs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    spare_buffer_.clear(); // keeps its capacity for the next round
+    if (!ok) {
+        LOG_ERROR("WAL write failed in " + config_.directory + ": " + std::strerror(errno));
+        failed_.store(true);
+        return false;
+    }
+
+    if (new_segment) {
+        // Records appended since the swap are still buffered and land in the
+        // new segment
+        return open_segment(flushed_lsn + 1);
+    }
+    return true;
+}
+
+uint64_t WriteAheadLog::rotate() {
+    uint64_t rotated_at = 0;
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    become_leader(lock);
+    lock.unlock();
+    bool flushed = flush(rotated_at, true);
+    lock.lock();
+    if (flushed) {
+        durable_lsn_ = std::max(durable_lsn_, rotated_at);
+    }
+    step_down(lock);
+    return rotated_at;
+}
+
+void WriteAheadLog::remove_segments_through(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    become_leader(lock);
+    lock.unlock();
+
+    // A segment is covered when the one after it starts at or below lsn + 1
+    size_t removable = 0;
+    while (removable + 1 < segments_.size() && segments_[removable + 1] <= lsn + 1) {
+        ::unlink(segment_path(segments_[removable]).c_str());
+        ++removable;
+    }
+    segments_.erase(segments_.begin(), segments_.begin() + removable);
+    if (removable > 0) {
+        durable_file::sync_directory(config_.directory);
+    }
+
+    lock.lock();
+    step_down(lock);
+}
+
+uint64_t WriteAheadLog::get_last_lsn() const {
+    std::lock_guard<std::mutex> lock(append_mutex_);
+    return next_lsn_ - 1;
+}
+
+uint64_t WriteAheadLog::get_durable_lsn() const {
+    std::lock_guard<std::mutex> lock(sync_mutex_);
+    return durable_lsn_;
+}
+
+void WriteAheadLog::interval_sync_loop() {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    while (!stopping_) {
+        sync_cv_.wait_for(lock, std::chrono::microseconds(config_.sync_interval_us));
+        if (stopping_ || buffered_bytes_.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+
+        become_leader(lock);
+        lock.unlock();
+        uint64_t flushed_lsn = 0;
+        bool flushed = flush(flushed_lsn, false);
+        lock.lock();
+        if (flushed) {
+            durable_lsn_ = std::max(durable_lsn_, flushed_lsn);
+        }
+        step_down(lock);
+    }
+}
+
+} // namespace replication
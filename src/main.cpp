@@ -2,6 +2,7 @@
 #include "protocols/hybrid_protocol.h"
 #include "network/network_manager.h"
 #include "performance/metrics.h"
+#include "performance/metrics_endpoint.h"
 #include "utils/logger.h"
 #include <iostream>
 #include <vector>
@@ -32,6 +33,8 @@ void print_usage(const char* program_name) {
               << "  --mode MODE         Replication mode: chain, quorum, hybrid (default: hybrid)\n"
               << "  --log-level LEVEL   Log level: debug, info, warn, error (default: info)\n"
               << "  --log-file FILE     Log file path (optional)\n"
+              << "  --metrics-port PORT Serve GET /metrics on PORT (default: off)\n"
+              << "  --perf-counters     Sample CPU cycles and cache misses via perf events\n"
               << "  --demo              Run demo workload\n"
               << "  --benchmark         Run performance benchmark\n"
               << "  --help              Show this help message\n"
@@ -45,6 +48,8 @@ struct Config {
     ReplicationMode mode = ReplicationMode::HYBRID_AUTO;
     LogLevel log_level = LogLevel::INFO;
     std::string log_file;
+    uint16_t metrics_port = 0;
+    bool perf_counters = false;
     bool run_demo = false;
     bool run_benchmark = false;
 };
@@ -84,6 +89,10 @@ bool parse_args(int argc, char* argv[], Config& config) {
             else if (level_str == "error") config.log_level = LogLevel::ERROR;
         } else if (arg == "--log-file" && i + 1 < argc) {
             config.log_file = argv[++i];
+        } else if (arg == "--metrics-port" && i + 1 < argc) {
+            config.metrics_port = static_cast<uint16_t>(std::stoul(argv[++i]));
+        } else if (arg == "--perf-counters") {
+            config.perf_counters = true;
         } else if (arg == "--demo") {
             config.run_demo = true;
         } else if (arg == "--benchmark") {
@@ -339,6 +348,8 @@ int main(int argc, char* argv[]) {
     if (!config.log_file.empty()) {
         logger.setLogFile(config.log_file);
     }
+    // Keep console and file I/O off the request path
+    logger.enableAsync();
     
     LOG_INFO("Starting Hybrid Chain-Quorum Replication Node " + std::to_string(config.node_id));
     
@@ -348,8 +359,12 @@ int main(int argc, char* argv[]) {
         cluster_nodes.push_back(config.node_id);
         std::sort(cluster_nodes.begin(), cluster_nodes.end());
         
-        // Initialize performance monitoring
+        // Initialize performance monitoring. Hardware counters only follow
+        // threads started afterwards, so open them before anything else runs.
         g_performance_monitor = std::make_unique<PerformanceMonitor>();
+        if (config.perf_counters) {
+            g_performance_monitor->enable_hardware_counters(true);
+        }
         
         // Create node
         auto node = std::make_shared<Node>(config.node_id, cluster_nodes);
@@ -362,7 +377,6 @@ int main(int argc, char* argv[]) {
         std::vector<uint32_t> quorum_nodes = cluster_nodes;
         
         auto hybrid_protocol = std::make_shared<HybridProtocol>(node, chain_order, quorum_nodes);
-        hybrid_protocol->set_read_preference(config.mode);
         hybrid_protocol->set_write_preference(config.mode);
         
         // Enable optimizations
@@ -370,6 +384,7 @@ int main(int argc, char* argv[]) {
         hybrid_protocol->enable_load_balancing(true);
         hybrid_protocol->enable_caching(true);
         hybrid_protocol->enable_request_batching(true);
+        hybrid_protocol->enable_chain_reordering(true);
         
         // Start services
         if (!node->start()) {
@@ -391,7 +406,24 @@ int main(int argc, char* argv[]) {
         }
         
         // Start heartbeat
-        network_manager->start_heartbeat(30000); // 30 seconds
+        // Probes only idle links; liveness is judged by phi, not the interval
+        network_manager->start_heartbeat(1000);
+        
+        // Sample resources once a second; the endpoint serves the snapshots
+        NetworkManager* transport = network_manager.get();
+        g_performance_monitor->set_network_byte_source([transport]() {
+            return transport->get_bytes_transferred();
+        });
+        g_performance_monitor->start_sampler(1000);
+        
+        std::unique_ptr<MetricsEndpoint> metrics_endpoint;
+        if (config.metrics_port != 0) {
+            metrics_endpoint = std::make_unique<MetricsEndpoint>(*g_performance_monitor, config.metrics_port);
+            if (!metrics_endpoint->start()) {
+                LOG_WARNING("Metrics endpoint disabled");
+                metrics_endpoint.reset();
+            }
+        }
         
         LOG_INFO("Node started successfully. Listening on port " + std::to_string(config.port));
         
@@ -441,6 +473,8 @@ int main(int argc, char* argv[]) {
         LOG_INFO("Shutting down node " + std::to_string(config.node_id));
         
         // Clean shutdown
+        metrics_endpoint.reset();
+        g_performance_monitor->stop_sampler();
         network_manager->stop();
         node->stop();
         
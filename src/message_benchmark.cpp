@@ -0,0 +1,162 @@
+#include "core/message.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace replication;
+
+// Micro-benchmark comparing the binary wire format with the text fallback
+
+namespace {
+
+// Prevents the compiler from optimizing away benchmark results
+volatile size_t g_sink = 0;
+
+struct CodecResults {
+    double encode_ns;
+    double decode_ns;
+    double view_decode_ns;
+    size_t encoded_bytes;
+};
+
+Message make_message(size_t value_size) {
+    Message msg;
+    msg.type = MessageType::WRITE_REQUEST;
+    msg.sender_id = 3;
+    msg.receiver_id = 1;
+    msg.key = "bench_key_12345";
+    msg.value = std::string(value_size, 'x');
+    msg.success = true;
+    msg.timestamp = 1700000000000000ULL;
+    msg.sequence_number = 42;
+    msg.ballot = (7ULL << 16) | 3;
+    msg.log_index = 123456;
+    msg.correlation_id = "req-000042";
+    msg.target_nodes = {1, 2, 3, 4, 5};
+    msg.metadata = "bench";
+    return msg;
+}
+
+template <typename Fn>
+double time_ns_per_op(int iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int iterations_for(size_t value_size) {
+    if (value_size >= 65536) return 2000;
+    if (value_size >= 1024) return 50000;
+    return 200000;
+}
+
+CodecResults bench_binary(const Message& msg, int iterations) {
+    CodecResults results;
+    std::string buffer;
+
+    results.encode_ns = time_ns_per_op(iterations, [&]() {
+        buffer.clear();
+        msg.serialize_to(buffer);
+        g_sink += buffer.size();
+    });
+    results.encoded_bytes = buffer.size();
+
+    results.decode_ns = time_ns_per_op(iterations, [&]() {
+        Message decoded = Message::deserialize(buffer);
+        g_sink += decoded.value.size();
+    });
+
+    results.view_decode_ns = time_ns_per_op(iterations, [&]() {
+        MessageView view;
+        if (MessageView::parse(buffer.data(), buffer.size(), view)) {
+            g_sink += view.value.size();
+        }
+    });
+
+    return results;
+}
+
+CodecResults bench_text(const Message& msg, int iterations) {
+    CodecResults results;
+    std::string buffer;
+
+    results.encode_ns = time_ns_per_op(iterations, [&]() {
+        buffer = msg.serialize_text();
+        g_sink += buffer.size();
+    });
+    results.encoded_bytes = buffer.size();
+
+    results.decode_ns = time_ns_per_op(iterations, [&]() {
+        Message decoded = Message::deserialize_text(buffer);
+        g_sink += decoded.value.size();
+    });
+    results.view_decode_ns = 0.0;
+
+    return results;
+}
+
+bool verify_round_trip(const Message& msg) {
+    Message decoded = Message::deserialize(msg.serialize());
+    return decoded.type == msg.type &&
+           decoded.sender_id == msg.sender_id &&
+           decoded.receiver_id == msg.receiver_id &&
+           decoded.key == msg.key &&
+           decoded.value == msg.value &&
+           decoded.success == msg.success &&
+           decoded.timestamp == msg.timestamp &&
+           decoded.sequence_number == msg.sequence_number &&
+           decoded.ballot == msg.ballot &&
+           decoded.log_index == msg.log_index &&
+           decoded.correlation_id == msg.correlation_id &&
+           decoded.target_nodes == msg.target_nodes &&
+           decoded.metadata == msg.metadata;
+}
+
+void print_row(const std::string& format, size_t value_size, const CodecResults& results) {
+    std::cout << std::left << std::setw(8) << format
+              << std::right << std::setw(8) << value_size
+              << std::setw(10) << results.encoded_bytes
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << results.encode_ns
+              << std::setw(14) << results.decode_ns;
+    if (results.view_decode_ns > 0.0) {
+        std::cout << std::setw(14) << results.view_decode_ns;
+    } else {
+        std::cout << std::setw(14) << "-";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Message Wire Format Micro-Benchmark" << std::endl;
+    std::cout << "===================================" << std::endl;
+    std::cout << std::left << std::setw(8) << "format"
+              << std::right << std::setw(8) << "value"
+              << std::setw(10) << "bytes"
+              << std::setw(14) << "encode ns/op"
+              << std::setw(14) << "decode ns/op"
+              << std::setw(14) << "view ns/op" << std::endl;
+
+    const std::vector<size_t> value_sizes = {64, 1024, 65536};
+
+    for (size_t value_size : value_sizes) {
+        Message msg = make_message(value_size);
+        if (!verify_round_trip(msg)) {
+            std::cerr << "Binary round trip failed for " << value_size << "B value" << std::endl;
+            return 1;
+        }
+
+        int iterations = iterations_for(value_size);
+        print_row("binary", value_size, bench_binary(msg, iterations));
+        print_row("text", value_size, bench_text(msg, iterations));
+    }
+
+    return 0;
+}
@@ -1,29 +1,115 @@
 #include "network/network_manager.h"
+#include "utils/clock.h"
 #include "utils/logger.h"
 #include <algorithm>
 #include <chrono>
 #include <thread>
 #include <cstring>
+#include <cerrno>
+#include <climits>
 #include <iostream>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
-// Simplified networking for demo purposes
-// In a production system, this would use proper socket programming
+// Non-blocking epoll transport. Each peer gets connection_pool_size_
+// persistent outbound streams; inbound connections are receive-only, so
+// replies travel over the receiver's own outbound streams.
 
 namespace replication {
 
+namespace {
+
+constexpr int kMaxEpollEvents = 64;
+constexpr int kMaxIovecs = 64;
+constexpr size_t kReadChunkSize = 64 * 1024;
+constexpr size_t kDefaultMaxQueuedBytes = 8 * 1024 * 1024;
+constexpr uint64_t kMinBatchPollIntervalUs = 50;
+constexpr uint64_t kHeartbeatTicksPerInterval = 10;
+
+// Marks a BATCH_REQUEST produced by send coalescing; its value is a
+// concatenation of complete frames
+const char* const kCoalescedBatchTag = "coalesced";
+// Marks a BATCH_REQUEST wrapping one compressed frame: sequence_number is
+// the codec, log_index the frame's raw size, value the compressed bytes
+const char* const kCompressedFrameTag = "compressed";
+// Marks the HEARTBEAT that opens every outbound stream; log_index is the
+// mask of codecs the sender can decode
+const char* const kCodecOfferTag = "codec_offer";
+
+// Below this, frames are mostly control messages that compress poorly and
+// would only pay the CPU cost
+constexpr size_t kDefaultCompressionMinBytes = 1024;
+// Refuse envelopes claiming more than this, rather than allocate it
+constexpr uint64_t kMaxDecompressedFrameBytes = 64 * 1024 * 1024;
+
+uint64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void set_socket_option(int fd, int level, int option, int value) {
+    setsockopt(fd, level, option, &value, sizeof(value));
+}
+
+bool resolve_endpoint(const NodeEndpoint& endpoint, sockaddr_in& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(endpoint.port);
+    
+    if (inet_pton(AF_INET, endpoint.hostname.c_str(), &addr.sin_addr) == 1) {
+        return true;
+    }
+    
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    
+    addrinfo* result = nullptr;
+    if (getaddrinfo(endpoint.hostname.c_str(), nullptr, &hints, &result) != 0 || !result) {
+        return false;
+    }
+    addr.sin_addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr;
+    freeaddrinfo(result);
+    return true;
+}
+
+} // namespace
+
 NetworkManager::NetworkManager(uint32_t node_id, uint16_t listen_port)
     : node_id_(node_id)
     , listen_port_(listen_port)
     , running_(false)
+    , listen_fd_(-1)
+    , listener_epoll_fd_(-1)
+    , sender_epoll_fd_(-1)
+    , sender_wakeup_fd_(-1)
     , compression_enabled_(false)
+    , compression_min_bytes_(kDefaultCompressionMinBytes)
+    , compression_codec_(CompressionCodec::LZ)
     , message_batching_enabled_(true)
     , reliable_delivery_enabled_(true)
-    , batch_timeout_(100)
-    , connection_pool_size_(10)
+    , batch_flush_deadline_us_(500)
+    , batch_max_messages_(64)
+    , batch_max_bytes_(64 * 1024)
+    , connection_pool_size_(1)
+    , max_queued_bytes_(kDefaultMaxQueuedBytes)
     , max_retry_attempts_(3)
     , message_timeout_(5000)
     , heartbeat_running_(false)
-    , heartbeat_interval_(30000) {
+    , heartbeat_interval_(30000)
+    , heartbeat_probes_sent_(0)
+    , peer_telemetry_(std::make_shared<PeerTelemetry>())
+    , bytes_sent_(0)
+    , bytes_received_(0) {
     
     LOG_INFO("NetworkManager initialized for node " + std::to_string(node_id_) + 
              " on port " + std::to_string(listen_port_));
@@ -39,9 +125,29 @@ bool NetworkManager::start() {
         return false;
     }
     
+    // Writes to a peer that reset the connection must not kill the process
+    signal(SIGPIPE, SIG_IGN);
+    
+    if (!open_listen_socket()) {
+        return false;
+    }
+    
+    sender_epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    sender_wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sender_epoll_fd_ < 0 || sender_wakeup_fd_ < 0) {
+        LOG_ERROR("Failed to create sender event loop: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    
+    epoll_event wakeup_event;
+    std::memset(&wakeup_event, 0, sizeof(wakeup_event));
+    wakeup_event.events = EPOLLIN;
+    wakeup_event.data.fd = sender_wakeup_fd_;
+    epoll_ctl(sender_epoll_fd_, EPOLL_CTL_ADD, sender_wakeup_fd_, &wakeup_event);
+    
     running_.store(true);
     
-    // Start listener thread (simplified)
+    // Start listener thread
     listener_thread_ = std::thread(&NetworkManager::listener_loop, this);
     
     // Start sender thread
@@ -69,6 +175,7 @@ void NetworkManager::stop() {
     }
     
     // Wait for threads to finish
+    wake_sender();
     if (listener_thread_.joinable()) {
         listener_thread_.join();
     }
@@ -79,6 +186,29 @@ void NetworkManager::stop() {
         batch_processor_thread_.join();
     }
     
+    // Tear down all peer streams and inbound connections
+    std::vector<uint32_t> peers;
+    {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
+        for (const auto& entry : connection_pool_) {
+            peers.push_back(entry.first);
+        }
+    }
+    for (uint32_t peer : peers) {
+        close_connection(peer);
+    }
+    for (const auto& entry : inbound_buffers_) {
+        close(entry.first);
+    }
+    inbound_buffers_.clear();
+    
+    for (int* fd : {&listen_fd_, &listener_epoll_fd_, &sender_epoll_fd_, &sender_wakeup_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    
     LOG_INFO("NetworkManager stopped");
 }
 
@@ -91,13 +221,18 @@ void NetworkManager::add_node(uint32_t node_id, const std::string& hostname, uin
 }
 
 void NetworkManager::remove_node(uint32_t node_id) {
-    std::lock_guard<std::mutex> lock(nodes_mutex_);
-    
-    auto it = known_nodes_.find(node_id);
-    if (it != known_nodes_.end()) {
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        
+        auto it = known_nodes_.find(node_id);
+        if (it == known_nodes_.end()) {
+            return;
+        }
         known_nodes_.erase(it);
-        LOG_INFO("Removed node " + std::to_string(node_id));
     }
+    
+    close_connection(node_id);
+    LOG_INFO("Removed node " + std::to_string(node_id));
 }
 
 bool NetworkManager::is_node_reachable(uint32_t node_id) const {
@@ -133,30 +268,39 @@ bool NetworkManager::send_message(uint32_t target_node, const Message& message)
         return false;
     }
     
+    // Tells the peer we are alive, so its link needs no probe for a while
+    failure_detector_.on_send(target_node);
+    
     // Use message batching if enabled
     if (message_batching_enabled_) {
-        std::lock_guard<std::mutex> lock(batch_mutex_);
-        pending_batches_[target_node].push_back(message);
+        PeerBatchQueue& queue = get_batch_queue(target_node);
+        std::string frame = frame_pool_.acquire();
+        message.serialize_to(frame);
+        size_t frame_size = frame.size();
+        
+        // Counters are bumped before the push so they never undercount
+        uint64_t expected = 0;
+        queue.oldest_enqueue_us.compare_exchange_strong(expected, now_us());
+        size_t count = queue.pending_count.fetch_add(1) + 1;
+        size_t bytes = queue.pending_bytes.fetch_add(frame_size) + frame_size;
+        queue.frames.push(std::move(frame));
         
-        // Send immediately if batch is full
-        if (pending_batches_[target_node].size() >= 10) {
-            process_message_batch(target_node);
+        // Flush inline once a threshold is crossed; if another thread is
+        // already flushing it will pick this frame up
+        if (count >= batch_max_messages_ || bytes >= batch_max_bytes_) {
+            flush_batch_queue(target_node, queue, false);
         }
         
         return true;
     }
     
-    // Simplified sending - just log for demo
     LOG_DEBUG("Sending message type " + std::to_string(static_cast<int>(message.type)) + 
               " to node " + std::to_string(target_node));
     
-    // Update statistics
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        message_counts_[target_node]++;
-    }
-    
-    return true;
+    std::string frame = frame_pool_.acquire();
+    message.serialize_to(frame);
+    compress_frame(target_node, frame);
+    return send_raw_message(target_node, std::move(frame), std::hash<std::string>()(message.key));
 }
 
 bool NetworkManager::broadcast_message(const std::vector<uint32_t>& target_nodes, const Message& message) {
@@ -178,18 +322,7 @@ void NetworkManager::set_message_handler(std::function<void(const Message&)> han
 }
 
 double NetworkManager::get_network_latency(uint32_t target_node) const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    
-    auto it = latency_history_.find(target_node);
-    if (it != latency_history_.end() && !it->second.empty()) {
-        uint64_t total_latency = 0;
-        for (uint64_t latency : it->second) {
-            total_latency += latency;
-        }
-        return static_cast<double>(total_latency) / it->second.size() / 1000.0;
-    }
-    
-    return 0.0;
+    return peer_telemetry_->get_stats(target_node).mean_rtt_us / 1000.0;
 }
 
 double NetworkManager::get_packet_loss_rate(uint32_t target_node) const {
@@ -207,22 +340,81 @@ double NetworkManager::get_packet_loss_rate(uint32_t target_node) const {
 }
 
 size_t NetworkManager::get_message_queue_size() const {
-    std::lock_guard<std::mutex> lock(batch_mutex_);
-    
     size_t total_size = 0;
-    for (const auto& batch : pending_batches_) {
-        total_size += batch.second.size();
+    {
+        std::shared_lock<std::shared_mutex> lock(batch_queues_mutex_);
+        for (const auto& entry : peer_batches_) {
+            total_size += entry.second->pending_count.load();
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+    for (const auto& entry : connection_pool_) {
+        for (const auto& connection : entry.second) {
+            std::lock_guard<std::mutex> conn_lock(connection->mutex);
+            total_size += connection->outbound_frames.size();
+        }
     }
     
     return total_size;
 }
 
+PeerBatchStats NetworkManager::get_peer_batch_stats(uint32_t target_node) const {
+    std::shared_lock<std::shared_mutex> lock(batch_queues_mutex_);
+    
+    auto it = peer_batches_.find(target_node);
+    if (it == peer_batches_.end()) {
+        return PeerBatchStats();
+    }
+    
+    std::lock_guard<std::mutex> flush_lock(it->second->flush_mutex);
+    return it->second->stats;
+}
+
+std::unordered_map<uint32_t, PeerBatchStats> NetworkManager::get_all_batch_stats() const {
+    std::shared_lock<std::shared_mutex> lock(batch_queues_mutex_);
+    
+    std::unordered_map<uint32_t, PeerBatchStats> all_stats;
+    for (const auto& entry : peer_batches_) {
+        std::lock_guard<std::mutex> flush_lock(entry.second->flush_mutex);
+        all_stats[entry.first] = entry.second->stats;
+    }
+    return all_stats;
+}
+
+PeerCompressionStats NetworkManager::get_peer_compression_stats(uint32_t peer) const {
+    std::lock_guard<std::mutex> lock(compression_mutex_);
+    
+    auto it = compression_stats_.find(peer);
+    return it != compression_stats_.end() ? it->second : PeerCompressionStats();
+}
+
+std::unordered_map<uint32_t, PeerCompressionStats> NetworkManager::get_all_compression_stats() const {
+    std::lock_guard<std::mutex> lock(compression_mutex_);
+    return compression_stats_;
+}
+
+size_t NetworkManager::get_queued_bytes(uint32_t target_node) const {
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+    
+    size_t total_bytes = 0;
+    auto it = connection_pool_.find(target_node);
+    if (it != connection_pool_.end()) {
+        for (const auto& connection : it->second) {
+            std::lock_guard<std::mutex> conn_lock(connection->mutex);
+            total_bytes += connection->queued_bytes;
+        }
+    }
+    return total_bytes;
+}
+
 void NetworkManager::start_heartbeat(uint64_t interval_ms) {
     if (heartbeat_running_.load()) {
         return;
     }
     
-    heartbeat_interval_ = interval_ms;
+    heartbeat_interval_ = std::max<uint64_t>(interval_ms, 1);
+    failure_detector_.set_probe_interval(heartbeat_interval_);
     heartbeat_running_.store(true);
     heartbeat_thread_ = std::thread(&NetworkManager::heartbeat_loop, this);
     
@@ -244,124 +436,752 @@ void NetworkManager::stop_heartbeat() {
 }
 
 void NetworkManager::handle_heartbeat(uint32_t sender_node) {
-    update_node_status(sender_node, true);
+    // The arrival itself was recorded with the frame; liveness changes are
+    // the heartbeat thread's to report
     LOG_DEBUG("Received heartbeat from node " + std::to_string(sender_node));
 }
 
+void NetworkManager::set_liveness_handler(std::function<void(uint32_t node_id, PeerLiveness liveness)> handler) {
+    liveness_handler_ = handler;
+}
+
+PeerLiveness NetworkManager::get_peer_liveness(uint32_t node_id) const {
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    
+    auto it = known_nodes_.find(node_id);
+    return it != known_nodes_.end() ? it->second.liveness : PeerLiveness::UNKNOWN;
+}
+
 void NetworkManager::listener_loop() {
-    // Simplified listener for demo
+    epoll_event events[kMaxEpollEvents];
+    
     while (running_.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        int ready = epoll_wait(listener_epoll_fd_, events, kMaxEpollEvents, 100);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("Listener epoll_wait failed: " + std::string(std::strerror(errno)));
+            break;
+        }
         
-        // Simulate receiving messages occasionally
-        if (message_handler_) {
-            // This would process incoming network messages in a real implementation
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd_) {
+                accept_connections();
+                continue;
+            }
+            
+            bool keep_open = !(events[i].events & (EPOLLERR | EPOLLHUP)) || (events[i].events & EPOLLIN);
+            if (keep_open && (events[i].events & EPOLLIN)) {
+                keep_open = receive_raw_message(fd);
+            }
+            
+            if (!keep_open) {
+                epoll_ctl(listener_epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+                inbound_buffers_.erase(fd);
+                close(fd);
+            }
         }
     }
 }
 
 void NetworkManager::sender_loop() {
+    epoll_event events[kMaxEpollEvents];
+    
     while (running_.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        int ready = epoll_wait(sender_epoll_fd_, events, kMaxEpollEvents, 10);
+        if (ready < 0 && errno != EINTR) {
+            LOG_ERROR("Sender epoll_wait failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+        
+        std::vector<std::shared_ptr<PeerConnection>> to_flush;
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.fd == sender_wakeup_fd_) {
+                uint64_t counter;
+                while (read(sender_wakeup_fd_, &counter, sizeof(counter)) > 0) {}
+                continue;
+            }
+            
+            // A stream became writable (connect completed or socket buffer drained)
+            auto* raw = static_cast<PeerConnection*>(events[i].data.ptr);
+            std::lock_guard<std::mutex> lock(connection_mutex_);
+            for (const auto& entry : connection_pool_) {
+                for (const auto& connection : entry.second) {
+                    if (connection.get() == raw) {
+                        to_flush.push_back(connection);
+                    }
+                }
+            }
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(dirty_mutex_);
+            to_flush.insert(to_flush.end(), dirty_connections_.begin(), dirty_connections_.end());
+            dirty_connections_.clear();
+        }
+        
+        for (const auto& connection : to_flush) {
+            flush_connection(connection);
+        }
     }
 }
 
 void NetworkManager::batch_processor_loop() {
     while (running_.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(batch_timeout_));
+        uint64_t deadline_us = batch_flush_deadline_us_;
+        std::this_thread::sleep_for(std::chrono::microseconds(
+            std::max(deadline_us / 2, kMinBatchPollIntervalUs)));
         
-        std::lock_guard<std::mutex> lock(batch_mutex_);
-        for (auto& batch_pair : pending_batches_) {
-            if (!batch_pair.second.empty()) {
-                process_message_batch(batch_pair.first);
+        // Flush only peers whose oldest frame has reached the deadline
+        uint64_t now = now_us();
+        std::vector<std::pair<uint32_t, PeerBatchQueue*>> due;
+        {
+            std::shared_lock<std::shared_mutex> lock(batch_queues_mutex_);
+            for (auto& entry : peer_batches_) {
+                uint64_t oldest = entry.second->oldest_enqueue_us.load();
+                if (oldest != 0 && now - oldest >= deadline_us) {
+                    due.emplace_back(entry.first, entry.second.get());
+                }
             }
         }
+        
+        // Queues are never erased while running, so the pointers stay valid
+        for (auto& entry : due) {
+            flush_batch_queue(entry.first, *entry.second, true);
+        }
     }
 }
 
 void NetworkManager::heartbeat_loop() {
+    // Ticks well inside the interval, so a probe is never much later than
+    // the peer's detector expects it
+    const uint64_t tick_us = std::max<uint64_t>(heartbeat_interval_ * 1000 / kHeartbeatTicksPerInterval, 1000);
+    
     while (heartbeat_running_.load() && running_.load()) {
         Message heartbeat_msg;
         heartbeat_msg.type = MessageType::HEARTBEAT;
         heartbeat_msg.sender_id = node_id_;
         heartbeat_msg.timestamp = heartbeat_msg.get_current_timestamp();
         
+        // Snapshot peers first: sending may need nodes_mutex_ to connect
+        std::vector<std::pair<uint32_t, PeerLiveness>> peers;
         {
             std::lock_guard<std::mutex> lock(nodes_mutex_);
             for (const auto& node_pair : known_nodes_) {
-                if (node_pair.first != node_id_ && node_pair.second.is_active) {
-                    send_message(node_pair.first, heartbeat_msg);
+                if (node_pair.first != node_id_) {
+                    peers.emplace_back(node_pair.first, node_pair.second.liveness);
                 }
             }
         }
         
-        std::this_thread::sleep_for(std::chrono::milliseconds(heartbeat_interval_));
+        // Failed peers are probed too: they may only be waiting to hear
+        // from us before they talk again
+        uint64_t now = monotonic_now_us();
+        uint64_t interval_us = heartbeat_interval_ * 1000;
+        std::vector<std::pair<uint32_t, PeerLiveness>> changes;
+        for (const auto& peer : peers) {
+            failure_detector_.watch(peer.first, now);
+            if (failure_detector_.send_idle_us(peer.first, now) >= interval_us) {
+                send_message(peer.first, heartbeat_msg);
+                heartbeat_probes_sent_.fetch_add(1, std::memory_order_relaxed);
+            }
+            PeerLiveness liveness = failure_detector_.liveness(peer.first, now);
+            if (liveness != peer.second) {
+                changes.emplace_back(peer.first, liveness);
+            }
+        }
+        
+        if (!changes.empty()) {
+            uint64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+            {
+                std::lock_guard<std::mutex> lock(nodes_mutex_);
+                for (const auto& change : changes) {
+                    auto it = known_nodes_.find(change.first);
+                    if (it != known_nodes_.end()) {
+                        it->second.liveness = change.second;
+                        it->second.is_active = change.second != PeerLiveness::FAILED;
+                        if (change.second == PeerLiveness::ALIVE) {
+                            it->second.last_heartbeat = now_ms;
+                        }
+                    }
+                }
+            }
+            for (const auto& change : changes) {
+                PhiAccrualDetector::Estimate estimate = failure_detector_.estimate(change.first, now);
+                std::string detail = "Node " + std::to_string(change.first) + " is " +
+                                     peer_liveness_name(change.second) + " (phi " +
+                                     std::to_string(estimate.phi) + " after " +
+                                     std::to_string(estimate.silence_ms) + "ms of silence)";
+                if (change.second == PeerLiveness::ALIVE || change.second == PeerLiveness::UNKNOWN) {
+                    LOG_INFO(detail);
+                } else {
+                    LOG_WARNING(detail);
+                }
+                if (liveness_handler_) {
+                    liveness_handler_(change.first, change.second);
+                }
+            }
+        }
+        
+        std::this_thread::sleep_for(std::chrono::microseconds(tick_us));
+    }
+}
+
+bool NetworkManager::open_listen_socket() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        LOG_ERROR("Failed to create listen socket: " + std::string(std::strerror(errno)));
+        return false;
     }
+    
+    set_socket_option(listen_fd_, SOL_SOCKET, SO_REUSEADDR, 1);
+    
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(listen_port_);
+    
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listen_fd_, SOMAXCONN) < 0) {
+        LOG_ERROR("Failed to listen on port " + std::to_string(listen_port_) + ": " +
+                  std::string(std::strerror(errno)));
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    
+    // Report the actual port when an ephemeral one was requested
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0) {
+        listen_port_ = ntohs(addr.sin_port);
+    }
+    
+    listener_epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (listener_epoll_fd_ < 0) {
+        LOG_ERROR("Failed to create listener epoll: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    epoll_ctl(listener_epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+    
+    LOG_INFO("Listening on port " + std::to_string(listen_port_));
+    return true;
 }
 
 bool NetworkManager::establish_connection(uint32_t target_node) {
-    // Simplified connection establishment
-    LOG_DEBUG("Establishing connection to node " + std::to_string(target_node));
+    NodeEndpoint endpoint;
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        auto it = known_nodes_.find(target_node);
+        if (it == known_nodes_.end()) {
+            LOG_WARNING("Cannot connect to unknown node " + std::to_string(target_node));
+            return false;
+        }
+        endpoint = it->second;
+    }
+    
+    sockaddr_in addr;
+    if (!resolve_endpoint(endpoint, addr)) {
+        LOG_ERROR("Failed to resolve " + endpoint.hostname + " for node " + std::to_string(target_node));
+        return false;
+    }
+    
+    LOG_DEBUG("Establishing " + std::to_string(connection_pool_size_) + " stream(s) to node " +
+              std::to_string(target_node));
+    
+    // Every stream opens by offering our decoders, so the peer can agree on
+    // a codec before any compressed frame could reach us
+    Message offer;
+    offer.type = MessageType::HEARTBEAT;
+    offer.sender_id = node_id_;
+    offer.receiver_id = target_node;
+    offer.metadata = kCodecOfferTag;
+    offer.log_index = supported_codecs();
+    std::string offer_frame;
+    offer.serialize_to(offer_frame);
+    
+    std::vector<std::shared_ptr<PeerConnection>> streams;
+    for (size_t i = 0; i < connection_pool_size_; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            LOG_ERROR("Failed to create socket: " + std::string(std::strerror(errno)));
+            break;
+        }
+        
+        // Batching coalesces frames itself and corks around writev; otherwise
+        // every frame should hit the wire immediately.
+        set_socket_option(fd, IPPROTO_TCP, TCP_NODELAY, message_batching_enabled_ ? 0 : 1);
+        
+        int rc = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        if (rc < 0 && errno != EINPROGRESS) {
+            LOG_WARNING("Connect to node " + std::to_string(target_node) + " failed: " +
+                        std::string(std::strerror(errno)));
+            close(fd);
+            break;
+        }
+        
+        auto connection = std::make_shared<PeerConnection>();
+        connection->fd = fd;
+        connection->peer_id = target_node;
+        connection->connected = (rc == 0);
+        connection->outbound_frames.push_back(offer_frame);
+        connection->queued_bytes = offer_frame.size();
+        
+        // Edge-triggered EPOLLOUT tells the sender when connect completes and
+        // when a full socket buffer drains again
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLOUT | EPOLLET;
+        event.data.ptr = connection.get();
+        epoll_ctl(sender_epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+        
+        streams.push_back(connection);
+    }
+    
+    if (streams.empty()) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+    auto& pool = connection_pool_[target_node];
+    if (!pool.empty()) {
+        // Another sender raced us; keep the existing streams
+        for (auto& connection : streams) {
+            epoll_ctl(sender_epoll_fd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+            close(connection->fd);
+        }
+        return true;
+    }
+    pool = std::move(streams);
     return true;
 }
 
 void NetworkManager::close_connection(uint32_t target_node) {
-    LOG_DEBUG("Closing connection to node " + std::to_string(target_node));
+    std::vector<std::shared_ptr<PeerConnection>> streams;
+    {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
+        auto it = connection_pool_.find(target_node);
+        if (it == connection_pool_.end()) {
+            return;
+        }
+        streams = std::move(it->second);
+        connection_pool_.erase(it);
+    }
+    
+    for (auto& connection : streams) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        reset_connection(*connection);
+    }
+    
+    LOG_DEBUG("Closed connection to node " + std::to_string(target_node));
 }
 
-bool NetworkManager::send_raw_message(uint32_t target_node, const std::vector<uint8_t>& data) {
-    // Simplified raw message sending
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    // Simulate network transmission
-    std::this_thread::sleep_for(std::chrono::microseconds(100));
+std::shared_ptr<PeerConnection> NetworkManager::get_connection(uint32_t target_node, size_t stream_hint) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        {
+            std::lock_guard<std::mutex> lock(connection_mutex_);
+            auto it = connection_pool_.find(target_node);
+            if (it != connection_pool_.end() && !it->second.empty()) {
+                // Same hint -> same stream, so per-key ordering is preserved
+                auto& connection = it->second[stream_hint % it->second.size()];
+                std::lock_guard<std::mutex> conn_lock(connection->mutex);
+                if (connection->fd >= 0) {
+                    return connection;
+                }
+                
+                // Stream was reset after an error; rebuild the peer's pool
+                for (auto& stream : it->second) {
+                    if (stream != connection) {
+                        std::lock_guard<std::mutex> stream_lock(stream->mutex);
+                        reset_connection(*stream);
+                    }
+                }
+                it->second.clear();
+            }
+        }
+        
+        if (!establish_connection(target_node)) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+bool NetworkManager::send_raw_message(uint32_t target_node, std::string frame, size_t stream_hint) {
+    return enqueue_frame(target_node, get_connection(target_node, stream_hint), std::move(frame));
+}
+
+bool NetworkManager::enqueue_frame(uint32_t target_node, const std::shared_ptr<PeerConnection>& connection,
+                                   std::string frame) {
+    if (!connection) {
+        frame_pool_.release(std::move(frame));
+        update_network_stats(target_node, 0, false);
+        return false;
+    }
     
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
-        end_time - start_time).count();
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->fd < 0) {
+            update_network_stats(target_node, 0, false);
+            return false;
+        }
+        
+        // Backpressure: refuse new frames while the peer is not draining
+        if (connection->queued_bytes + frame.size() > max_queued_bytes_) {
+            LOG_WARNING("Send queue to node " + std::to_string(target_node) + " is full (" +
+                        std::to_string(connection->queued_bytes) + " bytes)");
+            frame_pool_.release(std::move(frame));
+            update_network_stats(target_node, 0, false);
+            return false;
+        }
+        
+        connection->queued_bytes += frame.size();
+        connection->outbound_frames.push_back(std::move(frame));
+    }
     
-    update_network_stats(target_node, latency, true);
+    schedule_flush(connection);
     
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    message_counts_[target_node]++;
     return true;
 }
 
-bool NetworkManager::receive_raw_message(std::vector<uint8_t>& data) {
+bool NetworkManager::receive_raw_message(int fd) {
+    std::string& buffer = inbound_buffers_[fd];
+    
+    while (true) {
+        size_t offset = buffer.size();
+        buffer.resize(offset + kReadChunkSize);
+        ssize_t received = read(fd, &buffer[offset], kReadChunkSize);
+        
+        if (received > 0) {
+            buffer.resize(offset + static_cast<size_t>(received));
+            bytes_received_.fetch_add(static_cast<uint64_t>(received), std::memory_order_relaxed);
+            continue;
+        }
+        
+        buffer.resize(offset);
+        if (received == 0) {
+            return false; // Peer closed
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    
+    // Dispatch every complete frame; keep any trailing partial frame
+    size_t consumed = 0;
+    while (buffer.size() - consumed >= wire::kHeaderSize) {
+        const char* frame = buffer.data() + consumed;
+        size_t available = buffer.size() - consumed;
+        size_t frame_length = wire::frame_size(frame, available);
+        
+        if (frame_length == 0) {
+            LOG_WARNING("Dropping connection with invalid frame header");
+            return false;
+        }
+        if (frame_length > available) {
+            break;
+        }
+        
+        process_incoming_message(frame, frame_length);
+        consumed += frame_length;
+    }
+    
+    buffer.erase(0, consumed);
     return true;
 }
 
-void NetworkManager::process_incoming_message(const std::vector<uint8_t>& raw_data) {
-    std::vector<uint8_t> data = raw_data;
+void NetworkManager::accept_connections() {
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG_WARNING("accept failed: " + std::string(std::strerror(errno)));
+            }
+            return;
+        }
+        
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(listener_epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+        inbound_buffers_[fd];
+    }
+}
+
+void NetworkManager::schedule_flush(const std::shared_ptr<PeerConnection>& connection) {
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->flush_scheduled) {
+            return;
+        }
+        connection->flush_scheduled = true;
+    }
     
-    if (compression_enabled_) {
-        data = decompress_data(data);
+    {
+        std::lock_guard<std::mutex> lock(dirty_mutex_);
+        dirty_connections_.push_back(connection);
     }
+    wake_sender();
+}
+
+void NetworkManager::flush_connection(const std::shared_ptr<PeerConnection>& connection) {
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    connection->flush_scheduled = false;
     
-    Message message;
-    if (message.deserialize(data)) {
-        if (message.type == MessageType::HEARTBEAT) {
-            handle_heartbeat(message.sender_id);
-        } else if (message_handler_) {
-            message_handler_(message);
+    if (connection->fd < 0) {
+        return;
+    }
+    
+    if (!connection->connected) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+            if (error == 0 || error == EINPROGRESS || error == EALREADY) {
+                return; // Still connecting; EPOLLOUT will fire when done
+            }
+            LOG_WARNING("Connection to node " + std::to_string(connection->peer_id) + " failed: " +
+                        std::string(std::strerror(error)));
+            reset_connection(*connection);
+            return;
         }
-    } else {
+        
+        // getsockopt reports 0 both while in progress and once connected
+        sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        if (getpeername(connection->fd, reinterpret_cast<sockaddr*>(&peer), &peer_len) < 0) {
+            return;
+        }
+        connection->connected = true;
+    }
+    
+    if (connection->outbound_frames.empty()) {
+        return;
+    }
+    
+    if (message_batching_enabled_) {
+        set_socket_option(connection->fd, IPPROTO_TCP, TCP_CORK, 1);
+    }
+    
+    while (!connection->outbound_frames.empty()) {
+        iovec iov[kMaxIovecs];
+        int iov_count = 0;
+        for (auto it = connection->outbound_frames.begin();
+             it != connection->outbound_frames.end() && iov_count < kMaxIovecs; ++it, ++iov_count) {
+            size_t skip = (iov_count == 0) ? connection->head_offset : 0;
+            iov[iov_count].iov_base = const_cast<char*>(it->data()) + skip;
+            iov[iov_count].iov_len = it->size() - skip;
+        }
+        
+        ssize_t written = writev(connection->fd, iov, iov_count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            
+            LOG_WARNING("Write to node " + std::to_string(connection->peer_id) + " failed: " +
+                        std::string(std::strerror(errno)));
+            reset_connection(*connection);
+            return;
+        }
+        
+        bytes_sent_.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+        
+        // Retire fully written frames
+        size_t remaining = static_cast<size_t>(written);
+        connection->queued_bytes -= remaining;
+        while (remaining > 0) {
+            size_t front_left = connection->outbound_frames.front().size() - connection->head_offset;
+            if (remaining >= front_left) {
+                remaining -= front_left;
+                frame_pool_.release(std::move(connection->outbound_frames.front()));
+                connection->outbound_frames.pop_front();
+                connection->head_offset = 0;
+            } else {
+                connection->head_offset += remaining;
+                remaining = 0;
+            }
+        }
+    }
+    
+    if (message_batching_enabled_) {
+        set_socket_option(connection->fd, IPPROTO_TCP, TCP_CORK, 0);
+    }
+}
+
+void NetworkManager::reset_connection(PeerConnection& connection) {
+    if (connection.fd >= 0) {
+        if (sender_epoll_fd_ >= 0) {
+            epoll_ctl(sender_epoll_fd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+        }
+        close(connection.fd);
+        connection.fd = -1;
+    }
+    
+    if (!connection.outbound_frames.empty()) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        failed_sends_[connection.peer_id] += connection.outbound_frames.size();
+    }
+    connection.outbound_frames.clear();
+    connection.queued_bytes = 0;
+    connection.head_offset = 0;
+    connection.connected = false;
+}
+
+void NetworkManager::wake_sender() {
+    if (sender_wakeup_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(sender_wakeup_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void NetworkManager::process_incoming_message(const char* data, size_t size) {
+    MessageView view;
+    if (!MessageView::parse(data, size, view)) {
         LOG_WARNING("Failed to deserialize incoming message");
+        return;
+    }
+    
+    if (view.sender_id != node_id_) {
+        failure_detector_.on_arrival(view.sender_id);
+    }
+    
+    if (view.type == MessageType::BATCH_REQUEST && view.metadata == kCoalescedBatchTag) {
+        // Unpack coalesced frames in order
+        const char* frame = view.value.data();
+        size_t remaining = view.value.size();
+        while (remaining > 0) {
+            size_t frame_length = wire::frame_size(frame, remaining);
+            if (frame_length == 0 || frame_length > remaining) {
+                LOG_WARNING("Truncated frame inside batch from node " + std::to_string(view.sender_id));
+                return;
+            }
+            process_incoming_message(frame, frame_length);
+            frame += frame_length;
+            remaining -= frame_length;
+        }
+        return;
+    }
+    
+    if (view.type == MessageType::BATCH_REQUEST && view.metadata == kCompressedFrameTag) {
+        process_compressed_frame(view);
+        return;
+    }
+    
+    if (view.type == MessageType::HEARTBEAT) {
+        if (view.metadata == kCodecOfferTag) {
+            record_codec_offer(view.sender_id, static_cast<uint32_t>(view.log_index));
+        }
+        handle_heartbeat(view.sender_id);
+    } else if (message_handler_) {
+        message_handler_(view.to_message());
+    }
+}
+
+PeerBatchQueue& NetworkManager::get_batch_queue(uint32_t target_node) {
+    {
+        std::shared_lock<std::shared_mutex> lock(batch_queues_mutex_);
+        auto it = peer_batches_.find(target_node);
+        if (it != peer_batches_.end()) {
+            return *it->second;
+        }
     }
+    
+    std::unique_lock<std::shared_mutex> lock(batch_queues_mutex_);
+    auto& queue = peer_batches_[target_node];
+    if (!queue) {
+        queue = std::make_unique<PeerBatchQueue>();
+    }
+    return *queue;
 }
 
 void NetworkManager::process_message_batch(uint32_t target_node) {
-    if (pending_batches_[target_node].empty()) {
-        return;
+    PeerBatchQueue* queue = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(batch_queues_mutex_);
+        auto it = peer_batches_.find(target_node);
+        if (it == peer_batches_.end()) {
+            return;
+        }
+        queue = it->second.get();
+    }
+    
+    flush_batch_queue(target_node, *queue, true);
+}
+
+bool NetworkManager::flush_batch_queue(uint32_t target_node, PeerBatchQueue& queue, bool wait_for_lock) {
+    // Connecting may resolve a hostname; do it before taking the flush lock,
+    // so producers queued behind one slow peer never wait on it
+    std::shared_ptr<PeerConnection> connection = get_connection(target_node, 0);
+    
+    std::unique_lock<std::mutex> lock(queue.flush_mutex, std::defer_lock);
+    if (wait_for_lock) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return false;
+    }
+    
+    uint64_t oldest = queue.oldest_enqueue_us.exchange(0);
+    
+    Message batch;
+    batch.type = MessageType::BATCH_REQUEST;
+    batch.sender_id = node_id_;
+    batch.receiver_id = target_node;
+    batch.metadata = kCoalescedBatchTag;
+    std::string frames = frame_pool_.acquire();
+    frames.reserve(queue.pending_bytes.load());
+    
+    size_t count = 0;
+    std::string frame;
+    while (count < batch_max_messages_ && frames.size() < batch_max_bytes_ && queue.frames.pop(frame)) {
+        frames.append(frame);
+        frame_pool_.release(std::move(frame));
+        ++count;
+    }
+    
+    if (count == 0) {
+        return true;
     }
     
-    LOG_DEBUG("Processing message batch for node " + std::to_string(target_node) + 
-              " with " + std::to_string(pending_batches_[target_node].size()) + " messages");
+    size_t bytes = frames.size();
+    batch.value = std::move(frames);
+    queue.pending_count.fetch_sub(count);
+    queue.pending_bytes.fetch_sub(bytes);
     
-    // Simulate batch processing
-    for (const auto& msg : pending_batches_[target_node]) {
-        LOG_DEBUG("Batch sending message type " + std::to_string(static_cast<int>(msg.type)));
+    // Frames left behind (over the caps) restart the deadline clock
+    if (!queue.frames.empty()) {
+        uint64_t expected = 0;
+        queue.oldest_enqueue_us.compare_exchange_strong(expected, now_us());
     }
     
-    pending_batches_[target_node].clear();
+    LOG_DEBUG("Flushing batch of " + std::to_string(count) + " messages (" + std::to_string(bytes) +
+              " bytes) to node " + std::to_string(target_node));
+    
+    std::string batch_frame = frame_pool_.acquire();
+    batch.serialize_to(batch_frame);
+    frame_pool_.release(batch.value.release());
+    compress_frame(target_node, batch_frame);
+    bool sent = enqueue_frame(target_node, connection, std::move(batch_frame));
+    
+    uint64_t latency = oldest != 0 ? now_us() - oldest : 0;
+    queue.stats.batches_flushed++;
+    queue.stats.messages_flushed += count;
+    queue.stats.bytes_flushed += bytes;
+    queue.stats.total_flush_latency_us += latency;
+    queue.stats.max_flush_latency_us = std::max(queue.stats.max_flush_latency_us, latency);
+    
+    return sent;
 }
 
 bool NetworkManager::retry_failed_message(uint32_t target_node, const Message& message) {
@@ -374,25 +1194,127 @@ bool NetworkManager::retry_failed_message(uint32_t target_node, const Message& m
     return false;
 }
 
-std::vector<uint8_t> NetworkManager::compress_data(const std::vector<uint8_t>& data) {
-    // Placeholder compression
-    return data;
+void NetworkManager::compress_frame(uint32_t target_node, std::string& frame) {
+    if (!compression_enabled_ || frame.size() < compression_min_bytes_) {
+        return;
+    }
+    
+    // Peers that have not offered a decoder we share get raw frames
+    const FrameCodec* codec = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(compression_mutex_);
+        auto it = compression_stats_.find(target_node);
+        if (it == compression_stats_.end()) {
+            return;
+        }
+        uint32_t shared = it->second.peer_codecs & supported_codecs();
+        if (shared & (1U << static_cast<uint32_t>(compression_codec_))) {
+            codec = find_codec(compression_codec_);
+        } else if (shared & (1U << static_cast<uint32_t>(CompressionCodec::LZ))) {
+            codec = find_codec(CompressionCodec::LZ);
+        }
+        if (!codec) {
+            return;
+        }
+        it->second.codec = codec->id();
+    }
+    
+    uint64_t started = monotonic_now_ns();
+    Message envelope;
+    envelope.type = MessageType::BATCH_REQUEST;
+    envelope.sender_id = node_id_;
+    envelope.receiver_id = target_node;
+    envelope.metadata = kCompressedFrameTag;
+    envelope.sequence_number = static_cast<uint32_t>(codec->id());
+    envelope.log_index = frame.size();
+    
+    std::string compressed = frame_pool_.acquire();
+    std::string envelope_frame;
+    if (codec->compress(frame.data(), frame.size(), compressed) && compressed.size() < frame.size()) {
+        envelope.value = std::move(compressed);
+        envelope_frame = frame_pool_.acquire();
+        envelope.serialize_to(envelope_frame);
+        frame_pool_.release(envelope.value.release());
+    } else {
+        frame_pool_.release(std::move(compressed));
+    }
+    // The envelope header can eat a marginal saving
+    bool shrunk = !envelope_frame.empty() && envelope_frame.size() < frame.size();
+    uint64_t elapsed = monotonic_now_ns() - started;
+    
+    {
+        std::lock_guard<std::mutex> lock(compression_mutex_);
+        PeerCompressionStats& stats = compression_stats_[target_node];
+        stats.compress_ns += elapsed;
+        if (shrunk) {
+            stats.frames_compressed++;
+            stats.raw_bytes += frame.size();
+            stats.compressed_bytes += envelope_frame.size();
+        } else {
+            stats.frames_incompressible++;
+        }
+    }
+    
+    if (shrunk) {
+        frame.swap(envelope_frame);
+    }
+    frame_pool_.release(std::move(envelope_frame));
+}
+
+void NetworkManager::process_compressed_frame(const MessageView& view) {
+    const FrameCodec* codec = find_codec(static_cast<CompressionCodec>(view.sequence_number));
+    if (!codec) {
+        LOG_WARNING("Dropping frame from node " + std::to_string(view.sender_id) +
+                    " compressed with unsupported codec " + std::to_string(view.sequence_number));
+        return;
+    }
+    if (view.log_index > kMaxDecompressedFrameBytes) {
+        LOG_WARNING("Dropping compressed frame from node " + std::to_string(view.sender_id) +
+                    " claiming " + std::to_string(view.log_index) + " bytes");
+        return;
+    }
+    
+    uint64_t started = monotonic_now_ns();
+    std::string frame = frame_pool_.acquire();
+    if (!codec->decompress(view.value.data(), view.value.size(), static_cast<size_t>(view.log_index), frame)) {
+        LOG_WARNING("Corrupt " + std::string(codec->name()) + " frame from node " +
+                    std::to_string(view.sender_id));
+        frame_pool_.release(std::move(frame));
+        return;
+    }
+    uint64_t elapsed = monotonic_now_ns() - started;
+    
+    {
+        std::lock_guard<std::mutex> lock(compression_mutex_);
+        PeerCompressionStats& stats = compression_stats_[view.sender_id];
+        stats.frames_decompressed++;
+        stats.decompress_ns += elapsed;
+    }
+    
+    size_t frame_length = wire::frame_size(frame.data(), frame.size());
+    if (frame_length != frame.size()) {
+        LOG_WARNING("Compressed frame from node " + std::to_string(view.sender_id) + " is not one frame");
+    } else {
+        process_incoming_message(frame.data(), frame.size());
+    }
+    frame_pool_.release(std::move(frame));
 }
 
-std::vector<uint8_t> NetworkManager::decompress_data(const std::vector<uint8_t>& compressed_data) {
-    // Placeholder decompression
-    return compressed_data;
+void NetworkManager::record_codec_offer(uint32_t peer, uint32_t codecs) {
+    {
+        std::lock_guard<std::mutex> lock(compression_mutex_);
+        compression_stats_[peer].peer_codecs = codecs;
+    }
+    LOG_DEBUG("Node " + std::to_string(peer) + " offered codec mask " + std::to_string(codecs));
 }
 
 void NetworkManager::update_network_stats(uint32_t target_node, uint64_t latency, bool success) {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    
-    latency_history_[target_node].push_back(latency);
-    
-    if (latency_history_[target_node].size() > 100) {
-        latency_history_[target_node].erase(latency_history_[target_node].begin());
+    // Zero means the send failed before anything was timed
+    if (latency > 0) {
+        peer_telemetry_->record_rtt(target_node, latency);
     }
     
+    std::lock_guard<std::mutex> lock(stats_mutex_);
     message_counts_[target_node]++;
     
     if (!success) {
@@ -1,139 +1,281 @@
 #include "performance/metrics.h"
+#include "utils/clock.h"
 #include "utils/logger.h"
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <sstream>
+#include <thread>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
 
 namespace replication {
 
 // Global performance monitor instance
 std::unique_ptr<PerformanceMonitor> g_performance_monitor = nullptr;
 
+namespace {
+
+// Completed operations kept per thread for windowed stats and export
+constexpr size_t kRecentOperations = 1024;
+
+// Monitors whose shard each thread finds without taking a lock
+constexpr size_t kCachedShards = 64;
+
+// Monitor ids are never reused, so stale thread-local shard entries cannot match
+std::atomic<uint64_t> g_next_monitor_id{1};
+
+uint64_t pack_operation_meta(MessageType type, ReplicationMode mode, bool success, uint32_t hops) {
+    return static_cast<uint64_t>(type)
+         | (static_cast<uint64_t>(mode) << 16)
+         | (static_cast<uint64_t>(success ? 1 : 0) << 24)
+         | (static_cast<uint64_t>(hops) << 32);
+}
+
+void store_relaxed(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(value, std::memory_order_relaxed);
+}
+
+// Readings over shorter windows are dominated by clock-tick rounding
+constexpr uint64_t kMinResourceSampleNs = 100000000; // 100ms
+
+// Default link capacity for network utilization: 1 Gbit/s
+constexpr double kDefaultNetworkCapacity = 125000000.0;
+
+// Above this CPU or network utilization, latency mostly measures queueing
+constexpr double kSaturatedPercent = 80.0;
+
+// utime + stime of this process in clock ticks, from /proc/self/stat
+bool read_process_cpu_ticks(uint64_t* ticks) {
+    std::ifstream stat("/proc/self/stat");
+    std::string line;
+    if (!std::getline(stat, line)) {
+        return false;
+    }
+    
+    // The command name may contain spaces; field 3 starts after its ')'
+    size_t name_end = line.rfind(')');
+    if (name_end == std::string::npos || name_end + 2 > line.size()) {
+        return false;
+    }
+    std::istringstream fields(line.substr(name_end + 2));
+    std::string skipped;
+    for (int field = 3; field < 14; ++field) {
+        fields >> skipped;
+    }
+    uint64_t utime = 0;
+    uint64_t stime = 0;
+    if (!(fields >> utime >> stime)) {
+        return false;
+    }
+    *ticks = utime + stime;
+    return true;
+}
+
+// Resident set size in MB, from the VmRSS line of /proc/self/status
+double read_resident_mb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            std::istringstream fields(line.substr(6));
+            uint64_t kilobytes = 0;
+            fields >> kilobytes;
+            return kilobytes / 1024.0;
+        }
+    }
+    return 0.0;
+}
+
+int open_perf_counter(uint64_t config) {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.inherit = 1;
+    // User space only, so the default perf_event_paranoid level allows it
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+#else
+    (void)config;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+uint64_t read_perf_counter(int fd) {
+    uint64_t value = 0;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+        return 0;
+    }
+    return value;
+}
+
+LatencySummary summarize_snapshot(const LatencyHistogram::Snapshot& merged) {
+    LatencySummary summary;
+    if (merged.count == 0) {
+        return summary;
+    }
+    
+    summary.count = merged.count;
+    summary.mean_ns = merged.mean();
+    summary.p50_ns = merged.percentile(0.50);
+    summary.p95_ns = merged.percentile(0.95);
+    summary.p99_ns = merged.percentile(0.99);
+    summary.p999_ns = merged.percentile(0.999);
+    summary.max_ns = merged.max;
+    return summary;
+}
+
+} // namespace
+
+// Metrics written by exactly one thread. Readers merge all shards on demand.
+struct PerformanceMonitor::ThreadMetrics {
+    struct RecentOperation {
+        std::atomic<uint64_t> start_time;
+        std::atomic<uint64_t> latency_ns;
+        std::atomic<uint64_t> meta;
+    };
+    
+    // Histograms are allocated on first use of each (mode, type) pair
+    std::atomic<LatencyHistogram*> histograms[kReplicationModeCount][kMessageTypeCount];
+    std::atomic<uint64_t> failures[kReplicationModeCount][kMessageTypeCount];
+    RecentOperation recent[kRecentOperations];
+    std::atomic<uint64_t> recent_head;
+    std::thread::id owner;
+    
+    ThreadMetrics() : recent_head(0), owner(std::this_thread::get_id()) {
+        for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+            for (size_t type = 0; type < kMessageTypeCount; ++type) {
+                histograms[mode][type].store(nullptr, std::memory_order_relaxed);
+                failures[mode][type].store(0, std::memory_order_relaxed);
+            }
+        }
+        for (auto& op : recent) {
+            store_relaxed(op.start_time, 0);
+            store_relaxed(op.latency_ns, 0);
+            store_relaxed(op.meta, 0);
+        }
+    }
+    
+    ~ThreadMetrics() {
+        for (auto& by_type : histograms) {
+            for (auto& histogram : by_type) {
+                delete histogram.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
 PerformanceMonitor::PerformanceMonitor()
-    : total_operations_(0)
-    , successful_operations_(0)
-    , failed_operations_(0)
-    , cumulative_latency_(0.0)
+    : monitor_id_(g_next_monitor_id.fetch_add(1))
+    , active_operations_(new ActiveOperation[kActiveOperationSlots])
     , cpu_utilization_(0.0)
     , memory_usage_(0.0)
     , network_utilization_(0.0)
-    , chain_operations_(0)
-    , quorum_operations_(0)
-    , hybrid_operations_(0)
-    , chain_latency_(0.0)
-    , quorum_latency_(0.0)
-    , hybrid_latency_(0.0)
+    , last_sample_ns_(get_current_timestamp())
+    , last_cpu_ticks_(0)
+    , last_network_bytes_(0)
+    , network_capacity_(kDefaultNetworkCapacity)
+    , perf_cycles_fd_(-1)
+    , perf_cache_misses_fd_(-1)
+    , last_cycles_(0)
+    , last_cache_misses_(0)
+    , last_mode_time_ns_()
+    , mode_cycles_()
+    , mode_cache_misses_()
+    , sampler_running_(false)
     , detailed_logging_enabled_(false)
     , latency_threshold_(100.0) // 100ms
     , throughput_threshold_(1000.0) // 1000 ops/sec
     , start_time_(get_current_timestamp()) {
     
+    read_process_cpu_ticks(&last_cpu_ticks_);
+    
+    for (size_t i = 0; i < kActiveOperationSlots; ++i) {
+        active_operations_[i].tag.store(0, std::memory_order_relaxed);
+        active_operations_[i].start_time.store(0, std::memory_order_relaxed);
+        active_operations_[i].operation_type.store(0, std::memory_order_relaxed);
+    }
+    
     LOG_INFO("PerformanceMonitor initialized");
 }
 
-void PerformanceMonitor::start_operation(uint64_t operation_id, MessageType type, const std::string& key) {
-    std::lock_guard<std::mutex> lock(operations_mutex_);
-    
-    OperationMetrics metrics;
-    metrics.start_time = get_current_timestamp();
-    metrics.operation_type = type;
-    metrics.key = key;
-    metrics.success = false;
-    metrics.hops = 0;
-    metrics.mode_used = ReplicationMode::HYBRID_AUTO;
-    
-    active_operations_[operation_id] = metrics;
-    total_operations_.fetch_add(1);
+PerformanceMonitor::~PerformanceMonitor() {
+    stop_sampler();
+    close_hardware_counters();
+}
+
+void PerformanceMonitor::start_operation(uint64_t operation_id, MessageType type, const std::string& /*key*/) {
+    // Lock-free: an id colliding with a still-active slot simply replaces it
+    ActiveOperation& slot = active_operations_[operation_id & (kActiveOperationSlots - 1)];
+    slot.start_time.store(get_current_timestamp(), std::memory_order_relaxed);
+    slot.operation_type.store(static_cast<uint32_t>(type), std::memory_order_relaxed);
+    slot.tag.store(operation_id + 1, std::memory_order_release);
 }
 
 void PerformanceMonitor::end_operation(uint64_t operation_id, bool success, ReplicationMode mode, uint32_t hops) {
-    std::lock_guard<std::mutex> lock(operations_mutex_);
-    
-    auto it = active_operations_.find(operation_id);
-    if (it != active_operations_.end()) {
-        it->second.end_time = get_current_timestamp();
-        it->second.success = success;
-        it->second.mode_used = mode;
-        it->second.hops = hops;
-        
-        // Update counters
-        if (success) {
-            successful_operations_.fetch_add(1);
-        } else {
-            failed_operations_.fetch_add(1);
-        }
-        
-        // Update mode-specific metrics
-        uint64_t latency = it->second.get_latency_ms();
-        switch (mode) {
-            case ReplicationMode::CHAIN_ONLY:
-                chain_operations_.fetch_add(1);
-                chain_latency_.store(chain_latency_.load() + latency);
-                break;
-            case ReplicationMode::QUORUM_ONLY:
-                quorum_operations_.fetch_add(1);
-                quorum_latency_.store(quorum_latency_.load() + latency);
-                break;
-            case ReplicationMode::HYBRID_AUTO:
-                hybrid_operations_.fetch_add(1);
-                hybrid_latency_.store(hybrid_latency_.load() + latency);
-                break;
-        }
-        
-        // Update cumulative latency
-        cumulative_latency_.store(cumulative_latency_.load() + latency);
-        
-        // Move to completed operations
-        completed_operations_.push_back(it->second);
-        active_operations_.erase(it);
-        
-        // Keep only recent completed operations (last 10000)
-        if (completed_operations_.size() > 10000) {
-            completed_operations_.erase(completed_operations_.begin());
-        }
-        
-        if (detailed_logging_enabled_) {
-            LOG_DEBUG("Operation " + std::to_string(operation_id) + " completed: " + 
-                     (success ? "SUCCESS" : "FAILED") + " in " + std::to_string(latency) + "ms");
-        }
+    ActiveOperation& slot = active_operations_[operation_id & (kActiveOperationSlots - 1)];
+    uint64_t tag = operation_id + 1;
+    if (slot.tag.load(std::memory_order_acquire) != tag) {
+        return;
+    }
+    
+    uint64_t start_time = slot.start_time.load(std::memory_order_relaxed);
+    auto type = static_cast<MessageType>(slot.operation_type.load(std::memory_order_relaxed));
+    
+    // Claim the slot so a duplicate end_operation() is not counted twice
+    if (!slot.tag.compare_exchange_strong(tag, 0, std::memory_order_acq_rel)) {
+        return;
+    }
+    
+    uint64_t now = get_current_timestamp();
+    uint64_t latency_ns = now > start_time ? now - start_time : 0;
+    record(type, mode, start_time, latency_ns, success, hops);
+    
+    if (detailed_logging_enabled_) {
+        LOG_DEBUG("Operation " + std::to_string(operation_id) + " completed: " + 
+                 (success ? "SUCCESS" : "FAILED") + " in " + std::to_string(latency_ns / 1000.0) + "us");
     }
 }
 
+void PerformanceMonitor::record_operation(MessageType type, ReplicationMode mode, uint64_t latency_ns,
+                                          bool success, uint32_t hops) {
+    uint64_t now = get_current_timestamp();
+    record(type, mode, now > latency_ns ? now - latency_ns : 0, latency_ns, success, hops);
+}
+
 PerformanceStats PerformanceMonitor::get_current_stats() const {
     PerformanceStats stats;
     
-    std::lock_guard<std::mutex> lock(operations_mutex_);
+    uint64_t failures = 0;
+    LatencyHistogram::Snapshot merged = merge_histograms(kAnyFilter, kAnyFilter, &failures);
     
-    uint64_t total_ops = total_operations_.load();
+    uint64_t total_ops = merged.count + failures;
     if (total_ops > 0) {
         // Calculate throughput
         auto current_time = get_current_timestamp();
-        auto elapsed_seconds = (current_time - start_time_) / 1000000.0; // Convert to seconds
+        auto elapsed_seconds = (current_time - start_time_.load()) / 1e9; // Convert to seconds
         if (elapsed_seconds > 0) {
             stats.throughput_ops_per_sec = total_ops / elapsed_seconds;
         }
         
-        // Calculate success rate
-        stats.success_rate = static_cast<double>(successful_operations_.load()) / total_ops;
-        
-        // Calculate average latency
-        if (successful_operations_.load() > 0) {
-            stats.average_latency_ms = cumulative_latency_.load() / successful_operations_.load();
-        }
+        stats.success_rate = static_cast<double>(merged.count) / total_ops;
         
-        // Calculate percentile latencies
-        std::vector<uint64_t> latencies;
-        for (const auto& op : completed_operations_) {
-            if (op.success) {
-                latencies.push_back(op.get_latency_ms());
-            }
-        }
-        
-        if (!latencies.empty()) {
-            std::sort(latencies.begin(), latencies.end());
-            stats.p95_latency_ms = calculate_percentile(latencies, 0.95);
-            stats.p99_latency_ms = calculate_percentile(latencies, 0.99);
+        // Latencies are recorded in nanoseconds; stats report milliseconds
+        if (merged.count > 0) {
+            stats.average_latency_ms = merged.mean() / 1e6;
+            stats.p95_latency_ms = merged.percentile(0.95) / 1e6;
+            stats.p99_latency_ms = merged.percentile(0.99) / 1e6;
         }
     }
     
@@ -146,38 +288,45 @@ PerformanceStats PerformanceMonitor::get_current_stats() const {
 }
 
 PerformanceStats PerformanceMonitor::get_historical_stats(uint64_t duration_ms) const {
-    std::lock_guard<std::mutex> lock(operations_mutex_);
-    
-    auto cutoff_time = get_current_timestamp() - (duration_ms * 1000); // Convert to microseconds
+    uint64_t now = get_current_timestamp();
+    uint64_t window_ns = duration_ms * 1000000; // Convert to nanoseconds
+    uint64_t cutoff_time = now > window_ns ? now - window_ns : 0;
     
     PerformanceStats stats;
     uint64_t ops_in_window = 0;
-    uint64_t successful_ops = 0;
     double total_latency = 0.0;
     std::vector<uint64_t> latencies;
     
-    for (const auto& op : completed_operations_) {
-        if (op.start_time >= cutoff_time) {
-            ops_in_window++;
-            if (op.success) {
-                successful_ops++;
-                uint64_t latency = op.get_latency_ms();
-                total_latency += latency;
-                latencies.push_back(latency);
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        for (const auto& shard : shards_) {
+            uint64_t head = shard->recent_head.load(std::memory_order_acquire);
+            uint64_t available = std::min<uint64_t>(head, kRecentOperations);
+            for (uint64_t i = head - available; i < head; ++i) {
+                const auto& op = shard->recent[i % kRecentOperations];
+                if (op.start_time.load(std::memory_order_relaxed) < cutoff_time) {
+                    continue;
+                }
+                ops_in_window++;
+                if ((op.meta.load(std::memory_order_relaxed) >> 24) & 1) {
+                    uint64_t latency = op.latency_ns.load(std::memory_order_relaxed);
+                    total_latency += latency;
+                    latencies.push_back(latency);
+                }
             }
         }
     }
     
-    if (ops_in_window > 0) {
+    if (ops_in_window > 0 && duration_ms > 0) {
         stats.throughput_ops_per_sec = ops_in_window / (duration_ms / 1000.0);
-        stats.success_rate = static_cast<double>(successful_ops) / ops_in_window;
+        stats.success_rate = static_cast<double>(latencies.size()) / ops_in_window;
         
-        if (successful_ops > 0) {
-            stats.average_latency_ms = total_latency / successful_ops;
+        if (!latencies.empty()) {
+            stats.average_latency_ms = total_latency / latencies.size() / 1e6;
             
             std::sort(latencies.begin(), latencies.end());
-            stats.p95_latency_ms = calculate_percentile(latencies, 0.95);
-            stats.p99_latency_ms = calculate_percentile(latencies, 0.99);
+            stats.p95_latency_ms = calculate_percentile(latencies, 0.95) / 1e6;
+            stats.p99_latency_ms = calculate_percentile(latencies, 0.99) / 1e6;
         }
     }
     
@@ -186,92 +335,147 @@ PerformanceStats PerformanceMonitor::get_historical_stats(uint64_t duration_ms)
 
 double PerformanceMonitor::get_throughput() const {
     auto current_time = get_current_timestamp();
-    auto elapsed_seconds = (current_time - start_time_) / 1000000.0;
+    auto elapsed_seconds = (current_time - start_time_.load()) / 1e9;
     
     if (elapsed_seconds > 0) {
-        return total_operations_.load() / elapsed_seconds;
+        uint64_t failures = 0;
+        uint64_t successes = merge_histograms(kAnyFilter, kAnyFilter, &failures).count;
+        return (successes + failures) / elapsed_seconds;
     }
     
     return 0.0;
 }
 
 double PerformanceMonitor::get_average_latency() const {
-    uint64_t successful = successful_operations_.load();
-    if (successful > 0) {
-        return cumulative_latency_.load() / successful;
-    }
-    return 0.0;
+    // Microseconds, over successful operations
+    return merge_histograms(kAnyFilter, kAnyFilter, nullptr).mean() / 1000.0;
 }
 
 double PerformanceMonitor::get_percentile_latency(double percentile) const {
-    std::lock_guard<std::mutex> lock(operations_mutex_);
-    
-    std::vector<uint64_t> latencies;
-    for (const auto& op : completed_operations_) {
-        if (op.success) {
-            latencies.push_back(op.get_latency_ms());
-        }
-    }
-    
-    if (latencies.empty()) {
+    LatencyHistogram::Snapshot merged = merge_histograms(kAnyFilter, kAnyFilter, nullptr);
+    if (merged.count == 0) {
         return 0.0;
     }
     
-    std::sort(latencies.begin(), latencies.end());
-    return calculate_percentile(latencies, percentile);
+    return merged.percentile(percentile) / 1e6;
 }
 
 double PerformanceMonitor::get_success_rate() const {
-    uint64_t total = total_operations_.load();
+    uint64_t failures = 0;
+    uint64_t successes = merge_histograms(kAnyFilter, kAnyFilter, &failures).count;
+    uint64_t total = successes + failures;
     if (total > 0) {
-        return static_cast<double>(successful_operations_.load()) / total;
+        return static_cast<double>(successes) / total;
     }
     return 0.0;
 }
 
+LatencySummary PerformanceMonitor::get_latency_summary(ReplicationMode mode, MessageType type) const {
+    return summarize(static_cast<int>(mode), static_cast<int>(type));
+}
+
+LatencySummary PerformanceMonitor::get_mode_latency_summary(ReplicationMode mode) const {
+    return summarize(static_cast<int>(mode), kAnyFilter);
+}
+
+LatencySummary PerformanceMonitor::get_type_latency_summary(MessageType type) const {
+    return summarize(kAnyFilter, static_cast<int>(type));
+}
+
+LatencySummary PerformanceMonitor::get_overall_latency_summary() const {
+    return summarize(kAnyFilter, kAnyFilter);
+}
+
 PerformanceStats PerformanceMonitor::get_chain_stats() const {
-    PerformanceStats stats;
-    
-    uint64_t chain_ops = chain_operations_.load();
-    if (chain_ops > 0) {
-        stats.average_latency_ms = chain_latency_.load() / chain_ops;
-        stats.throughput_ops_per_sec = get_throughput(); // Simplified
-    }
-    
-    return stats;
+    return mode_stats(ReplicationMode::CHAIN_ONLY);
 }
 
 PerformanceStats PerformanceMonitor::get_quorum_stats() const {
-    PerformanceStats stats;
+    return mode_stats(ReplicationMode::QUORUM_ONLY);
+}
+
+PerformanceStats PerformanceMonitor::get_hybrid_stats() const {
+    return mode_stats(ReplicationMode::HYBRID_AUTO);
+}
+
+void PerformanceMonitor::update_system_stats() {
+    std::lock_guard<std::mutex> lock(sampler_mutex_);
+    
+    uint64_t now = get_current_timestamp();
+    uint64_t elapsed_ns = now > last_sample_ns_ ? now - last_sample_ns_ : 0;
+    uint64_t network_bytes = network_byte_source_ ? network_byte_source_() : 0;
     
-    uint64_t quorum_ops = quorum_operations_.load();
-    if (quorum_ops > 0) {
-        stats.average_latency_ms = quorum_latency_.load() / quorum_ops;
-        stats.throughput_ops_per_sec = get_throughput(); // Simplified
+    // Rates keep their previous value until enough time has passed
+    if (elapsed_ns >= kMinResourceSampleNs) {
+        last_sample_ns_ = now;
+        cpu_utilization_.store(measure_cpu_usage(elapsed_ns));
+        network_utilization_.store(measure_network_usage(elapsed_ns, network_bytes));
     }
+    memory_usage_.store(measure_memory_usage());
     
-    return stats;
+    publish_snapshot(network_bytes);
 }
 
-PerformanceStats PerformanceMonitor::get_hybrid_stats() const {
-    PerformanceStats stats;
+void PerformanceMonitor::start_sampler(uint64_t interval_ms) {
+    std::lock_guard<std::mutex> lock(sampler_thread_mutex_);
+    if (sampler_running_) {
+        return;
+    }
+    
+    sampler_running_ = true;
+    sampler_thread_ = std::thread(&PerformanceMonitor::sampler_loop, this, std::max<uint64_t>(interval_ms, 1));
     
-    uint64_t hybrid_ops = hybrid_operations_.load();
-    if (hybrid_ops > 0) {
-        stats.average_latency_ms = hybrid_latency_.load() / hybrid_ops;
-        stats.throughput_ops_per_sec = get_throughput(); // Simplified
+    LOG_INFO("Resource sampler started with interval " + std::to_string(interval_ms) + "ms");
+}
+
+void PerformanceMonitor::stop_sampler() {
+    {
+        std::lock_guard<std::mutex> lock(sampler_thread_mutex_);
+        if (!sampler_running_) {
+            return;
+        }
+        sampler_running_ = false;
     }
     
-    return stats;
+    sampler_cv_.notify_all();
+    if (sampler_thread_.joinable()) {
+        sampler_thread_.join();
+    }
 }
 
-void PerformanceMonitor::update_system_stats() {
-    cpu_utilization_.store(measure_cpu_usage());
-    memory_usage_.store(measure_memory_usage());
-    network_utilization_.store(measure_network_usage());
+std::shared_ptr<const MetricsSnapshot> PerformanceMonitor::get_metrics_snapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void PerformanceMonitor::set_network_byte_source(std::function<uint64_t()> source) {
+    std::lock_guard<std::mutex> lock(sampler_mutex_);
+    network_byte_source_ = std::move(source);
+    // Only traffic from now on counts towards utilization
+    last_network_bytes_ = network_byte_source_ ? network_byte_source_() : 0;
+}
+
+void PerformanceMonitor::set_network_capacity(double bytes_per_sec) {
+    std::lock_guard<std::mutex> lock(sampler_mutex_);
+    network_capacity_ = bytes_per_sec;
+}
+
+bool PerformanceMonitor::enable_hardware_counters(bool enable) {
+    std::lock_guard<std::mutex> lock(sampler_mutex_);
+    close_hardware_counters();
+    if (!enable) {
+        return true;
+    }
+    
+    perf_cycles_fd_ = open_perf_counter(PERF_COUNT_HW_CPU_CYCLES);
+    perf_cache_misses_fd_ = open_perf_counter(PERF_COUNT_HW_CACHE_MISSES);
+    if (perf_cycles_fd_ < 0 || perf_cache_misses_fd_ < 0) {
+        LOG_WARNING("Hardware counters unavailable: " + std::string(std::strerror(errno)));
+        close_hardware_counters();
+        return false;
+    }
     
-    // Cleanup old operations periodically
-    cleanup_old_operations();
+    LOG_INFO("Hardware counters enabled");
+    return true;
 }
 
 std::vector<std::string> PerformanceMonitor::get_performance_recommendations() const {
@@ -300,6 +504,13 @@ std::vector<std::string> PerformanceMonitor::get_performance_recommendations() c
                                 "%). Check network reliability and node health.");
     }
     
+    // Resource recommendations
+    if (current.network_utilization > kSaturatedPercent) {
+        recommendations.push_back("Network near capacity (" +
+                                std::to_string(current.network_utilization) +
+                                "%). Consider enabling compression or batching.");
+    }
+    
     // Mode-specific recommendations
     ReplicationMode recommended = get_recommended_mode();
     recommendations.push_back("Recommended replication mode: " + 
@@ -311,7 +522,8 @@ std::vector<std::string> PerformanceMonitor::get_performance_recommendations() c
 bool PerformanceMonitor::should_scale_up() const {
     PerformanceStats current = get_current_stats();
     
-    return (current.cpu_utilization > 80.0) || 
+    return (current.cpu_utilization > kSaturatedPercent) || 
+           (current.network_utilization > kSaturatedPercent) ||
            (current.memory_usage_mb > 1024.0) || // 1GB threshold
            (current.average_latency_ms > latency_threshold_ * 2);
 }
@@ -320,6 +532,7 @@ bool PerformanceMonitor::should_scale_down() const {
     PerformanceStats current = get_current_stats();
     
     return (current.cpu_utilization < 20.0) && 
+           (current.network_utilization < 20.0) &&
            (current.memory_usage_mb < 256.0) && // 256MB threshold
            (current.average_latency_ms < latency_threshold_ / 2);
 }
@@ -329,7 +542,31 @@ ReplicationMode PerformanceMonitor::get_recommended_mode() const {
 }
 
 void PerformanceMonitor::export_metrics_to_file(const std::string& filename) const {
-    std::lock_guard<std::mutex> lock(operations_mutex_);
+    struct ExportedOperation {
+        uint64_t start_time;
+        uint64_t latency_ns;
+        uint64_t meta;
+    };
+    
+    // Snapshot the per-thread recent-operation rings, then write them in time order
+    std::vector<ExportedOperation> operations;
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        for (const auto& shard : shards_) {
+            uint64_t head = shard->recent_head.load(std::memory_order_acquire);
+            uint64_t available = std::min<uint64_t>(head, kRecentOperations);
+            for (uint64_t i = head - available; i < head; ++i) {
+                const auto& op = shard->recent[i % kRecentOperations];
+                operations.push_back({op.start_time.load(std::memory_order_relaxed),
+                                      op.latency_ns.load(std::memory_order_relaxed),
+                                      op.meta.load(std::memory_order_relaxed)});
+            }
+        }
+    }
+    std::sort(operations.begin(), operations.end(),
+              [](const ExportedOperation& a, const ExportedOperation& b) {
+                  return a.start_time < b.start_time;
+              });
     
     std::ofstream file(filename);
     if (!file.is_open()) {
@@ -338,17 +575,16 @@ void PerformanceMonitor::export_metrics_to_file(const std::string& filename) con
     }
     
     // Write header
-    file << "timestamp,operation_type,success,latency_ms,mode,hops,key\n";
+    file << "timestamp,operation_type,success,latency_ms,mode,hops\n";
     
     // Write operation data
-    for (const auto& op : completed_operations_) {
-        file << op.start_time << ","
-             << static_cast<int>(op.operation_type) << ","
-             << (op.success ? "1" : "0") << ","
-             << op.get_latency_ms() << ","
-             << static_cast<int>(op.mode_used) << ","
-             << op.hops << ","
-             << op.key << "\n";
+    for (const auto& op : operations) {
+        file << op.start_time / 1000 << ","
+             << (op.meta & 0xFFFF) << ","
+             << ((op.meta >> 24) & 1) << ","
+             << op.latency_ns / 1e6 << ","
+             << ((op.meta >> 16) & 0xFF) << ","
+             << (op.meta >> 32) << "\n";
     }
     
     file.close();
@@ -356,24 +592,37 @@ void PerformanceMonitor::export_metrics_to_file(const std::string& filename) con
 }
 
 void PerformanceMonitor::reset_metrics() {
-    std::lock_guard<std::mutex> lock(operations_mutex_);
-    
-    active_operations_.clear();
-    completed_operations_.clear();
+    // Intended for quiescent periods; concurrent writers may keep a few samples
+    for (size_t i = 0; i < kActiveOperationSlots; ++i) {
+        active_operations_[i].tag.store(0, std::memory_order_relaxed);
+    }
     
-    total_operations_.store(0);
-    successful_operations_.store(0);
-    failed_operations_.store(0);
-    cumulative_latency_.store(0.0);
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        for (auto& shard : shards_) {
+            for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+                for (size_t type = 0; type < kMessageTypeCount; ++type) {
+                    LatencyHistogram* histogram = shard->histograms[mode][type].load(std::memory_order_acquire);
+                    if (histogram) {
+                        histogram->reset();
+                    }
+                    store_relaxed(shard->failures[mode][type], 0);
+                }
+            }
+            shard->recent_head.store(0, std::memory_order_release);
+        }
+    }
     
-    chain_operations_.store(0);
-    quorum_operations_.store(0);
-    hybrid_operations_.store(0);
-    chain_latency_.store(0.0);
-    quorum_latency_.store(0.0);
-    hybrid_latency_.store(0.0);
+    {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+            last_mode_time_ns_[mode] = 0.0;
+            mode_cycles_[mode] = 0;
+            mode_cache_misses_[mode] = 0;
+        }
+    }
     
-    start_time_ = get_current_timestamp();
+    start_time_.store(get_current_timestamp());
     
     LOG_INFO("Performance metrics reset");
 }
@@ -411,26 +660,137 @@ std::vector<std::string> PerformanceMonitor::get_active_alerts() const {
         alerts.push_back("HIGH_MEMORY_USAGE: " + std::to_string(current.memory_usage_mb) + "MB");
     }
     
+    if (current.network_utilization > 90.0) {
+        alerts.push_back("HIGH_NETWORK_USAGE: " + std::to_string(current.network_utilization) + "%");
+    }
+    
     return alerts;
 }
 
 uint64_t PerformanceMonitor::get_current_timestamp() const {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto duration = now.time_since_epoch();
-    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    // Monotonic nanoseconds; only differences are meaningful
+    return monotonic_now_ns();
 }
 
-std::vector<uint64_t> PerformanceMonitor::get_latency_samples(uint64_t duration_ms) const {
-    auto cutoff_time = get_current_timestamp() - (duration_ms * 1000);
+PerformanceMonitor::ThreadMetrics& PerformanceMonitor::local_shard() {
+    thread_local std::vector<std::pair<uint64_t, ThreadMetrics*>> thread_shards;
     
-    std::vector<uint64_t> samples;
-    for (const auto& op : completed_operations_) {
-        if (op.start_time >= cutoff_time && op.success) {
-            samples.push_back(op.get_latency_ms());
+    for (const auto& entry : thread_shards) {
+        if (entry.first == monitor_id_) {
+            return *entry.second;
         }
     }
     
-    return samples;
+    // First operation from this thread, or its entry was dropped while the
+    // thread used many other monitors (one per partition group, say): find
+    // or register its shard
+    ThreadMetrics* shard = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        std::thread::id self = std::this_thread::get_id();
+        for (const auto& existing : shards_) {
+            if (existing->owner == self) {
+                shard = existing.get();
+                break;
+            }
+        }
+        if (!shard) {
+            shards_.push_back(std::make_unique<ThreadMetrics>());
+            shard = shards_.back().get();
+        }
+    }
+    
+    // Drop entries for monitors that have most likely been destroyed
+    if (thread_shards.size() >= kCachedShards) {
+        thread_shards.erase(thread_shards.begin());
+    }
+    thread_shards.emplace_back(monitor_id_, shard);
+    return *shard;
+}
+
+void PerformanceMonitor::record(MessageType type, ReplicationMode mode, uint64_t start_time,
+                                uint64_t latency_ns, bool success, uint32_t hops) {
+    auto mode_index = static_cast<size_t>(mode);
+    auto type_index = static_cast<size_t>(type);
+    if (mode_index >= kReplicationModeCount || type_index >= kMessageTypeCount) {
+        return;
+    }
+    
+    ThreadMetrics& shard = local_shard();
+    if (success) {
+        auto& slot = shard.histograms[mode_index][type_index];
+        LatencyHistogram* histogram = slot.load(std::memory_order_relaxed);
+        if (!histogram) {
+            histogram = new LatencyHistogram();
+            slot.store(histogram, std::memory_order_release);
+        }
+        histogram->record(latency_ns);
+    } else {
+        auto& failures = shard.failures[mode_index][type_index];
+        store_relaxed(failures, failures.load(std::memory_order_relaxed) + 1);
+    }
+    
+    uint64_t head = shard.recent_head.load(std::memory_order_relaxed);
+    auto& op = shard.recent[head % kRecentOperations];
+    store_relaxed(op.start_time, start_time);
+    store_relaxed(op.latency_ns, latency_ns);
+    store_relaxed(op.meta, pack_operation_meta(type, mode, success, hops));
+    shard.recent_head.store(head + 1, std::memory_order_release);
+}
+
+LatencyHistogram::Snapshot PerformanceMonitor::merge_histograms(int mode, int type, uint64_t* failures) const {
+    LatencyHistogram::Snapshot merged;
+    
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    for (const auto& shard : shards_) {
+        for (size_t m = 0; m < kReplicationModeCount; ++m) {
+            if (mode != kAnyFilter && static_cast<size_t>(mode) != m) {
+                continue;
+            }
+            for (size_t t = 0; t < kMessageTypeCount; ++t) {
+                if (type != kAnyFilter && static_cast<size_t>(type) != t) {
+                    continue;
+                }
+                const LatencyHistogram* histogram = shard->histograms[m][t].load(std::memory_order_acquire);
+                if (histogram) {
+                    histogram->add_to(merged);
+                }
+                if (failures) {
+                    *failures += shard->failures[m][t].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+    
+    return merged;
+}
+
+LatencySummary PerformanceMonitor::summarize(int mode, int type) const {
+    return summarize_snapshot(merge_histograms(mode, type, nullptr));
+}
+
+PerformanceStats PerformanceMonitor::mode_stats(ReplicationMode mode) const {
+    PerformanceStats stats;
+    
+    uint64_t failures = 0;
+    LatencyHistogram::Snapshot merged = merge_histograms(static_cast<int>(mode), kAnyFilter, &failures);
+    uint64_t total_ops = merged.count + failures;
+    if (total_ops == 0) {
+        return stats;
+    }
+    
+    auto elapsed_seconds = (get_current_timestamp() - start_time_.load()) / 1e9;
+    if (elapsed_seconds > 0) {
+        stats.throughput_ops_per_sec = total_ops / elapsed_seconds;
+    }
+    stats.success_rate = static_cast<double>(merged.count) / total_ops;
+    if (merged.count > 0) {
+        stats.average_latency_ms = merged.mean() / 1e6;
+        stats.p95_latency_ms = merged.percentile(0.95) / 1e6;
+        stats.p99_latency_ms = merged.percentile(0.99) / 1e6;
+    }
+    
+    return stats;
 }
 
 double PerformanceMonitor::calculate_percentile(const std::vector<uint64_t>& sorted_values, double percentile) const {
@@ -450,30 +810,120 @@ double PerformanceMonitor::calculate_percentile(const std::vector<uint64_t>& sor
     return sorted_values[lower] * (1.0 - weight) + sorted_values[upper] * weight;
 }
 
-void PerformanceMonitor::cleanup_old_operations() {
-    auto cutoff_time = get_current_timestamp() - (3600 * 1000000); // 1 hour in microseconds
+double PerformanceMonitor::measure_cpu_usage(uint64_t elapsed_ns) {
+    uint64_t ticks = 0;
+    if (!read_process_cpu_ticks(&ticks)) {
+        return 0.0;
+    }
+    uint64_t used_ticks = ticks > last_cpu_ticks_ ? ticks - last_cpu_ticks_ : 0;
+    last_cpu_ticks_ = ticks;
     
-    auto it = std::remove_if(completed_operations_.begin(), completed_operations_.end(),
-        [cutoff_time](const OperationMetrics& op) {
-            return op.start_time < cutoff_time;
-        });
+    static const long ticks_per_second = sysconf(_SC_CLK_TCK);
+    if (elapsed_ns == 0 || ticks_per_second <= 0) {
+        return 0.0;
+    }
     
-    completed_operations_.erase(it, completed_operations_.end());
+    // Busy time as a share of every core's wall time
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    double busy_seconds = static_cast<double>(used_ticks) / ticks_per_second;
+    return std::min(100.0, busy_seconds / (elapsed_ns / 1e9) / cores * 100.0);
 }
 
-double PerformanceMonitor::measure_cpu_usage() const {
-    // Simplified CPU measurement - in practice would read from /proc/stat
-    return 50.0; // Placeholder
+double PerformanceMonitor::measure_memory_usage() const {
+    return read_resident_mb();
 }
 
-double PerformanceMonitor::measure_memory_usage() const {
-    // Simplified memory measurement - in practice would read from /proc/meminfo
-    return 512.0; // Placeholder in MB
+double PerformanceMonitor::measure_network_usage(uint64_t elapsed_ns, uint64_t total_bytes) {
+    if (!network_byte_source_) {
+        return 0.0;
+    }
+    uint64_t moved = total_bytes > last_network_bytes_ ? total_bytes - last_network_bytes_ : 0;
+    last_network_bytes_ = total_bytes;
+    
+    if (elapsed_ns == 0 || network_capacity_ <= 0.0) {
+        return 0.0;
+    }
+    return std::min(100.0, moved / (elapsed_ns / 1e9) / network_capacity_ * 100.0);
+}
+
+void PerformanceMonitor::sample_hardware_counters(MetricsSnapshot& snapshot) {
+    if (perf_cycles_fd_ < 0) {
+        return;
+    }
+    
+    uint64_t cycles = read_perf_counter(perf_cycles_fd_);
+    uint64_t cache_misses = read_perf_counter(perf_cache_misses_fd_);
+    uint64_t cycle_delta = cycles > last_cycles_ ? cycles - last_cycles_ : 0;
+    uint64_t miss_delta = cache_misses > last_cache_misses_ ? cache_misses - last_cache_misses_ : 0;
+    last_cycles_ = cycles;
+    last_cache_misses_ = cache_misses;
+    
+    // Charge the interval's counts to each mode by its share of the
+    // operation time recorded since the previous sample
+    double mode_time[kReplicationModeCount];
+    double total_time = 0.0;
+    for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+        const LatencySummary& latency = snapshot.mode_latency[mode];
+        double time_ns = latency.mean_ns * latency.count;
+        mode_time[mode] = std::max(0.0, time_ns - last_mode_time_ns_[mode]);
+        last_mode_time_ns_[mode] = time_ns;
+        total_time += mode_time[mode];
+    }
+    
+    for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+        if (total_time > 0.0) {
+            double share = mode_time[mode] / total_time;
+            mode_cycles_[mode] += static_cast<uint64_t>(cycle_delta * share);
+            mode_cache_misses_[mode] += static_cast<uint64_t>(miss_delta * share);
+        }
+        snapshot.mode_cycles[mode] = mode_cycles_[mode];
+        snapshot.mode_cache_misses[mode] = mode_cache_misses_[mode];
+    }
+    
+    snapshot.hardware_counters = true;
+    snapshot.cpu_cycles = cycles;
+    snapshot.cache_misses = cache_misses;
 }
 
-double PerformanceMonitor::measure_network_usage() const {
-    // Simplified network measurement - in practice would read from /proc/net/dev
-    return 25.0; // Placeholder percentage
+void PerformanceMonitor::close_hardware_counters() {
+    for (int* fd : {&perf_cycles_fd_, &perf_cache_misses_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    last_cycles_ = 0;
+    last_cache_misses_ = 0;
+}
+
+void PerformanceMonitor::publish_snapshot(uint64_t network_bytes) {
+    auto snapshot = std::make_shared<MetricsSnapshot>();
+    uint64_t now = get_current_timestamp();
+    uint64_t started = start_time_.load();
+    snapshot->taken_at_ns = now;
+    snapshot->uptime_ns = now > started ? now - started : 0;
+    snapshot->overall = get_current_stats();
+    for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+        uint64_t failures = 0;
+        snapshot->mode_latency[mode] = summarize_snapshot(
+            merge_histograms(static_cast<int>(mode), kAnyFilter, &failures));
+        snapshot->mode_failures[mode] = failures;
+    }
+    snapshot->network_bytes = network_bytes;
+    sample_hardware_counters(*snapshot);
+    
+    std::atomic_store(&snapshot_, std::shared_ptr<const MetricsSnapshot>(std::move(snapshot)));
+}
+
+void PerformanceMonitor::sampler_loop(uint64_t interval_ms) {
+    std::unique_lock<std::mutex> lock(sampler_thread_mutex_);
+    while (sampler_running_) {
+        lock.unlock();
+        update_system_stats();
+        lock.lock();
+        sampler_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                             [this] { return !sampler_running_; });
+    }
 }
 
 bool PerformanceMonitor::is_performance_degraded() const {
@@ -489,6 +939,36 @@ ReplicationMode PerformanceMonitor::analyze_optimal_mode() const {
     PerformanceStats chain_stats = get_chain_stats();
     PerformanceStats quorum_stats = get_quorum_stats();
     
+    // When CPU or network is saturated, latency mostly measures queueing;
+    // prefer the mode that costs the scarce resource least per operation
+    double cpu = cpu_utilization_.load();
+    double network = network_utilization_.load();
+    if (chain_stats.throughput_ops_per_sec > 0.0 && quorum_stats.throughput_ops_per_sec > 0.0 &&
+        (cpu > kSaturatedPercent || network > kSaturatedPercent)) {
+        auto chain = static_cast<size_t>(ReplicationMode::CHAIN_ONLY);
+        auto quorum = static_cast<size_t>(ReplicationMode::QUORUM_ONLY);
+        std::shared_ptr<const MetricsSnapshot> snapshot = get_metrics_snapshot();
+        
+        double chain_cost = 0.0;
+        double quorum_cost = 0.0;
+        if (cpu >= network && snapshot && snapshot->hardware_counters) {
+            uint64_t chain_ops = snapshot->mode_latency[chain].count + snapshot->mode_failures[chain];
+            uint64_t quorum_ops = snapshot->mode_latency[quorum].count + snapshot->mode_failures[quorum];
+            if (chain_ops > 0 && quorum_ops > 0) {
+                chain_cost = static_cast<double>(snapshot->mode_cycles[chain]) / chain_ops;
+                quorum_cost = static_cast<double>(snapshot->mode_cycles[quorum]) / quorum_ops;
+            }
+        } else {
+            // Hops stand in for the messages each operation puts on the wire
+            chain_cost = average_hops(ReplicationMode::CHAIN_ONLY);
+            quorum_cost = average_hops(ReplicationMode::QUORUM_ONLY);
+        }
+        
+        if (chain_cost > 0.0 && quorum_cost > 0.0 && chain_cost != quorum_cost) {
+            return chain_cost < quorum_cost ? ReplicationMode::CHAIN_ONLY : ReplicationMode::QUORUM_ONLY;
+        }
+    }
+    
     // Simple heuristic: prefer the mode with lower latency and higher throughput
     if (chain_stats.average_latency_ms < quorum_stats.average_latency_ms &&
         chain_stats.throughput_ops_per_sec > quorum_stats.throughput_ops_per_sec) {
@@ -523,4 +1003,24 @@ double PerformanceMonitor::calculate_efficiency_score(ReplicationMode mode) cons
     return (throughput_score * 0.6) + (latency_score * 0.4);
 }
 
+double PerformanceMonitor::average_hops(ReplicationMode mode) const {
+    uint64_t operations = 0;
+    uint64_t hops = 0;
+    
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    for (const auto& shard : shards_) {
+        uint64_t head = shard->recent_head.load(std::memory_order_acquire);
+        uint64_t available = std::min<uint64_t>(head, kRecentOperations);
+        for (uint64_t i = head - available; i < head; ++i) {
+            uint64_t meta = shard->recent[i % kRecentOperations].meta.load(std::memory_order_relaxed);
+            if (((meta >> 16) & 0xFF) == static_cast<uint64_t>(mode)) {
+                operations++;
+                hops += meta >> 32;
+            }
+        }
+    }
+    
+    return operations > 0 ? static_cast<double>(hops) / operations : 0.0;
+}
+
 } // namespace replication 
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include "performance/metrics_endpoint.h"
+#include "utils/logger.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace replication {
+
+namespace {
+
+// How long stop() may wait for the server thread to notice
+constexpr int kAcceptPollMs = 100;
+
+// Scrapers send a request line and a few headers; anything longer is cut off
+constexpr size_t kMaxRequestBytes = 8 * 1024;
+constexpr int kRequestTimeoutMs = 1000;
+
+const char* const kModeLabels[kReplicationModeCount] = {"chain", "quorum", "hybrid"};
+
+void write_all(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t result = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        written += static_cast<size_t>(result);
+    }
+}
+
+void send_response(int fd, const char* status, const std::string& body) {
+    std::ostringstream response;
+    response << "HTTP/1.1 " << status << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body;
+    write_all(fd, response.str());
+}
+
+void write_metric_header(std::ostringstream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n";
+}
+
+} // namespace
+
+MetricsEndpoint::MetricsEndpoint(const PerformanceMonitor& monitor, uint16_t port)
+    : monitor_(monitor)
+    , port_(port)
+    , listen_fd_(-1)
+    , running_(false) {
+}
+
+MetricsEndpoint::~MetricsEndpoint() {
+    stop();
+}
+
+bool MetricsEndpoint::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        LOG_ERROR("Failed to create metrics socket: " + std::string(std::strerror(errno)));
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port_);
+
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listen_fd_, 16) < 0) {
+        LOG_ERROR("Failed to listen for metrics on port " + std::to_string(port_) + ": " +
+                  std::string(std::strerror(errno)));
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+
+    running_.store(true);
+    server_thread_ = std::thread(&MetricsEndpoint::server_loop, this);
+
+    LOG_INFO("Metrics endpoint listening on port " + std::to_string(port_));
+    return true;
+}
+
+void MetricsEndpoint::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    if (server_thread_.joinable()) {
+        server_thread_.join();
+    }
+    close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+std::string MetricsEndpoint::render(const MetricsSnapshot& snapshot) {
+    std::ostringstream out;
+
+    write_metric_header(out, "replication_uptime_seconds", "gauge",
+                        "Time since the monitor started or was last reset.");
+    out << "replication_uptime_seconds " << snapshot.uptime_ns / 1e9 << "\n";
+
+    write_metric_header(out, "replication_operations_total", "counter",
+                        "Completed operations by replication mode and result.");
+    for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+        out << "replication_operations_total{mode=\"" << kModeLabels[mode] << "\",result=\"success\"} "
+            << snapshot.mode_latency[mode].count << "\n"
+            << "replication_operations_total{mode=\"" << kModeLabels[mode] << "\",result=\"failure\"} "
+            << snapshot.mode_failures[mode] << "\n";
+    }
+
+    write_metric_header(out, "replication_latency_seconds", "summary",
+                        "Latency of successful operations by replication mode.");
+    for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+        const LatencySummary& latency = snapshot.mode_latency[mode];
+        const std::string label = std::string("mode=\"") + kModeLabels[mode] + "\"";
+        const std::pair<const char*, uint64_t> quantiles[] = {
+            {"0.5", latency.p50_ns}, {"0.95", latency.p95_ns},
+            {"0.99", latency.p99_ns}, {"0.999", latency.p999_ns}};
+        for (const auto& quantile : quantiles) {
+            out << "replication_latency_seconds{" << label << ",quantile=\"" << quantile.first << "\"} "
+                << quantile.second / 1e9 << "\n";
+        }
+        out << "replication_latency_seconds_sum{" << label << "} "
+            << latency.mean_ns * latency.count / 1e9 << "\n"
+            << "replication_latency_seconds_count{" << label << "} " << latency.count << "\n";
+    }
+
+    write_metric_header(out, "replication_throughput_ops_per_second", "gauge",
+                        "Operations per second since the monitor started or was last reset.");
+    out << "replication_throughput_ops_per_second " << snapshot.overall.throughput_ops_per_sec << "\n";
+
+    write_metric_header(out, "replication_cpu_utilization_percent", "gauge",
+                        "Process CPU time as a share of all cores.");
+    out << "replication_cpu_utilization_percent " << snapshot.overall.cpu_utilization << "\n";
+
+    write_metric_header(out, "replication_resident_memory_megabytes", "gauge",
+                        "Process resident set size.");
+    out << "replication_resident_memory_megabytes " << snapshot.overall.memory_usage_mb << "\n";
+
+    write_metric_header(out, "replication_network_utilization_percent", "gauge",
+                        "Replication socket traffic as a share of the configured capacity.");
+    out << "replication_network_utilization_percent " << snapshot.overall.network_utilization << "\n";
+
+    write_metric_header(out, "replication_network_bytes_total", "counter",
+                        "Bytes sent and received on replication sockets.");
+    out << "replication_network_bytes_total " << snapshot.network_bytes << "\n";
+
+    if (snapshot.hardware_counters) {
+        write_metric_header(out, "replication_cpu_cycles_total", "counter",
+                            "User-space CPU cycles, apportioned to modes by operation time.");
+        out << "replication_cpu_cycles_total " << snapshot.cpu_cycles << "\n";
+        for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+            out << "replication_cpu_cycles_total{mode=\"" << kModeLabels[mode] << "\"} "
+                << snapshot.mode_cycles[mode] << "\n";
+        }
+
+        write_metric_header(out, "replication_cache_misses_total", "counter",
+                            "Cache misses, apportioned to modes by operation time.");
+        out << "replication_cache_misses_total " << snapshot.cache_misses << "\n";
+        for (size_t mode = 0; mode < kReplicationModeCount; ++mode) {
+            out << "replication_cache_misses_total{mode=\"" << kModeLabels[mode] << "\"} "
+                << snapshot.mode_cache_misses[mode] << "\n";
+        }
+    }
+
+    return out.str();
+}
+
+void MetricsEndpoint::server_loop() {
+    while (running_.load()) {
+        pollfd listener;
+        listener.fd = listen_fd_;
+        listener.events = POLLIN;
+        listener.revents = 0;
+
+        int ready = poll(&listener, 1, kAcceptPollMs);
+        if (ready <= 0 || !(listener.revents & POLLIN)) {
+            continue;
+        }
+
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        serve_connection(fd);
+        close(fd);
+    }
+}
+
+void MetricsEndpoint::serve_connection(int fd) {
+    timeval timeout;
+    timeout.tv_sec = kRequestTimeoutMs / 1000;
+    timeout.tv_usec = (kRequestTimeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters; read until the end of the headers
+    std::string request;
+    char chunk[1024];
+    while (request.size() < kMaxRequestBytes && request.find("\r\n\r\n") == std::string::npos) {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        request.append(chunk, static_cast<size_t>(received));
+    }
+
+    std::istringstream request_line(request.substr(0, request.find("\r\n")));
+    std::string method;
+    std::string target;
+    request_line >> method >> target;
+    std::string path = target.substr(0, target.find('?'));
+
+    if (method != "GET") {
+        send_response(fd, "405 Method Not Allowed", "Only GET is supported\n");
+        return;
+    }
+    if (path != "/metrics") {
+        send_response(fd, "404 Not Found", "Metrics are served at /metrics\n");
+        return;
+    }
+
+    std::shared_ptr<const MetricsSnapshot> snapshot = monitor_.get_metrics_snapshot();
+    if (!snapshot) {
+        send_response(fd, "503 Service Unavailable", "No metrics sampled yet\n");
+        return;
+    }
+    send_response(fd, "200 OK", render(*snapshot));
+}
+
+} // namespace replication
@@ -0,0 +1,218 @@
+#include "performance/workload.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace replication {
+
+namespace {
+
+// FNV-1a over the rank's bytes; scatters popular ranks across the keyspace
+uint64_t scramble(uint64_t rank) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (rank >> (i * 8)) & 0xFF;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+bool WorkloadSpec::ycsb(char workload, WorkloadSpec& spec) {
+    spec = WorkloadSpec();
+    spec.name = std::string("ycsb-") + static_cast<char>(std::tolower(static_cast<unsigned char>(workload)));
+    spec.read_proportion = 0.0;
+    switch (std::toupper(static_cast<unsigned char>(workload))) {
+        case 'A': // update heavy
+            spec.read_proportion = 0.5;
+            spec.update_proportion = 0.5;
+            return true;
+        case 'B': // read mostly
+            spec.read_proportion = 0.95;
+            spec.update_proportion = 0.05;
+            return true;
+        case 'C': // read only
+            spec.read_proportion = 1.0;
+            return true;
+        case 'D': // read latest
+            spec.read_proportion = 0.95;
+            spec.insert_proportion = 0.05;
+            spec.key_distribution = KeyDistribution::LATEST;
+            return true;
+        case 'E': // short ranges
+            spec.scan_proportion = 0.95;
+            spec.insert_proportion = 0.05;
+            return true;
+        case 'F': // read-modify-write
+            spec.read_proportion = 0.5;
+            spec.read_modify_write_proportion = 0.5;
+            return true;
+        default:
+            return false;
+    }
+}
+
+ZipfianGenerator::ZipfianGenerator(uint64_t items, double theta)
+    : items_(0)
+    , theta_(theta)
+    , alpha_(1.0 / (1.0 - theta))
+    , zeta2_(1.0 + std::pow(0.5, theta))
+    , zetan_(0.0)
+    , eta_(0.0) {
+    grow(std::max<uint64_t>(items, 1));
+}
+
+void ZipfianGenerator::grow(uint64_t items) {
+    for (uint64_t i = items_ + 1; i <= items; ++i) {
+        zetan_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+    }
+    items_ = items;
+    eta_ = (1.0 - std::pow(2.0 / items_, 1.0 - theta_)) / (1.0 - zeta2_ / zetan_);
+}
+
+uint64_t ZipfianGenerator::next(std::mt19937_64& rng, uint64_t items) {
+    if (items <= 1) {
+        return 0;
+    }
+    if (items < items_) {
+        // Rare (the keyspace shrank): start the sum over
+        items_ = 0;
+        zetan_ = 0.0;
+    }
+    if (items != items_) {
+        grow(items);
+    }
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    double uz = u * zetan_;
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < zeta2_) {
+        return 1;
+    }
+    uint64_t rank = static_cast<uint64_t>(items_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(rank, items - 1);
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadSpec& spec, std::atomic<uint64_t>& record_count, uint64_t seed)
+    : spec_(spec)
+    , record_count_(record_count)
+    , rng_(seed)
+    , unit_(0.0, 1.0)
+    , key_ranks_(std::max<uint64_t>(record_count.load(), 1), spec.zipfian_constant)
+    , value_sizes_(spec.max_value_size > spec.min_value_size ? spec.max_value_size - spec.min_value_size + 1 : 1,
+                   spec.zipfian_constant)
+    , total_proportion_(spec.read_proportion + spec.update_proportion + spec.insert_proportion +
+                        spec.scan_proportion + spec.read_modify_write_proportion) {}
+
+uint64_t WorkloadGenerator::next_key(uint64_t records) {
+    if (records <= 1) {
+        return 0;
+    }
+    switch (spec_.key_distribution) {
+        case KeyDistribution::UNIFORM:
+            return std::uniform_int_distribution<uint64_t>(0, records - 1)(rng_);
+        case KeyDistribution::LATEST:
+            return records - 1 - key_ranks_.next(rng_, records);
+        case KeyDistribution::HOTSPOT: {
+            uint64_t hot = std::max<uint64_t>(1, static_cast<uint64_t>(records * spec_.hotspot_data_fraction));
+            if (hot >= records || unit_(rng_) < spec_.hotspot_operation_fraction) {
+                return std::uniform_int_distribution<uint64_t>(0, std::min(hot, records) - 1)(rng_);
+            }
+            return std::uniform_int_distribution<uint64_t>(hot, records - 1)(rng_);
+        }
+        case KeyDistribution::ZIPFIAN:
+        default:
+            return scramble(key_ranks_.next(rng_, records)) % records;
+    }
+}
+
+size_t WorkloadGenerator::next_value_size() {
+    size_t low = std::min(spec_.min_value_size, spec_.max_value_size);
+    switch (spec_.value_distribution) {
+        case ValueSizeDistribution::UNIFORM:
+            return std::uniform_int_distribution<size_t>(low, spec_.max_value_size)(rng_);
+        case ValueSizeDistribution::ZIPFIAN:
+            return low + static_cast<size_t>(value_sizes_.next(rng_));
+        case ValueSizeDistribution::FIXED:
+        default:
+            return spec_.max_value_size;
+    }
+}
+
+WorkloadOperation WorkloadGenerator::next() {
+    WorkloadOperation operation;
+    double pick = unit_(rng_) * (total_proportion_ > 0 ? total_proportion_ : 1.0);
+    if ((pick -= spec_.read_proportion) < 0 || total_proportion_ <= 0) {
+        operation.kind = WorkloadOperationKind::READ;
+    } else if ((pick -= spec_.update_proportion) < 0) {
+        operation.kind = WorkloadOperationKind::UPDATE;
+    } else if ((pick -= spec_.insert_proportion) < 0) {
+        operation.kind = WorkloadOperationKind::INSERT;
+    } else if ((pick -= spec_.scan_proportion) < 0) {
+        operation.kind = WorkloadOperationKind::SCAN;
+    } else {
+        operation.kind = WorkloadOperationKind::READ_MODIFY_WRITE;
+    }
+
+    if (operation.kind == WorkloadOperationKind::INSERT) {
+        operation.key_index = next_insert_key();
+    } else {
+        operation.key_index = next_key(record_count_.load(std::memory_order_relaxed));
+    }
+    if (operation.kind == WorkloadOperationKind::SCAN) {
+        operation.scan_length = std::uniform_int_distribution<size_t>(1, std::max<size_t>(spec_.max_scan_length, 1))(rng_);
+    }
+    if (operation.kind != WorkloadOperationKind::READ && operation.kind != WorkloadOperationKind::SCAN) {
+        operation.value_size = next_value_size();
+    }
+    return operation;
+}
+
+const char* workload_operation_name(WorkloadOperationKind kind) {
+    switch (kind) {
+        case WorkloadOperationKind::READ: return "read";
+        case WorkloadOperationKind::UPDATE: return "update";
+        case WorkloadOperationKind::INSERT: return "insert";
+        case WorkloadOperationKind::SCAN: return "scan";
+        case WorkloadOperationKind::READ_MODIFY_WRITE: return "read_modify_write";
+    }
+    return "unknown";
+}
+
+const char* key_distribution_name(KeyDistribution distribution) {
+    switch (distribution) {
+        case KeyDistribution::UNIFORM: return "uniform";
+        case KeyDistribution::ZIPFIAN: return "zipfian";
+        case KeyDistribution::LATEST: return "latest";
+        case KeyDistribution::HOTSPOT: return "hotspot";
+    }
+    return "unknown";
+}
+
+bool parse_key_distribution(const std::string& name, KeyDistribution& distribution) {
+    for (KeyDistribution candidate : {KeyDistribution::UNIFORM, KeyDistribution::ZIPFIAN,
+                                      KeyDistribution::LATEST, KeyDistribution::HOTSPOT}) {
+        if (name == key_distribution_name(candidate)) {
+            distribution = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_value_size_distribution(const std::string& name, ValueSizeDistribution& distribution) {
+    if (name == "fixed") {
+        distribution = ValueSizeDistribution::FIXED;
+    } else if (name == "uniform") {
+        distribution = ValueSizeDistribution::UNIFORM;
+    } else if (name == "zipfian") {
+        distribution = ValueSizeDistribution::ZIPFIAN;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace replication
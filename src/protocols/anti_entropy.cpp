@@ -0,0 +1,369 @@
+#include "protocols/anti_entropy.h"
+#include "utils/clock.h"
+#include "utils/logger.h"
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <unordered_set>
+#include <utility>
+
+namespace replication {
+
+namespace {
+
+// Marks the final SYNC_RANGE_DATA chunk of a leaf
+const std::string kLastChunkTag = "sync_last";
+
+template <typename T>
+void append_packed(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T read_packed(const std::string& in, size_t offset) {
+    T value;
+    std::memcpy(&value, in.data() + offset, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+AntiEntropy::AntiEntropy(std::shared_ptr<Node> node, const AntiEntropyConfig& config)
+    : node_(node)
+    , partition_id_(0)
+    , next_request_id_(1) {
+    set_config(config);
+}
+
+void AntiEntropy::set_config(const AntiEntropyConfig& config) {
+    config_ = config;
+    if (config_.max_inflight_chunks == 0) {
+        config_.max_inflight_chunks = 1;
+    }
+}
+
+void AntiEntropy::set_scope(uint32_t partition_id, MerkleTree::KeyFilter filter) {
+    partition_id_ = partition_id;
+    filter_ = std::move(filter);
+}
+
+bool AntiEntropy::sync_pass(uint32_t source, size_t& keys_changed) {
+    keys_changed = 0;
+    MerkleTree local;
+    local.build(node_->get_storage(), true, filter_);
+
+    std::vector<uint32_t> leaves;
+    bool completed = find_differing_leaves(source, local, leaves) &&
+                     fetch_leaves(source, local, leaves, keys_changed);
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.passes++;
+    }
+
+    if (!completed) {
+        LOG_WARNING("Anti-entropy pass against node " + std::to_string(source) + " did not complete");
+        return false;
+    }
+    LOG_INFO("Anti-entropy pass against node " + std::to_string(source) + ": " +
+             std::to_string(leaves.size()) + " of " + std::to_string(MerkleTree::kLeafCount) +
+             " ranges differed, " + std::to_string(keys_changed) + " keys changed");
+    return true;
+}
+
+bool AntiEntropy::find_differing_leaves(uint32_t source, const MerkleTree& local, std::vector<uint32_t>& leaves) {
+    // Each round trip returns the children of the nodes still differing
+    std::vector<uint32_t> differing = {0};
+    for (size_t level = 0; level < MerkleTree::kDepth && !differing.empty(); ++level) {
+        Message request;
+        request.type = MessageType::SYNC_TREE_REQUEST;
+        request.log_index = level;
+        std::string& indices = request.value.mutable_str();
+        for (uint32_t index : differing) {
+            append_packed(indices, index);
+        }
+        std::future<Message> reply = send_request(source, request);
+        Message response;
+        if (!await_reply(request.sequence_number, reply, response)) {
+            return false;
+        }
+        if (!response.success || response.value.size() != differing.size() * MerkleTree::kFanout * sizeof(uint64_t)) {
+            LOG_WARNING("Malformed tree response from node " + std::to_string(source));
+            return false;
+        }
+
+        std::vector<uint32_t> children;
+        size_t offset = 0;
+        for (uint32_t index : differing) {
+            for (size_t child = 0; child < MerkleTree::kFanout; ++child) {
+                uint32_t child_index = static_cast<uint32_t>(index * MerkleTree::kFanout + child);
+                if (read_packed<uint64_t>(response.value, offset) != local.node_hash(level + 1, child_index)) {
+                    children.push_back(child_index);
+                }
+                offset += sizeof(uint64_t);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.ranges_compared += differing.size() * MerkleTree::kFanout;
+        }
+        differing = std::move(children);
+    }
+    leaves = std::move(differing);
+    return true;
+}
+
+bool AntiEntropy::fetch_leaves(uint32_t source, const MerkleTree& local, const std::vector<uint32_t>& leaves,
+                               size_t& keys_changed) {
+    struct LeafFetch {
+        uint32_t leaf;
+        std::unordered_set<std::string> received;
+
+        explicit LeafFetch(uint32_t leaf_index) : leaf(leaf_index) {}
+    };
+    struct Chunk {
+        std::shared_ptr<LeafFetch> fetch;
+        uint32_t request_id;
+        std::future<Message> reply;
+    };
+
+    // A leaf's next chunk is requested only once its previous one is applied;
+    // the window overlaps chunks of different leaves
+    std::deque<Chunk> window;
+    auto request_chunk = [&](const std::shared_ptr<LeafFetch>& fetch, uint64_t offset) {
+        Message request;
+        request.type = MessageType::SYNC_RANGE_REQUEST;
+        request.log_index = fetch->leaf;
+        request.ballot = offset;
+        std::future<Message> reply = send_request(source, request);
+        window.push_back(Chunk{fetch, request.sequence_number, std::move(reply)});
+    };
+    auto abandon_window = [&]() {
+        for (const Chunk& chunk : window) {
+            abandon(chunk.request_id);
+        }
+    };
+
+    size_t next_leaf = 0;
+    const StorageEngine& storage = node_->get_storage();
+    while (!window.empty() || next_leaf < leaves.size()) {
+        while (window.size() < config_.max_inflight_chunks && next_leaf < leaves.size()) {
+            request_chunk(std::make_shared<LeafFetch>(leaves[next_leaf++]), 0);
+        }
+
+        Chunk chunk = std::move(window.front());
+        window.pop_front();
+        Message data;
+        if (!await_reply(chunk.request_id, chunk.reply, data)) {
+            abandon_window();
+            return false;
+        }
+
+        // Keys that already match are left alone, so an unchanged key in a
+        // differing leaf costs no local write
+        std::vector<std::pair<std::string, std::string>> puts;
+        size_t bytes = 0;
+        size_t received = 0;
+        size_t offset = 0;
+        while (offset + 2 * sizeof(uint32_t) <= data.value.size()) {
+            uint32_t key_size = read_packed<uint32_t>(data.value, offset);
+            uint32_t value_size = read_packed<uint32_t>(data.value, offset + sizeof(uint32_t));
+            offset += 2 * sizeof(uint32_t);
+            if (data.value.size() - offset < static_cast<size_t>(key_size) + value_size) {
+                break;
+            }
+            std::string key = data.value.substr(offset, key_size);
+            std::string value = data.value.substr(offset + key_size, value_size);
+            offset += key_size + value_size;
+            bytes += key_size + value_size;
+            ++received;
+
+            ValueRef current = storage.get_ref(key);
+            if (!current || *current != value) {
+                puts.emplace_back(key, std::move(value));
+            }
+            chunk.fetch->received.insert(std::move(key));
+        }
+        if (!data.success || offset != data.value.size()) {
+            LOG_WARNING("Malformed range data from node " + std::to_string(source));
+            abandon_window();
+            return false;
+        }
+        keys_changed += node_->apply_catch_up(puts, {});
+
+        size_t removed = 0;
+        if (data.metadata == kLastChunkTag) {
+            // Whatever the leaf held here that the source no longer has
+            std::vector<std::string> erases;
+            for (const std::string& key : local.leaf_keys(chunk.fetch->leaf)) {
+                if (chunk.fetch->received.count(key) == 0) {
+                    erases.push_back(key);
+                }
+            }
+            removed = node_->apply_catch_up({}, erases);
+            keys_changed += removed;
+        } else {
+            request_chunk(chunk.fetch, data.ballot);
+        }
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.keys_transferred += received;
+        stats_.bytes_transferred += bytes;
+        stats_.keys_removed += removed;
+        if (data.metadata == kLastChunkTag) {
+            stats_.ranges_transferred++;
+        }
+    }
+    return true;
+}
+
+void AntiEntropy::handle_tree_request(const Message& request) {
+    // A request for the root starts a new pass against a fresh tree
+    std::shared_ptr<MerkleTree> tree = session_for(request.sender_id, request.log_index == 0);
+
+    Message response;
+    response.type = MessageType::SYNC_TREE_RESPONSE;
+    response.sender_id = node_->get_node_id();
+    response.receiver_id = request.sender_id;
+    response.timestamp = monotonic_now_us();
+    response.sequence_number = request.sequence_number;
+    response.partition_id = partition_id_;
+    response.log_index = request.log_index;
+    response.success = request.log_index < MerkleTree::kDepth &&
+                       request.value.size() % sizeof(uint32_t) == 0;
+
+    size_t width = response.success ? MerkleTree::level_width(request.log_index) : 0;
+    std::string& hashes = response.value.mutable_str();
+    for (size_t offset = 0; response.success && offset < request.value.size(); offset += sizeof(uint32_t)) {
+        uint32_t index = read_packed<uint32_t>(request.value, offset);
+        if (index >= width) {
+            response.success = false;
+            break;
+        }
+        for (size_t child = 0; child < MerkleTree::kFanout; ++child) {
+            append_packed(hashes, tree->node_hash(request.log_index + 1, index * MerkleTree::kFanout + child));
+        }
+    }
+    if (!response.success) {
+        response.value.clear();
+    }
+    node_->send_message(request.sender_id, response);
+}
+
+void AntiEntropy::handle_range_request(const Message& request) {
+    std::shared_ptr<MerkleTree> tree = session_for(request.sender_id, false);
+
+    Message response;
+    response.type = MessageType::SYNC_RANGE_DATA;
+    response.sender_id = node_->get_node_id();
+    response.receiver_id = request.sender_id;
+    response.timestamp = monotonic_now_us();
+    response.sequence_number = request.sequence_number;
+    response.partition_id = partition_id_;
+    response.log_index = request.log_index;
+    response.success = request.log_index < MerkleTree::kLeafCount;
+
+    const std::vector<std::string>& keys = tree->leaf_keys(static_cast<size_t>(request.log_index));
+    size_t next = static_cast<size_t>(request.ballot);
+    const StorageEngine& storage = node_->get_storage();
+    std::string& chunk = response.value.mutable_str();
+    while (response.success && next < keys.size() && chunk.size() < config_.chunk_bytes) {
+        const std::string& key = keys[next++];
+        // Deleted since the tree was built: omitted, so the recipient drops it
+        ValueRef value = storage.get_ref(key);
+        if (!value) {
+            continue;
+        }
+        append_packed(chunk, static_cast<uint32_t>(key.size()));
+        append_packed(chunk, static_cast<uint32_t>(value->size()));
+        chunk.append(key);
+        chunk.append(*value);
+    }
+    response.ballot = next;
+    if (next >= keys.size()) {
+        response.metadata = kLastChunkTag;
+    }
+    node_->send_message(request.sender_id, response);
+}
+
+void AntiEntropy::end_session(uint32_t requester) {
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    sessions_.erase(requester);
+}
+
+void AntiEntropy::handle_tree_response(const Message& response) {
+    resolve(response);
+}
+
+void AntiEntropy::handle_range_data(const Message& response) {
+    resolve(response);
+}
+
+AntiEntropyStats AntiEntropy::get_stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+std::shared_ptr<MerkleTree> AntiEntropy::session_for(uint32_t requester, bool rebuild) {
+    if (!rebuild) {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        auto it = sessions_.find(requester);
+        if (it != sessions_.end()) {
+            return it->second;
+        }
+    }
+
+    // Built outside the lock; a scan of a large store takes a while
+    auto tree = std::make_shared<MerkleTree>();
+    tree->build(node_->get_storage(), true, filter_);
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    sessions_[requester] = tree;
+    return tree;
+}
+
+std::future<Message> AntiEntropy::send_request(uint32_t source, Message& request) {
+    uint32_t request_id = next_request_id_.fetch_add(1);
+    auto waiter = std::make_shared<std::promise<Message>>();
+    std::future<Message> reply = waiter->get_future();
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_[request_id] = waiter;
+    }
+
+    request.sender_id = node_->get_node_id();
+    request.receiver_id = source;
+    request.timestamp = monotonic_now_us();
+    request.sequence_number = request_id;
+    request.partition_id = partition_id_;
+    node_->send_message(source, request);
+    return reply;
+}
+
+bool AntiEntropy::await_reply(uint32_t request_id, std::future<Message>& reply, Message& response) {
+    if (reply.wait_for(std::chrono::milliseconds(config_.request_timeout_ms)) != std::future_status::ready) {
+        abandon(request_id);
+        return false;
+    }
+    response = reply.get();
+    return true;
+}
+
+void AntiEntropy::abandon(uint32_t request_id) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_.erase(request_id);
+}
+
+void AntiEntropy::resolve(const Message& response) {
+    std::shared_ptr<std::promise<Message>> waiter;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        auto it = pending_.find(response.sequence_number);
+        if (it == pending_.end()) {
+            return; // timed out or abandoned
+        }
+        waiter = it->second;
+        pending_.erase(it);
+    }
+    waiter->set_value(response);
+}
+
+} // namespace replication
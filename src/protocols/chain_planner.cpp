@@ -0,0 +1,242 @@
+#include "protocols/chain_planner.h"
+#include <algorithm>
+#include <limits>
+#include <set>
+
+namespace replication {
+
+namespace {
+
+constexpr double kInfiniteCost = std::numeric_limits<double>::infinity();
+
+// Cost differences below this are rounding, not a better order
+constexpr double kCostEpsilonMs = 1e-9;
+
+double lookup(const std::unordered_map<uint32_t, double>& costs, uint32_t node) {
+    auto it = costs.find(node);
+    return it != costs.end() ? it->second : 0.0;
+}
+
+bool spans_domains(const std::vector<uint32_t>& members, const ChainPlacementPolicy& policy) {
+    std::set<uint32_t> domains;
+    for (uint32_t node : members) {
+        auto it = policy.failure_domains.find(node);
+        if (it != policy.failure_domains.end()) {
+            domains.insert(it->second);
+        }
+    }
+    return domains.size() > 1;
+}
+
+bool ends_conflict(uint32_t head, uint32_t tail, const ChainPlacementPolicy& policy, bool multi_domain) {
+    if (!policy.separate_head_and_tail || !multi_domain || head == tail) {
+        return false;
+    }
+    auto head_domain = policy.failure_domains.find(head);
+    auto tail_domain = policy.failure_domains.find(tail);
+    return head_domain != policy.failure_domains.end() && tail_domain != policy.failure_domains.end() &&
+           head_domain->second == tail_domain->second;
+}
+
+double path_cost(const std::vector<uint32_t>& order, const LatencyMatrix& rtt,
+                 const ChainPlacementPolicy& policy, bool multi_domain) {
+    if (order.empty()) {
+        return 0.0;
+    }
+    if (ends_conflict(order.front(), order.back(), policy, multi_domain)) {
+        return kInfiniteCost;
+    }
+
+    double total = policy.client_weight * lookup(policy.client_rtt_ms, order.front()) +
+                   policy.reader_weight * lookup(policy.reader_rtt_ms, order.back());
+    for (size_t i = 0; i + 1 < order.size(); ++i) {
+        total += rtt.get(order[i], order[i + 1]);
+    }
+    return total;
+}
+
+// Held-Karp over subsets, once per candidate head
+std::vector<uint32_t> plan_exact(const std::vector<uint32_t>& members, const LatencyMatrix& rtt,
+                                 const ChainPlacementPolicy& policy, bool multi_domain) {
+    const size_t n = members.size();
+    const size_t full = (size_t(1) << n) - 1;
+    std::vector<double> cost((size_t(1) << n) * n);
+    std::vector<uint8_t> parent((size_t(1) << n) * n);
+
+    std::vector<uint32_t> best_order;
+    double best_cost = kInfiniteCost;
+    for (size_t head = 0; head < n; ++head) {
+        std::fill(cost.begin(), cost.end(), kInfiniteCost);
+        cost[(size_t(1) << head) * n + head] =
+            policy.client_weight * lookup(policy.client_rtt_ms, members[head]);
+
+        for (size_t mask = 1; mask <= full; ++mask) {
+            if (!(mask & (size_t(1) << head))) {
+                continue;
+            }
+            for (size_t last = 0; last < n; ++last) {
+                double so_far = cost[mask * n + last];
+                if (so_far == kInfiniteCost) {
+                    continue;
+                }
+                for (size_t next = 0; next < n; ++next) {
+                    if (mask & (size_t(1) << next)) {
+                        continue;
+                    }
+                    size_t extended = mask | (size_t(1) << next);
+                    double candidate = so_far + rtt.get(members[last], members[next]);
+                    if (candidate < cost[extended * n + next]) {
+                        cost[extended * n + next] = candidate;
+                        parent[extended * n + next] = static_cast<uint8_t>(last);
+                    }
+                }
+            }
+        }
+
+        for (size_t tail = 0; tail < n; ++tail) {
+            if (n > 1 && tail == head) {
+                continue;
+            }
+            if (ends_conflict(members[head], members[tail], policy, multi_domain)) {
+                continue;
+            }
+            double total = cost[full * n + tail] + policy.reader_weight * lookup(policy.reader_rtt_ms, members[tail]);
+            if (total + kCostEpsilonMs < best_cost) {
+                best_cost = total;
+                best_order.assign(n, 0);
+                size_t mask = full;
+                size_t node = tail;
+                for (size_t position = n; position-- > 0;) {
+                    best_order[position] = members[node];
+                    size_t previous = parent[mask * n + node];
+                    mask &= ~(size_t(1) << node);
+                    node = previous;
+                }
+            }
+        }
+    }
+    return best_order;
+}
+
+// Nearest neighbour from each head, then 2-opt until no reversal helps
+std::vector<uint32_t> plan_heuristic(const std::vector<uint32_t>& members, const LatencyMatrix& rtt,
+                                     const ChainPlacementPolicy& policy, bool multi_domain) {
+    std::vector<uint32_t> best_order;
+    double best_cost = kInfiniteCost;
+
+    for (uint32_t head : members) {
+        std::vector<uint32_t> order = {head};
+        std::vector<uint32_t> remaining;
+        for (uint32_t node : members) {
+            if (node != head) {
+                remaining.push_back(node);
+            }
+        }
+        while (!remaining.empty()) {
+            auto nearest = std::min_element(remaining.begin(), remaining.end(),
+                [&](uint32_t a, uint32_t b) { return rtt.get(order.back(), a) < rtt.get(order.back(), b); });
+            order.push_back(*nearest);
+            remaining.erase(nearest);
+        }
+
+        double order_cost = path_cost(order, rtt, policy, multi_domain);
+        bool improved = true;
+        while (improved) {
+            improved = false;
+            for (size_t i = 1; i + 1 < order.size(); ++i) {
+                for (size_t j = i + 1; j < order.size(); ++j) {
+                    std::reverse(order.begin() + i, order.begin() + j + 1);
+                    double candidate = path_cost(order, rtt, policy, multi_domain);
+                    if (candidate + kCostEpsilonMs < order_cost) {
+                        order_cost = candidate;
+                        improved = true;
+                    } else {
+                        std::reverse(order.begin() + i, order.begin() + j + 1);
+                    }
+                }
+            }
+        }
+
+        if (order_cost + kCostEpsilonMs < best_cost) {
+            best_cost = order_cost;
+            best_order = order;
+        }
+    }
+    return best_order;
+}
+
+} // namespace
+
+void LatencyMatrix::set(uint32_t from, uint32_t to, double rtt_ms) {
+    auto result = rtt_ms_.emplace(std::make_pair(from, to), rtt_ms);
+    if (!result.second) {
+        total_ms_ -= result.first->second;
+        result.first->second = rtt_ms;
+    }
+    total_ms_ += rtt_ms;
+}
+
+bool LatencyMatrix::has(uint32_t from, uint32_t to) const {
+    return rtt_ms_.count(std::make_pair(from, to)) > 0;
+}
+
+double LatencyMatrix::get(uint32_t from, uint32_t to) const {
+    if (from == to) {
+        return 0.0;
+    }
+    auto it = rtt_ms_.find(std::make_pair(from, to));
+    if (it != rtt_ms_.end()) {
+        return it->second;
+    }
+    it = rtt_ms_.find(std::make_pair(to, from));
+    if (it != rtt_ms_.end()) {
+        return it->second;
+    }
+    return rtt_ms_.empty() ? 0.0 : total_ms_ / rtt_ms_.size();
+}
+
+void LatencyMatrix::clear() {
+    rtt_ms_.clear();
+    total_ms_ = 0.0;
+}
+
+double ChainPlanner::cost(const std::vector<uint32_t>& order, const LatencyMatrix& rtt,
+                          const ChainPlacementPolicy& policy) {
+    return path_cost(order, rtt, policy, spans_domains(order, policy));
+}
+
+ChainPlan ChainPlanner::plan(const std::vector<uint32_t>& current, const LatencyMatrix& rtt,
+                             const ChainPlacementPolicy& policy, bool require_improvement) {
+    ChainPlan plan;
+    bool multi_domain = spans_domains(current, policy);
+    plan.order = current;
+    plan.current_cost_ms = path_cost(current, rtt, policy, multi_domain);
+    plan.cost_ms = plan.current_cost_ms;
+    if (current.size() < 2) {
+        return plan;
+    }
+
+    std::vector<uint32_t> candidate = current.size() <= kMaxExactNodes ?
+                                      plan_exact(current, rtt, policy, multi_domain) :
+                                      plan_heuristic(current, rtt, policy, multi_domain);
+    if (candidate.empty()) {
+        return plan;
+    }
+    double candidate_cost = path_cost(candidate, rtt, policy, multi_domain);
+
+    // An order that breaks the domain constraint is always worth leaving
+    double savings = plan.current_cost_ms - candidate_cost;
+    double required = kCostEpsilonMs;
+    if (require_improvement && plan.current_cost_ms != kInfiniteCost) {
+        required = std::max({required, policy.min_improvement_ms,
+                             plan.current_cost_ms * policy.min_improvement_ratio});
+    }
+    if (candidate != current && savings >= required) {
+        plan.order = std::move(candidate);
+        plan.cost_ms = candidate_cost;
+        plan.changed = true;
+    }
+    return plan;
+}
+
+} // namespace replication
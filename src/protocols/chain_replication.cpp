@@ -1,40 +1,99 @@
 #include "protocols/chain_replication.h"
+#include "utils/clock.h"
 #include "utils/logger.h"
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 
 namespace replication {
 
+namespace {
+
+// Marks a BATCH_REQUEST carrying chain writes; its value is a
+// concatenation of CHAIN_FORWARD frames in version order
+const char* const kChainBatchTag = "chain_batch";
+
+// Marks a CHAIN_UPDATE carrying a member's RTT row instead of a new order
+const char* const kLatencyReportTag = "rtt_row";
+
+} // namespace
+
 ChainReplication::ChainReplication(std::shared_ptr<Node> node, const std::vector<uint32_t>& chain_order)
     : node_(node)
     , chain_order_(chain_order)
     , my_position_(0)
+    , partition_id_(0)
     , batching_enabled_(true)
     , batch_size_(10)
-    , pipelining_enabled_(true) {
+    , pipelining_enabled_(true)
+    , batch_max_delay_us_(1000) // 1ms
+    , stopping_(false)
+    , batches_flushed_(0)
+    , next_version_(1)
+    , max_inflight_writes_(128)
+    , write_timeout_ms_(5000)
+    , acked_version_(0)
+    , commit_watermark_(0)
+    , next_query_id_(1)
+    , version_query_timeout_ms_(1000)
+    , peer_telemetry_(std::make_shared<PeerTelemetry>())
+    , clean_reads_(0)
+    , dirty_reads_(0)
+    , chain_epoch_(0)
+    , reordering_enabled_(false)
+    , membership_changed_(false)
+    , switching_(false)
+    , reorder_interval_ms_(30000)
+    , reorders_applied_(0) {
     
     find_my_position();
+    batch_flush_thread_ = std::thread(&ChainReplication::batch_flush_loop, this);
     
     LOG_INFO("ChainReplication initialized for node " + std::to_string(node_->get_node_id()) + 
              " at position " + std::to_string(my_position_) + " in chain of " + 
              std::to_string(chain_order_.size()) + " nodes");
 }
 
+ChainReplication::~ChainReplication() {
+    {
+        std::unique_lock<std::mutex> lock(chain_mutex_);
+        stopping_ = true;
+        // Best effort: whatever is still batched goes down the chain now
+        process_write_batch(lock);
+    }
+    batch_cv_.notify_all();
+    window_cv_.notify_all();
+    planner_cv_.notify_all();
+    if (batch_flush_thread_.joinable()) {
+        batch_flush_thread_.join();
+    }
+    if (planner_thread_.joinable()) {
+        planner_thread_.join();
+    }
+}
+
 bool ChainReplication::process_read(const Message& request, Message& response) {
-    std::lock_guard<std::mutex> lock(chain_mutex_);
+    bool in_chain = false;
+    bool tail = false;
+    uint32_t tail_node = 0;
+    {
+        std::lock_guard<std::mutex> lock(chain_mutex_);
+        in_chain = my_position_ < chain_order_.size();
+        tail = is_tail();
+        tail_node = chain_order_.empty() ? 0 : chain_order_.back();
+    }
     
-    // In chain replication, reads are served by the tail
-    if (!is_tail()) {
-        // Forward to tail
-        if (chain_order_.size() > 0) {
-            uint32_t tail_node = chain_order_.back();
+    // Nodes outside the chain hand the read to the tail
+    if (!in_chain) {
+        if (tail_node != 0) {
             node_->send_message(tail_node, request);
             LOG_DEBUG("Forwarding read request to tail node " + std::to_string(tail_node));
         }
         return false;
     }
     
-    // We are the tail, serve the read directly
+    // CRAQ: every replica serves clean keys locally
     response.type = MessageType::READ_RESPONSE;
     response.sender_id = node_->get_node_id();
     response.timestamp = request.get_current_timestamp();
@@ -47,7 +106,26 @@ bool ChainReplication::process_read(const Message& request, Message& response) {
     }
     
     std::string value;
-    if (node_->read(request.key, value)) {
+    bool found = false;
+    if (tail) {
+        // The tail only ever holds committed versions
+        found = node_->read(request.key, value);
+        clean_reads_.fetch_add(1, std::memory_order_relaxed);
+    } else if (read_clean(request.key, value, found)) {
+        clean_reads_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Dirty key: the tail decides which version is committed
+        uint64_t committed_version = 0;
+        if (!query_tail_version(tail_node, request.key, committed_version) ||
+            !read_committed(request.key, committed_version, value, found)) {
+            node_->send_message(tail_node, request);
+            LOG_DEBUG("Version query failed, forwarding read to tail node " + std::to_string(tail_node));
+            return false;
+        }
+        dirty_reads_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    if (found) {
         response.value = value;
         response.success = true;
         LOG_DEBUG("Chain read successful for key: " + request.key);
@@ -59,8 +137,39 @@ bool ChainReplication::process_read(const Message& request, Message& response) {
     return response.success;
 }
 
+bool ChainReplication::serve_local_read(const Message& request, Message& response) {
+    bool tail = false;
+    {
+        std::lock_guard<std::mutex> lock(chain_mutex_);
+        if (my_position_ >= chain_order_.size()) {
+            return false;
+        }
+        tail = is_tail();
+    }
+    
+    std::string value;
+    bool found = false;
+    if (tail) {
+        found = node_->read(request.key, value);
+    } else if (!read_clean(request.key, value, found)) {
+        return false;
+    }
+    clean_reads_.fetch_add(1, std::memory_order_relaxed);
+    
+    response.type = MessageType::READ_RESPONSE;
+    response.sender_id = node_->get_node_id();
+    response.timestamp = monotonic_now_us();
+    response.key = request.key;
+    response.sequence_number = request.sequence_number;
+    response.success = found;
+    if (found) {
+        response.value = value;
+    }
+    return true;
+}
+
 bool ChainReplication::process_write(const Message& request, Message& response) {
-    std::lock_guard<std::mutex> lock(chain_mutex_);
+    std::unique_lock<std::mutex> lock(chain_mutex_);
     
     // In chain replication, writes start at the head
     if (!is_head()) {
@@ -88,30 +197,40 @@ bool ChainReplication::process_write(const Message& request, Message& response)
     response.key = request.key;
     response.sequence_number = request.sequence_number;
     
-    // Optimization: Use batching if enabled
-    if (batching_enabled_ && write_batch_.size() < batch_size_) {
-        write_batch_.push_back(request);
+    // Admit the write, batched or straight into the pipeline, then answer
+    // only once the tail has committed it; the wait ends after the write timeout
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(write_timeout_ms_);
+    auto completion = std::make_shared<std::promise<bool>>();
+    std::future<bool> committed = completion->get_future();
+    auto version = std::make_shared<uint64_t>(0);
+    
+    if (batching_enabled_ && chain_order_.size() > 1) {
+        PendingChainWrite batched;
+        batched.message = request;
+        batched.completion = completion;
+        batched.version = version;
+        batched.start_time = monotonic_now_us();
+        write_batch_.push_back(std::move(batched));
         
-        // Process batch when full or timeout
+        // Flush when full; the background flusher enforces the max delay
         if (write_batch_.size() >= batch_size_) {
-            process_write_batch();
+            process_write_batch(lock);
+        } else if (write_batch_.size() == 1) {
+            batch_cv_.notify_one();
         }
-        
-        response.success = true;
-        return true;
-    }
-    
-    // Process single write
-    bool success = node_->write(request.key, request.value);
-    
-    if (success && chain_order_.size() > 1) {
-        // Forward to next node in chain
-        if (!forward_write(request)) {
-            success = false;
+    } else {
+        *version = start_write(lock, request, completion);
+        if (*version == 0) {
+            completion->set_value(false);
         }
     }
+    lock.unlock();
+    
+    // The version is written under the lock before the completion is set
+    bool success = committed.wait_until(deadline) == std::future_status::ready && committed.get();
     
     response.success = success;
+    response.log_index = success ? *version : 0;
     
     if (success) {
         LOG_DEBUG("Chain write successful for key: " + request.key);
@@ -122,14 +241,185 @@ bool ChainReplication::process_write(const Message& request, Message& response)
     return success;
 }
 
+std::future<bool> ChainReplication::submit_write(const Message& request) {
+    auto completion = std::make_shared<std::promise<bool>>();
+    std::future<bool> committed = completion->get_future();
+    
+    std::unique_lock<std::mutex> lock(chain_mutex_);
+    if (!is_head()) {
+        completion->set_value(false);
+        return committed;
+    }
+    
+    if (batching_enabled_ && chain_order_.size() > 1) {
+        PendingChainWrite batched;
+        batched.message = request;
+        batched.completion = completion;
+        batched.start_time = monotonic_now_us();
+        write_batch_.push_back(std::move(batched));
+        
+        if (write_batch_.size() >= batch_size_) {
+            process_write_batch(lock);
+        } else if (write_batch_.size() == 1) {
+            batch_cv_.notify_one();
+        }
+        return committed;
+    }
+    
+    if (start_write(lock, request, completion) == 0) {
+        completion->set_value(false);
+    }
+    return committed;
+}
+
+bool ChainReplication::process_batch_write(const std::vector<Message>& requests,
+                                           std::vector<Message>& responses) {
+    responses.assign(requests.size(), Message());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        responses[i].type = MessageType::WRITE_RESPONSE;
+        responses[i].sender_id = node_->get_node_id();
+        responses[i].timestamp = monotonic_now_us();
+        responses[i].key = requests[i].key;
+        responses[i].sequence_number = requests[i].sequence_number;
+        responses[i].success = true;
+    }
+    if (requests.empty()) {
+        return true;
+    }
+    
+    std::unique_lock<std::mutex> lock(chain_mutex_);
+    
+    if (!is_head()) {
+        if (chain_order_.size() > 0) {
+            uint32_t head_node = chain_order_.front();
+            for (const Message& request : requests) {
+                node_->send_message(head_node, request);
+            }
+            LOG_DEBUG("Forwarding " + std::to_string(requests.size()) + " writes to head node " +
+                      std::to_string(head_node));
+        }
+        return true;
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(write_timeout_ms_);
+    std::vector<std::future<bool>> outcomes;
+    std::vector<std::shared_ptr<uint64_t>> versions;
+    outcomes.reserve(requests.size());
+    versions.reserve(requests.size());
+    for (const Message& request : requests) {
+        PendingChainWrite batched;
+        batched.message = request;
+        batched.completion = std::make_shared<std::promise<bool>>();
+        batched.version = std::make_shared<uint64_t>(0);
+        batched.start_time = monotonic_now_us();
+        outcomes.push_back(batched.completion->get_future());
+        versions.push_back(batched.version);
+        write_batch_.push_back(std::move(batched));
+    }
+    process_write_batch(lock);
+    lock.unlock();
+    
+    // Like process_write(), each write is answered once the tail commits it
+    bool all_committed = true;
+    for (size_t i = 0; i < outcomes.size(); ++i) {
+        bool committed = outcomes[i].wait_until(deadline) == std::future_status::ready && outcomes[i].get();
+        responses[i].success = committed;
+        responses[i].log_index = committed ? *versions[i] : 0;
+        all_committed = all_committed && committed;
+    }
+    if (!all_committed) {
+        LOG_ERROR("Chain batch write failed for some of " + std::to_string(requests.size()) + " keys");
+    }
+    return all_committed;
+}
+
+uint64_t ChainReplication::start_write(std::unique_lock<std::mutex>& lock, const Message& request,
+                                       std::shared_ptr<std::promise<bool>> completion) {
+    // Bound the writes in flight; acks from the tail reopen the window
+    if (chain_order_.size() > 1 &&
+        !window_cv_.wait_for(lock, std::chrono::milliseconds(write_timeout_ms_), [this]() {
+            return !switching_ && pending_writes_.size() < pipeline_window();
+        })) {
+        LOG_WARNING("Chain pipeline window full, rejecting write for key: " + request.key);
+        return 0;
+    }
+    if (!is_head()) {
+        return 0; // chain changed while waiting
+    }
+    
+    Message versioned = request;
+    versioned.log_index = next_version_++;
+    
+    if (chain_order_.size() == 1) {
+        apply_version(versioned.key, versioned.value, versioned.log_index, true);
+        acked_version_ = versioned.log_index;
+        if (commit_listener_) {
+            commit_listener_(versioned.key, versioned.log_index);
+        }
+        if (completion) {
+            completion->set_value(true);
+        }
+        return versioned.log_index;
+    }
+    
+    uint64_t version = versioned.log_index;
+    apply_version(versioned.key, versioned.value, version, false);
+    forward_write(std::move(versioned));
+    pending_writes_[version].completion = std::move(completion);
+    return version;
+}
+
+void ChainReplication::set_commit_listener(CommitListener listener) {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    commit_listener_ = std::move(listener);
+}
+
+void ChainReplication::enable_pipelining(bool enable) {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    pipelining_enabled_ = enable;
+    window_cv_.notify_all();
+}
+
+void ChainReplication::set_pipeline_window(size_t max_inflight_writes) {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    max_inflight_writes_ = std::max<size_t>(1, max_inflight_writes);
+    window_cv_.notify_all();
+}
+
+void ChainReplication::set_batch_max_delay_us(uint64_t delay_us) {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    batch_max_delay_us_ = std::max<uint64_t>(1, delay_us);
+    batch_cv_.notify_all();
+}
+
+size_t ChainReplication::get_inflight_writes() const {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    return pending_writes_.size();
+}
+
+bool ChainReplication::drain_writes(uint64_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(chain_mutex_);
+    
+    // A partial batch would otherwise sit until its deadline
+    if (!write_batch_.empty()) {
+        process_write_batch(lock);
+    }
+    return window_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        return stopping_ || (pending_writes_.empty() && write_batch_.empty());
+    });
+}
+
+uint64_t ChainReplication::get_acked_version() const {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    return acked_version_;
+}
+
 void ChainReplication::update_chain_order(const std::vector<uint32_t>& new_chain) {
     std::lock_guard<std::mutex> lock(chain_mutex_);
     
     chain_order_ = new_chain;
     find_my_position();
-    
-    // Optimize chain ordering based on network topology
-    optimize_chain_ordering();
+    schedule_replan();
     
     LOG_INFO("Chain order updated, new position: " + std::to_string(my_position_));
 }
@@ -157,27 +447,70 @@ uint32_t ChainReplication::get_predecessor() const {
 }
 
 void ChainReplication::handle_node_failure(uint32_t failed_node) {
-    std::lock_guard<std::mutex> lock(chain_mutex_);
-    
-    auto it = std::find(chain_order_.begin(), chain_order_.end(), failed_node);
-    if (it != chain_order_.end()) {
+    std::vector<std::shared_ptr<std::promise<bool>>> completed;
+    {
+        std::lock_guard<std::mutex> lock(chain_mutex_);
+        
+        auto it = std::find(chain_order_.begin(), chain_order_.end(), failed_node);
+        if (it == chain_order_.end()) {
+            return;
+        }
+        
+        uint32_t old_successor = get_successor();
         chain_order_.erase(it);
         find_my_position();
         
         LOG_WARNING("Node " + std::to_string(failed_node) + " failed, removed from chain");
         
+        // Repair the pipeline: in-flight writes either commit here, if we are
+        // the new tail, or go again to the new successor
+        if (failed_node == old_successor && !pending_writes_.empty()) {
+            uint32_t successor = get_successor();
+            if (successor == 0) {
+                for (auto& entry : pending_writes_) {
+                    const Message& pending = entry.second.message;
+                    apply_version(pending.key, pending.value, pending.log_index, true);
+                }
+                commit_watermark_ = pending_writes_.rbegin()->first;
+                Message last = pending_writes_.rbegin()->second.message;
+                acknowledge_through(commit_watermark_, completed);
+                send_ack(last);
+            } else {
+                for (const auto& entry : pending_writes_) {
+                    Message forward_msg = entry.second.message;
+                    forward_msg.type = MessageType::CHAIN_FORWARD;
+                    forward_msg.sender_id = node_->get_node_id();
+                    forward_msg.ballot = chain_epoch_;
+                    forward_msg.partition_id = partition_id_;
+                    node_->send_message(successor, forward_msg);
+                }
+                LOG_INFO("Resent " + std::to_string(pending_writes_.size()) +
+                         " in-flight writes to new successor " + std::to_string(successor));
+            }
+        }
+        
         // Validate chain integrity after failure
         validate_chain_integrity();
+        schedule_replan();
+    }
+    
+    for (auto& completion : completed) {
+        completion->set_value(true);
     }
 }
 
 void ChainReplication::handle_node_recovery(uint32_t recovered_node) {
     std::lock_guard<std::mutex> lock(chain_mutex_);
     
-    // Add recovered node back to chain in optimal position
-    // For now, add at the end
+    // Rejoins as the tail, moving it there if it is already listed. Callers
+    // promote a node only once it has caught up, since the tail serves
+    // committed reads. Every member appends it the same way; the head's
+    // planner then moves it to where its latencies fit best.
+    chain_order_.erase(std::remove(chain_order_.begin(), chain_order_.end(), recovered_node),
+                       chain_order_.end());
     chain_order_.push_back(recovered_node);
     find_my_position();
+    schedule_replan();
     
     LOG_INFO("Node " + std::to_string(recovered_node) + " recovered, added back to chain");
 }
@@ -185,8 +518,8 @@ void ChainReplication::handle_node_recovery(uint32_t recovered_node) {
 double ChainReplication::get_chain_utilization() const {
     std::lock_guard<std::mutex> lock(chain_mutex_);
     
-    // Calculate utilization based on pending operations
-    double utilization = static_cast<double>(pending_writes_.size()) / 100.0; // Max 100 pending
+    // Calculate utilization as the filled share of the pipeline window
+    double utilization = static_cast<double>(pending_writes_.size()) / pipeline_window();
     return std::min(utilization, 1.0);
 }
 
@@ -205,72 +538,497 @@ void ChainReplication::find_my_position() {
     LOG_WARNING("Node not found in chain order");
 }
 
-bool ChainReplication::forward_write(const Message& message) {
+bool ChainReplication::forward_write(Message message) {
     uint32_t successor = get_successor();
     if (successor == 0) {
         // We are the tail, send ACK back
         return send_ack(message);
     }
     
-    // Create forward message
-    Message forward_msg = message;
-    forward_msg.type = MessageType::CHAIN_FORWARD;
-    forward_msg.sender_id = node_->get_node_id();
+    message.type = MessageType::CHAIN_FORWARD;
+    message.sender_id = node_->get_node_id();
+    message.ballot = chain_epoch_;
+    message.partition_id = partition_id_;
+    node_->send_message(successor, message);
     
-    node_->send_message(successor, forward_msg);
-    
-    // Track pending write for reliability
-    pending_writes_[message.sequence_number] = message;
+    // Track pending write until the tail acknowledges its version
+    PendingChainWrite& pending = pending_writes_[message.log_index];
+    pending.message = std::move(message);
+    pending.start_time = monotonic_now_us();
     
     LOG_DEBUG("Forwarded write to successor node " + std::to_string(successor));
     return true;
 }
 
 bool ChainReplication::send_ack(const Message& original_request) {
+    // Acks are cumulative: every version up to the watermark is committed
     Message ack_msg;
     ack_msg.type = MessageType::CHAIN_ACK;
     ack_msg.sender_id = node_->get_node_id();
     ack_msg.timestamp = original_request.get_current_timestamp();
     ack_msg.sequence_number = original_request.sequence_number;
+    ack_msg.key = original_request.key;
+    ack_msg.log_index = commit_watermark_;
+    ack_msg.ballot = chain_epoch_;
     ack_msg.success = true;
     
-    // Send ACK to the original sender or previous node
     uint32_t predecessor = get_predecessor();
-    if (predecessor != 0) {
-        node_->send_message(predecessor, ack_msg);
-    } else {
-        // We are the head, send ACK to original client
-        node_->send_message(original_request.sender_id, ack_msg);
+    if (predecessor == 0) {
+        return false;
     }
+    ack_msg.partition_id = partition_id_;
+    node_->send_message(predecessor, ack_msg);
     
-    LOG_DEBUG("Sent ACK for write operation");
+    LOG_DEBUG("Sent ACK through version " + std::to_string(commit_watermark_));
     return true;
 }
 
-void ChainReplication::process_write_batch() {
+bool ChainReplication::commit_at_tail(const Message& message, Message& last) {
+    // Caller holds chain_mutex_. Links may reorder across streams, so the
+    // watermark only advances over contiguous versions
+    if (message.log_index <= commit_watermark_) {
+        return false;
+    }
+    early_commits_[message.log_index] = message;
+    
+    bool advanced = false;
+    while (!early_commits_.empty() && early_commits_.begin()->first == commit_watermark_ + 1) {
+        Message& next = early_commits_.begin()->second;
+        apply_version(next.key, next.value, next.log_index, true);
+        commit_watermark_ = next.log_index;
+        last = std::move(next);
+        early_commits_.erase(early_commits_.begin());
+        advanced = true;
+    }
+    
+    if (advanced) {
+        acked_version_ = commit_watermark_;
+    }
+    return advanced;
+}
+
+void ChainReplication::acknowledge_through(uint64_t version,
+                                           std::vector<std::shared_ptr<std::promise<bool>>>& completed) {
+    // Caller holds chain_mutex_; clears the acked prefix in one sweep
+    acked_version_ = std::max(acked_version_, version);
+    auto end = pending_writes_.upper_bound(version);
+    for (auto it = pending_writes_.begin(); it != end; ++it) {
+        mark_clean(it->second.message.key, it->first);
+        if (it->second.completion) {
+            // Only the head holds completions
+            if (commit_listener_) {
+                commit_listener_(it->second.message.key, it->first);
+            }
+            completed.push_back(std::move(it->second.completion));
+        }
+    }
+    pending_writes_.erase(pending_writes_.begin(), end);
+    window_cv_.notify_all();
+}
+
+void ChainReplication::process_write_batch(std::unique_lock<std::mutex>& lock) {
+    // Caller holds chain_mutex_ through lock
+    if (write_batch_.empty()) {
+        return;
+    }
+    
+    // The whole batch enters the pipeline once the window has room
+    if (!stopping_ && chain_order_.size() > 1 &&
+        !window_cv_.wait_for(lock, std::chrono::milliseconds(write_timeout_ms_), [this]() {
+            return stopping_ || (!switching_ && pending_writes_.size() < pipeline_window());
+        })) {
+        LOG_WARNING("Chain pipeline window full, failing batch of " + std::to_string(write_batch_.size()));
+        for (auto& batched : write_batch_) {
+            if (batched.completion) {
+                batched.completion->set_value(false);
+            }
+        }
+        write_batch_.clear();
+        return;
+    }
+    
     if (write_batch_.empty()) {
+        return; // another flusher took it while we waited
+    }
+    if (!is_head()) {
+        // A reorder moved the head while we waited; fail the writes so
+        // callers retry at the new head
+        for (auto& batched : write_batch_) {
+            if (batched.completion) {
+                batched.completion->set_value(false);
+            }
+        }
+        write_batch_.clear();
+        return;
+    }
+    
+    std::vector<PendingChainWrite> batch;
+    batch.swap(write_batch_);
+    
+    LOG_DEBUG("Processing write batch of size " + std::to_string(batch.size()));
+    
+    // Apply all writes in batch locally under consecutive versions
+    uint32_t successor = get_successor();
+    bool committed = successor == 0;
+    std::string frames;
+    for (auto& batched : batch) {
+        Message& write_msg = batched.message;
+        write_msg.log_index = next_version_++;
+        write_msg.type = MessageType::CHAIN_FORWARD;
+        write_msg.sender_id = node_->get_node_id();
+        write_msg.ballot = chain_epoch_;
+        if (batched.version) {
+            *batched.version = write_msg.log_index;
+        }
+        apply_version(write_msg.key, write_msg.value, write_msg.log_index, committed);
+        
+        if (committed) {
+            acked_version_ = write_msg.log_index;
+            if (commit_listener_) {
+                commit_listener_(write_msg.key, write_msg.log_index);
+            }
+            if (batched.completion) {
+                batched.completion->set_value(true);
+            }
+            continue;
+        }
+        write_msg.serialize_to(frames);
+        pending_writes_[write_msg.log_index] = std::move(batched);
+    }
+    
+    // Forward entire batch to successor as one frame
+    if (!committed) {
+        Message batch_msg;
+        batch_msg.type = MessageType::BATCH_REQUEST;
+        batch_msg.sender_id = node_->get_node_id();
+        batch_msg.timestamp = monotonic_now_us();
+        batch_msg.sequence_number = static_cast<uint32_t>(batch.size());
+        batch_msg.log_index = next_version_ - 1;
+        batch_msg.metadata = kChainBatchTag;
+        batch_msg.ballot = chain_epoch_;
+        batch_msg.value = std::move(frames);
+        batch_msg.partition_id = partition_id_;
+        node_->send_message(successor, batch_msg);
+    }
+    batches_flushed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ChainReplication::batch_flush_loop() {
+    std::unique_lock<std::mutex> lock(chain_mutex_);
+    while (!stopping_) {
+        batch_cv_.wait(lock, [this]() { return stopping_ || !write_batch_.empty(); });
+        if (stopping_) {
+            break;
+        }
+        
+        // Partial batches leave once their oldest write reaches the max delay
+        auto deadline = std::chrono::steady_clock::time_point(
+            std::chrono::microseconds(write_batch_.front().start_time + batch_max_delay_us_));
+        batch_cv_.wait_until(lock, deadline, [this]() { return stopping_ || write_batch_.empty(); });
+        if (stopping_) {
+            break;
+        }
+        if (!write_batch_.empty() &&
+            monotonic_now_us() >= write_batch_.front().start_time + batch_max_delay_us_) {
+            process_write_batch(lock);
+        }
+    }
+}
+
+std::vector<uint32_t> ChainReplication::get_chain_order() const {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    return chain_order_;
+}
+
+void ChainReplication::handle_chain_forward(const Message& message) {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    if (defer_if_newer_epoch(message)) {
+        return;
+    }
+    
+    // Keep versions monotonic if this node later becomes head
+    next_version_ = std::max(next_version_, message.log_index + 1);
+    
+    if (is_tail()) {
+        // The tail commits and starts the ack wave upstream
+        Message last;
+        send_ack(commit_at_tail(message, last) ? last : message);
         return;
     }
+    if (message.log_index <= acked_version_) {
+        return; // a resend of a write the tail already committed
+    }
+    
+    apply_version(message.key, message.value, message.log_index, false);
+    forward_write(message);
+}
+
+void ChainReplication::handle_chain_ack(const Message& message) {
+    std::vector<std::shared_ptr<std::promise<bool>>> completed;
+    {
+        std::lock_guard<std::mutex> lock(chain_mutex_);
+        if (defer_if_newer_epoch(message)) {
+            return;
+        }
+        if (message.log_index <= acked_version_) {
+            return; // covered by an earlier cumulative ack
+        }
+        
+        acknowledge_through(message.log_index, completed);
+        
+        uint32_t predecessor = get_predecessor();
+        if (predecessor != 0) {
+            Message ack_msg = message;
+            ack_msg.sender_id = node_->get_node_id();
+            ack_msg.ballot = chain_epoch_;
+            ack_msg.partition_id = partition_id_;
+            node_->send_message(predecessor, ack_msg);
+        }
+    }
     
-    LOG_DEBUG("Processing write batch of size " + std::to_string(write_batch_.size()));
+    // Complete client futures outside the lock
+    for (auto& completion : completed) {
+        completion->set_value(true);
+    }
+}
+
+void ChainReplication::handle_chain_batch(const Message& message) {
+    if (message.metadata != kChainBatchTag) {
+        return;
+    }
     
-    // Apply all writes in batch locally
-    for (const auto& write_msg : write_batch_) {
-        node_->write(write_msg.key, write_msg.value);
+    // Unpack the batch before taking the chain lock
+    std::vector<Message> writes;
+    const char* frame = message.value.data();
+    size_t remaining = message.value.size();
+    while (remaining > 0) {
+        size_t frame_length = wire::frame_size(frame, remaining);
+        if (frame_length == 0 || frame_length > remaining) {
+            LOG_WARNING("Truncated chain batch from node " + std::to_string(message.sender_id));
+            return;
+        }
+        writes.push_back(Message::deserialize(frame, frame_length));
+        frame += frame_length;
+        remaining -= frame_length;
+    }
+    if (writes.empty()) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    if (defer_if_newer_epoch(message)) {
+        return;
+    }
+    next_version_ = std::max(next_version_, writes.back().log_index + 1);
+    
+    if (is_tail()) {
+        // Commit the whole batch, then send a single cumulative ack
+        Message last;
+        bool advanced = false;
+        for (const auto& write_msg : writes) {
+            advanced = commit_at_tail(write_msg, last) || advanced;
+        }
+        if (advanced) {
+            send_ack(last);
+        } else {
+            send_ack(writes.back());
+        }
+        return;
+    }
+    
+    uint64_t now = monotonic_now_us();
+    for (auto& write_msg : writes) {
+        if (write_msg.log_index <= acked_version_) {
+            continue; // already committed at the tail
+        }
+        apply_version(write_msg.key, write_msg.value, write_msg.log_index, false);
+        PendingChainWrite& pending = pending_writes_[write_msg.log_index];
+        pending.start_time = now;
+        pending.message = std::move(write_msg);
     }
     
-    // Forward entire batch to successor if not tail
     uint32_t successor = get_successor();
     if (successor != 0) {
-        for (const auto& write_msg : write_batch_) {
-            Message forward_msg = write_msg;
-            forward_msg.type = MessageType::CHAIN_FORWARD;
-            forward_msg.sender_id = node_->get_node_id();
-            node_->send_message(successor, forward_msg);
+        Message batch_msg = message;
+        batch_msg.sender_id = node_->get_node_id();
+        batch_msg.ballot = chain_epoch_;
+        batch_msg.partition_id = partition_id_;
+        node_->send_message(successor, batch_msg);
+    }
+}
+
+void ChainReplication::handle_version_query(const Message& message) {
+    // Only the tail's clean version is authoritative
+    Message version_msg;
+    version_msg.type = MessageType::CHAIN_VERSION_RESPONSE;
+    version_msg.sender_id = node_->get_node_id();
+    version_msg.timestamp = monotonic_now_us();
+    version_msg.sequence_number = message.sequence_number;
+    version_msg.key = message.key;
+    
+    {
+        std::lock_guard<std::mutex> lock(versions_mutex_);
+        auto it = key_versions_.find(message.key);
+        version_msg.log_index = it != key_versions_.end() ? it->second.clean_version : 0;
+    }
+    version_msg.success = is_tail();
+    
+    version_msg.partition_id = partition_id_;
+    node_->send_message(message.sender_id, version_msg);
+}
+
+void ChainReplication::handle_version_response(const Message& message) {
+    peer_telemetry_->on_reply_received(message.sender_id,
+        PeerTelemetry::token(static_cast<uint32_t>(MessageType::CHAIN_VERSION_QUERY), message.sequence_number));
+    
+    std::shared_ptr<std::promise<uint64_t>> waiter;
+    {
+        std::lock_guard<std::mutex> lock(queries_mutex_);
+        auto it = version_queries_.find(message.sequence_number);
+        if (it == version_queries_.end()) {
+            return;
         }
+        waiter = it->second;
+        version_queries_.erase(it);
     }
     
-    write_batch_.clear();
+    if (message.success) {
+        waiter->set_value(message.log_index);
+    } else {
+        // Responder is no longer the tail; let the read fall back
+        waiter->set_value(UINT64_MAX);
+    }
+}
+
+bool ChainReplication::is_key_dirty(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(versions_mutex_);
+    auto it = key_versions_.find(key);
+    return it != key_versions_.end() && it->second.is_dirty();
+}
+
+void ChainReplication::apply_version(const std::string& key, const Payload& value,
+                                     uint64_t version, bool committed) {
+    std::lock_guard<std::mutex> lock(versions_mutex_);
+    CraqKeyState& state = key_versions_[key];
+    
+    if (committed) {
+        if (version < state.clean_version) {
+            return; // stale redelivery
+        }
+        state.clean_version = version;
+        state.dirty_versions.erase(state.dirty_versions.begin(),
+                                   state.dirty_versions.upper_bound(version));
+        if (!state.is_dirty()) {
+            node_->write_ref(key, value.ref());
+            state.clean_value.clear();
+        } else {
+            state.clean_value = value;
+            state.clean_exists = true;
+        }
+        return;
+    }
+    
+    // Remember the committed value before the first dirty version hides it
+    bool newest = !state.is_dirty() || version > state.dirty_versions.rbegin()->first;
+    if (!state.is_dirty()) {
+        state.clean_exists = node_->read(key, state.clean_value);
+    }
+    state.dirty_versions[version] = value;
+    if (newest) {
+        node_->write_ref(key, value.ref());
+    }
+}
+
+void ChainReplication::mark_clean(const std::string& key, uint64_t version) {
+    std::lock_guard<std::mutex> lock(versions_mutex_);
+    auto it = key_versions_.find(key);
+    if (it == key_versions_.end() || version <= it->second.clean_version) {
+        return;
+    }
+    
+    CraqKeyState& state = it->second;
+    auto version_it = state.dirty_versions.find(version);
+    if (version_it != state.dirty_versions.end()) {
+        state.clean_value = std::move(version_it->second);
+        state.clean_exists = true;
+    }
+    state.clean_version = version;
+    state.dirty_versions.erase(state.dirty_versions.begin(),
+                               state.dirty_versions.upper_bound(version));
+    if (!state.is_dirty()) {
+        state.clean_value.clear();
+    }
+}
+
+bool ChainReplication::read_clean(const std::string& key, std::string& value, bool& found) {
+    std::lock_guard<std::mutex> lock(versions_mutex_);
+    auto it = key_versions_.find(key);
+    if (it != key_versions_.end() && it->second.is_dirty()) {
+        return false;
+    }
+    found = node_->read(key, value);
+    return true;
+}
+
+bool ChainReplication::read_committed(const std::string& key, uint64_t version,
+                                      std::string& value, bool& found) {
+    std::lock_guard<std::mutex> lock(versions_mutex_);
+    auto it = key_versions_.find(key);
+    if (it == key_versions_.end() || !it->second.is_dirty()) {
+        // Acked while we were asking; storage is clean again
+        found = node_->read(key, value);
+        return true;
+    }
+    
+    const CraqKeyState& state = it->second;
+    if (version <= state.clean_version) {
+        found = state.clean_exists;
+        value = state.clean_value;
+        return true;
+    }
+    auto version_it = state.dirty_versions.find(version);
+    if (version_it != state.dirty_versions.end()) {
+        found = true;
+        value = version_it->second;
+        return true;
+    }
+    return false;
+}
+
+bool ChainReplication::query_tail_version(uint32_t tail_node, const std::string& key, uint64_t& version) {
+    if (tail_node == 0) {
+        return false;
+    }
+    
+    uint32_t query_id = next_query_id_.fetch_add(1);
+    auto waiter = std::make_shared<std::promise<uint64_t>>();
+    std::future<uint64_t> answer = waiter->get_future();
+    {
+        std::lock_guard<std::mutex> lock(queries_mutex_);
+        version_queries_[query_id] = waiter;
+    }
+    
+    Message query_msg;
+    query_msg.type = MessageType::CHAIN_VERSION_QUERY;
+    query_msg.sender_id = node_->get_node_id();
+    query_msg.timestamp = monotonic_now_us();
+    query_msg.sequence_number = query_id;
+    query_msg.key = key;
+    peer_telemetry_->on_request_sent(tail_node,
+        PeerTelemetry::token(static_cast<uint32_t>(MessageType::CHAIN_VERSION_QUERY), query_id));
+    query_msg.partition_id = partition_id_;
+    node_->send_message(tail_node, query_msg);
+    
+    bool answered = answer.wait_for(std::chrono::milliseconds(version_query_timeout_ms_)) ==
+                    std::future_status::ready;
+    if (!answered) {
+        std::lock_guard<std::mutex> lock(queries_mutex_);
+        version_queries_.erase(query_id);
+        return false;
+    }
+    
+    version = answer.get();
+    return version != UINT64_MAX;
 }
 
 bool ChainReplication::validate_chain_integrity() {
@@ -286,12 +1044,236 @@ bool ChainReplication::validate_chain_integrity() {
     return true;
 }
 
-void ChainReplication::optimize_chain_ordering() {
-    // Optimize chain order based on network latency and node capacity
-    // For now, this is a placeholder - in practice, this would use
-    // network measurements to optimize the chain ordering
+void ChainReplication::enable_reordering(bool enable) {
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> lock(chain_mutex_);
+        if (enable == reordering_enabled_) {
+            return;
+        }
+        reordering_enabled_ = enable;
+        if (enable) {
+            planner_thread_ = std::thread(&ChainReplication::planner_loop, this);
+        } else {
+            stopped = std::move(planner_thread_);
+        }
+    }
+    planner_cv_.notify_all();
+    if (stopped.joinable()) {
+        stopped.join();
+    }
+}
+
+void ChainReplication::set_reorder_interval(uint64_t interval_ms) {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    reorder_interval_ms_ = std::max<uint64_t>(1, interval_ms);
+    planner_cv_.notify_all();
+}
+
+void ChainReplication::set_placement_policy(const ChainPlacementPolicy& policy) {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    placement_policy_ = policy;
+}
+
+bool ChainReplication::reorder_chain(bool require_improvement) {
+    std::unique_lock<std::mutex> lock(chain_mutex_);
+    return replan(lock, !require_improvement);
+}
+
+uint64_t ChainReplication::get_chain_epoch() const {
+    std::lock_guard<std::mutex> lock(chain_mutex_);
+    return chain_epoch_;
+}
+
+void ChainReplication::handle_chain_update(const Message& message) {
+    if (message.metadata == kLatencyReportTag) {
+        std::lock_guard<std::mutex> lock(chain_mutex_);
+        if (!is_head()) {
+            return;
+        }
+        size_t count = std::min(message.target_nodes.size(), message.value.size() / sizeof(uint32_t));
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t rtt_us = 0;
+            std::memcpy(&rtt_us, message.value.data() + i * sizeof(uint32_t), sizeof(rtt_us));
+            latency_matrix_.set(message.sender_id, message.target_nodes[i], rtt_us / 1000.0);
+        }
+        return;
+    }
+    
+    std::vector<Message> ready;
+    {
+        std::lock_guard<std::mutex> lock(chain_mutex_);
+        if (message.ballot <= chain_epoch_ || message.target_nodes.empty()) {
+            return; // an older order, or one we sent ourselves
+        }
+        
+        chain_epoch_ = message.ballot;
+        next_version_ = std::max(next_version_, message.log_index + 1);
+        apply_chain_order(message.target_nodes);
+        
+        auto newer = std::stable_partition(deferred_messages_.begin(), deferred_messages_.end(),
+            [this](const Message& deferred) { return deferred.ballot > chain_epoch_; });
+        ready.assign(std::make_move_iterator(newer), std::make_move_iterator(deferred_messages_.end()));
+        deferred_messages_.erase(newer, deferred_messages_.end());
+        
+        LOG_INFO("Chain epoch " + std::to_string(chain_epoch_) + " from node " +
+                 std::to_string(message.sender_id) + ", new position: " + std::to_string(my_position_));
+    }
     
-    LOG_DEBUG("Chain ordering optimized");
+    // Messages that raced ahead of the new order, in arrival order
+    for (const Message& deferred : ready) {
+        switch (deferred.type) {
+            case MessageType::CHAIN_FORWARD:
+                handle_chain_forward(deferred);
+                break;
+            case MessageType::CHAIN_ACK:
+                handle_chain_ack(deferred);
+                break;
+            case MessageType::BATCH_REQUEST:
+                handle_chain_batch(deferred);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool ChainReplication::replan(std::unique_lock<std::mutex>& lock, bool membership_changed) {
+    if (!is_head() || switching_) {
+        return false;
+    }
+    
+    record_local_latencies();
+    ChainPlan plan = ChainPlanner::plan(chain_order_, latency_matrix_, placement_policy_, !membership_changed);
+    if (!plan.changed) {
+        // A rejoined member may still hold an older epoch; restate the order
+        if (membership_changed && chain_order_.size() > 1) {
+            announce_chain_order(chain_order_);
+        }
+        return false;
+    }
+    
+    // Writes in flight finish under the old order. New writes are still
+    // admitted, into the batch or at the window, and go out after the switch.
+    std::vector<uint32_t> members = chain_order_;
+    process_write_batch(lock);
+    switching_ = true;
+    bool drained = window_cv_.wait_for(lock, std::chrono::milliseconds(std::max<uint64_t>(1, write_timeout_ms_ / 2)),
+        [this]() { return stopping_ || pending_writes_.empty(); });
+    switching_ = false;
+    window_cv_.notify_all();
+    
+    if (stopping_ || !drained || chain_order_ != members) {
+        LOG_WARNING("Chain reorder abandoned, in-flight writes did not drain");
+        return false;
+    }
+    
+    announce_chain_order(plan.order);
+    apply_chain_order(plan.order);
+    reorders_applied_.fetch_add(1, std::memory_order_relaxed);
+    
+    LOG_INFO("Chain reordered for epoch " + std::to_string(chain_epoch_) + ", path cost " +
+             std::to_string(plan.current_cost_ms) + "ms -> " + std::to_string(plan.cost_ms) + "ms");
+    return true;
+}
+
+void ChainReplication::announce_chain_order(const std::vector<uint32_t>& new_order) {
+    Message update;
+    update.type = MessageType::CHAIN_UPDATE;
+    update.sender_id = node_->get_node_id();
+    update.timestamp = monotonic_now_us();
+    update.ballot = ++chain_epoch_;
+    update.log_index = next_version_ - 1;
+    update.target_nodes = new_order;
+    update.partition_id = partition_id_;
+    
+    for (uint32_t member : new_order) {
+        if (member != update.sender_id) {
+            node_->send_message(member, update);
+        }
+    }
+}
+
+void ChainReplication::apply_chain_order(const std::vector<uint32_t>& new_order) {
+    bool was_tail = is_tail();
+    chain_order_ = new_order;
+    find_my_position();
+    
+    // Everything before the switch was acked, so a new tail commits from there
+    if (is_tail() && !was_tail) {
+        commit_watermark_ = std::max(commit_watermark_, acked_version_);
+    }
+}
+
+bool ChainReplication::defer_if_newer_epoch(const Message& message) {
+    if (message.ballot <= chain_epoch_) {
+        return false;
+    }
+    deferred_messages_.push_back(message);
+    return true;
+}
+
+void ChainReplication::schedule_replan() {
+    membership_changed_ = true;
+    planner_cv_.notify_all();
+}
+
+void ChainReplication::record_local_latencies() {
+    uint32_t my_id = node_->get_node_id();
+    for (uint32_t member : chain_order_) {
+        if (member == my_id) {
+            continue;
+        }
+        PeerTelemetry::PeerStats stats = peer_telemetry_->get_stats(member);
+        if (stats.samples > 0) {
+            latency_matrix_.set(my_id, member, stats.mean_rtt_us / 1000.0);
+        }
+    }
+}
+
+Message ChainReplication::make_latency_report() {
+    Message report;
+    report.type = MessageType::CHAIN_UPDATE;
+    report.sender_id = node_->get_node_id();
+    report.timestamp = monotonic_now_us();
+    report.metadata = kLatencyReportTag;
+    report.partition_id = partition_id_;
+    
+    std::string rtts;
+    for (uint32_t member : chain_order_) {
+        if (member == report.sender_id) {
+            continue;
+        }
+        PeerTelemetry::PeerStats stats = peer_telemetry_->get_stats(member);
+        if (stats.samples == 0) {
+            continue;
+        }
+        uint32_t rtt_us = static_cast<uint32_t>(std::min<double>(stats.mean_rtt_us, UINT32_MAX));
+        rtts.append(reinterpret_cast<const char*>(&rtt_us), sizeof(rtt_us));
+        report.target_nodes.push_back(member);
+    }
+    report.value = std::move(rtts);
+    return report;
+}
+
+void ChainReplication::planner_loop() {
+    std::unique_lock<std::mutex> lock(chain_mutex_);
+    while (!stopping_ && reordering_enabled_) {
+        planner_cv_.wait_for(lock, std::chrono::milliseconds(reorder_interval_ms_), [this]() {
+            return stopping_ || !reordering_enabled_ || membership_changed_;
+        });
+        if (stopping_ || !reordering_enabled_) {
+            break;
+        }
+        
+        bool membership_changed = membership_changed_;
+        membership_changed_ = false;
+        if (is_head()) {
+            replan(lock, membership_changed);
+        } else if (my_position_ < chain_order_.size()) {
+            node_->send_message(chain_order_.front(), make_latency_report());
+        }
+    }
 }
 
 bool ChainReplication::should_use_fast_path(const Message& request) {
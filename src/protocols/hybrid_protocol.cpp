@@ -1,17 +1,51 @@
 #include "protocols/hybrid_protocol.h"
+#include "network/network_manager.h"
+#include "utils/clock.h"
 #include "utils/logger.h"
 #include <algorithm>
 #include <chrono>
 
 namespace replication {
 
+namespace {
+
+// Samples per mode required before observed latencies steer mode selection
+constexpr uint64_t kMinLatencySamples = 100;
+
+// Assumed cost of a mode switch until one has been measured
+constexpr double kInitialSwitchCostNs = 1e6;
+
+// Upper bound on waiting for in-flight chain writes during a switch
+constexpr uint64_t kSwitchDrainTimeoutMs = 5000;
+
+// Marks READ_REQUEST/READ_RESPONSE messages that carry a hedged read
+const std::string kHedgedReadTag = "hedged_read";
+
+// How long a hedged read waits on its duplicate once the primary has missed
+constexpr uint64_t kHedgeResponseTimeoutMs = 100;
+
+// How often the per-mode p95 hedge delays are re-read from the monitor
+constexpr uint64_t kHedgeDelayRefreshUs = 100000;
+
+// SYNC_COMPLETE phases, carried in log_index. A promotion is acked with
+// success set; a finished catch-up lets the source drop its session tree;
+// a peer holding this node back asks it to catch up.
+constexpr uint64_t kSyncPromote = 0;
+constexpr uint64_t kSyncFinished = 1;
+constexpr uint64_t kSyncRequired = 2;
+
+// Path of the calling thread's latest single-key operation
+thread_local ReplicationMode t_last_mode_used = ReplicationMode::HYBRID_AUTO;
+
+} // namespace
+
 HybridProtocol::HybridProtocol(std::shared_ptr<Node> node, 
                                const std::vector<uint32_t>& chain_order,
                                const std::vector<uint32_t>& quorum_nodes)
     : node_(node)
+    , partition_id_(0)
     , adaptive_switching_enabled_(true)
     , current_mode_(ReplicationMode::HYBRID_AUTO)
-    , read_preference_(ReplicationMode::CHAIN_ONLY)
     , write_preference_(ReplicationMode::QUORUM_ONLY)
     , switching_threshold_(0.15) // 15% performance difference threshold
     , intelligent_routing_enabled_(true)
@@ -19,15 +53,56 @@ HybridProtocol::HybridProtocol(std::shared_ptr<Node> node,
     , caching_enabled_(true)
     , speculative_execution_enabled_(false)
     , request_batching_enabled_(true)
-    , cache_ttl_(30000000) // 30 seconds in microseconds
+    , key_heat_(std::make_unique<HotKeyTracker>())
+    , hot_key_min_ops_(32)
+    , read_mostly_ratio_(4.0)
+    , write_contended_ratio_(1.0)
+    , read_cache_(std::make_unique<ReadCache>())
+    , cache_coherence_enabled_(true)
+    , cache_version_(1) // 0 marks unversioned cache entries
+    , cache_update_batch_size_(64)
+    , cache_update_max_delay_us_(1000)
+    , oldest_invalidation_us_(0)
+    , coherence_stopping_(false)
+    , cache_updates_sent_(0)
+    , next_hedge_id_(1) // 0 marks a read that was never hedged
+    , max_inflight_hedges_(16)
+    , min_hedge_delay_us_(500)
+    , hedge_delay_refresh_us_(0)
+    , hedges_inflight_(0)
+    , hedged_reads_sent_(0)
+    , hedge_wins_(0)
+    , read_workers_stopping_(false)
+    , mode_epoch_(0)
+    , mode_epoch_owner_(0)
+    , candidate_mode_(ReplicationMode::HYBRID_AUTO)
+    , candidate_votes_(0)
+    , switch_confirmations_(3)
+    , min_mode_dwell_us_(5000000) // 5 seconds
+    , last_switch_us_(0)
+    , switch_horizon_s_(10.0)
+    , switch_cost_ns_(kInitialSwitchCostNs)
     , chain_operations_(0)
     , quorum_operations_(0)
-    , cache_hits_(0)
-    , cache_misses_(0) {
+    , anti_entropy_(std::make_unique<AntiEntropy>(node))
+    , promotion_source_(0)
+    , rejoining_(false)
+    , latency_monitor_(std::make_unique<PerformanceMonitor>()) {
+    
+    // One telemetry store per node, so transport and protocol round trips
+    // land on the same peers
+    std::shared_ptr<NetworkManager> network = node_->get_network_manager();
+    peer_telemetry_ = network ? network->get_peer_telemetry() : std::make_shared<PeerTelemetry>();
     
     // Initialize sub-protocols
     chain_protocol_ = std::make_unique<ChainReplication>(node_, chain_order);
     quorum_protocol_ = std::make_unique<QuorumReplication>(node_, quorum_nodes);
+    chain_protocol_->set_peer_telemetry(peer_telemetry_);
+    quorum_protocol_->set_peer_telemetry(peer_telemetry_);
+    // Chain writes are invalidated once the tail commits them, under their version
+    chain_protocol_->set_commit_listener([this](const std::string& key, uint64_t version) {
+        publish_invalidation(key, version);
+    });
     
     // Enable optimizations on sub-protocols
     chain_protocol_->enable_batching(true);
@@ -37,12 +112,61 @@ HybridProtocol::HybridProtocol(std::shared_ptr<Node> node,
     quorum_protocol_->enable_read_optimization(true);
     quorum_protocol_->enable_adaptive_quorum(true);
     
+    refresh_coherence_peers();
+    coherence_flush_thread_ = std::thread(&HybridProtocol::coherence_flush_loop, this);
+    
     LOG_INFO("HybridProtocol initialized with chain (" + std::to_string(chain_order.size()) + 
              " nodes) and quorum (" + std::to_string(quorum_nodes.size()) + " nodes)");
 }
 
+HybridProtocol::~HybridProtocol() {
+    // The chain outlives the cache it would invalidate
+    chain_protocol_->set_commit_listener(nullptr);
+    
+    {
+        std::lock_guard<std::mutex> lock(coherence_mutex_);
+        coherence_stopping_ = true;
+    }
+    coherence_cv_.notify_all();
+    if (coherence_flush_thread_.joinable()) {
+        coherence_flush_thread_.join();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(read_task_mutex_);
+        read_workers_stopping_ = true;
+    }
+    read_task_cv_.notify_all();
+    for (std::thread& worker : read_workers_) {
+        worker.join();
+    }
+    
+    std::thread rejoin;
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        rejoin = std::move(rejoin_thread_);
+    }
+    if (rejoin.joinable()) {
+        rejoin.join();
+    }
+}
+
 bool HybridProtocol::process_read(const Message& request, Message& response) {
-    auto start_time = std::chrono::high_resolution_clock::now();
+    t_last_mode_used = ReplicationMode::HYBRID_AUTO;
+    
+    // Still catching up: the local store may be stale
+    if (!node_->is_serving()) {
+        response.type = MessageType::READ_RESPONSE;
+        response.sender_id = node_->get_node_id();
+        response.timestamp = monotonic_now_us();
+        response.key = request.key;
+        response.success = false;
+        return false;
+    }
+    
+    uint64_t start_time = monotonic_now_ns();
+    key_heat_->record_read(request.key, start_time / 1000);
+    repin_hot_key(request.key);
     
     // Try cache first if enabled
     if (caching_enabled_) {
@@ -55,90 +179,80 @@ bool HybridProtocol::process_read(const Message& request, Message& response) {
             response.value = cached_value;
             response.success = true;
             
-            cache_hits_.fetch_add(1);
             LOG_DEBUG("Cache hit for read key: " + request.key);
             return true;
         }
-        cache_misses_.fetch_add(1);
     }
     
-    // Determine optimal protocol for this read
-    ReplicationMode mode = adaptive_switching_enabled_ ? 
-                          decide_protocol_for_read(request) : read_preference_;
+    // Taken before the read: an invalidation that lands while it is in
+    // flight carries a newer version and makes the cache refuse the fill
+    uint64_t read_version = cache_version_.load(std::memory_order_acquire);
     
+    // Reads take the same route as the key's writes
+    ReplicationMode mode_used = get_pinned_route(request.key);
+    t_last_mode_used = mode_used;
     bool success = false;
     
     // Process with selected protocol
-    if (mode == ReplicationMode::CHAIN_ONLY || 
-        (mode == ReplicationMode::HYBRID_AUTO && current_metrics_.read_write_ratio > 2.0)) {
-        
+    if (speculative_execution_enabled_) {
+        success = hedged_read(request, response, mode_used);
+    } else if (mode_used == ReplicationMode::CHAIN_ONLY) {
         success = chain_protocol_->process_read(request, response);
-        chain_operations_.fetch_add(1);
         LOG_DEBUG("Processed read via Chain Replication");
-        
-    } else if (mode == ReplicationMode::QUORUM_ONLY ||
-               mode == ReplicationMode::HYBRID_AUTO) {
-        
+    } else {
         success = quorum_protocol_->process_read(request, response);
-        quorum_operations_.fetch_add(1);
         LOG_DEBUG("Processed read via Quorum Replication");
     }
+    if (mode_used == ReplicationMode::CHAIN_ONLY) {
+        chain_operations_.fetch_add(1);
+    } else {
+        quorum_operations_.fetch_add(1);
+    }
     
     // Update cache if successful and caching enabled
     if (success && caching_enabled_) {
-        update_cache(request.key, response.value);
+        update_cache(request.key, response.value, read_version);
     }
     
     // Update performance metrics
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
-        end_time - start_time).count();
-    update_performance_metrics(request, latency, success);
-    
-    // Start speculative execution for future requests if enabled
-    if (speculative_execution_enabled_) {
-        start_speculative_read(request);
-    }
+    update_performance_metrics(request, mode_used, monotonic_now_ns() - start_time, success);
     
     return success;
 }
 
 bool HybridProtocol::process_write(const Message& request, Message& response) {
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    // Invalidate cache entry if caching is enabled
-    if (caching_enabled_) {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        cache_.erase(request.key);
-    }
+    uint64_t start_time = monotonic_now_ns();
+    key_heat_->record_write(request.key, start_time / 1000);
+    repin_hot_key(request.key);
     
-    // Determine optimal protocol for this write
-    ReplicationMode mode = adaptive_switching_enabled_ ? 
-                          decide_protocol_for_write(request) : write_preference_;
+    // Held for the whole write so a mode switch can drain it
+    std::shared_lock<std::shared_mutex> gate(switch_gate_);
     
+    // Determine the protocol for this write
+    ReplicationMode mode_used = get_pinned_route(request.key);
+    t_last_mode_used = mode_used;
     bool success = false;
     
     // Process with selected protocol
-    if (mode == ReplicationMode::CHAIN_ONLY || 
-        (mode == ReplicationMode::HYBRID_AUTO && current_metrics_.network_partition_probability > 0.3)) {
-        
+    if (mode_used == ReplicationMode::CHAIN_ONLY) {
         success = chain_protocol_->process_write(request, response);
         chain_operations_.fetch_add(1);
         LOG_DEBUG("Processed write via Chain Replication");
-        
-    } else if (mode == ReplicationMode::QUORUM_ONLY ||
-               mode == ReplicationMode::HYBRID_AUTO) {
-        
+    } else {
         success = quorum_protocol_->process_write(request, response);
         quorum_operations_.fetch_add(1);
         LOG_DEBUG("Processed write via Quorum Replication");
     }
     
+    // Invalidate here and on every other replica; the chain's commit
+    // listener already did for chain writes. Failed quorum writes too: a
+    // timed-out write may still commit.
+    if (mode_used != ReplicationMode::CHAIN_ONLY) {
+        publish_invalidation(request.key, response.log_index);
+    }
+    
     // Update performance metrics
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
-        end_time - start_time).count();
-    update_performance_metrics(request, latency, success);
+    update_performance_metrics(request, mode_used, monotonic_now_ns() - start_time, success);
     
     // Start speculative execution for future requests if enabled
     if (speculative_execution_enabled_) {
@@ -148,29 +262,367 @@ bool HybridProtocol::process_write(const Message& request, Message& response) {
     return success;
 }
 
+bool HybridProtocol::multi_get(const std::vector<std::string>& keys, std::vector<Message>& responses) {
+    responses.assign(keys.size(), Message());
+    // One at a time also refuses every key while the node is catching up
+    if (!request_batching_enabled_ || !node_->is_serving()) {
+        bool all_succeeded = true;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            Message request;
+            request.type = MessageType::READ_REQUEST;
+            request.key = keys[i];
+            all_succeeded = process_read(request, responses[i]) && all_succeeded;
+        }
+        return all_succeeded;
+    }
+    
+    uint64_t start_time = monotonic_now_ns();
+    uint64_t read_version = cache_version_.load(std::memory_order_acquire);
+    
+    // Serve what the cache can, group the rest by protocol
+    std::vector<Message> chain_reads;
+    std::vector<Message> quorum_reads;
+    std::vector<size_t> chain_slots;
+    std::vector<size_t> quorum_slots;
+    size_t cache_hits = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        key_heat_->record_read(keys[i], start_time / 1000);
+        repin_hot_key(keys[i]);
+        
+        Message request;
+        request.type = MessageType::READ_REQUEST;
+        request.key = keys[i];
+        
+        std::string cached_value;
+        if (caching_enabled_ && try_cache_read(keys[i], cached_value)) {
+            Message& response = responses[i];
+            response.type = MessageType::READ_RESPONSE;
+            response.sender_id = node_->get_node_id();
+            response.timestamp = monotonic_now_us();
+            response.key = keys[i];
+            response.value = std::move(cached_value);
+            response.success = true;
+            ++cache_hits;
+            continue;
+        }
+        
+        if (get_pinned_route(keys[i]) == ReplicationMode::CHAIN_ONLY) {
+            chain_reads.push_back(std::move(request));
+            chain_slots.push_back(i);
+        } else {
+            quorum_reads.push_back(std::move(request));
+            quorum_slots.push_back(i);
+        }
+    }
+    
+    // CRAQ reads are local to this replica, so the chain group needs no round
+    for (size_t i = 0; i < chain_reads.size(); ++i) {
+        chain_protocol_->process_read(chain_reads[i], responses[chain_slots[i]]);
+    }
+    if (!quorum_reads.empty()) {
+        std::vector<Message> quorum_responses;
+        quorum_protocol_->process_batch_read(quorum_reads, quorum_responses);
+        for (size_t i = 0; i < quorum_slots.size(); ++i) {
+            responses[quorum_slots[i]] = std::move(quorum_responses[i]);
+        }
+    }
+    chain_operations_.fetch_add(chain_reads.size());
+    quorum_operations_.fetch_add(quorum_reads.size());
+    
+    uint64_t latency_ns = monotonic_now_ns() - start_time;
+    bool all_succeeded = true;
+    for (size_t i = 0; i < chain_slots.size(); ++i) {
+        const Message& response = responses[chain_slots[i]];
+        if (response.success && caching_enabled_) {
+            update_cache(response.key, response.value, read_version);
+        }
+        latency_monitor_->record_operation(MessageType::READ_REQUEST, ReplicationMode::CHAIN_ONLY,
+                                           latency_ns, response.success);
+        all_succeeded = all_succeeded && response.success;
+    }
+    for (size_t i = 0; i < quorum_slots.size(); ++i) {
+        const Message& response = responses[quorum_slots[i]];
+        if (response.success && caching_enabled_) {
+            update_cache(response.key, response.value, read_version);
+        }
+        latency_monitor_->record_operation(MessageType::READ_REQUEST, ReplicationMode::QUORUM_ONLY,
+                                           latency_ns, response.success);
+        all_succeeded = all_succeeded && response.success;
+    }
+    refresh_read_write_ratio();
+    
+    LOG_DEBUG("multi_get of " + std::to_string(keys.size()) + " keys: " + std::to_string(cache_hits) +
+              " cached, " + std::to_string(chain_reads.size()) + " chain, " +
+              std::to_string(quorum_reads.size()) + " quorum");
+    return all_succeeded;
+}
+
+bool HybridProtocol::multi_put(const std::vector<std::pair<std::string, std::string>>& entries,
+                               std::vector<Message>& responses) {
+    responses.assign(entries.size(), Message());
+    if (!request_batching_enabled_) {
+        bool all_succeeded = true;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            Message request;
+            request.type = MessageType::WRITE_REQUEST;
+            request.key = entries[i].first;
+            request.value = entries[i].second;
+            all_succeeded = process_write(request, responses[i]) && all_succeeded;
+        }
+        return all_succeeded;
+    }
+    
+    uint64_t start_time = monotonic_now_ns();
+    for (const auto& entry : entries) {
+        key_heat_->record_write(entry.first, start_time / 1000);
+        repin_hot_key(entry.first);
+    }
+    
+    // Held for the whole batch so a mode switch can drain it
+    std::shared_lock<std::shared_mutex> gate(switch_gate_);
+    
+    std::vector<Message> chain_writes;
+    std::vector<Message> quorum_writes;
+    std::vector<size_t> chain_slots;
+    std::vector<size_t> quorum_slots;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Message request;
+        request.type = MessageType::WRITE_REQUEST;
+        request.key = entries[i].first;
+        request.value = entries[i].second;
+        
+        if (get_pinned_route(request.key) == ReplicationMode::CHAIN_ONLY) {
+            chain_writes.push_back(std::move(request));
+            chain_slots.push_back(i);
+        } else {
+            quorum_writes.push_back(std::move(request));
+            quorum_slots.push_back(i);
+        }
+    }
+    
+    // One batch per destination protocol
+    if (!chain_writes.empty()) {
+        std::vector<Message> chain_responses;
+        chain_protocol_->process_batch_write(chain_writes, chain_responses);
+        for (size_t i = 0; i < chain_slots.size(); ++i) {
+            responses[chain_slots[i]] = std::move(chain_responses[i]);
+        }
+    }
+    if (!quorum_writes.empty()) {
+        std::vector<Message> quorum_responses;
+        quorum_protocol_->process_batch_write(quorum_writes, quorum_responses);
+        for (size_t i = 0; i < quorum_slots.size(); ++i) {
+            responses[quorum_slots[i]] = std::move(quorum_responses[i]);
+        }
+    }
+    chain_operations_.fetch_add(chain_writes.size());
+    quorum_operations_.fetch_add(quorum_writes.size());
+    
+    uint64_t latency_ns = monotonic_now_ns() - start_time;
+    bool all_succeeded = true;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        all_succeeded = all_succeeded && responses[i].success;
+    }
+    // As in process_write(), chain writes were published as they committed
+    for (size_t slot : quorum_slots) {
+        publish_invalidation(entries[slot].first, responses[slot].log_index);
+    }
+    for (size_t slot : chain_slots) {
+        latency_monitor_->record_operation(MessageType::WRITE_REQUEST, ReplicationMode::CHAIN_ONLY,
+                                           latency_ns, responses[slot].success);
+    }
+    for (size_t slot : quorum_slots) {
+        latency_monitor_->record_operation(MessageType::WRITE_REQUEST, ReplicationMode::QUORUM_ONLY,
+                                           latency_ns, responses[slot].success);
+    }
+    refresh_read_write_ratio();
+    
+    LOG_DEBUG("multi_put of " + std::to_string(entries.size()) + " keys: " +
+              std::to_string(chain_writes.size()) + " chain, " + std::to_string(quorum_writes.size()) + " quorum");
+    return all_succeeded;
+}
+
 void HybridProtocol::update_workload_metrics(const AdaptiveMetrics& metrics) {
+    ReplicationMode optimal_mode;
+    {
+        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        
+        current_metrics_ = metrics;
+        
+        // Analyze workload pattern
+        current_metrics_.pattern = analyze_workload_pattern();
+        
+        if (!adaptive_switching_enabled_) {
+            return;
+        }
+        optimal_mode = select_optimal_mode(Message()); // Dummy message for analysis
+        if (!should_switch_mode(optimal_mode)) {
+            return;
+        }
+    }
+    
+    // The switch drains writes, which take metrics_mutex_ on completion
+    execute_mode_switch(optimal_mode, 0, 0, true);
+}
+
+void HybridProtocol::set_switch_hysteresis(uint64_t min_dwell_ms, size_t confirmations) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    min_mode_dwell_us_ = min_dwell_ms * 1000;
+    switch_confirmations_ = std::max<size_t>(1, confirmations);
+    candidate_votes_ = 0;
+}
+
+bool HybridProtocol::switch_mode(ReplicationMode target) {
+    return execute_mode_switch(target, 0, 0, true);
+}
+
+size_t HybridProtocol::get_mode_switch_count() const {
     std::lock_guard<std::mutex> lock(metrics_mutex_);
+    return mode_switching_times_.size();
+}
+
+bool HybridProtocol::fence_supersedes(uint64_t epoch, uint32_t owner) const {
+    // Fences order by (epoch, sender), so replicas that fenced the same
+    // epoch concurrently all settle on the higher sender's mode
+    uint64_t current = mode_epoch_.load();
+    return epoch > current || (epoch == current && owner > mode_epoch_owner_.load());
+}
+
+bool HybridProtocol::execute_mode_switch(ReplicationMode target, uint64_t epoch, uint32_t epoch_owner,
+                                         bool announce) {
+    std::lock_guard<std::mutex> serial(switch_mutex_);
+    uint64_t switch_start = monotonic_now_ns();
+    
+    // 1. Drain: stop admitting writes, wait for the ones running here, then
+    //    for pipelined chain writes that returned before the tail acked
+    std::unique_lock<std::shared_mutex> gate(switch_gate_);
+    if (!chain_protocol_->drain_writes(kSwitchDrainTimeoutMs)) {
+        LOG_WARNING("Mode switch proceeding with chain writes still in flight");
+    }
     
-    current_metrics_ = metrics;
+    // 2. Fence: a new epoch, announced to every other replica
+    uint64_t new_epoch = epoch;
+    if (epoch == 0) {
+        new_epoch = mode_epoch_.load() + 1;
+        epoch_owner = node_->get_node_id();
+    }
+    if (!fence_supersedes(new_epoch, epoch_owner)) {
+        return false; // superseded by a newer fence
+    }
+    mode_epoch_.store(new_epoch);
+    mode_epoch_owner_.store(epoch_owner);
+    
+    if (announce) {
+        Message fence;
+        fence.type = MessageType::MODE_SWITCH;
+        fence.sender_id = node_->get_node_id();
+        fence.timestamp = monotonic_now_us();
+        fence.sequence_number = static_cast<uint32_t>(target);
+        fence.log_index = new_epoch;
+        fence.partition_id = partition_id_;
+        for (uint32_t peer : replica_peers()) {
+            fence.receiver_id = peer;
+            node_->send_message(peer, fence);
+        }
+    }
     
-    // Analyze workload pattern
-    current_metrics_.pattern = analyze_workload_pattern();
+    // 3. Activate
+    ReplicationMode previous = current_mode_.exchange(target);
+    gate.unlock();
+    
+    uint64_t now = monotonic_now_ns();
+    uint64_t switch_time = now - switch_start;
+    {
+        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        mode_switching_times_.push_back(switch_time / 1e6); // Convert to ms
+        switch_cost_ns_ = 0.7 * switch_cost_ns_ + 0.3 * static_cast<double>(switch_time);
+        last_switch_us_ = now / 1000;
+        candidate_votes_ = 0;
+    }
     
-    // Check if we should switch modes
-    if (adaptive_switching_enabled_) {
-        ReplicationMode optimal_mode = select_optimal_mode(Message()); // Dummy message for analysis
-        if (should_switch_mode(optimal_mode)) {
-            auto switch_start = std::chrono::high_resolution_clock::now();
-            current_mode_ = optimal_mode;
-            auto switch_end = std::chrono::high_resolution_clock::now();
-            
-            auto switch_time = std::chrono::duration_cast<std::chrono::microseconds>(
-                switch_end - switch_start).count();
-            mode_switching_times_.push_back(switch_time / 1000.0); // Convert to ms
-            
-            LOG_INFO("Switched to mode: " + std::to_string(static_cast<int>(optimal_mode)));
+    LOG_INFO("Switched from mode " + std::to_string(static_cast<int>(previous)) + " to " +
+             std::to_string(static_cast<int>(target)) + " at epoch " + std::to_string(new_epoch) +
+             " in " + std::to_string(switch_time / 1000) + "us");
+    return true;
+}
+
+void HybridProtocol::handle_mode_switch(const Message& message) {
+    if (message.sender_id == node_->get_node_id()) {
+        return;
+    }
+    if (message.sequence_number >= kReplicationModeCount) {
+        LOG_WARNING("Ignoring mode switch to unknown mode from node " + std::to_string(message.sender_id));
+        return;
+    }
+    
+    // A fence that carries a key pins that key's route only
+    if (!message.key.empty()) {
+        execute_key_pin(message.key, static_cast<ReplicationMode>(message.sequence_number), message.log_index,
+                        message.sender_id, false);
+        return;
+    }
+    if (!fence_supersedes(message.log_index, message.sender_id)) {
+        return; // stale fence
+    }
+    
+    // Drain local writes before adopting the sender's epoch
+    execute_mode_switch(static_cast<ReplicationMode>(message.sequence_number), message.log_index,
+                        message.sender_id, false);
+}
+
+bool HybridProtocol::execute_key_pin(const std::string& key, ReplicationMode mode, uint64_t epoch,
+                                     uint32_t epoch_owner, bool announce) {
+    if (mode != ReplicationMode::CHAIN_ONLY && mode != ReplicationMode::QUORUM_ONLY) {
+        return false;
+    }
+    // Pins change only under switch_mutex_, so the check holds through the drain
+    std::lock_guard<std::mutex> serial(switch_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(key_routes_mutex_);
+        auto it = key_routes_.find(key);
+        if (epoch == 0) {
+            if (it != key_routes_.end() && it->second.mode == mode) {
+                return true; // another caller pinned it meanwhile
+            }
+            epoch = (it != key_routes_.end() ? it->second.epoch : 0) + 1;
+            epoch_owner = node_->get_node_id();
+        } else if (it != key_routes_.end() &&
+                   (epoch < it->second.epoch || (epoch == it->second.epoch && epoch_owner <= it->second.owner))) {
+            return false; // superseded by a newer pin
         }
     }
+    
+    // Drain as for a mode switch, so no write routed the old way is still
+    // in flight when the first one routed the new way starts
+    std::unique_lock<std::shared_mutex> gate(switch_gate_);
+    if (!chain_protocol_->drain_writes(kSwitchDrainTimeoutMs)) {
+        LOG_WARNING("Pinning key " + key + " with chain writes still in flight");
+    }
+    
+    if (announce) {
+        Message fence;
+        fence.type = MessageType::MODE_SWITCH;
+        fence.sender_id = node_->get_node_id();
+        fence.timestamp = monotonic_now_us();
+        fence.sequence_number = static_cast<uint32_t>(mode);
+        fence.log_index = epoch;
+        fence.key = key;
+        fence.partition_id = partition_id_;
+        for (uint32_t peer : replica_peers()) {
+            fence.receiver_id = peer;
+            node_->send_message(peer, fence);
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(key_routes_mutex_);
+        key_routes_[key] = KeyPin{mode, epoch, epoch_owner, monotonic_now_us()};
+    }
+    gate.unlock();
+    
+    LOG_INFO("Pinned key " + key + " to mode " + std::to_string(static_cast<int>(mode)) + " at epoch " +
+             std::to_string(epoch));
+    return true;
 }
 
 ReplicationMode HybridProtocol::select_optimal_mode(const Message& /*request*/) {
@@ -193,8 +645,19 @@ ReplicationMode HybridProtocol::select_optimal_mode(const Message& /*request*/)
         quorum_score += 0.15;
     }
     
-    // Factor 3: Current latency
-    if (current_metrics_.average_latency > 100.0) { // > 100ms
+    // Factor 3: Observed latency distributions. A mode must beat the other on
+    // median plus tail latency by the switching threshold to earn the points.
+    LatencySummary chain_latency = latency_monitor_->get_mode_latency_summary(ReplicationMode::CHAIN_ONLY);
+    LatencySummary quorum_latency = latency_monitor_->get_mode_latency_summary(ReplicationMode::QUORUM_ONLY);
+    if (chain_latency.count >= kMinLatencySamples && quorum_latency.count >= kMinLatencySamples) {
+        double chain_cost = static_cast<double>(chain_latency.p50_ns + chain_latency.p99_ns);
+        double quorum_cost = static_cast<double>(quorum_latency.p50_ns + quorum_latency.p99_ns);
+        if (chain_cost * (1.0 + switching_threshold_) < quorum_cost) {
+            chain_score += 0.2;
+        } else if (quorum_cost * (1.0 + switching_threshold_) < chain_cost) {
+            quorum_score += 0.2;
+        }
+    } else if (current_metrics_.average_latency > 100.0) { // > 100ms
         // Prefer the protocol with better historical performance
         double chain_efficiency = get_hybrid_efficiency();
         if (chain_efficiency > 0.8) {
@@ -238,25 +701,35 @@ ReplicationMode HybridProtocol::select_optimal_mode(const Message& /*request*/)
 
 void HybridProtocol::update_chain_configuration(const std::vector<uint32_t>& new_chain) {
     chain_protocol_->update_chain_order(new_chain);
+    refresh_coherence_peers();
     LOG_INFO("Chain configuration updated");
 }
 
 void HybridProtocol::update_quorum_configuration(const std::vector<uint32_t>& new_quorum) {
     quorum_protocol_->update_quorum_nodes(new_quorum);
+    refresh_coherence_peers();
     LOG_INFO("Quorum configuration updated");
 }
 
+void HybridProtocol::set_partition(uint32_t partition_id, MerkleTree::KeyFilter owns_key) {
+    partition_id_ = partition_id;
+    chain_protocol_->set_partition(partition_id);
+    quorum_protocol_->set_partition(partition_id);
+    anti_entropy_->set_scope(partition_id, std::move(owns_key));
+}
+
 void HybridProtocol::handle_network_partition() {
     // Switch to chain replication during network partitions
-    if (adaptive_switching_enabled_) {
-        current_mode_ = ReplicationMode::CHAIN_ONLY;
+    if (adaptive_switching_enabled_ && current_mode_.load() != ReplicationMode::CHAIN_ONLY) {
         LOG_WARNING("Network partition detected, switching to Chain Replication");
+        execute_mode_switch(ReplicationMode::CHAIN_ONLY, 0, 0, true);
     }
 }
 
 void HybridProtocol::handle_node_failure(uint32_t failed_node) {
     chain_protocol_->handle_node_failure(failed_node);
     quorum_protocol_->handle_node_failure(failed_node);
+    refresh_coherence_peers();
     
     // Update metrics
     current_metrics_.active_nodes = std::max(size_t(1), current_metrics_.active_nodes - 1);
@@ -265,13 +738,345 @@ void HybridProtocol::handle_node_failure(uint32_t failed_node) {
 }
 
 void HybridProtocol::handle_node_recovery(uint32_t recovered_node) {
-    chain_protocol_->handle_node_recovery(recovered_node);
-    quorum_protocol_->handle_node_recovery(recovered_node);
+    // Its store may be arbitrarily stale; serving it as the tail or counting
+    // it toward a quorum waits until it has caught up
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        if (std::find(catching_up_nodes_.begin(), catching_up_nodes_.end(), recovered_node) ==
+            catching_up_nodes_.end()) {
+            catching_up_nodes_.push_back(recovered_node);
+        }
+    }
+    
+    Message required;
+    required.type = MessageType::SYNC_COMPLETE;
+    required.sender_id = node_->get_node_id();
+    required.receiver_id = recovered_node;
+    required.timestamp = monotonic_now_us();
+    required.log_index = kSyncRequired;
+    required.partition_id = partition_id_;
+    node_->send_message(recovered_node, required);
+    
+    LOG_INFO("Node " + std::to_string(recovered_node) + " recovered, held back until it catches up");
+}
+
+void HybridProtocol::readmit_node(uint32_t node_id) {
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        if (std::find(catching_up_nodes_.begin(), catching_up_nodes_.end(), node_id) ==
+            catching_up_nodes_.end()) {
+            catching_up_nodes_.push_back(node_id);
+        }
+    }
+    // Nothing to catch up on, so it is promoted straight away
+    promote_node(node_id);
+}
+
+void HybridProtocol::promote_node(uint32_t caught_up_node) {
+    bool was_catching_up = false;
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        auto it = std::find(catching_up_nodes_.begin(), catching_up_nodes_.end(), caught_up_node);
+        if (it != catching_up_nodes_.end()) {
+            catching_up_nodes_.erase(it);
+            was_catching_up = true;
+        }
+    }
+    
+    chain_protocol_->handle_node_recovery(caught_up_node);
+    quorum_protocol_->handle_node_recovery(caught_up_node);
+    refresh_coherence_peers();
     
     // Update metrics
-    current_metrics_.active_nodes++;
+    if (was_catching_up) {
+        current_metrics_.active_nodes++;
+    }
+    
+    LOG_INFO("Node " + std::to_string(caught_up_node) + " caught up, promoted to chain tail and quorum");
+}
+
+bool HybridProtocol::rejoin_cluster(uint32_t source) {
+    node_->begin_catch_up();
+    const AntiEntropyConfig& config = anti_entropy_->get_config();
+    
+    // Passes repeat while the cluster keeps writing; each only has to cover
+    // what changed during the one before
+    bool converged = false;
+    for (size_t pass = 0; pass < config.max_passes && !converged; ++pass) {
+        size_t keys_changed = 0;
+        if (!anti_entropy_->sync_pass(source, keys_changed)) {
+            return false;
+        }
+        converged = keys_changed <= config.converged_keys;
+    }
+    if (!converged) {
+        LOG_WARNING("Catch-up from node " + std::to_string(source) + " did not converge in " +
+                    std::to_string(config.max_passes) + " passes, rejoining anyway");
+    }
+    
+    if (!request_promotion(source)) {
+        return false;
+    }
+    promote_node(node_->get_node_id());
+    
+    // Writes committed before the peers promoted this node never reached it
+    size_t keys_changed = 0;
+    if (!anti_entropy_->sync_pass(source, keys_changed)) {
+        return false;
+    }
+    node_->end_catch_up();
+    
+    Message finished;
+    finished.type = MessageType::SYNC_COMPLETE;
+    finished.sender_id = node_->get_node_id();
+    finished.receiver_id = source;
+    finished.timestamp = monotonic_now_us();
+    finished.log_index = kSyncFinished;
+    finished.partition_id = partition_id_;
+    node_->send_message(source, finished);
+    
+    LOG_INFO("Node " + std::to_string(node_->get_node_id()) + " caught up from node " +
+             std::to_string(source) + " and is serving");
+    return true;
+}
+
+bool HybridProtocol::request_promotion(uint32_t source) {
+    auto ack = std::make_shared<std::promise<bool>>();
+    std::future<bool> acked = ack->get_future();
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        promotion_ack_ = ack;
+        promotion_source_ = source;
+    }
+    
+    std::vector<uint32_t> peers = replica_peers();
+    if (std::find(peers.begin(), peers.end(), source) == peers.end()) {
+        peers.push_back(source);
+    }
+    Message promote;
+    promote.type = MessageType::SYNC_COMPLETE;
+    promote.sender_id = node_->get_node_id();
+    promote.timestamp = monotonic_now_us();
+    promote.log_index = kSyncPromote;
+    promote.partition_id = partition_id_;
+    for (uint32_t peer : peers) {
+        promote.receiver_id = peer;
+        node_->send_message(peer, promote);
+    }
+    
+    bool answered = acked.wait_for(std::chrono::milliseconds(anti_entropy_->get_config().request_timeout_ms)) ==
+                    std::future_status::ready;
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        promotion_ack_.reset();
+    }
+    if (!answered) {
+        LOG_WARNING("Node " + std::to_string(source) + " did not ack the promotion");
+    }
+    return answered;
+}
+
+void HybridProtocol::start_rejoin(uint32_t source) {
+    std::lock_guard<std::mutex> lock(recovery_mutex_);
+    if (std::find(rejoin_sources_.begin(), rejoin_sources_.end(), source) == rejoin_sources_.end()) {
+        rejoin_sources_.push_back(source);
+    }
+    // Held back by several peers at once; one catch-up serves them all
+    if (rejoining_) {
+        return;
+    }
+    if (rejoin_thread_.joinable()) {
+        rejoin_thread_.join(); // finished, it cleared rejoining_
+    }
+    rejoining_ = true;
+    // Off the dispatcher: the passes wait on replies it delivers
+    rejoin_thread_ = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(recovery_mutex_);
+        while (!rejoin_sources_.empty()) {
+            uint32_t next = rejoin_sources_.front();
+            rejoin_sources_.pop_front();
+            lock.unlock();
+            bool caught_up = rejoin_cluster(next);
+            lock.lock();
+            if (caught_up) {
+                rejoin_sources_.clear();
+                break;
+            }
+            LOG_WARNING("Node " + std::to_string(node_->get_node_id()) + " could not catch up from node " +
+                        std::to_string(next));
+        }
+        rejoining_ = false;
+    });
+}
+
+void HybridProtocol::configure_anti_entropy(const AntiEntropyConfig& config) {
+    anti_entropy_->set_config(config);
+}
+
+void HybridProtocol::handle_message(const Message& message) {
+    switch (message.type) {
+        case MessageType::READ_REQUEST:
+            if (message.metadata == kHedgedReadTag) {
+                handle_hedged_read(message);
+            } else {
+                serve_remote_request(message);
+            }
+            break;
+        case MessageType::WRITE_REQUEST:
+            serve_remote_request(message);
+            break;
+        case MessageType::READ_RESPONSE:
+            handle_hedged_read_response(message);
+            break;
+        case MessageType::MODE_SWITCH:
+            handle_mode_switch(message);
+            break;
+        case MessageType::CACHE_UPDATE:
+            handle_cache_update(message);
+            break;
+        case MessageType::CHAIN_FORWARD:
+            chain_protocol_->handle_chain_forward(message);
+            break;
+        case MessageType::CHAIN_ACK:
+            chain_protocol_->handle_chain_ack(message);
+            break;
+        case MessageType::BATCH_REQUEST:
+            chain_protocol_->handle_chain_batch(message);
+            break;
+        case MessageType::CHAIN_VERSION_QUERY:
+            chain_protocol_->handle_version_query(message);
+            break;
+        case MessageType::CHAIN_VERSION_RESPONSE:
+            chain_protocol_->handle_version_response(message);
+            break;
+        case MessageType::CHAIN_UPDATE:
+            chain_protocol_->handle_chain_update(message);
+            break;
+        case MessageType::QUORUM_PREPARE:
+            quorum_protocol_->handle_prepare(message);
+            break;
+        case MessageType::QUORUM_PROMISE:
+            quorum_protocol_->handle_promise(message);
+            break;
+        case MessageType::QUORUM_ACCEPT:
+            quorum_protocol_->handle_accept(message);
+            break;
+        case MessageType::QUORUM_ACCEPTED:
+            quorum_protocol_->handle_accepted(message);
+            break;
+        case MessageType::QUORUM_COMMIT:
+            quorum_protocol_->handle_commit(message);
+            break;
+        case MessageType::QUORUM_READ_INDEX:
+            quorum_protocol_->handle_read_index(message);
+            break;
+        case MessageType::QUORUM_READ_INDEX_ACK:
+            quorum_protocol_->handle_read_index_ack(message);
+            break;
+        case MessageType::SYNC_TREE_REQUEST:
+        case MessageType::SYNC_TREE_RESPONSE:
+        case MessageType::SYNC_RANGE_REQUEST:
+        case MessageType::SYNC_RANGE_DATA:
+        case MessageType::SYNC_COMPLETE:
+            handle_anti_entropy_message(message);
+            break;
+        default:
+            LOG_DEBUG("Ignoring message type " + std::to_string(static_cast<int>(message.type)) +
+                      " from node " + std::to_string(message.sender_id));
+            break;
+    }
+}
+
+void HybridProtocol::serve_remote_request(const Message& request) {
+    Message response;
+    if (request.type == MessageType::READ_REQUEST) {
+        process_read(request, response);
+        response.type = MessageType::READ_RESPONSE;
+    } else {
+        process_write(request, response);
+        response.type = MessageType::WRITE_RESPONSE;
+    }
+    if (request.sender_id == 0 || request.sender_id == node_->get_node_id()) {
+        return; // nobody to answer
+    }
+    response.sender_id = node_->get_node_id();
+    response.receiver_id = request.sender_id;
+    response.sequence_number = request.sequence_number;
+    response.correlation_id = request.correlation_id;
+    response.key = request.key;
+    response.partition_id = partition_id_;
+    node_->send_message(request.sender_id, response);
+}
+
+void HybridProtocol::handle_anti_entropy_message(const Message& message) {
+    switch (message.type) {
+        case MessageType::SYNC_TREE_REQUEST:
+            anti_entropy_->handle_tree_request(message);
+            break;
+        case MessageType::SYNC_TREE_RESPONSE:
+            anti_entropy_->handle_tree_response(message);
+            break;
+        case MessageType::SYNC_RANGE_REQUEST:
+            anti_entropy_->handle_range_request(message);
+            break;
+        case MessageType::SYNC_RANGE_DATA:
+            anti_entropy_->handle_range_data(message);
+            break;
+        case MessageType::SYNC_COMPLETE:
+            handle_sync_complete(message);
+            break;
+        default:
+            break;
+    }
+}
+
+void HybridProtocol::handle_sync_complete(const Message& message) {
+    if (message.success) {
+        // The source acking our own promotion
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        if (promotion_ack_ && message.sender_id == promotion_source_) {
+            promotion_ack_->set_value(true);
+            promotion_ack_.reset();
+        }
+        return;
+    }
+    
+    if (message.log_index == kSyncRequired) {
+        // Each side holding the other back means both were cut off from
+        // each other; neither is known to be stale, so neither catches up
+        {
+            std::lock_guard<std::mutex> lock(recovery_mutex_);
+            if (std::find(catching_up_nodes_.begin(), catching_up_nodes_.end(), message.sender_id) !=
+                catching_up_nodes_.end()) {
+                return;
+            }
+        }
+        start_rejoin(message.sender_id);
+        return;
+    }
+    if (message.log_index != kSyncPromote) {
+        anti_entropy_->end_session(message.sender_id);
+        return;
+    }
     
-    LOG_INFO("Node " + std::to_string(recovered_node) + " recovered, protocols updated");
+    // The session tree stays for the final pass
+    promote_node(message.sender_id);
+    
+    Message ack;
+    ack.type = MessageType::SYNC_COMPLETE;
+    ack.sender_id = node_->get_node_id();
+    ack.receiver_id = message.sender_id;
+    ack.timestamp = monotonic_now_us();
+    ack.sequence_number = message.sequence_number;
+    ack.log_index = kSyncPromote;
+    ack.success = true;
+    ack.partition_id = partition_id_;
+    node_->send_message(message.sender_id, ack);
+}
+
+std::vector<uint32_t> HybridProtocol::get_catching_up_nodes() const {
+    std::lock_guard<std::mutex> lock(recovery_mutex_);
+    return catching_up_nodes_;
 }
 
 double HybridProtocol::get_hybrid_efficiency() const {
@@ -281,8 +1086,9 @@ double HybridProtocol::get_hybrid_efficiency() const {
     if (total_ops == 0) return 0.0;
     
     // Calculate efficiency based on successful operations and switching overhead
-    double cache_hit_rate = static_cast<double>(cache_hits_.load()) / 
-                           (cache_hits_.load() + cache_misses_.load());
+    uint64_t cache_lookups = read_cache_->get_hits() + read_cache_->get_misses();
+    double cache_hit_rate = cache_lookups > 0 ?
+                           static_cast<double>(read_cache_->get_hits()) / cache_lookups : 0.0;
     
     // Base efficiency from protocol balance
     double protocol_balance = std::min(chain_operations_.load(), quorum_operations_.load()) / 
@@ -305,115 +1111,574 @@ double HybridProtocol::get_mode_switching_overhead() const {
 }
 
 AdaptiveMetrics HybridProtocol::get_current_metrics() const {
-    std::lock_guard<std::mutex> lock(metrics_mutex_);
-    return current_metrics_;
+    AdaptiveMetrics metrics;
+    {
+        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        metrics = current_metrics_;
+    }
+    
+    // Prefer measured latency over the last reported value once we have samples
+    LatencySummary observed = latency_monitor_->get_overall_latency_summary();
+    if (observed.count > 0) {
+        metrics.average_latency = observed.mean_ns / 1e6;
+    }
+    return metrics;
+}
+
+LatencySummary HybridProtocol::get_mode_latency(ReplicationMode mode) const {
+    return latency_monitor_->get_mode_latency_summary(mode);
 }
 
-ReplicationMode HybridProtocol::decide_protocol_for_read(const Message& /*request*/) {
-    // Intelligent routing for read requests
+ReplicationMode HybridProtocol::get_last_mode_used() {
+    return t_last_mode_used;
+}
+
+ReplicationMode HybridProtocol::get_key_route(const std::string& key) const {
+    HotKeyTracker::Heat heat = key_heat_->heat(key);
+    if (heat.total() < hot_key_min_ops_) {
+        return ReplicationMode::HYBRID_AUTO;
+    }
     
-    if (intelligent_routing_enabled_) {
-        // Use cache hit probability and network conditions
-        if (current_metrics_.network_partition_probability > 0.2) {
-            return ReplicationMode::CHAIN_ONLY;
-        }
-        
-        // For hot keys, prefer chain replication (tail reads)
-        if (current_metrics_.pattern == WorkloadPattern::READ_HEAVY) {
-            return ReplicationMode::CHAIN_ONLY;
+    // Both operations on a hot key follow its class so the key keeps one path
+    if (heat.reads >= read_mostly_ratio_ * heat.writes) {
+        return ReplicationMode::CHAIN_ONLY;
+    }
+    if (heat.reads <= write_contended_ratio_ * heat.writes) {
+        return ReplicationMode::QUORUM_ONLY;
+    }
+    return ReplicationMode::HYBRID_AUTO;
+}
+
+void HybridProtocol::set_hot_key_thresholds(uint32_t min_ops, double read_mostly_ratio,
+                                            double write_contended_ratio) {
+    hot_key_min_ops_ = std::max<uint32_t>(1, min_ops);
+    read_mostly_ratio_ = read_mostly_ratio;
+    write_contended_ratio_ = std::min(write_contended_ratio, read_mostly_ratio);
+}
+
+ReplicationMode HybridProtocol::get_pinned_route(const std::string& key) const {
+    {
+        std::lock_guard<std::mutex> lock(key_routes_mutex_);
+        auto it = key_routes_.find(key);
+        if (it != key_routes_.end()) {
+            return it->second.mode;
         }
     }
     
-    return read_preference_;
+    // Node-local signals (heat, partition probability, the read/write mix)
+    // only act through fenced switches, never on a single request
+    ReplicationMode route = current_mode_.load(std::memory_order_relaxed);
+    if (route == ReplicationMode::HYBRID_AUTO) {
+        route = write_preference_;
+    }
+    return route == ReplicationMode::CHAIN_ONLY ? ReplicationMode::CHAIN_ONLY : ReplicationMode::QUORUM_ONLY;
+}
+
+bool HybridProtocol::pin_key_route(const std::string& key, ReplicationMode mode) {
+    return execute_key_pin(key, mode, 0, 0, true);
 }
 
-ReplicationMode HybridProtocol::decide_protocol_for_write(const Message& /*request*/) {
-    // Intelligent routing for write requests
+void HybridProtocol::repin_hot_key(const std::string& key) {
+    if (!adaptive_switching_enabled_ || !intelligent_routing_enabled_) {
+        return;
+    }
+    ReplicationMode wanted = get_key_route(key);
+    if (wanted == ReplicationMode::HYBRID_AUTO || get_pinned_route(key) == wanted) {
+        return;
+    }
     
-    if (intelligent_routing_enabled_) {
-        // For high-consistency requirements, prefer quorum
-        if (current_metrics_.pattern == WorkloadPattern::WRITE_HEAVY) {
-            return ReplicationMode::QUORUM_ONLY;
+    // A pin is held for the dwell time, like a mode
+    uint64_t pinned_us = 0;
+    {
+        std::lock_guard<std::mutex> lock(key_routes_mutex_);
+        auto it = key_routes_.find(key);
+        if (it != key_routes_.end()) {
+            pinned_us = it->second.pinned_us;
         }
-        
-        // For sequential writes, prefer chain
-        if (current_metrics_.pattern == WorkloadPattern::BURSTY) {
-            return ReplicationMode::CHAIN_ONLY;
+    }
+    if (pinned_us != 0) {
+        std::lock_guard<std::mutex> lock(metrics_mutex_);
+        if (monotonic_now_us() < pinned_us + min_mode_dwell_us_) {
+            return;
         }
     }
-    
-    return write_preference_;
+    pin_key_route(key, wanted);
 }
 
 bool HybridProtocol::should_switch_mode(ReplicationMode target_mode) {
-    return target_mode != current_mode_;
+    // Caller holds metrics_mutex_
+    ReplicationMode current = current_mode_.load();
+    if (target_mode == current) {
+        candidate_votes_ = 0; // the workload swung back
+        return false;
+    }
+    
+    // Hysteresis: the same target has to win several evaluations in a row
+    if (target_mode != candidate_mode_) {
+        candidate_mode_ = target_mode;
+        candidate_votes_ = 0;
+    }
+    if (++candidate_votes_ < switch_confirmations_) {
+        return false;
+    }
+    
+    // Dwell time since the last switch
+    if (last_switch_us_ != 0 && monotonic_now_us() < last_switch_us_ + min_mode_dwell_us_) {
+        return false;
+    }
+    
+    return switch_pays_off(current, target_mode);
+}
+
+bool HybridProtocol::switch_pays_off(ReplicationMode from, ReplicationMode to) const {
+    // Caller holds metrics_mutex_
+    LatencySummary from_latency = latency_for_mode(from);
+    LatencySummary to_latency = latency_for_mode(to);
+    if (from_latency.count < kMinLatencySamples || to_latency.count < kMinLatencySamples) {
+        return true; // nothing to predict with; hysteresis alone gates the switch
+    }
+    
+    // Same per-operation cost as select_optimal_mode: median plus tail
+    double gain_per_op = static_cast<double>(from_latency.p50_ns + from_latency.p99_ns) -
+                         static_cast<double>(to_latency.p50_ns + to_latency.p99_ns);
+    if (gain_per_op <= 0.0) {
+        return false;
+    }
+    double expected_gain = gain_per_op * current_metrics_.throughput * switch_horizon_s_;
+    
+    // Operations arriving during a switch each wait out roughly its duration
+    double stalled_ops = std::max(1.0, current_metrics_.throughput * switch_cost_ns_ / 1e9);
+    double switch_cost = switch_cost_ns_ * stalled_ops;
+    
+    if (expected_gain <= switch_cost) {
+        LOG_DEBUG("Skipping mode switch: predicted gain " + std::to_string(expected_gain) +
+                  "ns below switch cost " + std::to_string(switch_cost) + "ns");
+        return false;
+    }
+    return true;
+}
+
+LatencySummary HybridProtocol::latency_for_mode(ReplicationMode mode) const {
+    // Auto mode mixes both protocols, so its cost is the overall distribution
+    if (mode == ReplicationMode::HYBRID_AUTO) {
+        return latency_monitor_->get_overall_latency_summary();
+    }
+    return latency_monitor_->get_mode_latency_summary(mode);
+}
+
+std::vector<uint32_t> HybridProtocol::replica_peers() {
+    std::lock_guard<std::mutex> lock(coherence_mutex_);
+    return coherence_peers_;
 }
 
 bool HybridProtocol::try_cache_read(const std::string& key, std::string& value) {
-    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return read_cache_->get(key, value);
+}
+
+void HybridProtocol::update_cache(const std::string& key, const std::string& value, uint64_t version) {
+    // May be declined by admission control or as stale; the read itself
+    // already succeeded
+    read_cache_->put(key, value, version);
+}
+
+void HybridProtocol::configure_cache(const ReadCacheConfig& config) {
+    read_cache_ = std::make_unique<ReadCache>(config);
+    LOG_INFO("Read cache configured: " + std::to_string(config.max_entries) + " entries, " +
+             std::to_string(config.max_bytes) + " bytes, ttl " + std::to_string(config.ttl_us) + "us");
+}
+
+uint64_t HybridProtocol::advance_cache_version(uint64_t observed) {
+    uint64_t current = cache_version_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        next = std::max(current, observed) + 1;
+    } while (!cache_version_.compare_exchange_weak(current, next, std::memory_order_acq_rel));
+    return next;
+}
+
+void HybridProtocol::publish_invalidation(const std::string& key, uint64_t commit_index) {
+    uint64_t version = advance_cache_version(commit_index);
+    read_cache_->invalidate(key, version);
     
-    auto it = cache_.find(key);
-    if (it != cache_.end()) {
-        auto current_time = std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-        
-        if (current_time - it->second.second < cache_ttl_) {
-            value = it->second.first;
-            return true;
-        } else {
-            // Entry expired
-            cache_.erase(it);
+    if (!cache_coherence_enabled_) {
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(coherence_mutex_);
+    if (coherence_peers_.empty()) {
+        return;
+    }
+    
+    Message invalidation;
+    invalidation.key = key;
+    invalidation.log_index = version;
+    pending_invalidations_.push_back(std::move(invalidation));
+    
+    if (pending_invalidations_.size() >= cache_update_batch_size_) {
+        send_invalidations(lock);
+    } else if (pending_invalidations_.size() == 1) {
+        oldest_invalidation_us_ = monotonic_now_us();
+        coherence_cv_.notify_one();
+    }
+}
+
+void HybridProtocol::send_invalidations(std::unique_lock<std::mutex>& lock) {
+    // Caller holds coherence_mutex_ through lock
+    if (pending_invalidations_.empty()) {
+        return;
+    }
+    
+    std::vector<Message> batch;
+    batch.swap(pending_invalidations_);
+    std::vector<uint32_t> peers = coherence_peers_;
+    lock.unlock();
+    
+    // One key travels inline; more are packed as frames in the value
+    Message update;
+    update.type = MessageType::CACHE_UPDATE;
+    update.sender_id = node_->get_node_id();
+    update.timestamp = monotonic_now_us();
+    update.sequence_number = static_cast<uint32_t>(batch.size());
+    if (batch.size() == 1) {
+        update.key = std::move(batch.front().key);
+        update.log_index = batch.front().log_index;
+    } else {
+        for (const auto& invalidation : batch) {
+            invalidation.serialize_to(update.value.mutable_str());
+            update.log_index = std::max(update.log_index, invalidation.log_index);
         }
     }
     
-    return false;
+    update.partition_id = partition_id_;
+    for (uint32_t peer : peers) {
+        update.receiver_id = peer;
+        node_->send_message(peer, update);
+    }
+    cache_updates_sent_.fetch_add(1);
+    
+    lock.lock();
 }
 
-void HybridProtocol::update_cache(const std::string& key, const std::string& value) {
-    std::lock_guard<std::mutex> lock(cache_mutex_);
+void HybridProtocol::handle_cache_update(const Message& message) {
+    if (message.sender_id == node_->get_node_id()) {
+        return;
+    }
     
-    auto current_time = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    // Versions are re-stamped on the local clock so they order against reads
+    // that are already in flight here
+    if (message.value.empty()) {
+        read_cache_->invalidate(message.key, advance_cache_version(message.log_index));
+        return;
+    }
     
-    cache_[key] = std::make_pair(value, current_time);
+    const char* frame = message.value.data();
+    size_t remaining = message.value.size();
+    while (remaining > 0) {
+        size_t frame_length = wire::frame_size(frame, remaining);
+        if (frame_length == 0 || frame_length > remaining) {
+            // Drop what we cannot decode; the cache TTL remains the backstop
+            LOG_WARNING("Truncated cache update from node " + std::to_string(message.sender_id));
+            return;
+        }
+        MessageView invalidation;
+        if (MessageView::parse(frame, frame_length, invalidation)) {
+            read_cache_->invalidate(std::string(invalidation.key),
+                                    advance_cache_version(invalidation.log_index));
+        }
+        frame += frame_length;
+        remaining -= frame_length;
+    }
+}
+
+void HybridProtocol::flush_cache_updates() {
+    std::unique_lock<std::mutex> lock(coherence_mutex_);
+    send_invalidations(lock);
+}
+
+void HybridProtocol::set_cache_update_batch(size_t max_keys, uint64_t max_delay_us) {
+    std::lock_guard<std::mutex> lock(coherence_mutex_);
+    cache_update_batch_size_ = std::max<size_t>(1, max_keys);
+    cache_update_max_delay_us_ = max_delay_us;
+    coherence_cv_.notify_one();
+}
+
+void HybridProtocol::coherence_flush_loop() {
+    std::unique_lock<std::mutex> lock(coherence_mutex_);
+    while (!coherence_stopping_) {
+        coherence_cv_.wait(lock, [this]() { return coherence_stopping_ || !pending_invalidations_.empty(); });
+        if (coherence_stopping_) {
+            break;
+        }
+        
+        // Partial batches leave once their oldest invalidation reaches the max delay
+        auto deadline = std::chrono::steady_clock::time_point(
+            std::chrono::microseconds(oldest_invalidation_us_ + cache_update_max_delay_us_));
+        coherence_cv_.wait_until(lock, deadline, [this]() {
+            return coherence_stopping_ || pending_invalidations_.empty();
+        });
+        if (!pending_invalidations_.empty() &&
+            monotonic_now_us() >= oldest_invalidation_us_ + cache_update_max_delay_us_) {
+            send_invalidations(lock);
+        }
+    }
     
-    // Cleanup old entries if cache gets too large
-    if (cache_.size() > 1000) {
-        auto oldest = cache_.begin();
-        for (auto it = cache_.begin(); it != cache_.end(); ++it) {
-            if (it->second.second < oldest->second.second) {
-                oldest = it;
+    // Announce what is left rather than leave peers to the TTL
+    send_invalidations(lock);
+}
+
+void HybridProtocol::refresh_coherence_peers() {
+    std::vector<uint32_t> peers = chain_protocol_->get_chain_order();
+    std::vector<uint32_t> quorum = quorum_protocol_->get_quorum_nodes();
+    peers.insert(peers.end(), quorum.begin(), quorum.end());
+    std::sort(peers.begin(), peers.end());
+    peers.erase(std::unique(peers.begin(), peers.end()), peers.end());
+    peers.erase(std::remove(peers.begin(), peers.end(), node_->get_node_id()), peers.end());
+    
+    std::lock_guard<std::mutex> lock(coherence_mutex_);
+    coherence_peers_ = std::move(peers);
+}
+
+void HybridProtocol::enable_speculative_execution(bool enable) {
+    if (enable) {
+        std::lock_guard<std::mutex> lock(read_task_mutex_);
+        if (read_workers_.empty()) {
+            size_t workers = std::max(2u, std::thread::hardware_concurrency());
+            for (size_t i = 0; i < workers; ++i) {
+                read_workers_.emplace_back(&HybridProtocol::read_worker_loop, this);
             }
         }
-        cache_.erase(oldest);
     }
+    speculative_execution_enabled_ = enable;
 }
 
-void HybridProtocol::process_batched_requests() {
-    // Process batched read and write requests
-    if (!request_batching_enabled_) return;
+void HybridProtocol::set_hedge_policy(size_t max_inflight, uint64_t min_delay_us) {
+    max_inflight_hedges_ = max_inflight;
+    min_hedge_delay_us_ = min_delay_us;
+}
+
+bool HybridProtocol::hedged_read(const Message& request, Message& response, ReplicationMode mode) {
+    auto read = std::make_shared<HedgedRead>();
+    {
+        std::lock_guard<std::mutex> lock(read_task_mutex_);
+        read_tasks_.emplace_back([this, read, request, mode]() {
+            Message answer;
+            bool found = mode == ReplicationMode::CHAIN_ONLY ?
+                         chain_protocol_->process_read(request, answer) :
+                         quorum_protocol_->process_read(request, answer);
+            finish_hedge_attempt(*read, answer, found, false);
+        });
+    }
+    read_task_cv_.notify_one();
+    
+    auto hedge_at = std::chrono::steady_clock::now() + std::chrono::microseconds(hedge_delay_us(mode));
+    std::unique_lock<std::mutex> lock(read->mutex);
+    if (!read->cv.wait_until(lock, hedge_at, [&read]() { return read->done; })) {
+        lock.unlock();
+        send_hedge(request, mode, read);
+        lock.lock();
+        
+        read->cv.wait(lock, [&read]() { return read->done || read->primary_answered; });
+        if (!read->done) {
+            // The primary missed; give the duplicate a bounded time to find the key
+            read->cv.wait_for(lock, std::chrono::milliseconds(kHedgeResponseTimeoutMs),
+                              [&read]() { return read->done; });
+        }
+    }
+    response = read->response;
+    bool hedge_won = read->hedge_won;
+    uint32_t hedge_id = read->hedge_id;
+    lock.unlock();
+    
+    if (hedge_id != 0) {
+        // Whoever drops the entry releases its slot under the cap
+        std::lock_guard<std::mutex> hedges(hedge_mutex_);
+        if (hedged_reads_.erase(hedge_id) > 0) {
+            hedges_inflight_.fetch_sub(1);
+        }
+    }
+    if (hedge_won) {
+        hedge_wins_.fetch_add(1);
+        response.sequence_number = request.sequence_number;
+        response.metadata.clear();
+        LOG_DEBUG("Hedged read won for key: " + request.key);
+    }
+    return response.success;
+}
+
+bool HybridProtocol::send_hedge(const Message& request, ReplicationMode mode,
+                                const std::shared_ptr<HedgedRead>& read) {
+    // The in-flight cap bounds how much extra load hedging can add
+    size_t inflight = hedges_inflight_.load();
+    do {
+        if (inflight >= max_inflight_hedges_) {
+            return false;
+        }
+    } while (!hedges_inflight_.compare_exchange_weak(inflight, inflight + 1));
+    
+    uint32_t peer = select_hedge_replica(mode);
+    uint32_t hedge_id = next_hedge_id_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(read->mutex);
+        if (peer == 0 || read->done) {
+            hedges_inflight_.fetch_sub(1);
+            return false;
+        }
+        ++read->outstanding;
+        read->hedge_id = hedge_id;
+    }
+    {
+        std::lock_guard<std::mutex> lock(hedge_mutex_);
+        hedged_reads_[hedge_id] = read;
+    }
+    
+    Message hedge;
+    hedge.type = MessageType::READ_REQUEST;
+    hedge.sender_id = node_->get_node_id();
+    hedge.receiver_id = peer;
+    hedge.timestamp = monotonic_now_us();
+    hedge.sequence_number = hedge_id;
+    hedge.key = request.key;
+    hedge.log_index = static_cast<uint64_t>(mode);
+    hedge.metadata = kHedgedReadTag;
+    peer_telemetry_->on_request_sent(peer, PeerTelemetry::token(static_cast<uint32_t>(MessageType::READ_REQUEST),
+                                                                hedge_id));
+    hedge.partition_id = partition_id_;
+    node_->send_message(peer, hedge);
+    
+    hedged_reads_sent_.fetch_add(1);
+    LOG_DEBUG("Hedged read for key " + request.key + " sent to node " + std::to_string(peer));
+    return true;
+}
+
+void HybridProtocol::finish_hedge_attempt(HedgedRead& read, Message& answer, bool found, bool from_hedge) {
+    {
+        std::lock_guard<std::mutex> lock(read.mutex);
+        if (read.done) {
+            return;
+        }
+        --read.outstanding;
+        if (!from_hedge) {
+            read.primary_answered = true;
+        }
+        if (found || read.outstanding == 0) {
+            read.response = std::move(answer);
+            read.response.success = found;
+            read.hedge_won = from_hedge && found;
+            read.done = true;
+        } else if (!from_hedge) {
+            read.response = std::move(answer); // kept in case the duplicate misses too
+        }
+    }
+    read.cv.notify_all();
+}
+
+void HybridProtocol::handle_hedged_read(const Message& request) {
+    if (request.metadata != kHedgedReadTag) {
+        return;
+    }
     
-    std::lock_guard<std::mutex> lock(batch_mutex_);
+    // Served from committed local state only, so the message thread never
+    // blocks on a tail query or a quorum round
+    Message answer;
+    bool answered = request.log_index == static_cast<uint64_t>(ReplicationMode::CHAIN_ONLY) ?
+                    chain_protocol_->serve_local_read(request, answer) :
+                    quorum_protocol_->serve_local_read(request, answer);
+    
+    answer.type = MessageType::READ_RESPONSE;
+    answer.sender_id = node_->get_node_id();
+    answer.receiver_id = request.sender_id;
+    answer.timestamp = monotonic_now_us();
+    answer.sequence_number = request.sequence_number;
+    answer.key = request.key;
+    answer.metadata = kHedgedReadTag;
+    answer.success = answered && answer.success && node_->is_serving();
+    answer.partition_id = partition_id_;
+    node_->send_message(request.sender_id, answer);
+}
+
+void HybridProtocol::handle_hedged_read_response(const Message& response) {
+    if (response.metadata != kHedgedReadTag) {
+        return;
+    }
+    // Counted even when the read already returned; the peer was just slow
+    peer_telemetry_->on_reply_received(response.sender_id,
+        PeerTelemetry::token(static_cast<uint32_t>(MessageType::READ_REQUEST), response.sequence_number));
+    
+    std::shared_ptr<HedgedRead> read;
+    {
+        std::lock_guard<std::mutex> lock(hedge_mutex_);
+        auto it = hedged_reads_.find(response.sequence_number);
+        if (it == hedged_reads_.end()) {
+            return; // the read already returned
+        }
+        read = std::move(it->second);
+        hedged_reads_.erase(it);
+        hedges_inflight_.fetch_sub(1);
+    }
     
-    // Process read batch
-    if (!pending_reads_.empty()) {
-        LOG_DEBUG("Processing read batch of size " + std::to_string(pending_reads_.size()));
-        // Implementation would batch process reads
-        pending_reads_.clear();
+    Message answer = response;
+    finish_hedge_attempt(*read, answer, response.success, true);
+}
+
+uint64_t HybridProtocol::hedge_delay_us(ReplicationMode mode) {
+    uint64_t now = monotonic_now_us();
+    uint64_t refresh_at = hedge_delay_refresh_us_.load(std::memory_order_relaxed);
+    if (now >= refresh_at &&
+        hedge_delay_refresh_us_.compare_exchange_strong(refresh_at, now + kHedgeDelayRefreshUs)) {
+        // Merging the histograms is too costly to do on every read
+        const ReplicationMode modes[2] = {ReplicationMode::CHAIN_ONLY, ReplicationMode::QUORUM_ONLY};
+        for (size_t i = 0; i < 2; ++i) {
+            LatencySummary latency = latency_monitor_->get_mode_latency_summary(modes[i]);
+            hedge_delay_us_[i].store(latency.count >= kMinLatencySamples ? latency.p95_ns / 1000 : 0,
+                                     std::memory_order_relaxed);
+        }
+    }
+    size_t index = mode == ReplicationMode::CHAIN_ONLY ? 0 : 1;
+    return std::max(min_hedge_delay_us_, hedge_delay_us_[index].load(std::memory_order_relaxed));
+}
+
+uint32_t HybridProtocol::select_hedge_replica(ReplicationMode mode) {
+    std::shared_ptr<NetworkManager> network = node_->get_network_manager();
+    
+    // A quorum follower has no linearizable local answer, so outside LOCAL
+    // reads only the leaseholder is worth hedging to
+    if (mode != ReplicationMode::CHAIN_ONLY &&
+        quorum_protocol_->get_read_mode() != QuorumReadMode::LOCAL) {
+        uint32_t leaseholder = quorum_protocol_->get_leaseholder();
+        if (leaseholder == 0 || leaseholder == node_->get_node_id() ||
+            (network && !network->is_node_reachable(leaseholder))) {
+            return 0;
+        }
+        return leaseholder;
     }
     
-    // Process write batch
-    if (!pending_writes_.empty()) {
-        LOG_DEBUG("Processing write batch of size " + std::to_string(pending_writes_.size()));
-        // Implementation would batch process writes
-        pending_writes_.clear();
+    std::vector<uint32_t> replicas = mode == ReplicationMode::CHAIN_ONLY ?
+                                     chain_protocol_->get_chain_order() :
+                                     quorum_protocol_->get_quorum_nodes();
+    std::vector<uint32_t> candidates;
+    for (uint32_t peer : replicas) {
+        if (peer != node_->get_node_id() && (!network || network->is_node_reachable(peer))) {
+            candidates.push_back(peer);
+        }
     }
+    // Two random choices rather than the best-scored peer, so every hedger
+    // does not pile onto the same replica between samples
+    return peer_telemetry_->pick_two(candidates);
 }
 
-void HybridProtocol::start_speculative_read(const Message& request) {
-    // Start speculative read operations for performance
-    LOG_DEBUG("Starting speculative read for key: " + request.key);
-    // Implementation would predict and prefetch related data
+void HybridProtocol::read_worker_loop() {
+    std::unique_lock<std::mutex> lock(read_task_mutex_);
+    while (true) {
+        read_task_cv_.wait(lock, [this]() { return read_workers_stopping_ || !read_tasks_.empty(); });
+        if (read_tasks_.empty()) {
+            return; // stopping, and every queued primary has run
+        }
+        std::function<void()> task = std::move(read_tasks_.front());
+        read_tasks_.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
 }
 
 void HybridProtocol::start_speculative_write(const Message& request) {
@@ -428,8 +1693,13 @@ uint32_t HybridProtocol::select_optimal_replica_for_read() {
         return 0; // Default to local node
     }
     
-    // Would implement sophisticated load balancing algorithm
-    return 0;
+    // With CRAQ every chain member serves clean reads, so a local replica
+    // wins and everyone else picks the less loaded of two chain members
+    std::vector<uint32_t> chain = chain_protocol_->get_chain_order();
+    if (std::find(chain.begin(), chain.end(), node_->get_node_id()) != chain.end()) {
+        return node_->get_node_id();
+    }
+    return peer_telemetry_->pick_two(chain);
 }
 
 std::vector<uint32_t> HybridProtocol::select_optimal_nodes_for_write() {
@@ -440,31 +1710,40 @@ std::vector<uint32_t> HybridProtocol::select_optimal_nodes_for_write() {
         return optimal_nodes;
     }
     
-    // Would implement sophisticated node selection algorithm
+    // The majority with the lowest load scores; this node first when it is a
+    // member, since its own vote costs no round trip
+    std::vector<uint32_t> quorum = quorum_protocol_->get_quorum_nodes();
+    std::vector<uint32_t> peers;
+    for (uint32_t node_id : quorum) {
+        if (node_id == node_->get_node_id()) {
+            optimal_nodes.push_back(node_id);
+        } else {
+            peers.push_back(node_id);
+        }
+    }
+    size_t majority = (quorum.size() / 2) + 1;
+    for (uint32_t node_id : peer_telemetry_->rank(peers)) {
+        if (optimal_nodes.size() >= majority) {
+            break;
+        }
+        optimal_nodes.push_back(node_id);
+    }
     return optimal_nodes;
 }
 
-void HybridProtocol::update_performance_metrics(const Message& request, uint64_t latency, bool /*success*/) {
-    std::lock_guard<std::mutex> lock(metrics_mutex_);
-    
-    // Update running averages
-    current_metrics_.average_latency = (current_metrics_.average_latency * 0.9) + (latency / 1000.0 * 0.1);
-    
-    // Update throughput calculation would go here
-    
-    // Update read/write ratio
-    static size_t read_count = 0;
-    static size_t write_count = 0;
-    
-    if (request.is_read_operation()) {
-        read_count++;
-    } else if (request.is_write_operation()) {
-        write_count++;
-    }
+void HybridProtocol::update_performance_metrics(const Message& request, ReplicationMode mode,
+                                                uint64_t latency_ns, bool success) {
+    // Lock-free; select_optimal_mode() reads the merged distributions
+    latency_monitor_->record_operation(request.type, mode, latency_ns, success);
+    refresh_read_write_ratio();
+}
+
+void HybridProtocol::refresh_read_write_ratio() {
+    // The decayed ratio comes from the key tracker fed on every operation
+    double ratio = key_heat_->read_write_ratio();
     
-    if (write_count > 0) {
-        current_metrics_.read_write_ratio = static_cast<double>(read_count) / write_count;
-    }
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    current_metrics_.read_write_ratio = ratio;
 }
 
 WorkloadPattern HybridProtocol::analyze_workload_pattern() {
@@ -0,0 +1,187 @@
+#include "protocols/partitioned_replication.h"
+#include "utils/clock.h"
+#include "utils/logger.h"
+
+namespace replication {
+
+PartitionedReplication::PartitionedReplication(std::shared_ptr<Node> node, const PartitionConfig& config)
+    : node_(node)
+    , map_(std::make_shared<const PartitionMap>(node->get_cluster_nodes(), config)) {
+    groups_.resize(map_->get_partition_count());
+    local_partitions_ = map_->partitions_of(node_->get_node_id());
+
+    std::shared_ptr<const PartitionMap> map = map_;
+    for (uint32_t partition : local_partitions_) {
+        const std::vector<uint32_t>& replicas = map_->replicas(partition);
+        auto group = std::make_shared<HybridProtocol>(node_, replicas, replicas);
+        group->set_partition(partition, [map, partition](const std::string& key) {
+            return map->partition_for(key) == partition;
+        });
+        group->set_quorum_leader(map_->leader(partition));
+        groups_[partition] = std::move(group);
+    }
+
+    LOG_INFO("Node " + std::to_string(node_->get_node_id()) + " replicates " +
+             std::to_string(local_partitions_.size()) + " of " + std::to_string(map_->get_partition_count()) +
+             " partitions and leads " + std::to_string(map_->partitions_led_by(node_->get_node_id()).size()));
+}
+
+std::shared_ptr<HybridProtocol> PartitionedReplication::get_group(uint32_t partition) const {
+    return partition < groups_.size() ? groups_[partition] : nullptr;
+}
+
+void PartitionedReplication::for_each_group(const std::function<void(uint32_t, HybridProtocol&)>& apply) {
+    for (uint32_t partition : local_partitions_) {
+        apply(partition, *groups_[partition]);
+    }
+}
+
+HybridProtocol* PartitionedReplication::group_for_key(const std::string& key, uint32_t& partition) const {
+    partition = map_->partition_for(key);
+    return groups_[partition].get();
+}
+
+void PartitionedReplication::refuse(const Message& request, uint32_t partition, MessageType type,
+                                    Message& response) const {
+    response.type = type;
+    response.sender_id = node_->get_node_id();
+    response.timestamp = monotonic_now_us();
+    response.key = request.key;
+    response.sequence_number = request.sequence_number;
+    response.partition_id = partition;
+    response.target_nodes = map_->replicas(partition);
+    response.success = false;
+}
+
+bool PartitionedReplication::process_read(const Message& request, Message& response) {
+    uint32_t partition = 0;
+    HybridProtocol* group = group_for_key(request.key, partition);
+    if (!group) {
+        refuse(request, partition, MessageType::READ_RESPONSE, response);
+        return false;
+    }
+    return group->process_read(request, response);
+}
+
+bool PartitionedReplication::process_write(const Message& request, Message& response) {
+    uint32_t partition = 0;
+    HybridProtocol* group = group_for_key(request.key, partition);
+    if (!group) {
+        refuse(request, partition, MessageType::WRITE_RESPONSE, response);
+        return false;
+    }
+    return group->process_write(request, response);
+}
+
+bool PartitionedReplication::multi_get(const std::vector<std::string>& keys, std::vector<Message>& responses) {
+    responses.assign(keys.size(), Message());
+    std::vector<std::vector<size_t>> slots(groups_.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        slots[map_->partition_for(keys[i])].push_back(i);
+    }
+
+    bool all_succeeded = true;
+    std::vector<std::string> batch;
+    std::vector<Message> batch_responses;
+    for (uint32_t partition = 0; partition < slots.size(); ++partition) {
+        const std::vector<size_t>& indices = slots[partition];
+        if (indices.empty()) {
+            continue;
+        }
+        if (!groups_[partition]) {
+            for (size_t index : indices) {
+                Message request;
+                request.key = keys[index];
+                refuse(request, partition, MessageType::READ_RESPONSE, responses[index]);
+            }
+            all_succeeded = false;
+            continue;
+        }
+        batch.clear();
+        for (size_t index : indices) {
+            batch.push_back(keys[index]);
+        }
+        all_succeeded = groups_[partition]->multi_get(batch, batch_responses) && all_succeeded;
+        for (size_t i = 0; i < indices.size(); ++i) {
+            responses[indices[i]] = std::move(batch_responses[i]);
+        }
+    }
+    return all_succeeded;
+}
+
+bool PartitionedReplication::multi_put(const std::vector<std::pair<std::string, std::string>>& entries,
+                                       std::vector<Message>& responses) {
+    responses.assign(entries.size(), Message());
+    std::vector<std::vector<size_t>> slots(groups_.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        slots[map_->partition_for(entries[i].first)].push_back(i);
+    }
+
+    bool all_succeeded = true;
+    std::vector<std::pair<std::string, std::string>> batch;
+    std::vector<Message> batch_responses;
+    for (uint32_t partition = 0; partition < slots.size(); ++partition) {
+        const std::vector<size_t>& indices = slots[partition];
+        if (indices.empty()) {
+            continue;
+        }
+        if (!groups_[partition]) {
+            for (size_t index : indices) {
+                Message request;
+                request.key = entries[index].first;
+                refuse(request, partition, MessageType::WRITE_RESPONSE, responses[index]);
+            }
+            all_succeeded = false;
+            continue;
+        }
+        batch.clear();
+        for (size_t index : indices) {
+            batch.push_back(entries[index]);
+        }
+        all_succeeded = groups_[partition]->multi_put(batch, batch_responses) && all_succeeded;
+        for (size_t i = 0; i < indices.size(); ++i) {
+            responses[indices[i]] = std::move(batch_responses[i]);
+        }
+    }
+    return all_succeeded;
+}
+
+void PartitionedReplication::handle_message(const Message& message) {
+    uint32_t partition = message.partition_id;
+    if (message.type == MessageType::READ_REQUEST || message.type == MessageType::WRITE_REQUEST) {
+        partition = map_->partition_for(message.key);
+    }
+    if (partition >= groups_.size() || !groups_[partition]) {
+        LOG_DEBUG("Dropping message type " + std::to_string(static_cast<int>(message.type)) + " from node " +
+                  std::to_string(message.sender_id) + " for partition " + std::to_string(partition) +
+                  ", not replicated here");
+        return;
+    }
+    groups_[partition]->handle_message(message);
+}
+
+void PartitionedReplication::handle_node_failure(uint32_t failed_node) {
+    for (uint32_t partition : local_partitions_) {
+        if (map_->replicates(failed_node, partition)) {
+            groups_[partition]->handle_node_failure(failed_node);
+        }
+    }
+}
+
+void PartitionedReplication::handle_node_recovery(uint32_t recovered_node) {
+    for (uint32_t partition : local_partitions_) {
+        if (map_->replicates(recovered_node, partition)) {
+            groups_[partition]->handle_node_recovery(recovered_node);
+        }
+    }
+}
+
+void PartitionedReplication::readmit_node(uint32_t node_id) {
+    for (uint32_t partition : local_partitions_) {
+        if (map_->replicates(node_id, partition)) {
+            groups_[partition]->readmit_node(node_id);
+        }
+    }
+}
+
+} // namespace replication
@@ -1,20 +1,86 @@
 #include "protocols/quorum_replication.h"
+#include "utils/clock.h"
 #include "utils/logger.h"
 #include <algorithm>
 #include <chrono>
-#include <thread>
+#include <future>
 
 namespace replication {
 
+namespace {
+
+// Marks a QUORUM_ACCEPT whose value packs a batch of writes into one slot
+const std::string kQuorumBatchTag = "quorum_batch";
+
+// Committed slots an acceptor keeps so it can still answer a candidate whose
+// commit index lags behind its own
+constexpr uint64_t kRetainedCommittedSlots = 1024;
+
+} // namespace
+
+LogSlot& PaxosLog::append(uint64_t ballot, const std::string& key, const std::string& value) {
+    LogSlot slot;
+    slot.index = next_index();
+    slot.ballot = ballot;
+    slot.key = key;
+    slot.value = value;
+    slot.start_time = monotonic_now_us();
+    slot.completion = std::make_shared<std::promise<bool>>();
+    slots_.push_back(std::move(slot));
+    return slots_.back();
+}
+
+LogSlot* PaxosLog::find(uint64_t index) {
+    if (index < first_index_ || index >= next_index()) {
+        return nullptr;
+    }
+    return &slots_[index - first_index_];
+}
+
+void PaxosLog::pop_front() {
+    slots_.pop_front();
+    ++first_index_;
+}
+
+std::deque<LogSlot> PaxosLog::truncate(uint64_t next_index) {
+    std::deque<LogSlot> dropped;
+    dropped.swap(slots_);
+    first_index_ = next_index;
+    return dropped;
+}
+
 QuorumReplication::QuorumReplication(std::shared_ptr<Node> node, const std::vector<uint32_t>& quorum_nodes)
     : node_(node)
     , quorum_nodes_(quorum_nodes)
     , quorum_size_((quorum_nodes.size() / 2) + 1)
+    , partition_id_(0)
     , next_proposal_number_(1)
     , fast_quorum_enabled_(true)
     , read_optimization_enabled_(true)
     , adaptive_quorum_enabled_(true)
     , operation_timeout_(5000) // 5 seconds
+    , current_ballot_(0)
+    , highest_seen_ballot_(0)
+    , phase1_complete_(false)
+    , phase1_in_progress_(false)
+    , commit_index_(0)
+    , recovery_index_(0)
+    , max_inflight_accepts_(32)
+    , promised_ballot_(0)
+    , accepted_index_(0)
+    , read_mode_(QuorumReadMode::LEASE)
+    , lease_duration_us_(1000000) // 1 second
+    , max_clock_drift_us_(50000)  // 50ms
+    , lease_expiry_us_(0)
+    , lease_grant_ballot_(0)
+    , lease_grant_expiry_us_(0)
+    , preferred_leader_(0)
+    , open_read_round_(0)
+    , inflight_read_round_(0)
+    , lease_reads_(0)
+    , read_index_reads_(0)
+    , read_index_rounds_sent_(0)
+    , peer_telemetry_(std::make_shared<PeerTelemetry>())
     , successful_consensus_(0)
     , failed_consensus_(0) {
     
@@ -46,7 +112,7 @@ bool QuorumReplication::process_read(const Message& request, Message& response)
         }
     }
     
-    // Fast path for read optimization
+    // Fast path: this replica's committed state, which may trail the leader
     if (read_optimization_enabled_ && can_use_fast_path(request)) {
         std::string value;
         if (node_->read(request.key, value)) {
@@ -57,8 +123,26 @@ bool QuorumReplication::process_read(const Message& request, Message& response)
         }
     }
     
+    // Linearizable read on the leader through its lease or a ReadIndex round
+    if (read_mode_ != QuorumReadMode::PREPARE_ROUND) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(operation_timeout_);
+        std::string value;
+        bool found = false;
+        if (serve_linearizable_read(request.key, value, found, deadline)) {
+            response.success = found;
+            if (found) {
+                response.value = value;
+                successful_consensus_.fetch_add(1);
+            } else {
+                failed_consensus_.fetch_add(1);
+            }
+            LOG_DEBUG("Leader read for key: " + request.key + (found ? "" : " (not found)"));
+            return found;
+        }
+    }
+    
     // Consensus-based read for strong consistency
-    auto start_time = std::chrono::high_resolution_clock::now();
+    auto start_time = std::chrono::steady_clock::now();
     
     // Generate proposal number for read consensus
     uint64_t proposal_num = generate_proposal_number();
@@ -68,47 +152,42 @@ bool QuorumReplication::process_read(const Message& request, Message& response)
     read_state.proposal_number = proposal_num;
     read_state.phase = QuorumPhase::PREPARE;
     read_state.key = request.key;
-    read_state.start_time = std::chrono::duration_cast<std::chrono::microseconds>(
-        start_time.time_since_epoch()).count();
+    read_state.start_time = monotonic_now_us();
+    read_state.promised_nodes.insert(node_->get_node_id());
+    // Hold the promise so the round may be cleaned up while we wait
+    std::shared_ptr<std::promise<bool>> completion = read_state.completion;
+    std::future<bool> promised = completion->get_future();
     
     {
         std::lock_guard<std::mutex> lock(consensus_mutex_);
-        active_proposals_[proposal_num] = read_state;
+        prepare_rounds_[proposal_num] = std::move(read_state);
     }
     
-    // Send prepare messages
-    if (send_prepare_messages(proposal_num, request.key)) {
-        // Wait for consensus or timeout
-        auto timeout = start_time + std::chrono::milliseconds(operation_timeout_);
+    // Read rounds carry no ballot so they never depose the leader
+    send_prepare_messages(proposal_num, 0, request.key);
+    
+    // handle_promise() completes the round as soon as a majority arrives
+    auto timeout = start_time + std::chrono::milliseconds(operation_timeout_);
+    bool majority = promised.wait_until(timeout) == std::future_status::ready && promised.get();
+    
+    {
+        std::lock_guard<std::mutex> lock(consensus_mutex_);
+        prepare_rounds_.erase(proposal_num);
         
-        while (std::chrono::high_resolution_clock::now() < timeout) {
-            std::lock_guard<std::mutex> lock(consensus_mutex_);
-            auto it = active_proposals_.find(proposal_num);
-            if (it != active_proposals_.end() && it->second.has_majority(quorum_nodes_.size())) {
-                // Read consensus successful
-                std::string value;
-                if (node_->read(request.key, value)) {
-                    response.value = value;
-                    response.success = true;
-                    successful_consensus_.fetch_add(1);
-                    
-                    auto end_time = std::chrono::high_resolution_clock::now();
-                    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
-                        end_time - start_time).count();
-                    consensus_times_.push_back(duration);
-                    
-                    LOG_DEBUG("Quorum read successful for key: " + request.key);
-                    active_proposals_.erase(it);
-                    return true;
-                }
-                break;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::string value;
+        if (majority && node_->read(request.key, value)) {
+            response.value = value;
+            response.success = true;
+            successful_consensus_.fetch_add(1);
+            
+            auto end_time = std::chrono::steady_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+                end_time - start_time).count();
+            consensus_times_.push_back(duration);
+            
+            LOG_DEBUG("Quorum read successful for key: " + request.key);
+            return true;
         }
-        
-        // Cleanup on timeout/failure
-        std::lock_guard<std::mutex> lock(consensus_mutex_);
-        active_proposals_.erase(proposal_num);
     }
     
     response.success = false;
@@ -117,6 +196,25 @@ bool QuorumReplication::process_read(const Message& request, Message& response)
     return false;
 }
 
+bool QuorumReplication::serve_local_read(const Message& request, Message& response) {
+    response.type = MessageType::READ_RESPONSE;
+    response.sender_id = node_->get_node_id();
+    response.timestamp = monotonic_now_us();
+    response.key = request.key;
+    response.sequence_number = request.sequence_number;
+    
+    if (quorum_nodes_.size() == 1 || (read_mode_ == QuorumReadMode::LEASE && has_valid_lease())) {
+        response.success = node_->read(request.key, response.value);
+        return true;
+    }
+    // A fast-path miss is not authoritative
+    if (read_optimization_enabled_ && can_use_fast_path(request) && node_->read(request.key, response.value)) {
+        response.success = true;
+        return true;
+    }
+    return false;
+}
+
 bool QuorumReplication::process_write(const Message& request, Message& response) {
     response.type = MessageType::WRITE_RESPONSE;
     response.sender_id = node_->get_node_id();
@@ -139,17 +237,22 @@ bool QuorumReplication::process_write(const Message& request, Message& response)
         return success;
     }
     
-    auto start_time = std::chrono::high_resolution_clock::now();
+    if (refuse_for_leader(request, response)) {
+        return false;
+    }
+    
+    auto start_time = std::chrono::steady_clock::now();
     
     // Initiate consensus for write
     bool success = initiate_consensus(request.key, request.value);
     
     if (success) {
-        auto end_time = std::chrono::high_resolution_clock::now();
+        auto end_time = std::chrono::steady_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
             end_time - start_time).count();
         consensus_times_.push_back(duration);
         successful_consensus_.fetch_add(1);
+        response.log_index = get_commit_index();
         LOG_DEBUG("Quorum write successful for key: " + request.key);
     } else {
         failed_consensus_.fetch_add(1);
@@ -160,6 +263,127 @@ bool QuorumReplication::process_write(const Message& request, Message& response)
     return success;
 }
 
+bool QuorumReplication::process_batch_write(const std::vector<Message>& requests,
+                                            std::vector<Message>& responses) {
+    responses.assign(requests.size(), Message());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        responses[i].type = MessageType::WRITE_RESPONSE;
+        responses[i].sender_id = node_->get_node_id();
+        responses[i].timestamp = monotonic_now_us();
+        responses[i].key = requests[i].key;
+        responses[i].sequence_number = requests[i].sequence_number;
+    }
+    if (requests.empty()) {
+        return true;
+    }
+    
+    // Single node quorums apply directly, as in process_write()
+    if (quorum_nodes_.size() == 1) {
+        bool all_succeeded = true;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            responses[i].success = node_->write(requests[i].key, requests[i].value);
+            all_succeeded = all_succeeded && responses[i].success;
+        }
+        successful_consensus_.fetch_add(1);
+        return all_succeeded;
+    }
+    
+    Message refusal;
+    if (refuse_for_leader(requests.front(), refusal)) {
+        for (Message& response : responses) {
+            response.target_nodes = refusal.target_nodes;
+        }
+        return false;
+    }
+    
+    std::string frames;
+    for (const Message& request : requests) {
+        Message entry;
+        entry.type = MessageType::WRITE_REQUEST;
+        entry.key = request.key;
+        entry.value = request.value;
+        entry.serialize_to(frames);
+    }
+    
+    auto start_time = std::chrono::steady_clock::now();
+    
+    // One consensus instance for the whole batch
+    bool success = initiate_consensus("", frames, true);
+    
+    uint64_t commit_index = 0;
+    if (success) {
+        auto end_time = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            end_time - start_time).count();
+        consensus_times_.push_back(duration);
+        successful_consensus_.fetch_add(1);
+        commit_index = get_commit_index();
+        LOG_DEBUG("Quorum batch of " + std::to_string(requests.size()) + " writes committed");
+    } else {
+        failed_consensus_.fetch_add(1);
+        LOG_ERROR("Quorum batch of " + std::to_string(requests.size()) + " writes failed");
+    }
+    
+    for (Message& response : responses) {
+        response.success = success;
+        response.log_index = commit_index;
+    }
+    return success;
+}
+
+bool QuorumReplication::process_batch_read(const std::vector<Message>& requests,
+                                           std::vector<Message>& responses) {
+    responses.assign(requests.size(), Message());
+    if (requests.empty()) {
+        return true;
+    }
+    
+    // Leadership is confirmed once for the batch, after which every key is
+    // read from the leader's applied state
+    bool confirmed = false;
+    if (quorum_nodes_.size() > 1 && read_mode_ != QuorumReadMode::PREPARE_ROUND) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(operation_timeout_);
+        bool leader = false;
+        bool lease = false;
+        {
+            std::lock_guard<std::mutex> lock(consensus_mutex_);
+            leader = can_serve_reads();
+            lease = leader && read_mode_ == QuorumReadMode::LEASE && monotonic_now_us() < lease_expiry_us_;
+        }
+        if (lease) {
+            confirmed = true;
+            lease_reads_.fetch_add(requests.size(), std::memory_order_relaxed);
+        } else if (leader && confirm_read_index(deadline)) {
+            confirmed = true;
+            read_index_reads_.fetch_add(requests.size(), std::memory_order_relaxed);
+        }
+    }
+    
+    if (!confirmed) {
+        // Not the leader (or a single node): fall back to one read per key
+        bool all_succeeded = true;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            all_succeeded = process_read(requests[i], responses[i]) && all_succeeded;
+        }
+        return all_succeeded;
+    }
+    
+    bool all_found = true;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        Message& response = responses[i];
+        response.type = MessageType::READ_RESPONSE;
+        response.sender_id = node_->get_node_id();
+        response.timestamp = monotonic_now_us();
+        response.key = requests[i].key;
+        response.sequence_number = requests[i].sequence_number;
+        response.success = node_->read(requests[i].key, response.value);
+        all_found = all_found && response.success;
+    }
+    successful_consensus_.fetch_add(1);
+    LOG_DEBUG("Leader read batch of " + std::to_string(requests.size()) + " keys");
+    return all_found;
+}
+
 void QuorumReplication::update_quorum_nodes(const std::vector<uint32_t>& new_nodes) {
     std::lock_guard<std::mutex> lock(consensus_mutex_);
     
@@ -174,6 +398,11 @@ size_t QuorumReplication::get_quorum_size() const {
     return quorum_size_;
 }
 
+std::vector<uint32_t> QuorumReplication::get_quorum_nodes() const {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    return quorum_nodes_;
+}
+
 bool QuorumReplication::is_in_quorum(uint32_t node_id) const {
     return std::find(quorum_nodes_.begin(), quorum_nodes_.end(), node_id) != quorum_nodes_.end();
 }
@@ -185,25 +414,79 @@ void QuorumReplication::handle_prepare(const Message& message) {
     promise_msg.sender_id = node_->get_node_id();
     promise_msg.timestamp = message.get_current_timestamp();
     promise_msg.sequence_number = message.sequence_number;
-    promise_msg.success = true; // Promise to not accept lower numbered proposals
+    promise_msg.ballot = message.ballot;
+    
+    {
+        std::lock_guard<std::mutex> lock(consensus_mutex_);
+        
+        // A follower that granted a lease refuses other candidates until it runs out
+        bool lease_held = message.ballot != 0 && lease_grant_ballot_ != 0 &&
+                          (message.ballot & 0xFFFF) != (lease_grant_ballot_ & 0xFFFF) &&
+                          monotonic_now_us() < lease_grant_expiry_us_;
+        
+        // A candidate that lags past the retained slots could not recover
+        // them from this acceptor; it has to catch up before it can lead
+        bool too_far_behind = message.ballot != 0 && message.log_index + kRetainedCommittedSlots < commit_index_;
+        
+        // Ballot 0 is a read round and does not change the promise
+        if (message.ballot == 0 || (message.ballot >= promised_ballot_ && !lease_held && !too_far_behind)) {
+            promised_ballot_ = std::max(promised_ballot_, message.ballot);
+            promise_msg.success = true;
+            if (message.ballot != 0) {
+                // Every value accepted past the candidate's commit index
+                promise_msg.value = pack_accepted_values(message.log_index);
+                // The candidate's lease starts from this promise, so grant it here
+                if (read_mode_ == QuorumReadMode::LEASE) {
+                    lease_grant_ballot_ = message.ballot;
+                    lease_grant_expiry_us_ = monotonic_now_us() + lease_duration_us_;
+                }
+            }
+        } else {
+            // Tell the proposer which ballot it has to beat
+            promise_msg.ballot = std::max(promised_ballot_, lease_grant_ballot_);
+            promise_msg.success = false;
+        }
+        promise_msg.log_index = accepted_index_;
+    }
     
+    promise_msg.partition_id = partition_id_;
     node_->send_message(message.sender_id, promise_msg);
-    LOG_DEBUG("Sent promise for proposal " + std::to_string(message.sequence_number));
+    LOG_DEBUG("Sent promise for proposal " + std::to_string(message.sequence_number) +
+              (promise_msg.success ? "" : " (rejected)"));
 }
 
 void QuorumReplication::handle_promise(const Message& message) {
+    peer_telemetry_->on_reply_received(message.sender_id,
+        PeerTelemetry::token(static_cast<uint32_t>(MessageType::QUORUM_PREPARE), message.sequence_number));
+    
     // Handle incoming promise message
     std::lock_guard<std::mutex> lock(consensus_mutex_);
     
-    auto it = active_proposals_.find(message.sequence_number);
-    if (it != active_proposals_.end()) {
-        it->second.promised_nodes.insert(message.sender_id);
-        
-        if (it->second.has_majority(quorum_nodes_.size())) {
-            // Move to accept phase
-            it->second.phase = QuorumPhase::ACCEPT;
-            send_accept_messages(it->second.proposal_number, it->second.key, it->second.value);
-        }
+    auto it = prepare_rounds_.find(message.sequence_number);
+    if (it == prepare_rounds_.end()) {
+        return;
+    }
+    
+    QuorumState& round = it->second;
+    if (!message.success) {
+        round.rejected = true;
+        highest_seen_ballot_ = std::max(highest_seen_ballot_, message.ballot);
+        round.complete(false);
+        return;
+    }
+    if (round.ballot != 0 && message.ballot != round.ballot) {
+        return;
+    }
+    if (round.ballot != 0 && !merge_accepted_values(message, round)) {
+        return;
+    }
+    
+    round.promised_nodes.insert(message.sender_id);
+    round.highest_accepted_index = std::max(round.highest_accepted_index, message.log_index);
+    
+    if (round.has_majority(quorum_nodes_.size())) {
+        round.phase = QuorumPhase::ACCEPT;
+        round.complete(true);
     }
 }
 
@@ -214,28 +497,132 @@ void QuorumReplication::handle_accept(const Message& message) {
     accepted_msg.sender_id = node_->get_node_id();
     accepted_msg.timestamp = message.get_current_timestamp();
     accepted_msg.sequence_number = message.sequence_number;
-    accepted_msg.success = true;
+    accepted_msg.ballot = message.ballot;
+    accepted_msg.log_index = message.log_index;
     
-    // Apply the write locally
-    node_->write(message.key, message.value);
+    {
+        std::lock_guard<std::mutex> lock(consensus_mutex_);
+        accepted_msg.success = message.ballot >= promised_ballot_;
+        if (accepted_msg.success) {
+            promised_ballot_ = message.ballot;
+            accepted_index_ = std::max(accepted_index_, message.log_index);
+            if (read_mode_ == QuorumReadMode::LEASE) {
+                lease_grant_ballot_ = message.ballot;
+                lease_grant_expiry_us_ = monotonic_now_us() + lease_duration_us_;
+            }
+            // Held, not applied, until a leader reports the slot committed
+            if (message.log_index > commit_index_) {
+                AcceptedValue& accepted = accepted_values_[message.log_index];
+                accepted.ballot = message.ballot;
+                accepted.key = message.key;
+                accepted.value = message.value.str();
+                accepted.batch = message.metadata == kQuorumBatchTag;
+                apply_learned_commits();
+            }
+        } else {
+            accepted_msg.ballot = promised_ballot_;
+        }
+    }
     
+    accepted_msg.partition_id = partition_id_;
     node_->send_message(message.sender_id, accepted_msg);
-    LOG_DEBUG("Accepted proposal " + std::to_string(message.sequence_number));
+    LOG_DEBUG("Accepted slot " + std::to_string(message.log_index) +
+              (accepted_msg.success ? "" : " (rejected)"));
 }
 
 void QuorumReplication::handle_accepted(const Message& message) {
+    peer_telemetry_->on_reply_received(message.sender_id,
+        PeerTelemetry::token(static_cast<uint32_t>(MessageType::QUORUM_ACCEPT), message.log_index));
+    
     // Handle incoming accepted message
     std::lock_guard<std::mutex> lock(consensus_mutex_);
     
-    auto it = active_proposals_.find(message.sequence_number);
-    if (it != active_proposals_.end()) {
-        it->second.accepted_nodes.insert(message.sender_id);
-        
-        if (it->second.has_accept_majority(quorum_nodes_.size())) {
-            // Consensus achieved
-            it->second.phase = QuorumPhase::COMMIT;
-            LOG_DEBUG("Consensus achieved for proposal " + std::to_string(message.sequence_number));
+    if (!message.success) {
+        step_down(message.ballot);
+        return;
+    }
+    
+    LogSlot* slot = log_.find(message.log_index);
+    if (slot == nullptr || slot->ballot != message.ballot) {
+        return; // already committed, truncated or from an older ballot
+    }
+    
+    slot->accepted_nodes.insert(message.sender_id);
+    if (!slot->chosen && slot->has_accept_majority(quorum_nodes_.size())) {
+        slot->chosen = true;
+        LOG_DEBUG("Consensus achieved for slot " + std::to_string(message.log_index));
+        extend_lease(slot->start_time);
+        commit_chosen_slots();
+    }
+}
+
+void QuorumReplication::handle_commit(const Message& message) {
+    // The sender, as leader of ballot, committed every slot up to log_index
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    
+    if (phase1_complete_) {
+        return; // our own log decides what this node commits
+    }
+    uint64_t learned = commit_ballots_.empty() ? commit_index_ : commit_ballots_.rbegin()->first;
+    if (message.log_index <= learned) {
+        return;
+    }
+    commit_ballots_[message.log_index] = message.ballot;
+    apply_learned_commits();
+}
+
+void QuorumReplication::handle_read_index(const Message& message) {
+    // Follower side of ReadIndex: confirm the sender is still the leader
+    Message ack_msg;
+    ack_msg.type = MessageType::QUORUM_READ_INDEX_ACK;
+    ack_msg.sender_id = node_->get_node_id();
+    ack_msg.timestamp = monotonic_now_us();
+    ack_msg.sequence_number = message.sequence_number;
+    ack_msg.ballot = message.ballot;
+    
+    {
+        std::lock_guard<std::mutex> lock(consensus_mutex_);
+        ack_msg.success = message.ballot >= promised_ballot_;
+        if (ack_msg.success) {
+            promised_ballot_ = message.ballot;
+            if (read_mode_ == QuorumReadMode::LEASE) {
+                lease_grant_ballot_ = message.ballot;
+                lease_grant_expiry_us_ = monotonic_now_us() + lease_duration_us_;
+            }
+        } else {
+            ack_msg.ballot = promised_ballot_;
         }
+        ack_msg.log_index = accepted_index_;
+    }
+    
+    ack_msg.partition_id = partition_id_;
+    node_->send_message(message.sender_id, ack_msg);
+}
+
+void QuorumReplication::handle_read_index_ack(const Message& message) {
+    peer_telemetry_->on_reply_received(message.sender_id,
+        PeerTelemetry::token(static_cast<uint32_t>(MessageType::QUORUM_READ_INDEX), message.sequence_number));
+    
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    
+    auto it = read_index_rounds_.find(message.sequence_number);
+    if (it == read_index_rounds_.end()) {
+        return;
+    }
+    
+    ReadIndexRound& round = it->second;
+    if (!message.success) {
+        round.complete(false);
+        step_down(message.ballot);
+        return;
+    }
+    if (message.ballot != round.ballot) {
+        return;
+    }
+    
+    round.acks.insert(message.sender_id);
+    if (round.acks.size() >= (quorum_nodes_.size() / 2) + 1) {
+        round.complete(true);
     }
 }
 
@@ -265,6 +652,12 @@ void QuorumReplication::handle_node_recovery(uint32_t recovered_node) {
         
         LOG_INFO("Node " + std::to_string(recovered_node) + " recovered, added to quorum");
     }
+    
+    // Hand leadership back; the preferred leader wins phase 1 once the
+    // grants to this node run out
+    if (recovered_node == preferred_leader_ && defers_to_leader() && phase1_complete_) {
+        step_down(current_ballot_);
+    }
 }
 
 void QuorumReplication::adjust_quorum_size_based_on_load() {
@@ -299,82 +692,543 @@ uint64_t QuorumReplication::generate_proposal_number() {
     return next_proposal_number_.fetch_add(1);
 }
 
-bool QuorumReplication::initiate_consensus(const std::string& key, const std::string& value) {
-    uint64_t proposal_num = generate_proposal_number();
-    
-    QuorumState write_state;
-    write_state.proposal_number = proposal_num;
-    write_state.phase = QuorumPhase::PREPARE;
-    write_state.key = key;
-    write_state.value = value;
-    write_state.start_time = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    
+uint64_t QuorumReplication::generate_ballot() {
+    // Rounds live in the high bits and the node id breaks ties
+    uint64_t round = (std::max(current_ballot_, highest_seen_ballot_) >> 16) + 1;
+    return (round << 16) | (node_->get_node_id() & 0xFFFF);
+}
+
+void QuorumReplication::set_pipeline_window(size_t max_inflight_accepts) {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    max_inflight_accepts_ = std::max<size_t>(1, max_inflight_accepts);
+    window_cv_.notify_all();
+}
+
+bool QuorumReplication::is_leader() const {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    return phase1_complete_;
+}
+
+uint64_t QuorumReplication::get_current_ballot() const {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    return current_ballot_;
+}
+
+uint64_t QuorumReplication::get_commit_index() const {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    return commit_index_;
+}
+
+bool QuorumReplication::has_valid_lease() const {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    return can_serve_reads() && monotonic_now_us() < lease_expiry_us_;
+}
+
+uint32_t QuorumReplication::get_leaseholder() const {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    uint64_t now = monotonic_now_us();
+    if (can_serve_reads() && now < lease_expiry_us_) {
+        return node_->get_node_id();
+    }
+    if (lease_grant_ballot_ == 0 || now >= lease_grant_expiry_us_) {
+        return 0;
+    }
+    // Ballots carry the proposer's id in their low 16 bits
+    for (uint32_t member : quorum_nodes_) {
+        if ((member & 0xFFFF) == (lease_grant_ballot_ & 0xFFFF)) {
+            return member;
+        }
+    }
+    return 0;
+}
+
+void QuorumReplication::extend_lease(uint64_t round_start_us) {
+    // Caller holds consensus_mutex_. Followers start their grant when the
+    // round reaches them, i.e. no earlier than round_start_us
+    if (read_mode_ != QuorumReadMode::LEASE || lease_duration_us_ <= max_clock_drift_us_) {
+        return;
+    }
+    lease_expiry_us_ = std::max(lease_expiry_us_, round_start_us + lease_duration_us_ - max_clock_drift_us_);
+}
+
+bool QuorumReplication::can_serve_reads() const {
+    // Caller holds consensus_mutex_. Until the re-proposed slots commit, a
+    // new leader's state may miss writes its predecessors acknowledged
+    return phase1_complete_ && commit_index_ >= recovery_index_;
+}
+
+void QuorumReplication::set_preferred_leader(uint32_t node_id) {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    preferred_leader_ = node_id;
+}
+
+uint32_t QuorumReplication::get_preferred_leader() const {
+    std::lock_guard<std::mutex> lock(consensus_mutex_);
+    return preferred_leader_;
+}
+
+bool QuorumReplication::defers_to_leader() const {
+    // Caller holds consensus_mutex_. A preferred leader that failed has
+    // left quorum_nodes_, and then any replica may take over.
+    return preferred_leader_ != 0 && preferred_leader_ != node_->get_node_id() && is_in_quorum(preferred_leader_);
+}
+
+bool QuorumReplication::refuse_for_leader(const Message& request, Message& response) {
+    uint32_t leader = 0;
     {
         std::lock_guard<std::mutex> lock(consensus_mutex_);
-        active_proposals_[proposal_num] = write_state;
+        if (!defers_to_leader()) {
+            return false;
+        }
+        leader = preferred_leader_;
     }
-    
-    // Phase 1: Prepare
-    if (!send_prepare_messages(proposal_num, key)) {
+    response.success = false;
+    response.target_nodes = {leader};
+    LOG_DEBUG("Refusing write for key " + request.key + ", node " + std::to_string(leader) + " leads");
+    return true;
+}
+
+bool QuorumReplication::serve_linearizable_read(const std::string& key, std::string& value, bool& found,
+                                                std::chrono::steady_clock::time_point deadline) {
+    {
         std::lock_guard<std::mutex> lock(consensus_mutex_);
-        active_proposals_.erase(proposal_num);
+        if (!can_serve_reads()) {
+            return false;
+        }
+        // The leader applies slots as they commit, so its local state is current
+        if (read_mode_ == QuorumReadMode::LEASE && monotonic_now_us() < lease_expiry_us_) {
+            found = node_->read(key, value);
+            lease_reads_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    
+    if (!confirm_read_index(deadline)) {
+        return false;
+    }
+    found = node_->read(key, value);
+    read_index_reads_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool QuorumReplication::confirm_read_index(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(consensus_mutex_);
+    if (!can_serve_reads()) {
         return false;
     }
     
-    // Wait for majority promises and then move to accept phase
-    auto start_time = std::chrono::high_resolution_clock::now();
-    auto timeout = start_time + std::chrono::milliseconds(operation_timeout_);
+    // Join the open round, or open one and become responsible for sending it
+    bool owner = open_read_round_ == 0;
+    if (owner) {
+        open_read_round_ = generate_proposal_number();
+        read_index_rounds_[open_read_round_].id = open_read_round_;
+    }
+    uint64_t id = open_read_round_;
+    std::shared_future<bool> done = read_index_rounds_[id].done;
     
-    while (std::chrono::high_resolution_clock::now() < timeout) {
-        {
-            std::lock_guard<std::mutex> lock(consensus_mutex_);
-            auto it = active_proposals_.find(proposal_num);
-            if (it != active_proposals_.end()) {
-                if (it->second.phase == QuorumPhase::COMMIT && 
-                    it->second.has_accept_majority(quorum_nodes_.size())) {
-                    // Consensus successful
-                    node_->write(key, value);
-                    active_proposals_.erase(it);
-                    return true;
+    if (!owner) {
+        lock.unlock();
+        return done.wait_until(deadline) == std::future_status::ready && done.get();
+    }
+    
+    // One round in flight at a time; reads arriving meanwhile pile into ours
+    while (inflight_read_round_ != 0) {
+        auto it = read_index_rounds_.find(inflight_read_round_);
+        if (it == read_index_rounds_.end() || it->second.completed) {
+            break;
+        }
+        std::shared_future<bool> previous = it->second.done;
+        lock.unlock();
+        bool finished = previous.wait_until(deadline) == std::future_status::ready;
+        lock.lock();
+        if (!finished) {
+            read_index_rounds_[id].complete(false);
+            read_index_rounds_.erase(id);
+            open_read_round_ = 0;
+            return false;
+        }
+    }
+    
+    ReadIndexRound& round = read_index_rounds_[id];
+    open_read_round_ = 0;
+    if (!can_serve_reads()) {
+        round.complete(false);
+        read_index_rounds_.erase(id);
+        return false;
+    }
+    
+    inflight_read_round_ = id;
+    round.ballot = current_ballot_;
+    round.read_index = commit_index_;
+    round.start_time = monotonic_now_us();
+    round.acks.insert(node_->get_node_id());
+    
+    Message read_index_msg;
+    read_index_msg.type = MessageType::QUORUM_READ_INDEX;
+    read_index_msg.sender_id = node_->get_node_id();
+    read_index_msg.timestamp = monotonic_now_us();
+    read_index_msg.sequence_number = static_cast<uint32_t>(id);
+    read_index_msg.ballot = round.ballot;
+    read_index_msg.log_index = round.read_index;
+    std::vector<uint32_t> targets = quorum_nodes_;
+    lock.unlock();
+    
+    uint64_t read_token = PeerTelemetry::token(static_cast<uint32_t>(MessageType::QUORUM_READ_INDEX),
+                                               read_index_msg.sequence_number);
+    read_index_msg.partition_id = partition_id_;
+    for (uint32_t node_id : targets) {
+        if (node_id != node_->get_node_id()) {
+            peer_telemetry_->on_request_sent(node_id, read_token);
+            node_->send_message(node_id, read_index_msg);
+        }
+    }
+    read_index_rounds_sent_.fetch_add(1, std::memory_order_relaxed);
+    
+    bool confirmed = done.wait_until(deadline) == std::future_status::ready && done.get();
+    
+    lock.lock();
+    auto it = read_index_rounds_.find(id);
+    if (it != read_index_rounds_.end()) {
+        if (confirmed) {
+            extend_lease(it->second.start_time);
+        }
+        it->second.complete(false);
+        read_index_rounds_.erase(it);
+    }
+    if (inflight_read_round_ == id) {
+        inflight_read_round_ = 0;
+    }
+    return confirmed;
+}
+
+bool QuorumReplication::initiate_consensus(const std::string& key, const std::string& value, bool batch) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(operation_timeout_);
+    
+    std::unique_lock<std::mutex> lock(consensus_mutex_);
+    
+    // Phase 1 only runs until this node holds a stable ballot
+    if (!ensure_leadership(lock, deadline)) {
+        return false;
+    }
+    
+    // Wait for room in the pipeline window
+    if (!window_cv_.wait_until(lock, deadline, [this]() {
+            return !phase1_complete_ || log_.inflight() < max_inflight_accepts_;
+        }) || !phase1_complete_) {
+        return false;
+    }
+    
+    LogSlot& slot = log_.append(current_ballot_, key, value);
+    slot.batch = batch;
+    slot.accepted_nodes.insert(node_->get_node_id());
+    promised_ballot_ = std::max(promised_ballot_, current_ballot_);
+    accepted_index_ = std::max(accepted_index_, slot.index);
+    AcceptedValue& accepted = accepted_values_[slot.index];
+    accepted.ballot = slot.ballot;
+    accepted.key = key;
+    accepted.value = value;
+    accepted.batch = batch;
+    
+    uint64_t ballot = slot.ballot;
+    uint64_t index = slot.index;
+    std::future<bool> committed = slot.completion->get_future();
+    if (slot.has_accept_majority(quorum_nodes_.size())) {
+        slot.chosen = true;
+        commit_chosen_slots();
+    }
+    lock.unlock();
+    
+    // Phase 2: Accept, pipelined with other in-flight slots
+    send_accept_messages(ballot, index, key, value, batch);
+    
+    if (committed.wait_until(deadline) == std::future_status::ready) {
+        return committed.get();
+    }
+    
+    // A slot that cannot commit blocks every later slot, so give up the
+    // ballot and fail the uncommitted suffix
+    lock.lock();
+    if (current_ballot_ == ballot && phase1_complete_) {
+        LOG_WARNING("Slot " + std::to_string(index) + " timed out, stepping down as leader");
+        step_down(ballot);
+    }
+    lock.unlock();
+    
+    return committed.wait_for(std::chrono::seconds(0)) == std::future_status::ready && committed.get();
+}
+
+bool QuorumReplication::ensure_leadership(std::unique_lock<std::mutex>& lock,
+                                          std::chrono::steady_clock::time_point deadline) {
+    while (!phase1_complete_) {
+        if (phase1_in_progress_) {
+            // Another caller is already running phase 1; share its outcome
+            if (!phase1_cv_.wait_until(lock, deadline, [this]() { return !phase1_in_progress_; })) {
+                return false;
+            }
+            continue;
+        }
+        
+        if (defers_to_leader()) {
+            return false;
+        }
+        if (lease_grant_ballot_ != 0 && (lease_grant_ballot_ & 0xFFFF) != (node_->get_node_id() & 0xFFFF) &&
+            monotonic_now_us() < lease_grant_expiry_us_) {
+            // Still bound by a lease granted to the current leader
+            return false;
+        }
+        
+        uint64_t ballot = generate_ballot();
+        uint64_t proposal_num = generate_proposal_number();
+        if (ballot < promised_ballot_) {
+            highest_seen_ballot_ = std::max(highest_seen_ballot_, promised_ballot_);
+            continue;
+        }
+        promised_ballot_ = ballot;
+        
+        QuorumState& round = prepare_rounds_[proposal_num];
+        round.proposal_number = proposal_num;
+        round.ballot = ballot;
+        round.start_time = monotonic_now_us();
+        uint64_t round_start = round.start_time;
+        round.promised_nodes.insert(node_->get_node_id());
+        round.highest_accepted_index = accepted_index_;
+        round.accepted_values.insert(accepted_values_.upper_bound(commit_index_), accepted_values_.end());
+        uint64_t commit_index = commit_index_;
+        std::shared_ptr<std::promise<bool>> completion = round.completion;
+        std::future<bool> promised = completion->get_future();
+        phase1_in_progress_ = true;
+        
+        lock.unlock();
+        send_prepare_messages(proposal_num, ballot, "", commit_index);
+        bool won = promised.wait_until(deadline) == std::future_status::ready && promised.get();
+        lock.lock();
+        
+        auto it = prepare_rounds_.find(proposal_num);
+        won = won && it != prepare_rounds_.end();
+        if (won) {
+            current_ballot_ = ballot;
+            phase1_complete_ = true;
+            commit_ballots_.clear();
+            extend_lease(round_start);
+            
+            // Finish whatever earlier leaders started: every slot past our
+            // commit index is proposed again under this ballot, with the
+            // highest-ballot value any promiser accepted for it. No promiser
+            // accepted a slot left empty, so it was never chosen and becomes
+            // a no-op (an empty batch).
+            const QuorumState& recovered = it->second;
+            uint64_t last = recovered.highest_accepted_index;
+            if (!recovered.accepted_values.empty()) {
+                last = std::max(last, recovered.accepted_values.rbegin()->first);
+            }
+            uint64_t reproposed = last > commit_index_ ? last - commit_index_ : 0;
+            log_.truncate(commit_index_ + 1);
+            for (uint64_t index = commit_index_ + 1; index <= last; ++index) {
+                auto found = recovered.accepted_values.find(index);
+                AcceptedValue value;
+                if (found != recovered.accepted_values.end()) {
+                    value = found->second;
+                } else {
+                    value.batch = true;
                 }
+                value.ballot = ballot;
+                
+                LogSlot& slot = log_.append(ballot, value.key, value.value);
+                slot.batch = value.batch;
+                slot.accepted_nodes.insert(node_->get_node_id());
+                slot.chosen = slot.has_accept_majority(quorum_nodes_.size());
+                accepted_values_[index] = value;
+                send_accept_messages(ballot, index, value.key, value.value, value.batch);
             }
+            accepted_index_ = std::max(accepted_index_, last);
+            recovery_index_ = std::max(last, commit_index_);
+            commit_chosen_slots();
+            
+            LOG_INFO("Node " + std::to_string(node_->get_node_id()) + " became Paxos leader with ballot " +
+                     std::to_string(ballot) + ", re-proposed " + std::to_string(reproposed) + " slots");
+        }
+        if (it != prepare_rounds_.end()) {
+            prepare_rounds_.erase(it);
+        }
+        phase1_in_progress_ = false;
+        phase1_cv_.notify_all();
+        
+        if (!won) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void QuorumReplication::commit_chosen_slots() {
+    // Slots commit strictly in log order; caller holds consensus_mutex_
+    bool advanced = false;
+    while (!log_.empty() && log_.front().chosen) {
+        LogSlot& slot = log_.front();
+        apply_write(slot.key, slot.value, slot.batch);
+        commit_index_ = slot.index;
+        slot.completion->set_value(true);
+        log_.pop_front();
+        advanced = true;
+    }
+    if (advanced) {
+        trim_accepted_values();
+        send_commit_messages(current_ballot_, commit_index_);
+        window_cv_.notify_all();
+    }
+}
+
+void QuorumReplication::apply_learned_commits() {
+    // Caller holds consensus_mutex_. A slot committed under ballot b was
+    // chosen at b, so any value this acceptor holds from b or later is the
+    // chosen one. A slot still missing usually means its accept is in
+    // flight; past the retained window it is left to anti-entropy.
+    while (!commit_ballots_.empty()) {
+        uint64_t next = commit_index_ + 1;
+        auto bound = commit_ballots_.lower_bound(next);
+        auto accepted = accepted_values_.find(next);
+        if (accepted != accepted_values_.end() && accepted->second.ballot >= bound->second) {
+            apply_write(accepted->second.key, accepted->second.value, accepted->second.batch);
+        } else if (commit_ballots_.rbegin()->first - commit_index_ <= kRetainedCommittedSlots) {
+            break;
+        } else {
+            LOG_WARNING("Slot " + std::to_string(next) + " committed without its value here, not applied");
+        }
+        commit_index_ = next;
+        if (bound->first == next) {
+            commit_ballots_.erase(bound);
+        }
+    }
+    trim_accepted_values();
+}
+
+void QuorumReplication::trim_accepted_values() {
+    // Caller holds consensus_mutex_
+    if (commit_index_ > kRetainedCommittedSlots) {
+        accepted_values_.erase(accepted_values_.begin(),
+                               accepted_values_.upper_bound(commit_index_ - kRetainedCommittedSlots));
+    }
+}
+
+std::string QuorumReplication::pack_accepted_values(uint64_t after_index) const {
+    // Caller holds consensus_mutex_; one frame per slot, in log order
+    std::string frames;
+    for (auto it = accepted_values_.upper_bound(after_index); it != accepted_values_.end(); ++it) {
+        Message entry;
+        entry.type = MessageType::QUORUM_ACCEPT;
+        entry.log_index = it->first;
+        entry.ballot = it->second.ballot;
+        entry.key = it->second.key;
+        entry.value = it->second.value;
+        if (it->second.batch) {
+            entry.metadata = kQuorumBatchTag;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        entry.serialize_to(frames);
+    }
+    return frames;
+}
+
+bool QuorumReplication::merge_accepted_values(const Message& promise, QuorumState& round) {
+    // Caller holds consensus_mutex_. Keeps the highest-ballot value per slot;
+    // a promise that does not parse is not counted.
+    std::map<uint64_t, AcceptedValue> reported;
+    const char* frame = promise.value.data();
+    size_t remaining = promise.value.size();
+    while (remaining > 0) {
+        size_t frame_length = wire::frame_size(frame, remaining);
+        if (frame_length == 0 || frame_length > remaining) {
+            LOG_WARNING("Truncated promise from node " + std::to_string(promise.sender_id) + ", ignored");
+            return false;
+        }
+        Message entry = Message::deserialize(frame, frame_length);
+        AcceptedValue& value = reported[entry.log_index];
+        value.ballot = entry.ballot;
+        value.key = std::move(entry.key);
+        value.value = entry.value.release();
+        value.batch = entry.metadata == kQuorumBatchTag;
+        frame += frame_length;
+        remaining -= frame_length;
     }
     
-    // Timeout or failure
-    {
-        std::lock_guard<std::mutex> lock(consensus_mutex_);
-        active_proposals_.erase(proposal_num);
+    for (auto& entry : reported) {
+        AcceptedValue& known = round.accepted_values[entry.first];
+        if (entry.second.ballot > known.ballot) {
+            known = std::move(entry.second);
+        }
+    }
+    return true;
+}
+
+void QuorumReplication::apply_write(const std::string& key, const std::string& value, bool batch) {
+    if (!batch) {
+        node_->write(key, value);
+        return;
     }
     
-    return false;
+    // Applied together so a durable node waits for one log sync per slot
+    std::vector<std::pair<std::string, std::string>> entries;
+    const char* frame = value.data();
+    size_t remaining = value.size();
+    while (remaining > 0) {
+        size_t frame_length = wire::frame_size(frame, remaining);
+        if (frame_length == 0 || frame_length > remaining) {
+            LOG_WARNING("Truncated quorum batch, " + std::to_string(remaining) + " bytes not applied");
+            break;
+        }
+        Message entry = Message::deserialize(frame, frame_length);
+        entries.emplace_back(std::move(entry.key), entry.value.release());
+        frame += frame_length;
+        remaining -= frame_length;
+    }
+    node_->write_batch(entries);
+}
+
+void QuorumReplication::step_down(uint64_t observed_ballot) {
+    // Caller holds consensus_mutex_
+    highest_seen_ballot_ = std::max(highest_seen_ballot_, observed_ballot);
+    if (!phase1_complete_) {
+        return;
+    }
+    
+    phase1_complete_ = false;
+    lease_expiry_us_ = 0;
+    for (auto& entry : read_index_rounds_) {
+        entry.second.complete(false);
+    }
+    std::deque<LogSlot> dropped = log_.truncate(log_.next_index());
+    for (LogSlot& slot : dropped) {
+        slot.completion->set_value(false);
+    }
+    window_cv_.notify_all();
+    LOG_WARNING("Node " + std::to_string(node_->get_node_id()) + " lost Paxos leadership, " +
+                std::to_string(dropped.size()) + " in-flight slots failed");
 }
 
 void QuorumReplication::cleanup_expired_proposals() {
     std::lock_guard<std::mutex> lock(consensus_mutex_);
     
-    auto current_time = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    uint64_t current_time = monotonic_now_us();
     
-    auto it = active_proposals_.begin();
-    while (it != active_proposals_.end()) {
+    auto it = prepare_rounds_.begin();
+    while (it != prepare_rounds_.end()) {
         if (current_time - it->second.start_time > operation_timeout_ * 1000) {
             LOG_DEBUG("Cleaning up expired proposal " + std::to_string(it->first));
-            it = active_proposals_.erase(it);
+            it = prepare_rounds_.erase(it);
         } else {
             ++it;
         }
     }
 }
 
-bool QuorumReplication::send_prepare_messages(uint64_t proposal_number, const std::string& key) {
+bool QuorumReplication::send_prepare_messages(uint64_t proposal_number, uint64_t ballot, const std::string& key,
+                                              uint64_t commit_index) {
     Message prepare_msg;
     prepare_msg.type = MessageType::QUORUM_PREPARE;
     prepare_msg.sender_id = node_->get_node_id();
     prepare_msg.timestamp = prepare_msg.get_current_timestamp();
     prepare_msg.sequence_number = proposal_number;
+    prepare_msg.ballot = ballot;
+    prepare_msg.log_index = commit_index;  // promisers report accepted values past it
     prepare_msg.key = key;
     
     // Send to optimal quorum subset for better performance
@@ -385,8 +1239,12 @@ bool QuorumReplication::send_prepare_messages(uint64_t proposal_number, const st
         target_nodes = quorum_nodes_;
     }
     
+    uint64_t prepare_token = PeerTelemetry::token(static_cast<uint32_t>(MessageType::QUORUM_PREPARE),
+                                                  prepare_msg.sequence_number);
+    prepare_msg.partition_id = partition_id_;
     for (uint32_t node_id : target_nodes) {
         if (node_id != node_->get_node_id()) {
+            peer_telemetry_->on_request_sent(node_id, prepare_token);
             node_->send_message(node_id, prepare_msg);
         }
     }
@@ -395,25 +1253,49 @@ bool QuorumReplication::send_prepare_messages(uint64_t proposal_number, const st
     return true;
 }
 
-bool QuorumReplication::send_accept_messages(uint64_t proposal_number, const std::string& key, const std::string& value) {
+bool QuorumReplication::send_accept_messages(uint64_t ballot, uint64_t log_index, const std::string& key,
+                                             const std::string& value, bool batch) {
     Message accept_msg;
     accept_msg.type = MessageType::QUORUM_ACCEPT;
     accept_msg.sender_id = node_->get_node_id();
     accept_msg.timestamp = accept_msg.get_current_timestamp();
-    accept_msg.sequence_number = proposal_number;
+    accept_msg.sequence_number = static_cast<uint32_t>(log_index);
+    accept_msg.ballot = ballot;
+    accept_msg.log_index = log_index;
     accept_msg.key = key;
     accept_msg.value = value;
+    if (batch) {
+        accept_msg.metadata = kQuorumBatchTag;
+    }
     
+    uint64_t accept_token = PeerTelemetry::token(static_cast<uint32_t>(MessageType::QUORUM_ACCEPT), log_index);
+    accept_msg.partition_id = partition_id_;
     for (uint32_t node_id : quorum_nodes_) {
         if (node_id != node_->get_node_id()) {
+            peer_telemetry_->on_request_sent(node_id, accept_token);
             node_->send_message(node_id, accept_msg);
         }
     }
     
-    LOG_DEBUG("Sent accept messages for proposal " + std::to_string(proposal_number));
+    LOG_DEBUG("Sent accept messages for slot " + std::to_string(log_index));
     return true;
 }
 
+void QuorumReplication::send_commit_messages(uint64_t ballot, uint64_t commit_index) {
+    Message commit_msg;
+    commit_msg.type = MessageType::QUORUM_COMMIT;
+    commit_msg.sender_id = node_->get_node_id();
+    commit_msg.timestamp = commit_msg.get_current_timestamp();
+    commit_msg.ballot = ballot;
+    commit_msg.log_index = commit_index;
+    commit_msg.partition_id = partition_id_;
+    for (uint32_t node_id : quorum_nodes_) {
+        if (node_id != node_->get_node_id()) {
+            node_->send_message(node_id, commit_msg);
+        }
+    }
+}
+
 size_t QuorumReplication::calculate_optimal_quorum_size() {
     // Calculate optimal quorum size based on network conditions and load
     // This is a simplified heuristic - in practice would use more sophisticated analysis
@@ -434,27 +1316,41 @@ size_t QuorumReplication::calculate_optimal_quorum_size() {
 }
 
 bool QuorumReplication::can_use_fast_path(const Message& request) {
-    // Determine if fast path can be used for read optimization
+    // A local read is not linearizable, so only LOCAL mode may take it
     return request.is_read_operation() && 
            !request.key.empty() && 
-           fast_quorum_enabled_;
+           fast_quorum_enabled_ &&
+           read_mode_ == QuorumReadMode::LOCAL;
 }
 
 std::vector<uint32_t> QuorumReplication::select_optimal_quorum_subset() {
-    // Select optimal subset of nodes for quorum operations
-    // This would typically consider network latency, node load, etc.
-    
-    if (quorum_nodes_.size() <= quorum_size_) {
+    // Thrifty: this node plus the fastest, least-loaded peers, enough for a
+    // majority. A smaller quorum_size_ would never gather enough promises.
+    size_t subset_size = std::max(quorum_size_, (quorum_nodes_.size() / 2) + 1);
+    if (quorum_nodes_.size() <= subset_size) {
         return quorum_nodes_;
     }
     
-    // For now, just return the first quorum_size_ nodes
-    // In practice, this would use sophisticated selection algorithms
-    std::vector<uint32_t> subset;
-    for (size_t i = 0; i < quorum_size_ && i < quorum_nodes_.size(); ++i) {
-        subset.push_back(quorum_nodes_[i]);
+    std::vector<uint32_t> peers;
+    bool member = false;
+    for (uint32_t node_id : quorum_nodes_) {
+        if (node_id == node_->get_node_id()) {
+            member = true;
+        } else {
+            peers.push_back(node_id);
+        }
     }
     
+    std::vector<uint32_t> subset;
+    if (member) {
+        subset.push_back(node_->get_node_id());
+    }
+    for (uint32_t node_id : peer_telemetry_->rank(peers)) {
+        if (subset.size() >= subset_size) {
+            break;
+        }
+        subset.push_back(node_id);
+    }
     return subset;
 }
 
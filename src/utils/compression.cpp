@@ -0,0 +1,240 @@
+#include "utils/compression.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef REPLICATION_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace replication {
+
+namespace {
+
+// LZ block format, a sequence of
+//   token: high nibble literal count, low nibble match length - kMinMatch;
+//          15 in either means the count continues in bytes of 255 plus a
+//          final byte below 255
+//   literal count extension, literals, u16 little-endian match offset,
+//   match length extension
+// The last sequence carries literals only. Matches never reach into the
+// last kLastLiterals bytes, so a block always ends with literals.
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashBits = 12;
+
+inline uint32_t read32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hash_sequence(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - kHashBits);
+}
+
+void put_length(std::string& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+void put_sequence(std::string& out, const char* literals, size_t literal_count,
+                  size_t offset, size_t match_length) {
+    size_t match_code = match_length >= kMinMatch ? match_length - kMinMatch : 0;
+    uint8_t token = static_cast<uint8_t>((literal_count < 15 ? literal_count : 15) << 4);
+    if (match_length > 0) {
+        token |= static_cast<uint8_t>(match_code < 15 ? match_code : 15);
+    }
+    out.push_back(static_cast<char>(token));
+    if (literal_count >= 15) {
+        put_length(out, literal_count - 15);
+    }
+    out.append(literals, literal_count);
+    if (match_length == 0) {
+        return; // last sequence
+    }
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (match_code >= 15) {
+        put_length(out, match_code - 15);
+    }
+}
+
+// False if the extension runs off the end of the block
+bool get_length(const uint8_t*& in, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (in >= end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+class LzCodec : public FrameCodec {
+public:
+    CompressionCodec id() const override { return CompressionCodec::LZ; }
+    const char* name() const override { return "lz"; }
+
+    bool compress(const char* data, size_t size, std::string& out) const override {
+        out.reserve(out.size() + size + size / 255 + 16);
+        size_t anchor = 0;
+        if (size > kMinMatch + kLastLiterals) {
+            // Cleared each call: a stale position could point past this one
+            thread_local std::vector<uint32_t> table(size_t(1) << kHashBits);
+            std::fill(table.begin(), table.end(), 0);
+            size_t limit = size - kLastLiterals - kMinMatch;
+            size_t position = 1; // position 0 only seeds the table
+            table[hash_sequence(read32(data))] = 0;
+            while (position <= limit) {
+                uint32_t sequence = read32(data + position);
+                uint32_t& slot = table[hash_sequence(sequence)];
+                size_t candidate = slot;
+                slot = static_cast<uint32_t>(position);
+                if (position - candidate > kMaxOffset || read32(data + candidate) != sequence) {
+                    // Skip faster through data that keeps missing
+                    position += 1 + ((position - anchor) >> 6);
+                    continue;
+                }
+                size_t match_length = kMinMatch;
+                size_t max_length = size - kLastLiterals - position;
+                while (match_length < max_length && data[candidate + match_length] == data[position + match_length]) {
+                    ++match_length;
+                }
+                put_sequence(out, data + anchor, position - anchor, position - candidate, match_length);
+                position += match_length;
+                anchor = position;
+            }
+        }
+        put_sequence(out, data + anchor, size - anchor, 0, 0);
+        return true;
+    }
+
+    bool decompress(const char* data, size_t size, size_t raw_size, std::string& out) const override {
+        size_t base = out.size();
+        out.resize(base + raw_size);
+        char* dest = &out[0] + base;
+        size_t written = 0;
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t* end = in + size;
+
+        while (in < end) {
+            uint8_t token = *in++;
+            size_t literal_count = token >> 4;
+            if (literal_count == 15 && !get_length(in, end, literal_count)) {
+                break;
+            }
+            if (literal_count > static_cast<size_t>(end - in) || literal_count > raw_size - written) {
+                break;
+            }
+            std::memcpy(dest + written, in, literal_count);
+            in += literal_count;
+            written += literal_count;
+            if (in == end) {
+                if (written == raw_size) {
+                    return true;
+                }
+                break;
+            }
+
+            if (end - in < 2) {
+                break;
+            }
+            size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+            in += 2;
+            size_t match_length = token & 0x0F;
+            if (match_length == 15 && !get_length(in, end, match_length)) {
+                break;
+            }
+            match_length += kMinMatch;
+            if (offset == 0 || offset > written || match_length > raw_size - written) {
+                break;
+            }
+            // A match closer than its length overlaps the bytes it produces
+            const char* source = dest + written - offset;
+            if (offset >= match_length) {
+                std::memcpy(dest + written, source, match_length);
+            } else {
+                for (size_t i = 0; i < match_length; ++i) {
+                    dest[written + i] = source[i];
+                }
+            }
+            written += match_length;
+        }
+        out.resize(base);
+        return false;
+    }
+};
+
+#ifdef REPLICATION_WITH_ZLIB
+class ZlibCodec : public FrameCodec {
+public:
+    CompressionCodec id() const override { return CompressionCodec::ZLIB; }
+    const char* name() const override { return "zlib"; }
+
+    bool compress(const char* data, size_t size, std::string& out) const override {
+        size_t base = out.size();
+        uLongf length = compressBound(static_cast<uLong>(size));
+        out.resize(base + length);
+        if (compress2(reinterpret_cast<Bytef*>(&out[base]), &length, reinterpret_cast<const Bytef*>(data),
+                      static_cast<uLong>(size), Z_BEST_SPEED) != Z_OK) {
+            out.resize(base);
+            return false;
+        }
+        out.resize(base + length);
+        return true;
+    }
+
+    bool decompress(const char* data, size_t size, size_t raw_size, std::string& out) const override {
+        size_t base = out.size();
+        out.resize(base + raw_size);
+        uLongf length = static_cast<uLongf>(raw_size);
+        if (uncompress(reinterpret_cast<Bytef*>(&out[0] + base), &length, reinterpret_cast<const Bytef*>(data),
+                       static_cast<uLong>(size)) != Z_OK || length != raw_size) {
+            out.resize(base);
+            return false;
+        }
+        return true;
+    }
+};
+#endif
+
+} // namespace
+
+const FrameCodec* find_codec(CompressionCodec id) {
+    static const LzCodec lz;
+#ifdef REPLICATION_WITH_ZLIB
+    static const ZlibCodec zlib;
+#endif
+    switch (id) {
+        case CompressionCodec::LZ:
+            return &lz;
+#ifdef REPLICATION_WITH_ZLIB
+        case CompressionCodec::ZLIB:
+            return &zlib;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+uint32_t supported_codecs() {
+    uint32_t mask = 1U << static_cast<uint32_t>(CompressionCodec::LZ);
+#ifdef REPLICATION_WITH_ZLIB
+    mask |= 1U << static_cast<uint32_t>(CompressionCodec::ZLIB);
+#endif
+    return mask;
+}
+
+const char* codec_name(CompressionCodec id) {
+    const FrameCodec* codec = find_codec(id);
+    return codec ? codec->name() : "none";
+}
+
+} // namespace replication
@@ -11,8 +11,12 @@ Logger& Logger::getInstance() {
     return instance;
 }
 
+Logger::~Logger() {
+    disableAsync();
+}
+
 void Logger::setLogLevel(LogLevel level) {
-    currentLevel_ = level;
+    currentLevel_.store(static_cast<int>(level), std::memory_order_relaxed);
 }
 
 void Logger::setLogFile(const std::string& filename) {
@@ -28,30 +32,95 @@ void Logger::setLogFile(const std::string& filename) {
     }
 }
 
-void Logger::log(LogLevel level, const std::string& message) {
-    if (level < currentLevel_) {
+void Logger::enableAsync(size_t capacity) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    if (async_enabled_.load(std::memory_order_relaxed)) {
         return;
     }
     
+    // The ring outlives disableAsync(): a producer may still be pushing into it
+    if (!queue_) {
+        queue_ = std::make_unique<BoundedQueue<LogRecord>>(capacity);
+    }
+    writer_stopping_.store(false);
+    writer_thread_ = std::thread(&Logger::writerLoop, this);
+    async_enabled_.store(true, std::memory_order_release);
+}
+
+void Logger::disableAsync() {
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        if (!async_enabled_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        async_enabled_.store(false, std::memory_order_release);
+        writer_stopping_.store(true);
+    }
+    writer_cv_.notify_one();
+    writer_thread_.join();
+    
+    // Write anything that raced in after the writer's final drain
     std::lock_guard<std::mutex> lock(logMutex_);
+    LogRecord record;
+    while (queue_->try_pop(record)) {
+        write(record);
+        written_.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::cout.flush();
+    if (logFile_.is_open()) {
+        logFile_.flush();
+    }
+}
+
+void Logger::flush() {
+    if (!isAsync()) {
+        std::lock_guard<std::mutex> lock(logMutex_);
+        std::cout.flush();
+        if (logFile_.is_open()) {
+            logFile_.flush();
+        }
+        return;
+    }
     
-    std::string timestamp = getCurrentTimestamp();
-    std::string level_str = logLevelToString(level);
+    // Wait until the writer has caught up with everything queued so far
+    uint64_t target = enqueued_.load(std::memory_order_acquire);
+    while (written_.load(std::memory_order_acquire) < target && isAsync()) {
+        writer_cv_.notify_one();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+void Logger::log(LogLevel level, const std::string& message) {
+    if (isEnabled(level)) {
+        log(level, std::string(message));
+    }
+}
+
+void Logger::log(LogLevel level, std::string&& message) {
+    if (!isEnabled(level)) {
+        return;
+    }
     
-    std::string formatted_message = "[" + timestamp + "] [" + level_str + "] " + message;
+    LogRecord record{level, std::chrono::system_clock::now(), std::move(message)};
     
-    // Output to console
-    if (level >= LogLevel::WARNING) {
-        std::cerr << formatted_message << std::endl;
-    } else {
-        std::cout << formatted_message << std::endl;
+    if (async_enabled_.load(std::memory_order_acquire)) {
+        if (queue_->try_push(std::move(record))) {
+            enqueued_.fetch_add(1, std::memory_order_release);
+            if (writer_idle_.load(std::memory_order_acquire)) {
+                writer_cv_.notify_one();
+            }
+            return;
+        }
+        
+        // Ring is full: drop routine messages, but never lose errors
+        if (level < LogLevel::ERROR) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
     }
     
-    // Output to file if available
-    if (logFile_.is_open()) {
-        logFile_ << formatted_message << std::endl;
-        logFile_.flush();
-    }
+    std::lock_guard<std::mutex> lock(logMutex_);
+    write(record);
 }
 
 void Logger::debug(const std::string& message) {
@@ -74,14 +143,81 @@ void Logger::critical(const std::string& message) {
     log(LogLevel::CRITICAL, message);
 }
 
-std::string Logger::getCurrentTimestamp() const {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
+void Logger::writerLoop() {
+    LogRecord record;
+    uint64_t reported_drops = 0;
+    
+    while (true) {
+        bool wrote = false;
+        {
+            std::lock_guard<std::mutex> lock(logMutex_);
+            while (queue_->try_pop(record)) {
+                write(record);
+                written_.fetch_add(1, std::memory_order_release);
+                wrote = true;
+            }
+            
+            uint64_t drops = dropped_.load(std::memory_order_relaxed);
+            if (drops != reported_drops) {
+                write({LogLevel::WARNING, std::chrono::system_clock::now(),
+                       "Log ring full, dropped " + std::to_string(drops - reported_drops) + " messages"});
+                reported_drops = drops;
+                wrote = true;
+            }
+            
+            // One flush per drained batch instead of one per message
+            if (wrote) {
+                std::cout.flush();
+                if (logFile_.is_open()) {
+                    logFile_.flush();
+                }
+            }
+        }
+        
+        if (writer_stopping_.load() && queue_->empty()) {
+            break;
+        }
+        
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        writer_idle_.store(true, std::memory_order_release);
+        // The timeout bounds the delay if a producer's notify is missed
+        writer_cv_.wait_for(lock, std::chrono::milliseconds(5), [this]() {
+            return writer_stopping_.load() || !queue_->empty();
+        });
+        writer_idle_.store(false, std::memory_order_release);
+    }
+}
+
+void Logger::write(const LogRecord& record) {
+    std::string formatted_message = "[" + formatTimestamp(record.time) + "] [" +
+                                    logLevelToString(record.level) + "] " + record.message + "\n";
+    
+    // Output to console
+    if (record.level >= LogLevel::WARNING) {
+        std::cerr << formatted_message;
+    } else {
+        std::cout << formatted_message;
+    }
+    
+    // Output to file if available; synchronous writers flush only on warnings
+    if (logFile_.is_open()) {
+        logFile_ << formatted_message;
+        if (record.level >= LogLevel::WARNING) {
+            logFile_.flush();
+        }
+    }
+}
+
+std::string Logger::formatTimestamp(std::chrono::system_clock::time_point time) const {
+    auto time_t = std::chrono::system_clock::to_time_t(time);
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
+        time.time_since_epoch()) % 1000;
+    
+    std::tm local_time;
+    localtime_r(&time_t, &local_time);
     
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+    ss << std::put_time(&local_time, "%Y-%m-%d %H:%M:%S");
     ss << "." << std::setfill('0') << std::setw(3) << ms.count();
     
     return ss.str();
@@ -98,4 +234,4 @@ std::string Logger::logLevelToString(LogLevel level) const {
     }
 }
 
-} // namespace replication 
\ No newline at end of file
+} // namespace replication
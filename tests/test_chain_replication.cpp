@@ -1,5 +1,6 @@
 #include "protocols/chain_replication.h"
 #include "core/node.h"
+#include "utils/buffer_pool.h"
 #include "utils/logger.h"
 #include <cassert>
 #include <iostream>
@@ -7,6 +8,7 @@
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <future>
 
 using namespace replication;
 
@@ -25,6 +27,12 @@ public:
         test_performance_optimization();
         test_batching();
         test_pipelining();
+        test_craq_reads();
+        test_ack_driven_completion();
+        test_write_waits_for_tail_ack();
+        test_shared_payloads();
+        test_chain_planner();
+        test_chain_reordering();
         
         std::cout << "All Chain Replication tests passed!" << std::endl;
     }
@@ -120,12 +128,25 @@ private:
         write_request.value = "new_value";
         write_request.sender_id = 100; // Client
         
+        // The successor's ack commits version 1 while the head waits for it
+        auto acker = std::async(std::launch::async, [&chain]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Message ack_msg;
+            ack_msg.type = MessageType::CHAIN_ACK;
+            ack_msg.sender_id = 2;
+            ack_msg.log_index = 1;
+            ack_msg.success = true;
+            chain.handle_chain_ack(ack_msg);
+        });
+        
         Message write_response;
         bool success = chain.process_write(write_request, write_response);
+        acker.get();
         
         assert(success);
         assert(write_response.type == MessageType::WRITE_RESPONSE);
         assert(write_response.success);
+        assert(write_response.log_index == 1);
         
         // Verify data was written to head
         std::string stored_value;
@@ -234,16 +255,50 @@ private:
         chain.set_batch_size(5);
         
         // Test multiple writes with batching enabled
+        std::vector<std::future<bool>> writes;
         for (int i = 0; i < 3; i++) {
             Message write_msg;
             write_msg.type = MessageType::WRITE_REQUEST;
             write_msg.key = "batch_key_" + std::to_string(i);
             write_msg.value = "batch_value_" + std::to_string(i);
-            
-            Message response;
-            bool success = chain.process_write(write_msg, response);
-            assert(success);
+            writes.push_back(chain.submit_write(write_msg));
+        }
+        
+        // The partial batch is flushed by the max-delay deadline
+        chain.set_batch_max_delay_us(1000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        assert(chain.get_batches_flushed() == 1);
+        assert(chain.get_inflight_writes() == 3);
+        
+        Message ack_msg;
+        ack_msg.type = MessageType::CHAIN_ACK;
+        ack_msg.sender_id = 2;
+        ack_msg.log_index = 3;
+        ack_msg.success = true;
+        chain.handle_chain_ack(ack_msg);
+        for (auto& write : writes) {
+            assert(write.get());
+        }
+        
+        // A batch write answers each write once the tail has committed it
+        std::vector<Message> requests(2);
+        for (size_t i = 0; i < requests.size(); i++) {
+            requests[i].type = MessageType::WRITE_REQUEST;
+            requests[i].key = "batch_call_key_" + std::to_string(i);
+            requests[i].value = "batch_call_value";
         }
+        std::vector<Message> responses;
+        auto batch_written = std::async(std::launch::async, [&chain, &requests, &responses]() {
+            return chain.process_batch_write(requests, responses);
+        });
+        assert(batch_written.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+        assert(chain.get_inflight_writes() == 2);
+        
+        ack_msg.log_index = 5;
+        chain.handle_chain_ack(ack_msg);
+        assert(batch_written.get());
+        assert(responses[0].success && responses[0].log_index == 4);
+        assert(responses[1].success && responses[1].log_index == 5);
         
         std::cout << "✓ Write batching test passed" << std::endl;
     }
@@ -265,12 +320,345 @@ private:
         write_msg.key = "pipeline_key";
         write_msg.value = "pipeline_value";
         
+        // The batched write is answered after the tail acks its version
+        auto acker = std::async(std::launch::async, [&chain]() {
+            while (chain.get_inflight_writes() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            Message ack_msg;
+            ack_msg.type = MessageType::CHAIN_ACK;
+            ack_msg.sender_id = 2;
+            ack_msg.log_index = 1;
+            ack_msg.success = true;
+            chain.handle_chain_ack(ack_msg);
+        });
+        
         Message response;
         bool success = chain.process_write(write_msg, response);
+        acker.get();
         assert(success);
+        assert(response.log_index == 1);
         
         std::cout << "✓ Write pipelining test passed" << std::endl;
     }
+    
+    void test_craq_reads() {
+        std::cout << "Testing CRAQ reads at non-tail replicas..." << std::endl;
+        
+        std::vector<uint32_t> node_ids = {1, 2, 3};
+        auto middle_node = std::make_shared<Node>(2, node_ids);
+        
+        std::vector<uint32_t> chain_order = {1, 2, 3};
+        ChainReplication chain(middle_node, chain_order);
+        chain.set_version_query_timeout(10);
+        
+        // A write passing through the middle leaves the key dirty
+        Message forward_msg;
+        forward_msg.type = MessageType::CHAIN_FORWARD;
+        forward_msg.sender_id = 1;
+        forward_msg.key = "craq_key";
+        forward_msg.value = "craq_value";
+        forward_msg.log_index = 1;
+        chain.handle_chain_forward(forward_msg);
+        assert(chain.is_key_dirty("craq_key"));
+        
+        // Without a tail answer the dirty read cannot be served locally
+        Message read_request;
+        read_request.type = MessageType::READ_REQUEST;
+        read_request.key = "craq_key";
+        read_request.sender_id = 100;
+        
+        Message read_response;
+        assert(!chain.process_read(read_request, read_response));
+        
+        // The tail's ack makes the version clean and locally readable
+        Message ack_msg;
+        ack_msg.type = MessageType::CHAIN_ACK;
+        ack_msg.sender_id = 3;
+        ack_msg.key = "craq_key";
+        ack_msg.log_index = 1;
+        ack_msg.success = true;
+        chain.handle_chain_ack(ack_msg);
+        assert(!chain.is_key_dirty("craq_key"));
+        
+        Message clean_response;
+        assert(chain.process_read(read_request, clean_response));
+        assert(clean_response.value == "craq_value");
+        assert(chain.get_clean_read_count() == 1);
+        
+        std::cout << "✓ CRAQ read test passed" << std::endl;
+    }
+    
+    void test_ack_driven_completion() {
+        std::cout << "Testing ack-driven write completion..." << std::endl;
+        
+        std::vector<uint32_t> node_ids = {1, 2, 3};
+        auto head_node = std::make_shared<Node>(1, node_ids);
+        
+        std::vector<uint32_t> chain_order = {1, 2, 3};
+        ChainReplication chain(head_node, chain_order);
+        chain.enable_batching(false);
+        chain.set_pipeline_window(8);
+        
+        std::vector<uint64_t> committed_versions;
+        chain.set_commit_listener([&committed_versions](const std::string&, uint64_t version) {
+            committed_versions.push_back(version);
+        });
+        
+        std::vector<std::future<bool>> writes;
+        for (int i = 0; i < 4; i++) {
+            Message write_msg;
+            write_msg.type = MessageType::WRITE_REQUEST;
+            write_msg.key = "pipe_key_" + std::to_string(i);
+            write_msg.value = "pipe_value_" + std::to_string(i);
+            writes.push_back(chain.submit_write(write_msg));
+        }
+        assert(chain.get_inflight_writes() == 4);
+        assert(writes[0].wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+        assert(committed_versions.empty());
+        
+        // One cumulative ack from the successor covers the first three versions
+        Message ack_msg;
+        ack_msg.type = MessageType::CHAIN_ACK;
+        ack_msg.sender_id = 2;
+        ack_msg.log_index = 3;
+        ack_msg.success = true;
+        chain.handle_chain_ack(ack_msg);
+        
+        assert(writes[0].get() && writes[1].get() && writes[2].get());
+        assert(writes[3].wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+        assert(chain.get_inflight_writes() == 1);
+        assert(chain.get_acked_version() == 3);
+        assert((committed_versions == std::vector<uint64_t>{1, 2, 3}));
+        
+        std::cout << "✓ Ack-driven completion test passed" << std::endl;
+    }
+    
+    void test_write_waits_for_tail_ack() {
+        std::cout << "Testing writes answered after the tail ack..." << std::endl;
+        
+        std::vector<uint32_t> node_ids = {1, 2, 3};
+        auto head_node = std::make_shared<Node>(1, node_ids);
+        
+        std::vector<uint32_t> chain_order = {1, 2, 3};
+        ChainReplication chain(head_node, chain_order);
+        chain.enable_batching(false);
+        chain.set_write_timeout(2000);
+        
+        Message write_msg;
+        write_msg.type = MessageType::WRITE_REQUEST;
+        write_msg.key = "acked_key";
+        write_msg.value = "acked_value";
+        
+        Message response;
+        auto written = std::async(std::launch::async, [&chain, &write_msg, &response]() {
+            return chain.process_write(write_msg, response);
+        });
+        
+        // Forwarded and applied at the head, but not committed yet
+        assert(written.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+        assert(chain.get_inflight_writes() == 1);
+        assert(chain.is_key_dirty("acked_key"));
+        
+        Message ack_msg;
+        ack_msg.type = MessageType::CHAIN_ACK;
+        ack_msg.sender_id = 2;
+        ack_msg.log_index = 1;
+        ack_msg.success = true;
+        chain.handle_chain_ack(ack_msg);
+        
+        assert(written.get());
+        assert(response.success);
+        assert(response.log_index == 1);
+        
+        // Without an ack the write is not reported as done
+        chain.set_write_timeout(50);
+        write_msg.key = "unacked_key";
+        Message unacked_response;
+        assert(!chain.process_write(write_msg, unacked_response));
+        assert(!unacked_response.success);
+        
+        std::cout << "✓ Write waits for tail ack test passed" << std::endl;
+    }
+    
+    void test_shared_payloads() {
+        std::cout << "Testing shared message payloads..." << std::endl;
+        
+        // Copies share bytes; writing through one detaches it first
+        Payload original(std::string(1024, 'x'));
+        Payload copy = original;
+        assert(copy.share_count() == 2);
+        assert(copy.data() == original.data());
+        copy.mutable_str()[0] = 'y';
+        assert(original.str()[0] == 'x' && copy.str()[0] == 'y');
+        assert(original.share_count() == 1);
+        
+        std::vector<uint32_t> node_ids = {1, 2, 3};
+        auto head_node = std::make_shared<Node>(1, node_ids);
+        std::vector<uint32_t> chain_order = {1, 2, 3};
+        ChainReplication chain(head_node, chain_order);
+        chain.enable_batching(false);
+        
+        Message write_msg;
+        write_msg.type = MessageType::WRITE_REQUEST;
+        write_msg.key = "shared_key";
+        write_msg.value = std::string(4096, 'v');
+        std::future<bool> written = chain.submit_write(write_msg);
+        
+        // Storage, the dirty version and the pending forward hold one buffer
+        ValueRef stored = head_node->read_ref("shared_key");
+        assert(stored && stored->data() == write_msg.value.data());
+        long dirty_owners = stored.use_count();
+        assert(dirty_owners >= 5);
+        
+        Message ack_msg;
+        ack_msg.type = MessageType::CHAIN_ACK;
+        ack_msg.sender_id = 2;
+        ack_msg.log_index = 1;
+        ack_msg.success = true;
+        chain.handle_chain_ack(ack_msg);
+        assert(written.get());
+        
+        // Committing drops the dirty and pending copies, not the bytes
+        assert(head_node->read_ref("shared_key") == stored);
+        assert(stored.use_count() < dirty_owners);
+        
+        BufferPool pool(4);
+        std::string frame = pool.acquire();
+        frame.reserve(4096);
+        pool.release(std::move(frame));
+        std::string reused = pool.acquire();
+        assert(reused.empty() && reused.capacity() >= 4096);
+        assert(pool.get_reuse_count() == 1);
+        
+        std::cout << "✓ Shared payloads test passed" << std::endl;
+    }
+    
+    void test_chain_planner() {
+        std::cout << "Testing latency-aware chain planning..." << std::endl;
+        
+        // Two zones, 1ms inside each and 20ms between them
+        LatencyMatrix rtt;
+        std::vector<uint32_t> zone_of = {0, 0, 0, 1, 1};
+        for (uint32_t a = 1; a <= 4; a++) {
+            for (uint32_t b = 1; b <= 4; b++) {
+                if (a != b) {
+                    rtt.set(a, b, zone_of[a] == zone_of[b] ? 1.0 : 20.0);
+                }
+            }
+        }
+        ChainPlacementPolicy policy;
+        policy.failure_domains = {{1, 0}, {2, 0}, {3, 1}, {4, 1}};
+        
+        std::vector<uint32_t> zigzag = {1, 3, 2, 4};
+        ChainPlan plan = ChainPlanner::plan(zigzag, rtt, policy, true);
+        assert(plan.changed);
+        assert(plan.current_cost_ms == 60.0 && plan.cost_ms == 22.0);
+        assert(zone_of[plan.order[0]] == zone_of[plan.order[1]]);
+        assert(zone_of[plan.order.front()] != zone_of[plan.order.back()]);
+        
+        // Clients near node 1 and readers near node 2 would put both ends in
+        // zone 0; the domain constraint keeps them apart
+        LatencyMatrix flat;
+        flat.set(1, 2, 1.0);
+        flat.set(1, 3, 1.0);
+        flat.set(2, 3, 1.0);
+        std::vector<uint32_t> three = {1, 2, 3};
+        policy.client_rtt_ms = {{1, 0.0}, {2, 10.0}, {3, 10.0}};
+        policy.reader_rtt_ms = {{1, 10.0}, {2, 0.0}, {3, 10.0}};
+        plan = ChainPlanner::plan(three, flat, policy, false);
+        assert(zone_of[plan.order.front()] != zone_of[plan.order.back()]);
+        policy.separate_head_and_tail = false;
+        assert(ChainPlanner::cost({1, 3, 2}, flat, policy) < ChainPlanner::cost(plan.order, flat, policy));
+        
+        // Small savings wait for a membership change
+        LatencyMatrix close;
+        close.set(1, 2, 10.0);
+        close.set(2, 3, 10.0);
+        close.set(1, 3, 10.3);
+        ChainPlacementPolicy defaults;
+        std::vector<uint32_t> nearly = {2, 1, 3};
+        assert(!ChainPlanner::plan(nearly, close, defaults, true).changed);
+        assert(ChainPlanner::plan(nearly, close, defaults, false).changed);
+        
+        // Past the exact limit the heuristic still straightens a line
+        LatencyMatrix line;
+        std::vector<uint32_t> shuffled = {7, 2, 11, 4, 9, 1, 12, 5, 3, 10, 6, 8};
+        for (uint32_t a = 1; a <= 12; a++) {
+            for (uint32_t b = a + 1; b <= 12; b++) {
+                line.set(a, b, static_cast<double>(b - a));
+            }
+        }
+        plan = ChainPlanner::plan(shuffled, line, defaults, true);
+        assert(shuffled.size() > ChainPlanner::kMaxExactNodes);
+        assert(plan.changed && plan.cost_ms == 11.0);
+        
+        std::cout << "✓ Chain planner test passed" << std::endl;
+    }
+    
+    void test_chain_reordering() {
+        std::cout << "Testing online chain reordering..." << std::endl;
+        
+        std::vector<uint32_t> node_ids = {1, 2, 3};
+        std::vector<uint32_t> chain_order = {1, 2, 3};
+        
+        // A forward from the next epoch waits for its CHAIN_UPDATE
+        auto member_node = std::make_shared<Node>(2, node_ids);
+        ChainReplication member(member_node, chain_order);
+        Message forward_msg;
+        forward_msg.type = MessageType::CHAIN_FORWARD;
+        forward_msg.sender_id = 3;
+        forward_msg.key = "moved_key";
+        forward_msg.value = "moved_value";
+        forward_msg.log_index = 1;
+        forward_msg.ballot = 1;
+        member.handle_chain_forward(forward_msg);
+        assert(!member.is_key_dirty("moved_key") && member.get_inflight_writes() == 0);
+        
+        Message update_msg;
+        update_msg.type = MessageType::CHAIN_UPDATE;
+        update_msg.sender_id = 1;
+        update_msg.ballot = 1;
+        update_msg.target_nodes = {1, 3, 2};
+        member.handle_chain_update(update_msg);
+        assert(member.get_chain_epoch() == 1 && member.is_tail());
+        std::string value;
+        assert(member_node->read("moved_key", value) && value == "moved_value");
+        assert(!member.is_key_dirty("moved_key"));
+        
+        // Stale orders are ignored
+        update_msg.target_nodes = {2, 1, 3};
+        member.handle_chain_update(update_msg);
+        assert(member.get_chain_order() == std::vector<uint32_t>({1, 3, 2}));
+        
+        // The head plans from the rows its members report
+        auto head_node = std::make_shared<Node>(1, node_ids);
+        ChainReplication head(head_node, chain_order);
+        ChainPlacementPolicy policy;
+        policy.client_rtt_ms = {{1, 0.0}, {2, 5.0}, {3, 5.0}};
+        head.set_placement_policy(policy);
+        
+        auto report = [&head](uint32_t sender, const std::vector<uint32_t>& peers,
+                              const std::vector<uint32_t>& rtts_us) {
+            Message report_msg;
+            report_msg.type = MessageType::CHAIN_UPDATE;
+            report_msg.sender_id = sender;
+            report_msg.metadata = "rtt_row";
+            report_msg.target_nodes = peers;
+            report_msg.value = std::string(reinterpret_cast<const char*>(rtts_us.data()),
+                                           rtts_us.size() * sizeof(uint32_t));
+            head.handle_chain_update(report_msg);
+        };
+        report(2, {1, 3}, {50000, 1000});
+        report(3, {1, 2}, {1000, 1000});
+        
+        assert(head.reorder_chain());
+        assert(head.get_chain_order() == std::vector<uint32_t>({1, 3, 2}));
+        assert(head.get_chain_epoch() == 1 && head.get_reorders_applied() == 1);
+        assert(!head.reorder_chain());
+        
+        std::cout << "✓ Chain reordering test passed" << std::endl;
+    }
 };
 
 void run_chain_replication_tests() {
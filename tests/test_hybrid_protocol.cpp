@@ -1,6 +1,11 @@
 #include "protocols/hybrid_protocol.h"
+#include "protocols/partitioned_replication.h"
+#include "core/merkle_tree.h"
 #include "core/node.h"
+#include "core/partition_map.h"
+#include "network/network_manager.h"
 #include "utils/logger.h"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
@@ -20,8 +25,17 @@ public:
         
         test_hybrid_initialization();
         test_adaptive_mode_switching();
+        test_mode_switch_hysteresis();
         test_intelligent_routing();
         test_caching_layer();
+        test_read_cache_bounds();
+        test_cache_coherence();
+        test_per_key_routing();
+        test_multi_get_put();
+        test_hedged_reads();
+        test_peer_telemetry();
+        test_anti_entropy_catch_up();
+        test_partitioned_replication();
         test_load_balancing();
         test_fault_tolerance();
         test_performance_optimization();
@@ -102,6 +116,463 @@ private:
         std::cout << "    ✓ Adaptive mode switching test passed" << std::endl;
     }
     
+    void test_mode_switch_hysteresis() {
+        std::cout << "  Testing mode switch hysteresis..." << std::endl;
+        
+        std::vector<uint32_t> nodes = {1};
+        auto node = std::make_shared<Node>(1, nodes);
+        node->start();
+        
+        HybridProtocol hybrid(node, nodes, nodes);
+        hybrid.set_switch_hysteresis(0, 3);
+        
+        AdaptiveMetrics read_heavy;
+        read_heavy.read_write_ratio = 5.0;
+        read_heavy.throughput = 1000.0;
+        read_heavy.network_partition_probability = 0.1;
+        read_heavy.active_nodes = 3;
+        
+        AdaptiveMetrics write_heavy = read_heavy;
+        write_heavy.read_write_ratio = 0.3;
+        write_heavy.active_nodes = 7;
+        
+        // An oscillating workload never confirms a new mode
+        for (int i = 0; i < 6; ++i) {
+            hybrid.update_workload_metrics(i % 2 == 0 ? read_heavy : write_heavy);
+        }
+        assert(hybrid.get_current_mode() == ReplicationMode::HYBRID_AUTO);
+        assert(hybrid.get_mode_epoch() == 0);
+        
+        // A sustained one switches once, through a new epoch
+        for (int i = 0; i < 3; ++i) {
+            hybrid.update_workload_metrics(read_heavy);
+        }
+        assert(hybrid.get_current_mode() == ReplicationMode::CHAIN_ONLY);
+        assert(hybrid.get_mode_epoch() == 1);
+        assert(hybrid.get_mode_switch_count() == 1);
+        
+        // The dwell time holds the new mode
+        hybrid.set_switch_hysteresis(60000, 1);
+        hybrid.update_workload_metrics(write_heavy);
+        assert(hybrid.get_current_mode() == ReplicationMode::CHAIN_ONLY);
+        
+        // Fences from other replicas: newer epochs are adopted, stale ones ignored
+        Message fence;
+        fence.type = MessageType::MODE_SWITCH;
+        fence.sender_id = 2;
+        fence.sequence_number = static_cast<uint32_t>(ReplicationMode::QUORUM_ONLY);
+        fence.log_index = 5;
+        hybrid.handle_mode_switch(fence);
+        assert(hybrid.get_current_mode() == ReplicationMode::QUORUM_ONLY);
+        assert(hybrid.get_mode_epoch() == 5);
+        
+        fence.sequence_number = static_cast<uint32_t>(ReplicationMode::CHAIN_ONLY);
+        fence.log_index = 4;
+        hybrid.handle_mode_switch(fence);
+        assert(hybrid.get_current_mode() == ReplicationMode::QUORUM_ONLY);
+        
+        // Concurrent fences of one epoch: the higher sender wins everywhere
+        fence.sender_id = 3;
+        fence.log_index = 5;
+        hybrid.handle_mode_switch(fence);
+        assert(hybrid.get_current_mode() == ReplicationMode::CHAIN_ONLY);
+        assert(hybrid.get_mode_epoch() == 5);
+        
+        fence.sender_id = 2;
+        fence.sequence_number = static_cast<uint32_t>(ReplicationMode::QUORUM_ONLY);
+        hybrid.handle_mode_switch(fence);
+        assert(hybrid.get_current_mode() == ReplicationMode::CHAIN_ONLY);
+        
+        // Writes keep flowing across a manual switch
+        assert(hybrid.switch_mode(ReplicationMode::CHAIN_ONLY));
+        assert(hybrid.get_mode_epoch() == 6);
+        Message write_request;
+        write_request.type = MessageType::WRITE_REQUEST;
+        write_request.key = "after_switch";
+        write_request.value = "value";
+        Message write_response;
+        assert(hybrid.process_write(write_request, write_response));
+        assert(hybrid.get_mode_switching_overhead() >= 0.0);
+        
+        node->stop();
+        std::cout << "    ✓ Mode switch hysteresis test passed" << std::endl;
+    }
+    
+    void test_multi_get_put() {
+        std::cout << "  Testing multi_get/multi_put batching..." << std::endl;
+        
+        std::vector<uint32_t> nodes = {1};
+        auto node = std::make_shared<Node>(1, nodes);
+        node->start();
+        
+        HybridProtocol hybrid(node, nodes, nodes);
+        
+        std::vector<std::pair<std::string, std::string>> entries = {
+            {"batch_a", "1"}, {"batch_b", "2"}, {"batch_c", "3"}
+        };
+        std::vector<Message> responses;
+        assert(hybrid.multi_put(entries, responses));
+        assert(responses.size() == 3);
+        for (size_t i = 0; i < responses.size(); ++i) {
+            assert(responses[i].success);
+            assert(responses[i].key == entries[i].first);
+        }
+        
+        // Responses line up with the keys, misses included
+        std::vector<std::string> keys = {"batch_c", "batch_missing", "batch_a"};
+        assert(!hybrid.multi_get(keys, responses));
+        assert(responses.size() == 3);
+        assert(responses[0].success && responses[0].value == "3");
+        assert(!responses[1].success);
+        assert(responses[2].success && responses[2].value == "1");
+        
+        // A batched overwrite invalidates what the batched read cached
+        assert(hybrid.multi_put({{"batch_a", "updated"}}, responses));
+        assert(hybrid.multi_get({"batch_a"}, responses));
+        assert(responses[0].value == "updated");
+        
+        // With batching off the same calls go key by key
+        hybrid.enable_request_batching(false);
+        assert(hybrid.multi_put({{"batch_d", "4"}}, responses));
+        assert(hybrid.multi_get({"batch_b", "batch_d"}, responses));
+        assert(responses[0].value == "2" && responses[1].value == "4");
+        
+        node->stop();
+        std::cout << "    ✓ multi_get/multi_put test passed" << std::endl;
+    }
+    
+    void test_hedged_reads() {
+        std::cout << "  Testing hedged reads..." << std::endl;
+        
+        std::vector<uint32_t> nodes = {1, 2};
+        auto node = std::make_shared<Node>(1, nodes);
+        node->start();
+        
+        HybridProtocol hybrid(node, nodes, nodes);
+        hybrid.enable_adaptive_switching(false);
+        hybrid.enable_caching(false);
+        hybrid.set_write_preference(ReplicationMode::CHAIN_ONLY);
+        hybrid.set_hedge_policy(1, 1000);
+        hybrid.enable_speculative_execution(true);
+        
+        // A clean key is answered by the primary well before the hedge delay
+        node->write("hedge_clean", "value");
+        Message request;
+        request.type = MessageType::READ_REQUEST;
+        request.key = "hedge_clean";
+        Message response;
+        assert(hybrid.process_read(request, response));
+        assert(response.value == "value");
+        assert(hybrid.get_hedged_read_count() == 0);
+        
+        // The tail (node 2) never acks, so the key stays dirty on the head and
+        // the primary blocks on a version query; the duplicate answers first
+        Message write_request;
+        write_request.type = MessageType::WRITE_REQUEST;
+        write_request.key = "hedge_dirty";
+        write_request.value = "uncommitted";
+        hybrid.process_write(write_request, response);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        
+        std::thread replica([&hybrid]() {
+            while (hybrid.get_hedges_inflight() == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            Message answer;
+            answer.type = MessageType::READ_RESPONSE;
+            answer.sender_id = 2;
+            answer.sequence_number = 1; // first hedge id
+            answer.key = "hedge_dirty";
+            answer.value = "committed";
+            answer.metadata = "hedged_read";
+            answer.success = true;
+            hybrid.handle_hedged_read_response(answer);
+        });
+        
+        auto start = std::chrono::steady_clock::now();
+        request.key = "hedge_dirty";
+        assert(hybrid.process_read(request, response));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        replica.join();
+        
+        assert(response.value == "committed");
+        assert(hybrid.get_hedged_read_count() == 1);
+        assert(hybrid.get_hedge_win_count() == 1);
+        assert(hybrid.get_hedges_inflight() == 0);
+        assert(elapsed < std::chrono::milliseconds(500));
+        
+        node->stop();
+        std::cout << "    ✓ Hedged reads test passed" << std::endl;
+    }
+    
+    void test_peer_telemetry() {
+        std::cout << "  Testing peer telemetry..." << std::endl;
+        
+        PeerTelemetry telemetry;
+        uint64_t token = PeerTelemetry::token(static_cast<uint32_t>(MessageType::QUORUM_ACCEPT), 7);
+        
+        // Replies are matched to their send and leave nothing outstanding
+        telemetry.on_request_sent(2, token);
+        assert(telemetry.get_stats(2).outstanding == 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        assert(telemetry.on_reply_received(2, token));
+        assert(!telemetry.on_reply_received(2, token)); // already answered
+        assert(!telemetry.on_reply_received(9, token)); // never sent
+        PeerTelemetry::PeerStats stats = telemetry.get_stats(2);
+        assert(stats.samples == 1);
+        assert(stats.outstanding == 0);
+        assert(stats.mean_rtt_us >= 2000.0);
+        
+        // The sample ring keeps only the most recent round trips
+        for (size_t i = 0; i < 2 * PeerTelemetry::kRttSamples; ++i) {
+            telemetry.record_rtt(3, 100);
+        }
+        stats = telemetry.get_stats(3);
+        assert(stats.samples == 2 * PeerTelemetry::kRttSamples);
+        assert(stats.mean_rtt_us == 100.0);
+        assert(stats.max_rtt_us == 100);
+        
+        // A fast peer with a backlog loses to a slower idle one
+        telemetry.record_rtt(4, 300);
+        for (uint64_t id = 0; id < 8; ++id) {
+            telemetry.on_request_sent(3, PeerTelemetry::token(static_cast<uint32_t>(MessageType::READ_REQUEST), id));
+        }
+        assert(telemetry.load_score(3) > telemetry.load_score(4));
+        std::vector<uint32_t> ranked = telemetry.rank({3, 4});
+        assert(ranked.size() == 2 && ranked[0] == 4);
+        for (int i = 0; i < 20; ++i) {
+            assert(telemetry.pick_two({3, 4}) == 4);
+        }
+        assert(telemetry.pick_two({}) == 0);
+        
+        std::vector<uint32_t> nodes = {1};
+        auto node = std::make_shared<Node>(1, nodes);
+        HybridProtocol hybrid(node, nodes, nodes);
+        assert(hybrid.get_peer_telemetry() != nullptr);
+        
+        std::cout << "    ✓ Peer telemetry test passed" << std::endl;
+    }
+    
+    void test_anti_entropy_catch_up() {
+        std::cout << "  Testing anti-entropy catch-up..." << std::endl;
+        
+        // Equal stores hash equal whatever their insertion order; one changed
+        // key differs only along the path to its leaf
+        ShardedStorageEngine source_store, stale_store;
+        for (int i = 0; i < 1000; ++i) {
+            source_store.put("ae_key" + std::to_string(i), "value" + std::to_string(i));
+            stale_store.put("ae_key" + std::to_string(999 - i), "value" + std::to_string(999 - i));
+        }
+        MerkleTree source_tree, stale_tree;
+        source_tree.build(source_store);
+        stale_tree.build(stale_store);
+        assert(source_tree.root_hash() == stale_tree.root_hash());
+        
+        stale_store.put("ae_key7", "stale");
+        stale_tree.build(stale_store, true);
+        assert(source_tree.root_hash() != stale_tree.root_hash());
+        size_t leaf = MerkleTree::leaf_for("ae_key7");
+        size_t differing = 0;
+        for (size_t i = 0; i < MerkleTree::kLeafCount; ++i) {
+            differing += source_tree.node_hash(MerkleTree::kDepth, i) != stale_tree.node_hash(MerkleTree::kDepth, i);
+        }
+        assert(differing == 1);
+        assert(source_tree.node_hash(MerkleTree::kDepth, leaf) != stale_tree.node_hash(MerkleTree::kDepth, leaf));
+        const std::vector<std::string>& leaf_keys = stale_tree.leaf_keys(leaf);
+        assert(std::find(leaf_keys.begin(), leaf_keys.end(), "ae_key7") != leaf_keys.end());
+        
+        std::vector<uint32_t> nodes = {1, 2};
+        auto node = std::make_shared<Node>(1, nodes);
+        node->start();
+        HybridProtocol hybrid(node, nodes, nodes);
+        hybrid.enable_adaptive_switching(false);
+        hybrid.enable_caching(false);
+        
+        // While catching up the node refuses reads, and range data never
+        // overwrites a key written since the catch-up began
+        node->write("ae_old", "old");
+        node->begin_catch_up();
+        assert(!node->is_serving());
+        Message request;
+        request.type = MessageType::READ_REQUEST;
+        request.key = "ae_old";
+        Message response;
+        assert(!hybrid.process_read(request, response));
+        
+        node->write("ae_live", "new");
+        size_t applied = node->apply_catch_up({{"ae_live", "older"}, {"ae_missing", "fetched"}}, {"ae_old"});
+        assert(applied == 2);
+        std::string value;
+        assert(node->read("ae_live", value) && value == "new");
+        assert(node->read("ae_missing", value) && value == "fetched");
+        assert(!node->read("ae_old", value));
+        node->end_catch_up();
+        assert(node->is_serving());
+        
+        // A recovered peer is held back until it reports it has caught up
+        hybrid.handle_node_recovery(2);
+        assert(hybrid.get_catching_up_nodes() == std::vector<uint32_t>{2});
+        Message complete;
+        complete.type = MessageType::SYNC_COMPLETE;
+        complete.sender_id = 2;
+        complete.log_index = 0; // promote
+        hybrid.handle_anti_entropy_message(complete);
+        assert(hybrid.get_catching_up_nodes().empty());
+
+        // Seen from a node that was itself cut off, the peer kept serving
+        hybrid.handle_node_failure(2);
+        hybrid.readmit_node(2);
+        assert(hybrid.get_catching_up_nodes().empty());
+
+        node->stop();
+
+        // Over loopback: the source holds the recovered node back, and that
+        // node walks the source's tree and fetches the differing ranges
+        std::vector<uint32_t> pair = {3, 4};
+        auto source = std::make_shared<Node>(3, pair);
+        auto stale = std::make_shared<Node>(4, pair);
+        assert(source->start() && stale->start());
+        source->get_network_manager()->add_node(4, "127.0.0.1", stale->get_network_manager()->get_listen_port());
+        stale->get_network_manager()->add_node(3, "127.0.0.1", source->get_network_manager()->get_listen_port());
+        for (int i = 0; i < 1000; ++i) {
+            source->write("sync_key" + std::to_string(i), "value" + std::to_string(i));
+            if (i < 990) {
+                stale->write("sync_key" + std::to_string(i), "value" + std::to_string(i));
+            }
+        }
+        stale->write("sync_key0", "stale");
+        stale->write("sync_gone", "deleted meanwhile");
+
+        source->get_hybrid_protocol()->handle_node_recovery(4);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while ((!source->get_hybrid_protocol()->get_catching_up_nodes().empty() || !stale->is_serving()) &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        assert(source->get_hybrid_protocol()->get_catching_up_nodes().empty());
+        assert(stale->is_serving());
+        for (int i = 0; i < 1000; ++i) {
+            assert(stale->read("sync_key" + std::to_string(i), value) && value == "value" + std::to_string(i));
+        }
+        assert(!stale->read("sync_gone", value));
+        AntiEntropyStats stats = stale->get_hybrid_protocol()->get_anti_entropy_stats();
+        assert(stats.passes >= 2); // catch-up, then the pass after promotion
+        assert(stats.ranges_transferred > 0 && stats.ranges_transferred < MerkleTree::kLeafCount);
+        assert(stats.keys_removed == 1);
+
+        stale->stop();
+        source->stop();
+        std::cout << "    ✓ Anti-entropy catch-up test passed" << std::endl;
+    }
+    
+    void test_partitioned_replication() {
+        std::cout << "  Testing partitioned replication..." << std::endl;
+        
+        // Every partition gets distinct replicas, and heads spread over the nodes
+        std::vector<uint32_t> nodes = {1, 2, 3, 4, 5};
+        PartitionConfig config;
+        config.partition_count = 64;
+        config.replication_factor = 3;
+        PartitionMap map(nodes, config);
+        assert(map.get_partition_count() == 64);
+        std::vector<size_t> led(6, 0);
+        for (uint32_t partition = 0; partition < map.get_partition_count(); ++partition) {
+            std::vector<uint32_t> replicas = map.replicas(partition);
+            assert(replicas.size() == 3);
+            std::sort(replicas.begin(), replicas.end());
+            assert(std::unique(replicas.begin(), replicas.end()) == replicas.end());
+            assert(map.replicates(map.leader(partition), partition));
+            led[map.leader(partition)]++;
+        }
+        for (uint32_t node_id : nodes) {
+            assert(led[node_id] >= 4);
+            assert(map.partitions_led_by(node_id).size() == led[node_id]);
+        }
+        
+        // Keys spread evenly; removing a node only moves the partitions it held
+        std::vector<size_t> keys_per_partition(64, 0);
+        for (int i = 0; i < 64000; ++i) {
+            keys_per_partition[map.partition_for("part_key" + std::to_string(i))]++;
+        }
+        for (size_t count : keys_per_partition) {
+            assert(count > 500 && count < 1500);
+        }
+        PartitionMap shrunk({1, 2, 3, 4}, config);
+        for (uint32_t partition = 0; partition < map.get_partition_count(); ++partition) {
+            if (!map.replicates(5, partition)) {
+                assert(shrunk.replicas(partition) == map.replicas(partition));
+            }
+        }
+        
+        // The partition id survives the wire, and anti-entropy trees can
+        // cover one partition alone
+        Message tagged;
+        tagged.type = MessageType::QUORUM_PREPARE;
+        tagged.partition_id = 42;
+        assert(Message::deserialize(tagged.serialize()).partition_id == 42);
+        ShardedStorageEngine store;
+        size_t in_partition = 0;
+        for (int i = 0; i < 1000; ++i) {
+            std::string key = "part_key" + std::to_string(i);
+            store.put(key, "value");
+            in_partition += map.partition_for(key) == 7;
+        }
+        MerkleTree scoped;
+        scoped.build(store, false, [&map](const std::string& key) { return map.partition_for(key) == 7; });
+        assert(scoped.get_key_count() == in_partition);
+        
+        // Node 1 of three runs a group for each partition it replicates and
+        // refuses keys of the others, naming their replicas
+        std::vector<uint32_t> cluster = {1, 2, 3};
+        auto node = std::make_shared<Node>(1, cluster);
+        config.partition_count = 8;
+        config.replication_factor = 1;
+        auto partitions = std::make_shared<PartitionedReplication>(node, config);
+        node->attach_partitions(partitions);
+        node->start();
+        const PartitionMap& placement = partitions->get_partition_map();
+        assert(partitions->get_group_count() == placement.partitions_of(1).size());
+        
+        std::string local_key, remote_key;
+        for (int i = 0; local_key.empty() || remote_key.empty(); ++i) {
+            std::string key = "part_key" + std::to_string(i);
+            (placement.replicates(1, placement.partition_for(key)) ? local_key : remote_key) = key;
+        }
+        uint32_t remote_partition = placement.partition_for(remote_key);
+        assert(!partitions->get_group(remote_partition));
+        assert(partitions->get_group(placement.partition_for(local_key))->get_partition() ==
+               placement.partition_for(local_key));
+        
+        Message request;
+        request.type = MessageType::WRITE_REQUEST;
+        request.key = local_key;
+        request.value = "local";
+        Message response;
+        assert(partitions->process_write(request, response));
+        request.key = remote_key;
+        assert(!partitions->process_write(request, response));
+        assert(response.partition_id == remote_partition);
+        assert(response.target_nodes == placement.replicas(remote_partition));
+        
+        // Batches split by partition and still line up with the input
+        std::vector<Message> responses;
+        assert(!partitions->multi_put({{remote_key, "r"}, {local_key, "batched"}}, responses));
+        assert(!responses[0].success && responses[1].success);
+        assert(!partitions->multi_get({local_key, remote_key}, responses));
+        assert(responses[0].success && responses[0].value == "batched");
+        assert(!responses[1].success && responses[1].target_nodes == placement.replicas(remote_partition));
+        
+        // Protocol traffic for a partition held elsewhere is dropped
+        Message stray;
+        stray.type = MessageType::QUORUM_PREPARE;
+        stray.sender_id = 2;
+        stray.partition_id = remote_partition;
+        partitions->handle_message(stray);
+        
+        node->stop();
+        std::cout << "    ✓ Partitioned replication test passed" << std::endl;
+    }
+    
     void test_intelligent_routing() {
         std::cout << "  Testing intelligent routing..." << std::endl;
         
@@ -114,7 +585,6 @@ private:
         
         // Disable adaptive switching for predictable testing
         hybrid.enable_adaptive_switching(false);
-        hybrid.set_read_preference(ReplicationMode::CHAIN_ONLY);
         
         // Pre-populate some data
         node->write("route_key", "route_value");
@@ -166,7 +636,6 @@ private:
         // Use predictable chain-only mode for testing
         hybrid.enable_adaptive_switching(false);
         hybrid.set_write_preference(ReplicationMode::CHAIN_ONLY);
-        hybrid.set_read_preference(ReplicationMode::CHAIN_ONLY);
         
         // Write some data directly to ensure it's immediately available
         bool write_success = node->write("cache_key", "cache_value");
@@ -206,6 +675,208 @@ private:
         std::cout << "    ✓ Caching layer test passed" << std::endl;
     }
     
+    void test_read_cache_bounds() {
+        std::cout << "  Testing read cache bounds and admission..." << std::endl;
+        
+        // Entry limit: CLOCK evicts once the shard is full
+        ReadCacheConfig config;
+        config.shard_count = 1;
+        config.max_entries = 4;
+        config.admission_enabled = false;
+        ReadCache by_count(config);
+        for (int i = 0; i < 10; ++i) {
+            assert(by_count.put("key" + std::to_string(i), "value"));
+        }
+        assert(by_count.size() == 4);
+        assert(by_count.get_evictions() == 6);
+        
+        // Byte limit: 20-byte entries against a 64-byte budget
+        config.max_entries = 100;
+        config.max_bytes = 64;
+        ReadCache by_bytes(config);
+        for (int i = 0; i < 10; ++i) {
+            by_bytes.put("k" + std::to_string(i), std::string(18, 'v'));
+        }
+        assert(by_bytes.bytes() <= 64);
+        assert(by_bytes.size() == 3);
+        assert(!by_bytes.put("huge", std::string(100, 'v')));
+        
+        // TinyLFU: a one-off scan must not flush frequently read keys
+        config.max_entries = 8;
+        config.max_bytes = 1024 * 1024;
+        config.admission_enabled = true;
+        ReadCache admitted(config);
+        std::string value;
+        for (int i = 0; i < 8; ++i) {
+            admitted.put("hot" + std::to_string(i), "value");
+        }
+        for (int round = 0; round < 5; ++round) {
+            for (int i = 0; i < 8; ++i) {
+                assert(admitted.get("hot" + std::to_string(i), value));
+            }
+        }
+        for (int i = 0; i < 100; ++i) {
+            std::string key = "scan" + std::to_string(i);
+            if (!admitted.get(key, value)) {
+                admitted.put(key, "value");
+            }
+        }
+        for (int i = 0; i < 8; ++i) {
+            assert(admitted.get("hot" + std::to_string(i), value));
+        }
+        assert(admitted.get_rejections() > 0);
+        
+        // TTL expiry and explicit invalidation
+        admitted.set_ttl(1000); // 1ms
+        admitted.put("hot0", "fresh");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        assert(!admitted.get("hot0", value));
+        admitted.set_ttl(30000000);
+        admitted.put("hot1", "fresh");
+        assert(admitted.erase("hot1"));
+        assert(!admitted.get("hot1", value));
+        
+        std::cout << "    ✓ Read cache bounds test passed" << std::endl;
+    }
+    
+    void test_cache_coherence() {
+        std::cout << "  Testing versioned cache coherence..." << std::endl;
+        
+        // A fill from a read that started before an invalidation is refused
+        ReadCache cache;
+        assert(cache.put("key", "v1", 5));
+        assert(cache.invalidate("key", 7));
+        assert(!cache.put("key", "stale", 6));
+        assert(cache.put("key", "fresh", 8));
+        assert(!cache.invalidate("key", 8));
+        
+        std::vector<uint32_t> nodes = {1};
+        auto node = std::make_shared<Node>(1, nodes);
+        node->start();
+        
+        HybridProtocol hybrid(node, nodes, nodes);
+        hybrid.enable_adaptive_switching(false);
+        
+        for (int i = 0; i < 3; ++i) {
+            std::string key = "coherent" + std::to_string(i);
+            assert(node->write(key, "old"));
+            Message read_request;
+            read_request.type = MessageType::READ_REQUEST;
+            read_request.key = key;
+            Message read_response;
+            assert(hybrid.process_read(read_request, read_response));
+        }
+        assert(hybrid.get_read_cache().size() == 3);
+        
+        // Single invalidation from the committing replica
+        Message update;
+        update.type = MessageType::CACHE_UPDATE;
+        update.sender_id = 2;
+        update.key = "coherent0";
+        update.log_index = 42;
+        hybrid.handle_cache_update(update);
+        assert(hybrid.get_read_cache().size() == 2);
+        assert(hybrid.get_cache_version() > 42);
+        
+        // Batched invalidations travel as frames in the value
+        Message batch;
+        batch.type = MessageType::CACHE_UPDATE;
+        batch.sender_id = 2;
+        for (int i = 1; i < 3; ++i) {
+            Message invalidation;
+            invalidation.key = "coherent" + std::to_string(i);
+            invalidation.log_index = 43;
+            invalidation.serialize_to(batch.value.mutable_str());
+        }
+        hybrid.handle_cache_update(batch);
+        assert(hybrid.get_read_cache().size() == 0);
+        
+        node->stop();
+        std::cout << "    ✓ Cache coherence test passed" << std::endl;
+    }
+    
+    void test_per_key_routing() {
+        std::cout << "  Testing per-key routing..." << std::endl;
+        
+        // Counts halve once per half-life
+        HotKeyTracker tracker(1024, 1000);
+        for (int i = 0; i < 100; ++i) {
+            tracker.record_read("key", 10);
+        }
+        assert(tracker.heat("key").reads >= 100);
+        tracker.record_read("key", 2000);
+        assert(tracker.heat("key").reads <= 60);
+        assert(tracker.heat("cold").total() == 0);
+        
+        std::vector<uint32_t> nodes = {1};
+        auto node = std::make_shared<Node>(1, nodes);
+        node->start();
+        
+        HybridProtocol hybrid(node, nodes, nodes);
+        hybrid.enable_caching(false); // every read must reach the router
+        hybrid.set_hot_key_thresholds(32, 4.0, 1.0);
+        
+        assert(node->write("read_mostly", "value"));
+        for (int i = 0; i < 64; ++i) {
+            Message request;
+            request.type = MessageType::READ_REQUEST;
+            request.key = "read_mostly";
+            Message response;
+            hybrid.process_read(request, response);
+        }
+        for (int i = 0; i < 64; ++i) {
+            Message request;
+            request.type = MessageType::WRITE_REQUEST;
+            request.key = "contended";
+            request.value = "v" + std::to_string(i);
+            Message response;
+            hybrid.process_write(request, response);
+        }
+        
+        assert(hybrid.get_key_heat("read_mostly").reads >= 64);
+        assert(hybrid.get_key_route("read_mostly") == ReplicationMode::CHAIN_ONLY);
+        assert(hybrid.get_key_route("contended") == ReplicationMode::QUORUM_ONLY);
+        assert(hybrid.get_key_route("cold") == ReplicationMode::HYBRID_AUTO);
+        
+        // Reads and writes of a key share one route. The read-mostly key was
+        // pinned to chain; the others keep the default route, quorum.
+        assert(hybrid.get_pinned_route("read_mostly") == ReplicationMode::CHAIN_ONLY);
+        assert(hybrid.get_pinned_route("contended") == ReplicationMode::QUORUM_ONLY);
+        assert(hybrid.get_pinned_route("cold") == ReplicationMode::QUORUM_ONLY);
+        Message write_request;
+        write_request.type = MessageType::WRITE_REQUEST;
+        write_request.key = "read_mostly";
+        write_request.value = "updated";
+        Message write_response;
+        assert(hybrid.process_write(write_request, write_response));
+        assert(HybridProtocol::get_last_mode_used() == ReplicationMode::CHAIN_ONLY);
+        
+        // Pins from other replicas are fenced per key: the higher sender of
+        // an epoch wins, older epochs are ignored
+        Message pin;
+        pin.type = MessageType::MODE_SWITCH;
+        pin.sender_id = 3;
+        pin.key = "cold";
+        pin.sequence_number = static_cast<uint32_t>(ReplicationMode::CHAIN_ONLY);
+        pin.log_index = 2;
+        hybrid.handle_mode_switch(pin);
+        assert(hybrid.get_pinned_route("cold") == ReplicationMode::CHAIN_ONLY);
+        pin.sender_id = 2;
+        pin.sequence_number = static_cast<uint32_t>(ReplicationMode::QUORUM_ONLY);
+        hybrid.handle_mode_switch(pin);
+        pin.log_index = 1;
+        hybrid.handle_mode_switch(pin);
+        assert(hybrid.get_pinned_route("cold") == ReplicationMode::CHAIN_ONLY);
+        assert(hybrid.get_current_mode() == ReplicationMode::HYBRID_AUTO);
+        
+        // The global ratio is per instance and reflects both streams
+        AdaptiveMetrics metrics = hybrid.get_current_metrics();
+        assert(metrics.read_write_ratio > 0.5 && metrics.read_write_ratio < 2.0);
+        
+        node->stop();
+        std::cout << "    ✓ Per-key routing test passed" << std::endl;
+    }
+    
     void test_load_balancing() {
         std::cout << "  Testing load balancing..." << std::endl;
         
@@ -219,7 +890,6 @@ private:
         // Use predictable chain-only mode for testing
         hybrid.enable_adaptive_switching(false);
         hybrid.set_write_preference(ReplicationMode::CHAIN_ONLY);
-        hybrid.set_read_preference(ReplicationMode::CHAIN_ONLY);
         
         // First, write all data sequentially to ensure it's available
         std::atomic<int> successful_reads(0);
@@ -272,7 +942,6 @@ private:
         // Use predictable chain-only mode for testing
         hybrid.enable_adaptive_switching(false);
         hybrid.set_write_preference(ReplicationMode::CHAIN_ONLY);
-        hybrid.set_read_preference(ReplicationMode::CHAIN_ONLY);
         
         // Test normal operation - write directly to ensure immediate visibility
         bool success = node->write("fault_key", "fault_value");
@@ -428,7 +1097,6 @@ private:
         HybridProtocol hybrid(node, initial_chain, initial_quorum);
         
         // Test configuration preferences
-        hybrid.set_read_preference(ReplicationMode::CHAIN_ONLY);
         hybrid.set_write_preference(ReplicationMode::QUORUM_ONLY);
         
         // Test chain configuration update
@@ -1,13 +1,35 @@
 #include "performance/metrics.h"
+#include "performance/metrics_endpoint.h"
+#include "performance/workload.h"
 #include "protocols/hybrid_protocol.h"
+#include "core/message_dispatcher.h"
 #include "core/node.h"
+#include "core/snapshot.h"
+#include "network/network_manager.h"
+#include "utils/compression.h"
+#include "utils/durable_file.h"
+#include "utils/failure_detector.h"
 #include "utils/logger.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <fstream>
+#include <future>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include <thread>
 #include <chrono>
 #include <random>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 using namespace replication;
 
@@ -25,11 +47,18 @@ public:
         test_throughput_measurement();
         test_latency_measurement();
         test_percentile_calculations();
+        test_latency_histograms();
         test_metrics_export();
         test_alerting_system();
         test_system_resource_monitoring();
+        test_metrics_endpoint();
         test_protocol_comparison();
         test_scalability_limits();
+        test_durable_restart();
+        test_message_dispatch();
+        test_frame_compression();
+        test_failure_detector();
+        test_workload_generators();
         
         std::cout << "All Performance tests passed!" << std::endl;
     }
@@ -171,6 +200,57 @@ private:
                   << std::fixed << std::setprecision(1) << p95 << "ms, P99: " << p99 << "ms)" << std::endl;
     }
     
+    void test_latency_histograms() {
+        std::cout << "  Testing per-thread latency histograms..." << std::endl;
+        
+        // Bucket bounds stay within the histogram's relative error
+        for (uint64_t value : {0ULL, 63ULL, 64ULL, 1000ULL, 123456ULL, 1ULL << 30}) {
+            uint64_t bound = LatencyHistogram::bucket_upper_bound(LatencyHistogram::bucket_index(value));
+            assert(bound >= value);
+            assert(bound - value <= value / LatencyHistogram::kSubBucketCount);
+        }
+        
+        g_performance_monitor->reset_metrics();
+        
+        // 4 threads record 1us..10ms for chain reads plus slow quorum writes
+        const int thread_count = 4;
+        const int samples_per_thread = 10000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([samples_per_thread]() {
+                for (int i = 1; i <= samples_per_thread; ++i) {
+                    g_performance_monitor->record_operation(MessageType::READ_REQUEST,
+                                                            ReplicationMode::CHAIN_ONLY, i * 1000ULL, true);
+                }
+                g_performance_monitor->record_operation(MessageType::WRITE_REQUEST,
+                                                        ReplicationMode::QUORUM_ONLY, 50000000ULL, true);
+                g_performance_monitor->record_operation(MessageType::WRITE_REQUEST,
+                                                        ReplicationMode::QUORUM_ONLY, 1000ULL, false);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        LatencySummary reads = g_performance_monitor->get_latency_summary(ReplicationMode::CHAIN_ONLY,
+                                                                          MessageType::READ_REQUEST);
+        assert(reads.count == static_cast<uint64_t>(thread_count * samples_per_thread));
+        assert(reads.p50_ns >= 4900000 && reads.p50_ns <= 5100000);
+        assert(reads.p999_ns >= 9900000 && reads.p999_ns <= 10000000);
+        assert(reads.max_ns == 10000000);
+        
+        LatencySummary quorum = g_performance_monitor->get_mode_latency_summary(ReplicationMode::QUORUM_ONLY);
+        assert(quorum.count == static_cast<uint64_t>(thread_count));
+        assert(quorum.p50_ns == 50000000);
+        
+        LatencySummary writes = g_performance_monitor->get_type_latency_summary(MessageType::WRITE_REQUEST);
+        assert(writes.count == quorum.count);
+        assert(g_performance_monitor->get_success_rate() < 1.0);
+        
+        std::cout << "    ✓ Latency histogram test passed (P50: " << reads.p50_ns / 1000
+                  << "us, P99.9: " << reads.p999_ns / 1000 << "us)" << std::endl;
+    }
+    
     void test_metrics_export() {
         std::cout << "  Testing metrics export..." << std::endl;
         
@@ -266,6 +346,31 @@ private:
         assert(cpu >= 0.0 && cpu <= 100.0);
         assert(memory >= 0.0);
         assert(network >= 0.0 && network <= 100.0);
+#ifdef __linux__
+        assert(memory > 0.0); // read from /proc/self/status
+#endif
+        
+        // Network utilization is the byte source's rate against the capacity
+        {
+            PerformanceMonitor monitor;
+            std::atomic<uint64_t> bytes(0);
+            monitor.set_network_capacity(1000000.0); // 1 MB/s
+            monitor.set_network_byte_source([&bytes]() { return bytes.load(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            bytes.store(100000); // ~0.5 MB/s over the window
+            monitor.update_system_stats();
+            double utilization = monitor.get_network_utilization();
+            assert(utilization > 10.0 && utilization <= 60.0);
+            
+            std::shared_ptr<const MetricsSnapshot> snapshot = monitor.get_metrics_snapshot();
+            assert(snapshot && snapshot->network_bytes == 100000);
+            
+            // Without perf events (containers, macOS) the snapshot just omits them
+            if (!monitor.enable_hardware_counters(true)) {
+                monitor.update_system_stats();
+                assert(!monitor.get_metrics_snapshot()->hardware_counters);
+            }
+        }
         
         // Test scaling recommendations
         bool should_scale_up = g_performance_monitor->should_scale_up();
@@ -277,6 +382,62 @@ private:
         std::cout << "    ✓ System resource monitoring test passed" << std::endl;
     }
     
+    void test_metrics_endpoint() {
+        std::cout << "  Testing metrics scrape endpoint..." << std::endl;
+        
+        PerformanceMonitor monitor;
+        for (int i = 0; i < 20; ++i) {
+            monitor.record_operation(MessageType::WRITE_REQUEST, ReplicationMode::CHAIN_ONLY,
+                                     2000000, i % 10 != 0, 3);
+        }
+        
+        MetricsEndpoint endpoint(monitor, 0);
+        assert(endpoint.start());
+        assert(endpoint.get_port() != 0);
+        
+        auto scrape = [&endpoint](const std::string& path) {
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(endpoint.get_port());
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            assert(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+            std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+            assert(send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()));
+            std::string response;
+            char chunk[4096];
+            ssize_t received;
+            while ((received = recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+                response.append(chunk, static_cast<size_t>(received));
+            }
+            close(fd);
+            return response;
+        };
+        
+        // Nothing is served until the sampler has published a snapshot
+        assert(scrape("/metrics").find("503") != std::string::npos);
+        
+        monitor.start_sampler(10);
+        for (int i = 0; i < 100 && !monitor.get_metrics_snapshot(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        monitor.stop_sampler();
+        
+        std::string response = scrape("/metrics");
+        assert(response.find("HTTP/1.1 200 OK") == 0);
+        assert(response.find("replication_operations_total{mode=\"chain\",result=\"success\"} 18") != std::string::npos);
+        assert(response.find("replication_operations_total{mode=\"chain\",result=\"failure\"} 2") != std::string::npos);
+        assert(response.find("replication_latency_seconds_count{mode=\"chain\"} 18") != std::string::npos);
+        assert(response.find("replication_resident_memory_megabytes") != std::string::npos);
+        assert(scrape("/other").find("404") != std::string::npos);
+        
+        endpoint.stop();
+        assert(!endpoint.is_running());
+        
+        std::cout << "    ✓ Metrics scrape endpoint test passed" << std::endl;
+    }
+    
     void test_protocol_comparison() {
         std::cout << "  Testing protocol comparison..." << std::endl;
         
@@ -390,6 +551,614 @@ private:
         
         std::cout << "    ✓ Scalability limits test passed" << std::endl;
     }
+    
+    void test_durable_restart() {
+        std::cout << "  Testing WAL and snapshot restart..." << std::endl;
+        
+        char dir_template[] = "/tmp/replication_wal_XXXXXX";
+        assert(mkdtemp(dir_template) != nullptr);
+        std::string directory = dir_template;
+        
+        DurabilityConfig config;
+        config.directory = directory;
+        config.sync_policy = WalSyncPolicy::PER_BATCH;
+        config.snapshot_interval_ops = 0; // snapshots only when asked
+        std::vector<uint32_t> nodes = {1};
+        
+        {
+            Node node(1, nodes);
+            assert(node.enable_durability(config));
+            
+            // Concurrent writers share syncs
+            std::vector<std::thread> writers;
+            for (int t = 0; t < 8; ++t) {
+                writers.emplace_back([&node, t]() {
+                    for (int i = 0; i < 25; ++i) {
+                        assert(node.write("key_" + std::to_string(t * 25 + i), "value_" + std::to_string(i)));
+                    }
+                });
+            }
+            for (auto& writer : writers) {
+                writer.join();
+            }
+            assert(node.get_wal()->get_record_count() == 200);
+            assert(node.get_wal()->get_sync_count() < 200);
+            assert(node.get_wal()->get_durable_lsn() == 200);
+            
+            // Everything so far goes into the snapshot; the rest stays in the WAL tail
+            assert(node.take_snapshot());
+            assert(node.write("key_0", "rewritten"));
+            assert(node.delete_key("key_1"));
+            assert(node.write_batch({{"tail_a", "a"}, {"tail_b", "b"}}));
+        }
+        assert(SnapshotStore(directory).list() == std::vector<uint64_t>{200});
+        
+        {
+            Node node(1, nodes);
+            assert(node.enable_durability(config));
+            std::string value;
+            assert(node.get_storage().size() == 201);
+            assert(node.read("key_0", value) && value == "rewritten");
+            assert(!node.read("key_1", value));
+            assert(node.read("key_199", value) && value == "value_24");
+            assert(node.read("tail_b", value) && value == "b");
+            assert(node.get_wal()->get_last_lsn() == 204);
+        }
+        
+        // A crash mid-append leaves a torn record; recovery drops it and goes on
+        std::vector<uint64_t> segments = durable_file::list_numbered(directory, "wal-", ".log");
+        assert(!segments.empty());
+        std::ofstream torn(durable_file::numbered_path(directory, "wal-", segments.back(), ".log"),
+                           std::ios::binary | std::ios::app);
+        torn.write("\x30\x00\x00\x00partial", 11);
+        torn.close();
+        {
+            Node node(1, nodes);
+            assert(node.enable_durability(config));
+            std::string value;
+            assert(node.get_storage().size() == 201);
+            assert(node.write("after_torn", "ok"));
+            assert(node.get_wal()->get_last_lsn() == 205);
+        }
+        {
+            Node node(1, nodes);
+            assert(node.enable_durability(config));
+            std::string value;
+            assert(node.read("after_torn", value) && value == "ok");
+            assert(node.take_snapshot());
+        }
+        
+        for (uint64_t lsn : SnapshotStore(directory).list()) {
+            std::remove(durable_file::numbered_path(directory, "snapshot-", lsn, ".snap").c_str());
+        }
+        for (uint64_t lsn : durable_file::list_numbered(directory, "wal-", ".log")) {
+            std::remove(durable_file::numbered_path(directory, "wal-", lsn, ".log").c_str());
+        }
+        std::remove(directory.c_str());
+        
+        std::cout << "    ✓ WAL and snapshot restart test passed" << std::endl;
+    }
+    
+    void test_message_dispatch() {
+        std::cout << "  Testing sharded message dispatch..." << std::endl;
+        
+        Message keyed;
+        keyed.type = MessageType::WRITE_REQUEST;
+        keyed.key = "k";
+        Message promise;
+        promise.type = MessageType::QUORUM_PROMISE;
+        Message sync_request;
+        sync_request.type = MessageType::SYNC_RANGE_REQUEST;
+        assert(MessageDispatcher::lane_for(keyed) == DispatchLane::KEYED);
+        assert(MessageDispatcher::lane_for(promise) == DispatchLane::CONTROL);
+        assert(MessageDispatcher::lane_for(sync_request) == DispatchLane::SHARED);
+        Message forward;
+        forward.type = MessageType::CHAIN_FORWARD;
+        forward.key = "k";
+        Message commit;
+        commit.type = MessageType::QUORUM_COMMIT;
+        assert(MessageDispatcher::lane_for(forward) == DispatchLane::REPLICATION);
+        assert(MessageDispatcher::lane_for(commit) == DispatchLane::CONTROL);
+        
+        // Per-key order holds across workers fed by several producers
+        {
+            std::mutex order_mutex;
+            std::map<std::string, std::vector<uint32_t>> seen;
+            DispatcherConfig config;
+            config.worker_threads = 4;
+            config.lane_capacity = 64; // small, so producers also hit full rings
+            MessageDispatcher dispatcher([&](const Message& message) {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                seen[message.key].push_back(message.sequence_number);
+            }, config);
+            assert(dispatcher.start());
+            
+            std::vector<std::thread> producers;
+            for (int p = 0; p < 4; ++p) {
+                producers.emplace_back([&dispatcher, p]() {
+                    for (uint32_t i = 0; i < 2000; ++i) {
+                        Message message;
+                        message.type = MessageType::WRITE_REQUEST;
+                        message.key = "producer_" + std::to_string(p) + "_key_" + std::to_string(i % 8);
+                        message.sequence_number = i;
+                        assert(dispatcher.dispatch(std::move(message)));
+                    }
+                });
+            }
+            for (auto& producer : producers) {
+                producer.join();
+            }
+            dispatcher.stop();
+            
+            assert(seen.size() == 32);
+            for (const auto& entry : seen) {
+                assert(entry.second.size() == 250);
+                assert(std::is_sorted(entry.second.begin(), entry.second.end()));
+            }
+            DispatcherStats stats = dispatcher.get_stats();
+            assert(stats.dispatched == 8000 && stats.keyed_handled == 8000);
+        }
+        
+        // A worker blocked in a client request does not hold up the control
+        // lane (the promise that unblocks it) or shared work (idle worker)
+        {
+            std::promise<void> promised;
+            std::shared_future<void> unblocked = promised.get_future().share();
+            std::atomic<int> shared_done(0);
+            DispatcherConfig config;
+            config.worker_threads = 2;
+            MessageDispatcher dispatcher([&](const Message& message) {
+                if (message.type == MessageType::WRITE_REQUEST) {
+                    assert(unblocked.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+                } else if (message.type == MessageType::SYNC_RANGE_REQUEST) {
+                    shared_done.fetch_add(1);
+                } else if (message.type == MessageType::QUORUM_PROMISE) {
+                    while (shared_done.load() < 10) {
+                        std::this_thread::yield();
+                    }
+                    promised.set_value();
+                }
+            }, config);
+            assert(dispatcher.start());
+            
+            assert(dispatcher.dispatch(keyed));
+            for (int i = 0; i < 10; ++i) {
+                assert(dispatcher.dispatch(sync_request));
+            }
+            assert(dispatcher.dispatch(promise));
+            dispatcher.stop();
+            
+            DispatcherStats stats = dispatcher.get_stats();
+            assert(stats.control_handled == 1 && stats.keyed_handled == 1 && stats.shared_handled == 10);
+        }
+        
+        // Replication data blocked on the disk holds up neither the keyed
+        // lanes nor the control lane, and one sender's chain forwards and
+        // batches keep its order across replication lanes
+        {
+            std::promise<void> synced;
+            std::shared_future<void> disk = synced.get_future().share();
+            std::mutex order_mutex;
+            std::map<uint32_t, std::vector<uint32_t>> batches;
+            std::atomic<int> keyed_done(0);
+            DispatcherConfig config;
+            config.worker_threads = 2;
+            config.replication_threads = 4;
+            MessageDispatcher dispatcher([&](const Message& message) {
+                if (message.type == MessageType::CHAIN_FORWARD && message.sender_id == 0) {
+                    assert(disk.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+                } else if (message.type == MessageType::CHAIN_FORWARD || message.type == MessageType::BATCH_REQUEST) {
+                    std::lock_guard<std::mutex> lock(order_mutex);
+                    batches[message.sender_id].push_back(message.sequence_number);
+                } else if (message.type == MessageType::WRITE_REQUEST) {
+                    keyed_done.fetch_add(1);
+                } else if (message.type == MessageType::QUORUM_COMMIT) {
+                    while (keyed_done.load() < 10) {
+                        std::this_thread::yield();
+                    }
+                    synced.set_value();
+                }
+            }, config);
+            assert(dispatcher.start());
+            assert(dispatcher.get_replication_lane_count() == 4);
+            
+            assert(dispatcher.dispatch(forward));
+            for (uint32_t i = 0; i < 200; ++i) {
+                Message batch;
+                batch.type = MessageType::BATCH_REQUEST;
+                batch.sender_id = 2 + i % 4;
+                batch.sequence_number = i;
+                if (i % 5 == 0) {
+                    Message keyed_forward = batch;
+                    keyed_forward.type = MessageType::CHAIN_FORWARD;
+                    keyed_forward.key = "f" + std::to_string(i);
+                    assert(dispatcher.dispatch(std::move(keyed_forward)));
+                }
+                assert(dispatcher.dispatch(std::move(batch)));
+            }
+            for (int i = 0; i < 10; ++i) {
+                keyed.key = "k" + std::to_string(i);
+                assert(dispatcher.dispatch(keyed));
+            }
+            assert(dispatcher.dispatch(commit));
+            dispatcher.stop();
+            
+            assert(batches.size() == 4);
+            for (const auto& entry : batches) {
+                assert(entry.second.size() == 60);
+                assert(std::is_sorted(entry.second.begin(), entry.second.end()));
+            }
+            DispatcherStats stats = dispatcher.get_stats();
+            assert(stats.control_handled == 1 && stats.keyed_handled == 10 && stats.replication_handled == 241);
+        }
+        
+        std::cout << "    ✓ Sharded message dispatch test passed" << std::endl;
+    }
+    
+    void test_frame_compression() {
+        std::cout << "  Testing frame compression..." << std::endl;
+        
+        std::string json;
+        for (int i = 0; json.size() < 16 * 1024; ++i) {
+            json += "{\"id\":" + std::to_string(i) + ",\"owner\":\"alice\",\"active\":true},";
+        }
+        std::string random_bytes(8 * 1024, '\0');
+        std::mt19937 gen(7);
+        for (char& byte : random_bytes) {
+            byte = static_cast<char>(gen());
+        }
+        
+        assert(supported_codecs() & (1U << static_cast<uint32_t>(CompressionCodec::LZ)));
+        assert(find_codec(CompressionCodec::NONE) == nullptr);
+        for (uint32_t id = 1; id < 32; ++id) {
+            const FrameCodec* codec = find_codec(static_cast<CompressionCodec>(id));
+            if (!codec) {
+                continue;
+            }
+            for (const std::string& input : {json, random_bytes, std::string(5000, 'a'), std::string("abc"), std::string()}) {
+                std::string compressed = "prefix";
+                assert(codec->compress(input.data(), input.size(), compressed));
+                std::string restored = "prefix";
+                assert(codec->decompress(compressed.data() + 6, compressed.size() - 6, input.size(), restored));
+                assert(restored == "prefix" + input);
+            }
+            
+            std::string compressed;
+            codec->compress(json.data(), json.size(), compressed);
+            assert(compressed.size() * 3 < json.size());
+            
+            // Corrupt or truncated input fails cleanly and leaves out alone
+            std::string restored = "keep";
+            assert(!codec->decompress(compressed.data(), compressed.size() / 2, json.size(), restored));
+            assert(!codec->decompress(compressed.data(), compressed.size(), json.size() + 1, restored));
+            assert(restored == "keep");
+        }
+        
+        // Two managers on loopback: large frames travel compressed once the
+        // receiver's codec offer has arrived, small ones stay raw
+        {
+            NetworkManager sender(1, 0);
+            NetworkManager receiver(2, 0);
+            sender.enable_compression(true);
+            sender.enable_message_batching(false);
+            std::mutex received_mutex;
+            std::vector<Message> received;
+            receiver.set_message_handler([&](const Message& message) {
+                std::lock_guard<std::mutex> lock(received_mutex);
+                received.push_back(message);
+            });
+            assert(sender.start() && receiver.start());
+            sender.add_node(2, "127.0.0.1", receiver.get_listen_port());
+            receiver.add_node(1, "127.0.0.1", sender.get_listen_port());
+            
+            Message hello;
+            hello.type = MessageType::READ_REQUEST;
+            hello.key = "hello";
+            assert(receiver.send_message(1, hello));
+            for (int i = 0; i < 200 && sender.get_peer_compression_stats(2).peer_codecs == 0; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            
+            for (int i = 0; i < 10; ++i) {
+                Message write;
+                write.type = MessageType::WRITE_REQUEST;
+                write.sender_id = 1;
+                write.key = "json_" + std::to_string(i);
+                write.value = json;
+                assert(sender.send_message(2, write));
+                Message read;
+                read.type = MessageType::READ_REQUEST;
+                read.sender_id = 1;
+                read.key = "small_" + std::to_string(i);
+                assert(sender.send_message(2, read));
+            }
+            for (int i = 0; i < 200; ++i) {
+                {
+                    std::lock_guard<std::mutex> lock(received_mutex);
+                    if (received.size() == 20) {
+                        break;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            sender.stop();
+            receiver.stop();
+            
+            assert(received.size() == 20);
+            for (const Message& message : received) {
+                assert(message.type != MessageType::WRITE_REQUEST || message.value.str() == json);
+            }
+            PeerCompressionStats sent = sender.get_peer_compression_stats(2);
+            PeerCompressionStats decoded = receiver.get_peer_compression_stats(1);
+            assert(sent.codec != CompressionCodec::NONE);
+            assert(sent.frames_compressed == 10 && sent.frames_incompressible == 0);
+            assert(sent.compression_ratio() > 3.0);
+            assert(decoded.frames_decompressed == 10);
+            std::cout << "    Ratio " << std::fixed << std::setprecision(2) << sent.compression_ratio()
+                      << "x, " << sent.average_compress_us() << "us compress, "
+                      << decoded.average_decompress_us() << "us decompress per frame" << std::endl;
+        }
+        
+        std::cout << "    ✓ Frame compression test passed" << std::endl;
+    }
+    
+    void test_failure_detector() {
+        std::cout << "  Testing phi-accrual failure detection..." << std::endl;
+        
+        FailureDetectorConfig config;
+        config.probe_interval_ms = 100;
+        config.min_std_deviation_ms = 10;
+        
+        // A steady 100ms rhythm: phi grows with the silence after it
+        {
+            PhiAccrualDetector detector(config);
+            assert(detector.liveness(7, 1000) == PeerLiveness::UNKNOWN);
+            uint64_t now = 1000000;
+            for (int i = 0; i < 20; ++i, now += 100000) {
+                detector.on_arrival(7, now);
+            }
+            uint64_t last = now - 100000;
+            PhiAccrualDetector::Estimate steady = detector.estimate(7, last + 50000);
+            assert(steady.samples == 19 && steady.mean_gap_ms == 100.0);
+            assert(steady.phi < 1.0 && steady.liveness == PeerLiveness::ALIVE);
+            assert(detector.phi(7, last + 120000) > steady.phi);
+            assert(detector.liveness(7, last + 150000) == PeerLiveness::SUSPECT);
+            assert(detector.liveness(7, last + 300000) == PeerLiveness::FAILED);
+            assert(std::isfinite(detector.phi(7, last + 3600000000ULL)));
+            
+            // Heard from again after an outage: alive, and the outage was
+            // not taken as the new rhythm
+            detector.on_arrival(7, last + 5000000);
+            assert(detector.liveness(7, last + 5000000) == PeerLiveness::ALIVE);
+            assert(detector.estimate(7, last + 5000000).samples == 19);
+        }
+        
+        // Bursts of traffic are recorded as one probe interval each, so the
+        // first idle gap afterwards is not suspicious
+        {
+            PhiAccrualDetector detector(config);
+            uint64_t now = 1000000;
+            for (int i = 0; i < 5000; ++i, now += 100) {
+                detector.on_arrival(3, now);
+            }
+            PhiAccrualDetector::Estimate busy = detector.estimate(3, now + 100000);
+            assert(busy.samples == 4 && busy.mean_gap_ms == 100.0);
+            assert(busy.liveness == PeerLiveness::ALIVE);
+            
+            // A watched peer that never speaks is still suspected
+            detector.watch(4, now);
+            assert(detector.liveness(4, now + 50000) == PeerLiveness::ALIVE);
+            assert(detector.liveness(4, now + 1000000) == PeerLiveness::FAILED);
+        }
+        
+        // Two managers on loopback: idle links are probed, busy ones are
+        // not, and a stopped peer is failed and then recovered
+        {
+            FailureDetectorConfig loopback;
+            loopback.min_std_deviation_ms = 25;
+            NetworkManager watcher(1, 0);
+            auto peer = std::make_unique<NetworkManager>(2, 0);
+            watcher.set_failure_detector_config(loopback);
+            peer->set_failure_detector_config(loopback);
+            std::mutex changes_mutex;
+            std::vector<PeerLiveness> changes;
+            watcher.set_liveness_handler([&](uint32_t node_id, PeerLiveness liveness) {
+                std::lock_guard<std::mutex> lock(changes_mutex);
+                assert(node_id == 2);
+                changes.push_back(liveness);
+            });
+            auto saw = [&](PeerLiveness liveness) {
+                std::lock_guard<std::mutex> lock(changes_mutex);
+                return std::find(changes.begin(), changes.end(), liveness) != changes.end();
+            };
+            auto wait_for = [&](PeerLiveness liveness) {
+                for (int i = 0; i < 400 && !saw(liveness); ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                return saw(liveness);
+            };
+            
+            assert(watcher.start() && peer->start());
+            uint16_t peer_port = peer->get_listen_port();
+            watcher.add_node(2, "127.0.0.1", peer_port);
+            peer->add_node(1, "127.0.0.1", watcher.get_listen_port());
+            watcher.start_heartbeat(50);
+            peer->start_heartbeat(50);
+            
+            assert(wait_for(PeerLiveness::ALIVE));
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            assert(!saw(PeerLiveness::FAILED));
+            assert(watcher.get_peer_liveness(2) == PeerLiveness::ALIVE);
+            uint64_t idle_probes = peer->get_heartbeat_probes_sent();
+            assert(idle_probes > 0);
+            
+            // Data to the watcher stands in for the peer's probes
+            uint64_t probes_before = peer->get_heartbeat_probes_sent();
+            for (int i = 0; i < 100; ++i) {
+                Message write;
+                write.type = MessageType::WRITE_REQUEST;
+                write.sender_id = 2;
+                write.key = "busy_" + std::to_string(i);
+                peer->send_message(1, write);
+                std::this_thread::sleep_for(std::chrono::milliseconds(3));
+            }
+            assert(peer->get_heartbeat_probes_sent() - probes_before <= 1);
+            assert(watcher.get_peer_liveness(2) == PeerLiveness::ALIVE);
+            
+            auto stopped_at = std::chrono::steady_clock::now();
+            peer->stop();
+            peer.reset();
+            assert(wait_for(PeerLiveness::FAILED));
+            auto detection_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - stopped_at).count();
+            assert(saw(PeerLiveness::SUSPECT));
+            assert(!watcher.is_node_reachable(2));
+            
+            {
+                std::lock_guard<std::mutex> lock(changes_mutex);
+                changes.clear();
+            }
+            peer = std::make_unique<NetworkManager>(2, peer_port);
+            peer->set_failure_detector_config(loopback);
+            assert(peer->start());
+            peer->add_node(1, "127.0.0.1", watcher.get_listen_port());
+            peer->start_heartbeat(50);
+            assert(wait_for(PeerLiveness::ALIVE));
+            assert(watcher.is_node_reachable(2));
+            
+            peer->stop();
+            watcher.stop();
+            std::cout << "    Failure detected " << detection_ms << "ms after the peer stopped, "
+                      << idle_probes << " idle probes" << std::endl;
+        }
+        
+        std::cout << "    ✓ Failure detector test passed" << std::endl;
+    }
+    
+    void test_workload_generators() {
+        std::cout << "  Testing YCSB workload generators..." << std::endl;
+        
+        const uint64_t records = 10000;
+        const int draws = 200000;
+        
+        // Zipfian: a small head takes most requests but is scattered
+        {
+            std::mt19937_64 rng(1);
+            ZipfianGenerator ranks(records);
+            std::vector<int> counts(records, 0);
+            for (int i = 0; i < draws; ++i) {
+                uint64_t rank = ranks.next(rng);
+                assert(rank < records);
+                counts[rank]++;
+            }
+            assert(counts[0] > counts[1] && counts[1] > counts[10] && counts[10] > counts[1000]);
+            int head = 0;
+            for (uint64_t i = 0; i < records / 10; ++i) {
+                head += counts[i];
+            }
+            assert(head > draws * 6 / 10);
+            
+            std::atomic<uint64_t> record_count(records);
+            WorkloadSpec spec;
+            assert(WorkloadSpec::ycsb('c', spec));
+            WorkloadGenerator generator(spec, record_count, 2);
+            std::map<uint64_t, int> keys;
+            for (int i = 0; i < draws; ++i) {
+                WorkloadOperation operation = generator.next();
+                assert(operation.kind == WorkloadOperationKind::READ && operation.key_index < records);
+                keys[operation.key_index]++;
+            }
+            int hottest = 0;
+            uint64_t hottest_key = 0;
+            for (const auto& entry : keys) {
+                if (entry.second > hottest) {
+                    hottest = entry.second;
+                    hottest_key = entry.first;
+                }
+            }
+            assert(hottest > draws / 100 && hottest_key != 0);
+        }
+        
+        // Operation mixes and the keys inserts claim
+        {
+            std::atomic<uint64_t> record_count(records);
+            WorkloadSpec spec;
+            assert(WorkloadSpec::ycsb('A', spec));
+            assert(!WorkloadSpec::ycsb('G', spec));
+            
+            assert(WorkloadSpec::ycsb('D', spec));
+            WorkloadGenerator generator(spec, record_count, 3);
+            std::map<WorkloadOperationKind, int> kinds;
+            uint64_t expected_insert = records;
+            int recent = 0;
+            for (int i = 0; i < draws; ++i) {
+                WorkloadOperation operation = generator.next();
+                kinds[operation.kind]++;
+                if (operation.kind == WorkloadOperationKind::INSERT) {
+                    assert(operation.key_index == expected_insert++);
+                    assert(operation.value_size == spec.max_value_size);
+                } else if (record_count.load() - operation.key_index <= 100) {
+                    recent++;
+                }
+            }
+            assert(record_count.load() == expected_insert);
+            assert(std::abs(kinds[WorkloadOperationKind::INSERT] - draws / 20) < draws / 100);
+            assert(recent > kinds[WorkloadOperationKind::READ] / 2); // latest: new keys are hot
+            
+            assert(WorkloadSpec::ycsb('E', spec));
+            spec.max_scan_length = 10;
+            WorkloadGenerator scans(spec, record_count, 4);
+            for (int i = 0; i < 1000; ++i) {
+                WorkloadOperation operation = scans.next();
+                assert(operation.kind == WorkloadOperationKind::SCAN || operation.kind == WorkloadOperationKind::INSERT);
+                if (operation.kind == WorkloadOperationKind::SCAN) {
+                    assert(operation.scan_length >= 1 && operation.scan_length <= 10);
+                }
+            }
+        }
+        
+        // Hotspot and value sizes
+        {
+            std::atomic<uint64_t> record_count(records);
+            WorkloadSpec spec;
+            assert(WorkloadSpec::ycsb('A', spec));
+            assert(parse_key_distribution("hotspot", spec.key_distribution));
+            assert(!parse_key_distribution("gaussian", spec.key_distribution));
+            assert(parse_value_size_distribution("zipfian", spec.value_distribution));
+            spec.min_value_size = 100;
+            spec.max_value_size = 4096;
+            WorkloadGenerator generator(spec, record_count, 5);
+            int hot = 0;
+            size_t small_values = 0;
+            size_t updates = 0;
+            for (int i = 0; i < draws; ++i) {
+                WorkloadOperation operation = generator.next();
+                if (operation.key_index < records / 5) {
+                    hot++;
+                }
+                if (operation.kind == WorkloadOperationKind::UPDATE) {
+                    assert(operation.value_size >= 100 && operation.value_size <= 4096);
+                    updates++;
+                    small_values += operation.value_size < 200 ? 1 : 0;
+                }
+            }
+            assert(std::abs(hot - draws * 8 / 10) < draws / 50);
+            assert(small_values > updates / 2);
+        }
+        
+        // Poisson gaps average out to the requested rate
+        {
+            PoissonArrivals arrivals(100000.0, 6); // mean gap 10us
+            uint64_t total_ns = 0;
+            for (int i = 0; i < draws; ++i) {
+                total_ns += arrivals.next_gap_ns();
+            }
+            double mean_gap_us = total_ns / 1000.0 / draws;
+            assert(mean_gap_us > 9.8 && mean_gap_us < 10.2);
+        }
+        
+        std::cout << "    ✓ YCSB workload generators test passed" << std::endl;
+    }
 };
 
 void run_performance_tests() {
@@ -6,6 +6,7 @@
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <future>
 
 using namespace replication;
 
@@ -22,10 +23,15 @@ public:
         test_quorum_size_calculation();
         test_consensus_operations();
         test_fast_quorum_reads();
+        test_linearizable_reads_skip_fast_path();
         test_adaptive_quorum();
         test_node_failure_handling();
         test_timeout_handling();
         test_performance_metrics();
+        test_apply_on_commit();
+        test_leader_change_recovery();
+        test_leader_step_down();
+        test_preferred_leader();
         
         std::cout << "All Quorum Replication tests passed!" << std::endl;
     }
@@ -116,9 +122,10 @@ private:
         
         QuorumReplication quorum(node, quorum_nodes);
         
-        // Enable fast quorum optimization
+        // Enable fast quorum optimization; local reads are not linearizable
         quorum.enable_fast_quorum(true);
         quorum.enable_read_optimization(true);
+        quorum.set_read_mode(QuorumReadMode::LOCAL);
         
         Message read_request;
         read_request.type = MessageType::READ_REQUEST;
@@ -144,6 +151,59 @@ private:
         std::cout << "    ✓ Fast quorum reads test passed" << std::endl;
     }
     
+    void test_linearizable_reads_skip_fast_path() {
+        std::cout << "  Testing linearizable reads skip the fast path..." << std::endl;
+        
+        std::vector<uint32_t> quorum_nodes = {1, 2, 3};
+        auto node = std::make_shared<Node>(2, quorum_nodes);
+        node->start();
+        
+        // A follower's local copy may trail the leader
+        node->write("stale_key", "stale_value");
+        
+        QuorumReplication quorum(node, quorum_nodes);
+        quorum.enable_fast_quorum(true);
+        quorum.enable_read_optimization(true);
+        quorum.set_timeout(100);
+        
+        Message read_request;
+        read_request.type = MessageType::READ_REQUEST;
+        read_request.key = "stale_key";
+        read_request.sender_id = 100;
+        
+        const QuorumReadMode modes[] = {QuorumReadMode::LEASE, QuorumReadMode::READ_INDEX};
+        for (QuorumReadMode mode : modes) {
+            quorum.set_read_mode(mode);
+            
+            // Neither a leader nor a leaseholder, so nothing is served locally
+            Message local_response;
+            assert(!quorum.serve_local_read(read_request, local_response));
+            
+            Message read_response;
+            assert(!quorum.process_read(read_request, read_response));
+            assert(!read_response.success);
+        }
+
+        // Accepting from leader 1 grants it the lease: hedges go there, and
+        // this follower still answers nothing locally
+        quorum.set_read_mode(QuorumReadMode::LEASE);
+        assert(quorum.get_leaseholder() == 0);
+        Message accept;
+        accept.type = MessageType::QUORUM_ACCEPT;
+        accept.sender_id = 1;
+        accept.ballot = (1ULL << 16) | 1;
+        accept.log_index = 1;
+        accept.key = "stale_key";
+        accept.value = "fresh_value";
+        quorum.handle_accept(accept);
+        assert(quorum.get_leaseholder() == 1);
+        Message local_response;
+        assert(!quorum.serve_local_read(read_request, local_response));
+
+        node->stop();
+        std::cout << "    ✓ Linearizable reads skip fast path test passed" << std::endl;
+    }
+    
     void test_adaptive_quorum() {
         std::cout << "  Testing adaptive quorum..." << std::endl;
         
@@ -276,6 +336,240 @@ private:
         std::cout << "    ✓ Performance metrics test passed" << std::endl;
     }
     
+    Message make_accepted(uint32_t sender, uint64_t ballot, uint64_t index, bool success) {
+        Message accepted;
+        accepted.type = MessageType::QUORUM_ACCEPTED;
+        accepted.sender_id = sender;
+        accepted.ballot = ballot;
+        accepted.log_index = index;
+        accepted.sequence_number = static_cast<uint32_t>(index);
+        accepted.success = success;
+        return accepted;
+    }
+    
+    // Answers the candidate's first prepare from sender until it leads
+    bool grant_leadership(QuorumReplication& quorum, uint32_t sender, uint64_t ballot,
+                          const std::string& accepted_frames) {
+        Message promise;
+        promise.type = MessageType::QUORUM_PROMISE;
+        promise.sender_id = sender;
+        promise.sequence_number = 1;
+        promise.ballot = ballot;
+        promise.success = true;
+        promise.value = accepted_frames;
+        for (int attempt = 0; attempt < 200 && !quorum.is_leader(); ++attempt) {
+            quorum.handle_promise(promise);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return quorum.is_leader();
+    }
+    
+    void test_apply_on_commit() {
+        std::cout << "  Testing writes applied only on commit..." << std::endl;
+        
+        std::vector<uint32_t> quorum_nodes = {1, 2, 3};
+        auto node = std::make_shared<Node>(2, quorum_nodes);
+        node->start();
+        
+        QuorumReplication quorum(node, quorum_nodes);
+        const uint64_t ballot = (1ULL << 16) | 1;
+        
+        // Promising node 1's ballot grants it the lease it counts on once it leads
+        Message prepare;
+        prepare.type = MessageType::QUORUM_PREPARE;
+        prepare.sender_id = 1;
+        prepare.ballot = ballot;
+        quorum.handle_prepare(prepare);
+        assert(quorum.get_leaseholder() == 1);
+        
+        Message accept;
+        accept.type = MessageType::QUORUM_ACCEPT;
+        accept.sender_id = 1;
+        accept.ballot = ballot;
+        accept.log_index = 1;
+        accept.sequence_number = 1;
+        accept.key = "commit_key";
+        accept.value = "commit_value";
+        quorum.handle_accept(accept);
+        
+        // Accepted is not committed: the leader may still lose the slot
+        std::string value;
+        assert(!node->read("commit_key", value));
+        assert(quorum.get_commit_index() == 0);
+        
+        Message commit;
+        commit.type = MessageType::QUORUM_COMMIT;
+        commit.sender_id = 1;
+        commit.ballot = ballot;
+        commit.log_index = 1;
+        quorum.handle_commit(commit);
+        assert(node->read("commit_key", value));
+        assert(value == "commit_value");
+        assert(quorum.get_commit_index() == 1);
+        
+        // A commit that overtakes its accept is applied once the value arrives
+        commit.log_index = 2;
+        quorum.handle_commit(commit);
+        assert(quorum.get_commit_index() == 1);
+        accept.log_index = 2;
+        accept.sequence_number = 2;
+        accept.key = "late_key";
+        accept.value = "late_value";
+        quorum.handle_accept(accept);
+        assert(node->read("late_key", value));
+        assert(value == "late_value");
+        assert(quorum.get_commit_index() == 2);
+        
+        node->stop();
+        std::cout << "    ✓ Apply on commit test passed" << std::endl;
+    }
+    
+    void test_leader_change_recovery() {
+        std::cout << "  Testing leader change recovery..." << std::endl;
+        
+        std::vector<uint32_t> quorum_nodes = {1, 2, 3};
+        auto node = std::make_shared<Node>(3, quorum_nodes);
+        node->start();
+        
+        QuorumReplication quorum(node, quorum_nodes);
+        quorum.set_timeout(2000);
+        
+        // Node 2 led with ballot (1, 2) and node 1 accepted slot 1 from it
+        // before node 2 failed; nothing was committed
+        Message previous;
+        previous.type = MessageType::QUORUM_ACCEPT;
+        previous.log_index = 1;
+        previous.ballot = (1ULL << 16) | 2;
+        previous.key = "recovered_key";
+        previous.value = "recovered_value";
+        std::string accepted_frames;
+        previous.serialize_to(accepted_frames);
+        
+        Message request;
+        request.type = MessageType::WRITE_REQUEST;
+        request.key = "new_key";
+        request.value = "new_value";
+        auto result = std::async(std::launch::async, [&quorum, request]() {
+            Message response;
+            return quorum.process_write(request, response);
+        });
+        
+        // Node 3 wins ballot (1, 3) with node 1's promise
+        const uint64_t ballot = (1ULL << 16) | 3;
+        assert(grant_leadership(quorum, 1, ballot, accepted_frames));
+        
+        // Slot 1 may hold an acknowledged write, so no read is served locally
+        // until it commits again
+        Message read_request;
+        read_request.type = MessageType::READ_REQUEST;
+        read_request.key = "recovered_key";
+        Message read_response;
+        assert(!quorum.has_valid_lease());
+        assert(!quorum.serve_local_read(read_request, read_response));
+        
+        // The recovered value is proposed again in slot 1, ahead of the new write
+        quorum.handle_accepted(make_accepted(1, ballot, 1, true));
+        assert(quorum.has_valid_lease());
+        assert(quorum.serve_local_read(read_request, read_response));
+        assert(read_response.value == "recovered_value");
+        std::string value;
+        assert(node->read("recovered_key", value));
+        assert(value == "recovered_value");
+        assert(quorum.get_commit_index() == 1);
+        
+        while (result.wait_for(std::chrono::milliseconds(5)) != std::future_status::ready) {
+            quorum.handle_accepted(make_accepted(1, ballot, 2, true));
+        }
+        assert(result.get());
+        assert(node->read("new_key", value));
+        assert(value == "new_value");
+        assert(quorum.get_commit_index() == 2);
+        
+        node->stop();
+        std::cout << "    ✓ Leader change recovery test passed" << std::endl;
+    }
+    
+    void test_leader_step_down() {
+        std::cout << "  Testing leader step-down..." << std::endl;
+        
+        std::vector<uint32_t> quorum_nodes = {1, 2, 3};
+        auto node = std::make_shared<Node>(3, quorum_nodes);
+        node->start();
+        
+        QuorumReplication quorum(node, quorum_nodes);
+        quorum.set_timeout(2000);
+        
+        Message request;
+        request.type = MessageType::WRITE_REQUEST;
+        request.key = "lost_key";
+        request.value = "lost_value";
+        auto result = std::async(std::launch::async, [&quorum, request]() {
+            Message response;
+            return quorum.process_write(request, response);
+        });
+        
+        const uint64_t ballot = (1ULL << 16) | 3;
+        assert(grant_leadership(quorum, 1, ballot, ""));
+        
+        // A higher ballot deposes the leader before slot 1 reaches a majority
+        while (result.wait_for(std::chrono::milliseconds(5)) != std::future_status::ready) {
+            quorum.handle_accepted(make_accepted(1, (2ULL << 16) | 1, 1, false));
+        }
+        assert(!result.get());
+        assert(!quorum.is_leader());
+        
+        // The failed slot was never committed, so it is not applied
+        std::string value;
+        assert(!node->read("lost_key", value));
+        assert(quorum.get_commit_index() == 0);
+        
+        node->stop();
+        std::cout << "    ✓ Leader step-down test passed" << std::endl;
+    }
+    
+    void test_preferred_leader() {
+        std::cout << "  Testing preferred leader..." << std::endl;
+        
+        std::vector<uint32_t> quorum_nodes = {1, 2, 3};
+        auto node = std::make_shared<Node>(2, quorum_nodes);
+        node->start();
+        
+        QuorumReplication quorum(node, quorum_nodes);
+        quorum.set_timeout(2000);
+        quorum.enable_adaptive_quorum(false);
+        quorum.set_preferred_leader(1);
+        
+        // While node 1 is up, writes here are refused and point at it
+        Message request;
+        request.type = MessageType::WRITE_REQUEST;
+        request.key = "preferred_key";
+        request.value = "value";
+        Message response;
+        assert(!quorum.process_write(request, response));
+        assert(response.target_nodes == std::vector<uint32_t>{1});
+        assert(!quorum.is_leader());
+        
+        // Once it fails, this replica runs phase 1 and takes over
+        quorum.handle_node_failure(1);
+        auto result = std::async(std::launch::async, [&quorum, request]() {
+            Message write_response;
+            return quorum.process_write(request, write_response);
+        });
+        const uint64_t ballot = (1ULL << 16) | 2;
+        assert(grant_leadership(quorum, 3, ballot, ""));
+        while (result.wait_for(std::chrono::milliseconds(5)) != std::future_status::ready) {
+            quorum.handle_accepted(make_accepted(3, ballot, 1, true));
+        }
+        assert(result.get());
+        
+        // and hands leadership back when node 1 returns
+        quorum.handle_node_recovery(1);
+        assert(!quorum.is_leader());
+        
+        node->stop();
+        std::cout << "    ✓ Preferred leader test passed" << std::endl;
+    }
+    
     void test_paxos_message_handling() {
         std::cout << "  Testing Paxos message handling..." << std::endl;
         